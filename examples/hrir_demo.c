@@ -73,7 +73,7 @@ int main() {
         while (hr_ir_step(runtime)) {
             printf("  PC: %zu, Executed: %s\n",
                    hr_ir_get_pc(runtime),
-                   hr_ir_get_cell(program, hr_ir_get_pc(runtime) - 1)->executed ? "YES" : "NO");
+                   hr_ir_cell_executed(runtime, hr_ir_get_pc(runtime) - 1) ? "YES" : "NO");
         }
 
         printf("Execution complete: %s\n", hr_ir_is_complete(runtime) ? "YES" : "NO");
@@ -59,6 +59,7 @@ typedef struct {
     bool auto_hoist;      // Policy: Auto-generate synthetic hierarchy
     bool debug_mode;      // I/O: Verbose logging + stats
     bool reversible_default; // Always true - reversibility by default
+    bool optimize_hrir;   // Codegen: Peephole-optimize L1 HRIR
 } CompilerOptions;
 
 // =============================================================================
@@ -82,6 +83,7 @@ typedef struct {
         size_t r_term_ops_count;
         size_t d_term_ops_count;
         size_t membrane_crossings_count;
+        size_t hrir_cells_removed;
         double compilation_time_ms;
         double validation_time_ms;
     } stats;
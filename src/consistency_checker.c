@@ -187,7 +187,7 @@ ConsistencyResult validate_hrir_consistency(HRIR_Program* program) {
         }
 
         // Check inverse consistency
-        if (cell->is_reversible && !cell->inverse) {
+        if (cell->is_reversible && !hr_ir_has_inverse(program, i)) {
             result.is_consistent = false;
             result.error_message = "Reversible cell missing inverse";
             break;
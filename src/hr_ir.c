@@ -1,11 +1,16 @@
 // rio-riovn-merged/src/hr_ir.c
 // L1 HRIR Implementation - Homoiconic Reversible IR
 
-#include "hr_ir.h"
+#define _POSIX_C_SOURCE 200809L
+
+#include "hr_ir_internal.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
 
 // =============================================================================
 // BUILT-IN OPERATIONS
@@ -24,320 +29,1792 @@ const char* HRIR_OP_PRINT = "print";
 const char* HRIR_OP_READ = "read";
 const char* HRIR_OP_STORE = "store";
 const char* HRIR_OP_LOAD = "load";
+const char* HRIR_OP_VADD = "vadd";
+const char* HRIR_OP_VSUB = "vsub";
+const char* HRIR_OP_VXOR = "vxor";
+const char* HRIR_OP_VSCALE = "vscale";
+const char* HRIR_OP_VSUM = "vsum";
+
+// =============================================================================
+// CELL ARENA
+// =============================================================================
+
+#define HRIR_ARENA_CHUNK_SIZE (16 * 1024)
+#define HRIR_ARENA_CHUNK_MAX  (1024 * 1024)
+#define HRIR_ARENA_ALIGN      16
+
+void* hr_ir_arena_alloc(HRIR_Arena* arena, size_t size) {
+    const size_t align = HRIR_ARENA_ALIGN;
+    HRIR_ArenaChunk* chunk = arena->head;
+    size_t start = 0;
+
+    if (chunk) {
+        uintptr_t next = (uintptr_t)(chunk->bytes + chunk->used);
+        start = chunk->used + ((align - next % align) % align);
+    }
+
+    if (!chunk || start + size > chunk->size) {
+        // Chunks double up to a cap; oversized requests get a chunk of their own
+        size_t chunk_size = HRIR_ARENA_CHUNK_SIZE;
+        if (chunk && chunk->size < HRIR_ARENA_CHUNK_MAX) chunk_size = chunk->size * 2;
+        else if (chunk) chunk_size = HRIR_ARENA_CHUNK_MAX;
+        if (size + align > chunk_size) chunk_size = size + align;
+        chunk = malloc(sizeof(HRIR_ArenaChunk) + chunk_size);
+        if (!chunk) return NULL;
+
+        chunk->prev = arena->head;
+        chunk->used = 0;
+        chunk->size = chunk_size;
+        arena->head = chunk;
+        arena->chunk_count++;
+        start = (align - (uintptr_t)chunk->bytes % align) % align;
+    }
+
+    void* memory = chunk->bytes + start;
+    arena->bytes_used += start + size - chunk->used;
+    chunk->used = start + size;
+    memset(memory, 0, size);
+    return memory;
+}
+
+void hr_ir_arena_free(HRIR_Arena* arena) {
+    HRIR_ArenaChunk* chunk = arena->head;
+    while (chunk) {
+        HRIR_ArenaChunk* prev = chunk->prev;
+        free(chunk);
+        chunk = prev;
+    }
+    memset(arena, 0, sizeof(*arena));
+}
 
 // =============================================================================
 // CELL CREATION API
 // =============================================================================
 
-HRIR_Cell* hr_ir_create_cell(const char* opcode, const char** args, size_t arg_count) {
-    if (!opcode) return NULL;
+// Copy of text owned by the cell's arena, or by the heap
+static char* hr_ir_cell_strdup(HRIR_Cell* cell, const char* text) {
+    if (!cell->arena) return strdup(text);
+
+    size_t length = strlen(text) + 1;
+    char* copy = hr_ir_arena_alloc(cell->arena, length);
+    if (copy) memcpy(copy, text, length);
+    return copy;
+}
+
+// Lay out a cell, its argument array and every string in one block
+static HRIR_Cell* hr_ir_build_cell(HRIR_Arena* arena, const char* opcode,
+                                   const char** args, size_t arg_count) {
+    if (!opcode) return NULL;
+
+    size_t size = sizeof(HRIR_Cell) + strlen(opcode) + 1;
+    if (arg_count > 0) {
+        size += (arg_count + 1) * sizeof(char*); // +1 for NULL terminator
+        for (size_t i = 0; i < arg_count; i++) {
+            if (args[i]) size += strlen(args[i]) + 1;
+        }
+    }
+
+    HRIR_Cell* cell = arena ? hr_ir_arena_alloc(arena, size) : calloc(1, size);
+    if (!cell) return NULL;
+
+    char* text = (char*)(cell + 1);
+    if (arg_count > 0) {
+        cell->args = (const char**)text;
+        text += (arg_count + 1) * sizeof(char*);
+        for (size_t i = 0; i < arg_count; i++) {
+            if (!args[i]) continue;
+            size_t length = strlen(args[i]) + 1;
+            memcpy(text, args[i], length);
+            cell->args[i] = text;
+            text += length;
+        }
+    }
+    memcpy(text, opcode, strlen(opcode) + 1);
+    cell->opcode = text;
+
+    cell->arg_count = arg_count;
+    cell->is_reversible = true; // Default to reversible
+    cell->executed = false;
+    cell->result = NULL;
+    cell->arena = arena;
+
+    return cell;
+}
+
+HRIR_Cell* hr_ir_create_cell(const char* opcode, const char** args, size_t arg_count) {
+    return hr_ir_build_cell(NULL, opcode, args, arg_count);
+}
+
+HRIR_Cell* hr_ir_create_inverse(HRIR_Cell* cell) {
+    if (!cell || !cell->is_reversible) return NULL;
+
+    HRIR_Opcode inverse = hr_ir_inverse_opcode(hr_ir_opcode_from_name(cell->opcode));
+    if (inverse == HRIR_OPC_COUNT) return NULL; // Not invertible
+
+    // Only the opcode differs, so the operands are shared rather than copied
+    HRIR_Cell* inv = cell->arena ? hr_ir_arena_alloc(cell->arena, sizeof(HRIR_Cell))
+                                 : calloc(1, sizeof(HRIR_Cell));
+    if (!inv) return NULL;
+
+    inv->opcode = hr_ir_opcode_name(inverse);
+    inv->args = cell->args;
+    inv->arg_count = cell->arg_count;
+    inv->is_reversible = true;
+    inv->arena = cell->arena;
+    return inv;
+}
+
+HRIR_Cell* hr_ir_get_inverse(HRIR_Cell* cell) {
+    if (!cell) return NULL;
+
+    if (!cell->inverse) {
+        cell->inverse = hr_ir_create_inverse(cell); // Note: inverse->inverse is left unset
+    }
+    return cell->inverse;
+}
+
+void hr_ir_set_cell_meta(HRIR_Cell* cell, const char* source_location,
+                        uint32_t line_number, const char* canonical_path) {
+    if (!cell) return;
+
+    // Arena strings are reclaimed with the program, heap strings here
+    if (source_location) {
+        if (!cell->arena) free((void*)cell->source_location);
+        cell->source_location = hr_ir_cell_strdup(cell, source_location);
+    }
+    cell->line_number = line_number;
+    if (canonical_path) {
+        if (!cell->arena) free((void*)cell->canonical_path);
+        cell->canonical_path = hr_ir_cell_strdup(cell, canonical_path);
+    }
+}
+
+void hr_ir_free_cell(HRIR_Cell* cell) {
+    if (!cell || cell->arena) return; // Arena cells go with their program
+
+    free((void*)cell->source_location);
+    free((void*)cell->canonical_path);
+
+    // Note: result cleanup depends on result type
+    if (cell->result) {
+        free(cell->result);
+    }
+
+    if (cell->inverse) {
+        hr_ir_free_cell(cell->inverse);
+    }
+
+    free(cell); // Opcode and args live in the same block, or belong to the forward cell
+}
+
+// =============================================================================
+// OPCODE MAPPING
+// =============================================================================
+
+static const char* hr_ir_opcode_names[HRIR_OPC_COUNT] = {
+    "add", "subtract", "multiply", "divide",
+    "equal", "less", "greater",
+    "jump", "jump_if",
+    "print", "read",
+    "store", "load",
+    "custom",
+    "vadd", "vsub", "vxor", "vscale", "vsum"
+};
+
+HRIR_Opcode hr_ir_opcode_from_name(const char* name) {
+    if (!name) return HRIR_OPC_CUSTOM;
+
+    for (int op = 0; op < HRIR_OPC_COUNT; op++) {
+        if (op != HRIR_OPC_CUSTOM && strcmp(name, hr_ir_opcode_names[op]) == 0) {
+            return (HRIR_Opcode)op;
+        }
+    }
+    return HRIR_OPC_CUSTOM;
+}
+
+const char* hr_ir_opcode_name(HRIR_Opcode opcode) {
+    if (opcode >= HRIR_OPC_COUNT) return "unknown";
+    return hr_ir_opcode_names[opcode];
+}
+
+// Opcode undoing each built-in when applied to the same operands
+static const uint8_t hr_ir_inverse_opcodes[HRIR_OPC_COUNT] = {
+    HRIR_OPC_SUBTRACT, HRIR_OPC_ADD, HRIR_OPC_DIVIDE, HRIR_OPC_MULTIPLY,
+    HRIR_OPC_COUNT, HRIR_OPC_COUNT, HRIR_OPC_COUNT,
+    HRIR_OPC_COUNT, HRIR_OPC_COUNT,
+    HRIR_OPC_COUNT, HRIR_OPC_COUNT,
+    HRIR_OPC_COUNT, HRIR_OPC_COUNT,
+    HRIR_OPC_COUNT,
+    HRIR_OPC_VSUB, HRIR_OPC_VADD, HRIR_OPC_VXOR, HRIR_OPC_COUNT, HRIR_OPC_COUNT
+};
+
+HRIR_Opcode hr_ir_inverse_opcode(HRIR_Opcode opcode) {
+    if (opcode >= HRIR_OPC_COUNT) return HRIR_OPC_COUNT;
+    return (HRIR_Opcode)hr_ir_inverse_opcodes[opcode];
+}
+
+bool hr_ir_has_inverse(const HRIR_Program* program, size_t index) {
+    if (!program || index >= program->cell_count) return false;
+
+    return (program->flags[index] & HRIR_FLAG_REVERSIBLE) &&
+           hr_ir_inverse_opcode((HRIR_Opcode)program->opcodes[index]) != HRIR_OPC_COUNT;
+}
+
+const char* hr_ir_get_opcode_name(const HRIR_Program* program, size_t index) {
+    if (!program || index >= program->cell_count) return NULL;
+
+    if (program->opcodes[index] == HRIR_OPC_CUSTOM) {
+        return hr_ir_const_text(program, program->meta[index].opcode_name);
+    }
+    return hr_ir_opcode_name((HRIR_Opcode)program->opcodes[index]);
+}
+
+// =============================================================================
+// CONSTANT POOL
+// =============================================================================
+
+uint32_t hr_ir_hash(const char* text, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Classify a constant and pre-parse numeric literals
+static void hr_ir_classify(HRIR_Const* entry, const char* text) {
+    entry->kind = HRIR_CONST_STRING;
+    entry->value.type = HRIR_VALUE_NONE;
+    entry->value.as.i = 0;
+
+    if (entry->length == 0) return;
+
+    if (isalpha((unsigned char)text[0]) || text[0] == '_') {
+        for (size_t i = 1; i < entry->length; i++) {
+            if (!isalnum((unsigned char)text[i]) && text[i] != '_') return;
+        }
+        entry->kind = HRIR_CONST_SYMBOL;
+        return;
+    }
+
+    if (isspace((unsigned char)text[0])) return;
+
+    char* end = NULL;
+    errno = 0;
+    long long i = strtoll(text, &end, 10);
+    if (errno == 0 && end == text + entry->length) {
+        entry->kind = HRIR_CONST_NUMBER;
+        entry->value.type = HRIR_VALUE_INT;
+        entry->value.as.i = (int64_t)i;
+        return;
+    }
+
+    errno = 0;
+    double f = strtod(text, &end);
+    if (errno == 0 && end == text + entry->length) {
+        entry->kind = HRIR_CONST_NUMBER;
+        entry->value.type = HRIR_VALUE_FLOAT;
+        entry->value.as.f = f;
+    }
+}
+
+static bool hr_ir_pool_rehash(HRIR_ConstPool* pool, uint32_t slot_capacity) {
+    uint32_t* slots = calloc(slot_capacity, sizeof(uint32_t));
+    if (!slots) return false;
+
+    for (uint32_t id = 0; id < pool->count; id++) {
+        uint32_t slot = pool->entries[id].hash & (slot_capacity - 1);
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & (slot_capacity - 1);
+        }
+        slots[slot] = id + 1;
+    }
+
+    free(pool->slots);
+    pool->slots = slots;
+    pool->slot_capacity = slot_capacity;
+    return true;
+}
+
+// Find the slot holding text, or the empty slot where it would go
+static uint32_t hr_ir_pool_probe(const HRIR_ConstPool* pool, const char* text,
+                                 size_t length, uint32_t hash) {
+    uint32_t slot = hash & (pool->slot_capacity - 1);
+    while (pool->slots[slot] != 0) {
+        const HRIR_Const* entry = &pool->entries[pool->slots[slot] - 1];
+        if (entry->hash == hash && entry->length == length &&
+            memcmp(pool->bytes + entry->offset, text, length) == 0) {
+            break;
+        }
+        slot = (slot + 1) & (pool->slot_capacity - 1);
+    }
+    return slot;
+}
+
+uint32_t hr_ir_find_const(const HRIR_Program* program, const char* text, size_t length) {
+    if (!program || !text || program->pool.slot_capacity == 0) return HRIR_NO_CONST;
+
+    const HRIR_ConstPool* pool = &program->pool;
+    uint32_t slot = hr_ir_pool_probe(pool, text, length, hr_ir_hash(text, length));
+    return pool->slots[slot] ? pool->slots[slot] - 1 : HRIR_NO_CONST;
+}
+
+uint32_t hr_ir_intern(HRIR_Program* program, const char* text, size_t length) {
+    if (!program || !text) return HRIR_NO_CONST;
+
+    HRIR_ConstPool* pool = &program->pool;
+    uint32_t hash = hr_ir_hash(text, length);
+
+    // A loaded image is only copied out once a new constant arrives
+    if (program->image) {
+        uint32_t found = hr_ir_find_const(program, text, length);
+        if (found != HRIR_NO_CONST) return found;
+        if (!hr_ir_detach_image(program)) return HRIR_NO_CONST;
+    }
+
+    // Keep the table at most 70% full
+    if ((size_t)(pool->count + 1) * 10 > (size_t)pool->slot_capacity * 7) {
+        if (!hr_ir_pool_rehash(pool, pool->slot_capacity ? pool->slot_capacity * 2 : 64)) {
+            return HRIR_NO_CONST;
+        }
+    }
+
+    uint32_t slot = hr_ir_pool_probe(pool, text, length, hash);
+    if (pool->slots[slot] != 0) {
+        return pool->slots[slot] - 1;
+    }
+
+    if (pool->count == HRIR_NO_CONST || pool->bytes_size + length + 1 > UINT32_MAX) {
+        return HRIR_NO_CONST;
+    }
+
+    // Expand entries and bytes if needed
+    if (pool->count >= pool->capacity) {
+        uint32_t new_capacity = pool->capacity ? pool->capacity * 2 : 64;
+        HRIR_Const* new_entries = realloc(pool->entries, new_capacity * sizeof(HRIR_Const));
+        if (!new_entries) return HRIR_NO_CONST;
+        pool->entries = new_entries;
+        pool->capacity = new_capacity;
+    }
+
+    if (pool->bytes_size + length + 1 > pool->bytes_capacity) {
+        size_t new_capacity = pool->bytes_capacity ? pool->bytes_capacity : 1024;
+        while (pool->bytes_size + length + 1 > new_capacity) new_capacity *= 2;
+        char* new_bytes = realloc(pool->bytes, new_capacity);
+        if (!new_bytes) return HRIR_NO_CONST;
+        pool->bytes = new_bytes;
+        pool->bytes_capacity = new_capacity;
+    }
+
+    uint32_t id = pool->count++;
+    HRIR_Const* entry = &pool->entries[id];
+    entry->offset = (uint32_t)pool->bytes_size;
+    entry->length = (uint32_t)length;
+    entry->hash = hash;
+    entry->reg = 0;
+
+    memcpy(pool->bytes + pool->bytes_size, text, length);
+    pool->bytes[pool->bytes_size + length] = '\0';
+    pool->bytes_size += length + 1;
+
+    hr_ir_classify(entry, pool->bytes + entry->offset);
+    if (entry->kind == HRIR_CONST_SYMBOL) {
+        entry->reg = pool->register_count++;
+    }
+
+    pool->slots[slot] = id + 1;
+    return id;
+}
+
+const HRIR_Const* hr_ir_get_const(const HRIR_Program* program, uint32_t const_id) {
+    if (!program || const_id >= program->pool.count) return NULL;
+    return &program->pool.entries[const_id];
+}
+
+const char* hr_ir_const_text(const HRIR_Program* program, uint32_t const_id) {
+    if (!program || const_id >= program->pool.count) return NULL;
+    return program->pool.bytes + program->pool.entries[const_id].offset;
+}
+
+static uint32_t hr_ir_intern_optional(HRIR_Program* program, const char* text) {
+    return text ? hr_ir_intern(program, text, strlen(text)) : HRIR_NO_CONST;
+}
+
+// =============================================================================
+// PROGRAM MANAGEMENT API
+// =============================================================================
+
+// Grow every per-cell array together; capacity only advances once all succeed
+static bool hr_ir_grow_cells(HRIR_Program* program, size_t new_capacity) {
+    void* p;
+
+    p = realloc(program->opcodes, new_capacity * sizeof(uint8_t));
+    if (!p) return false;
+    program->opcodes = p;
+
+    p = realloc(program->flags, new_capacity * sizeof(uint8_t));
+    if (!p) return false;
+    program->flags = p;
+
+    p = realloc(program->ids, new_capacity * sizeof(uint32_t));
+    if (!p) return false;
+    program->ids = p;
+
+    p = realloc(program->arg_offsets, new_capacity * sizeof(uint32_t));
+    if (!p) return false;
+    program->arg_offsets = p;
+
+    p = realloc(program->arg_counts, new_capacity * sizeof(uint16_t));
+    if (!p) return false;
+    program->arg_counts = p;
+
+    p = realloc(program->meta, new_capacity * sizeof(HRIR_CellMeta));
+    if (!p) return false;
+    program->meta = p;
+
+    p = realloc(program->cells, new_capacity * sizeof(HRIR_Cell*));
+    if (!p) return false;
+    program->cells = p;
+    memset(program->cells + program->capacity, 0,
+           (new_capacity - program->capacity) * sizeof(HRIR_Cell*));
+
+    program->capacity = new_capacity;
+    return true;
+}
+
+HRIR_Program* hr_ir_create_program(const char* source_name) {
+    HRIR_Program* program = calloc(1, sizeof(HRIR_Program));
+    if (!program) return NULL;
+
+    if (!hr_ir_grow_cells(program, 16)) { // Initial capacity 16
+        hr_ir_free_program(program);
+        return NULL;
+    }
+
+    program->cell_count = 0;
+    program->next_id = 1;
+
+    // "result" always owns register 0
+    if (hr_ir_intern(program, "result", 6) == HRIR_NO_CONST) {
+        hr_ir_free_program(program);
+        return NULL;
+    }
+
+    if (source_name) {
+        program->source_name = strdup(source_name);
+    }
+
+    return program;
+}
+
+static bool hr_ir_reserve_args(HRIR_Program* program, size_t arg_count) {
+    if (program->arg_count + arg_count > program->arg_capacity) {
+        size_t new_capacity = program->arg_capacity ? program->arg_capacity : 64;
+        while (program->arg_count + arg_count > new_capacity) new_capacity *= 2;
+        uint32_t* new_args = realloc(program->args, new_capacity * sizeof(uint32_t));
+        if (!new_args) return false;
+        program->args = new_args;
+        program->arg_capacity = new_capacity;
+    }
+    return true;
+}
+
+bool hr_ir_reserve_cell(HRIR_Program* program, size_t arg_count) {
+    if (arg_count > UINT16_MAX) return false;
+    if (program->image && !hr_ir_detach_image(program)) return false;
+
+    if (program->cell_count >= program->capacity) {
+        if (!hr_ir_grow_cells(program, program->capacity * 2)) return false;
+    }
+    return hr_ir_reserve_args(program, arg_count);
+}
+
+// =============================================================================
+// CELL LOOKUP BY ID
+// =============================================================================
+
+static size_t hr_ir_id_hash(uint32_t id) {
+    return (size_t)((id * 0x9E3779B1u) ^ (id >> 16));
+}
+
+static void hr_ir_id_insert(HRIR_Program* program, size_t index) {
+    size_t mask = program->id_slot_capacity - 1;
+    size_t slot = hr_ir_id_hash(program->ids[index]) & mask;
+    while (program->id_slots[slot] != 0) slot = (slot + 1) & mask;
+    program->id_slots[slot] = (uint32_t)(index + 1);
+}
+
+// Table sized for `cells` cells at most half full; without one, lookups
+// fall back to binary search
+static bool hr_ir_id_table(HRIR_Program* program, size_t cells) {
+    size_t capacity = 64;
+    while (capacity < cells * 2) capacity *= 2;
+    if (capacity == program->id_slot_capacity) {
+        memset(program->id_slots, 0, capacity * sizeof(uint32_t));
+        return true;
+    }
+
+    free(program->id_slots);
+    program->id_slots = calloc(capacity, sizeof(uint32_t));
+    program->id_slot_capacity = program->id_slots ? capacity : 0;
+    return program->id_slots != NULL;
+}
+
+void hr_ir_index_ids(HRIR_Program* program) {
+    if (!hr_ir_id_table(program, program->cell_count)) return;
+    for (size_t i = 0; i < program->cell_count; i++) {
+        hr_ir_id_insert(program, i);
+    }
+}
+
+static void hr_ir_map_id(HRIR_Program* program, size_t index) {
+    if (program->id_slots && (index + 1) * 2 <= program->id_slot_capacity) {
+        hr_ir_id_insert(program, index);
+    } else {
+        hr_ir_index_ids(program);
+    }
+}
+
+bool hr_ir_reserve(HRIR_Program* program, size_t cells, size_t args) {
+    if (!program) return false;
+    if (program->image && !hr_ir_detach_image(program)) return false;
+
+    size_t needed = program->cell_count + cells;
+    if (needed > program->capacity && !hr_ir_grow_cells(program, needed)) return false;
+    if (!hr_ir_reserve_args(program, args)) return false;
+
+    // Rehash now rather than on some later append
+    if (needed * 2 > program->id_slot_capacity && hr_ir_id_table(program, needed)) {
+        for (size_t i = 0; i < program->cell_count; i++) {
+            hr_ir_id_insert(program, i);
+        }
+    }
+    return true;
+}
+
+// =============================================================================
+// HASH-CONSING
+// =============================================================================
+
+// Only argument runs are shared, not whole cells: the opcode, flags, run
+// offset and count stay in the per-position arrays, which the interpreter
+// indexes directly. With hash-consing on, a new cell whose run matches one
+// already stored points at that run instead of appending a copy. Runs in the
+// table are never written again: hr_ir_own_args copies one out first.
+
+static uint32_t hr_ir_run_hash(const uint32_t* args, size_t count) {
+    uint32_t hash = 2166136261u ^ (uint32_t)count;
+    for (size_t i = 0; i < count; i++) {
+        hash = (hash ^ args[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t hr_ir_body_offset(uint64_t entry) {
+    return (uint32_t)(entry >> 16);
+}
+
+static size_t hr_ir_body_count(uint64_t entry) {
+    return (size_t)(entry & 0xFFFF);
+}
+
+// Slot holding a run equal to args[0..count), or the empty slot for it
+static uint32_t hr_ir_body_probe(const HRIR_Program* program, const uint32_t* args,
+                                 size_t count, uint32_t hash) {
+    const HRIR_BodyTable* bodies = &program->bodies;
+    uint32_t slot = hash & (bodies->capacity - 1);
+    while (bodies->slots[slot] != 0) {
+        uint64_t entry = bodies->slots[slot];
+        if (hr_ir_body_count(entry) == count &&
+            memcmp(program->args + hr_ir_body_offset(entry), args, count * sizeof(uint32_t)) == 0) {
+            break;
+        }
+        slot = (slot + 1) & (bodies->capacity - 1);
+    }
+    return slot;
+}
+
+static bool hr_ir_bodies_rehash(HRIR_Program* program, uint32_t capacity) {
+    uint64_t* slots = calloc(capacity, sizeof(uint64_t));
+    if (!slots) return false;
+
+    HRIR_BodyTable* bodies = &program->bodies;
+    for (uint32_t i = 0; i < bodies->capacity; i++) {
+        uint64_t entry = bodies->slots[i];
+        if (entry == 0) continue;
+        uint32_t slot = hr_ir_run_hash(program->args + hr_ir_body_offset(entry),
+                                       hr_ir_body_count(entry)) & (capacity - 1);
+        while (slots[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = entry;
+    }
+
+    free(bodies->slots);
+    bodies->slots = slots;
+    bodies->capacity = capacity;
+    return true;
+}
+
+// Offset for the run just written at program->args + program->arg_count:
+// an equal stored run, or the new run itself once appended
+static uint32_t hr_ir_share_args(HRIR_Program* program, size_t count) {
+    uint32_t offset = (uint32_t)program->arg_count;
+    HRIR_BodyTable* bodies = &program->bodies;
+    if (bodies->capacity == 0 || count == 0) {
+        program->arg_count += count;
+        return offset;
+    }
+
+    const uint32_t* args = program->args + offset;
+    uint32_t hash = hr_ir_run_hash(args, count);
+    uint32_t slot = hr_ir_body_probe(program, args, count, hash);
+    if (bodies->slots[slot] != 0) {
+        bodies->shared_cells++;
+        bodies->saved_slots += count;
+        return hr_ir_body_offset(bodies->slots[slot]);
+    }
+
+    program->arg_count += count;
+
+    // A full table only stops sharing; the run is stored either way
+    if ((size_t)(bodies->count + 1) * 10 > (size_t)bodies->capacity * 7) {
+        if (!hr_ir_bodies_rehash(program, bodies->capacity * 2)) return offset;
+        slot = hr_ir_body_probe(program, args, count, hash);
+    }
+    bodies->slots[slot] = ((uint64_t)offset << 16) | count;
+    bodies->count++;
+    return offset;
+}
+
+bool hr_ir_set_hash_consing(HRIR_Program* program, bool enabled) {
+    if (!program) return false;
+
+    HRIR_BodyTable* bodies = &program->bodies;
+    if (!enabled) {
+        free(bodies->slots);
+        bodies->slots = NULL;
+        bodies->capacity = 0;
+        bodies->count = 0;
+        return true;
+    }
+    if (bodies->capacity > 0) return true;
+    if (program->image && !hr_ir_detach_image(program)) return false;
+
+    // Rebuild args[] with every cell already in the program shared as well
+    size_t capacity = program->arg_count > 64 ? program->arg_count : 64;
+    uint32_t* args = malloc(capacity * sizeof(uint32_t));
+    if (!args || !hr_ir_bodies_rehash(program, 1024)) {
+        free(args);
+        return false;
+    }
+
+    uint32_t* old_args = program->args;
+    program->args = args;
+    program->arg_capacity = capacity;
+    program->arg_count = 0;
+    for (size_t i = 0; i < program->cell_count; i++) {
+        size_t count = program->arg_counts[i];
+        memcpy(args + program->arg_count, old_args + program->arg_offsets[i], count * sizeof(uint32_t));
+        program->arg_offsets[i] = hr_ir_share_args(program, count);
+    }
+    free(old_args);
+    return true;
+}
+
+uint32_t* hr_ir_own_args(HRIR_Program* program, size_t index) {
+    size_t count = program->arg_counts[index];
+    if (program->image && !hr_ir_detach_image(program)) return NULL;
+    if (!hr_ir_reserve_args(program, count)) return NULL;
+
+    // Any run may be shared (or come from a shared image), so write a copy
+    uint32_t* copy = program->args + program->arg_count;
+    memcpy(copy, program->args + program->arg_offsets[index], count * sizeof(uint32_t));
+    program->arg_offsets[index] = (uint32_t)program->arg_count;
+    program->arg_count += count;
+    return copy;
+}
+
+size_t hr_ir_push_cell(HRIR_Program* program, HRIR_Opcode op, uint32_t opcode_name,
+                       size_t arg_count, uint8_t flags, uint32_t id) {
+    size_t index = program->cell_count++;
+    program->opcodes[index] = (uint8_t)op;
+    program->flags[index] = flags;
+    program->ids[index] = id;
+    program->arg_offsets[index] = hr_ir_share_args(program, arg_count);
+    program->arg_counts[index] = (uint16_t)arg_count;
+    program->meta[index].source_location = HRIR_NO_CONST;
+    program->meta[index].canonical_path = HRIR_NO_CONST;
+    program->meta[index].opcode_name = opcode_name;
+    program->meta[index].line_number = 0;
+    program->cells[index] = NULL;
+    program->next_id = id + 1;
+    hr_ir_map_id(program, index);
+    return index;
+}
+
+// Encode one cell into the parallel arrays, returns its index or SIZE_MAX
+static size_t hr_ir_encode_cell(HRIR_Program* program, const char* opcode,
+                                const char** args, size_t arg_count, uint8_t flags) {
+    if (!opcode || !hr_ir_reserve_cell(program, arg_count)) return SIZE_MAX;
+
+    HRIR_Opcode op = hr_ir_opcode_from_name(opcode);
+    uint32_t opcode_name = HRIR_NO_CONST;
+    if (op == HRIR_OPC_CUSTOM) {
+        opcode_name = hr_ir_intern_optional(program, opcode);
+        if (opcode_name == HRIR_NO_CONST) return SIZE_MAX;
+    }
+
+    uint32_t* slots = program->args + program->arg_count;
+    for (size_t i = 0; i < arg_count; i++) {
+        const char* text = args[i] ? args[i] : "";
+        slots[i] = hr_ir_intern(program, text, strlen(text));
+        if (slots[i] == HRIR_NO_CONST) return SIZE_MAX;
+    }
+
+    return hr_ir_push_cell(program, op, opcode_name, arg_count, flags, program->next_id);
+}
+
+static bool hr_ir_adopt_cell(HRIR_Program* program, HRIR_Cell* cell) {
+    uint8_t flags = 0;
+    if (cell->is_reversible) flags |= HRIR_FLAG_REVERSIBLE;
+
+    size_t index = hr_ir_encode_cell(program, cell->opcode, cell->args, cell->arg_count, flags);
+    if (index == SIZE_MAX) return false;
+
+    program->meta[index].source_location = hr_ir_intern_optional(program, cell->source_location);
+    program->meta[index].canonical_path = hr_ir_intern_optional(program, cell->canonical_path);
+    program->meta[index].line_number = cell->line_number;
+
+    // The caller's cell becomes the accessor view for this index
+    cell->id = program->ids[index];
+    program->cells[index] = cell;
+    program->heap_cells++;
+
+    return true;
+}
+
+bool hr_ir_add_cell(HRIR_Program* program, HRIR_Cell* cell) {
+    if (!program || !cell || cell->arena) return false;
+    return hr_ir_adopt_cell(program, cell);
+}
+
+bool hr_ir_add_cells(HRIR_Program* program, HRIR_Cell** cells, size_t count) {
+    if (!program || (!cells && count > 0)) return false;
+
+    size_t args = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!cells[i] || cells[i]->arena) return false;
+        args += cells[i]->arg_count;
+    }
+    if (!hr_ir_reserve(program, count, args)) return false;
+
+    size_t first = program->cell_count;
+    uint32_t next_id = program->next_id;
+    for (size_t i = 0; i < count; i++) {
+        if (hr_ir_adopt_cell(program, cells[i])) continue;
+
+        // Hand every cell back; interned constants and argument slots stay
+        for (size_t k = first; k < program->cell_count; k++) {
+            program->cells[k] = NULL;
+        }
+        program->heap_cells -= program->cell_count - first;
+        program->cell_count = first;
+        program->next_id = next_id;
+        hr_ir_index_ids(program);
+        return false;
+    }
+    return true;
+}
+
+uint32_t hr_ir_emit(HRIR_Program* program, const char* opcode,
+                    const char** args, size_t arg_count, bool is_reversible) {
+    if (!program) return 0;
+
+    size_t index = hr_ir_encode_cell(program, opcode, args, arg_count,
+                                     is_reversible ? HRIR_FLAG_REVERSIBLE : 0);
+    return index == SIZE_MAX ? 0 : program->ids[index];
+}
+
+bool hr_ir_set_meta(HRIR_Program* program, size_t index, const char* source_location,
+                    uint32_t line_number, const char* canonical_path) {
+    if (!program || index >= program->cell_count) return false;
+
+    if (source_location) {
+        program->meta[index].source_location = hr_ir_intern_optional(program, source_location);
+    }
+    program->meta[index].line_number = line_number;
+    if (canonical_path) {
+        program->meta[index].canonical_path = hr_ir_intern_optional(program, canonical_path);
+    }
+
+    // Keep a materialized view in sync
+    hr_ir_set_cell_meta(program->cells[index], source_location, line_number, canonical_path);
+
+    return true;
+}
+
+// Build the HRIR_Cell view of an encoded cell
+static HRIR_Cell* hr_ir_materialize(HRIR_Program* program, size_t index) {
+    size_t arg_count = program->arg_counts[index];
+    const char** args = NULL;
+
+    if (arg_count > 0) {
+        args = malloc(arg_count * sizeof(char*));
+        if (!args) return NULL;
+        for (size_t i = 0; i < arg_count; i++) {
+            args[i] = hr_ir_const_text(program, program->args[program->arg_offsets[index] + i]);
+        }
+    }
+
+    HRIR_Cell* cell = hr_ir_build_cell(&program->arena, hr_ir_get_opcode_name(program, index),
+                                       args, arg_count);
+    free(args);
+    if (!cell) return NULL;
+
+    const HRIR_CellMeta* meta = &program->meta[index];
+    cell->id = program->ids[index];
+    cell->is_reversible = (program->flags[index] & HRIR_FLAG_REVERSIBLE) != 0;
+    hr_ir_set_cell_meta(cell, hr_ir_const_text(program, meta->source_location),
+                        meta->line_number, hr_ir_const_text(program, meta->canonical_path));
+
+    return cell;
+}
+
+HRIR_Cell* hr_ir_get_cell_by_id(HRIR_Program* program, uint32_t id) {
+    size_t index;
+    if (!program || !hr_ir_find_index(program, id, &index)) return NULL;
+    return hr_ir_get_cell(program, index);
+}
+
+HRIR_Cell* hr_ir_get_cell(HRIR_Program* program, size_t index) {
+    if (!program || index >= program->cell_count) return NULL;
+
+    if (!program->cells[index]) {
+        program->cells[index] = hr_ir_materialize(program, index);
+    }
+    return program->cells[index];
+}
+
+void hr_ir_release_view(HRIR_Program* program, size_t index) {
+    HRIR_Cell* view = program->cells[index];
+    if (!view) return;
+
+    if (!view->arena) program->heap_cells--;
+    hr_ir_free_cell(view);
+    program->cells[index] = NULL;
+}
+
+void hr_ir_free_program(HRIR_Program* program) {
+    if (!program) return;
+
+    // Arena views need no walk; only adopted heap cells are freed one by one
+    for (size_t i = 0; program->heap_cells > 0 && i < program->cell_count; i++) {
+        hr_ir_release_view(program, i);
+    }
+    free(program->cells);
+    hr_ir_arena_free(&program->arena);
+    free(program->bodies.slots);
+    free(program->id_slots);
+
+    // Arrays still inside a binary image go with it
+    if (program->image) {
+        hr_ir_release_image(program);
+        free((void*)program->source_name);
+        free(program);
+        return;
+    }
+
+    free(program->opcodes);
+    free(program->flags);
+    free(program->ids);
+    free(program->arg_offsets);
+    free(program->arg_counts);
+    free(program->meta);
+    free(program->args);
+
+    free(program->pool.bytes);
+    free(program->pool.entries);
+    free(program->pool.slots);
+
+    free((void*)program->source_name);
+    free(program);
+}
+
+// =============================================================================
+// SERIALIZATION API
+// =============================================================================
+
+// Growable output buffer; any allocation failure sticks until the end
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+    bool failed;
+} HRIR_Buffer;
+
+static void hr_buf_append(HRIR_Buffer* buf, const char* text, size_t length) {
+    if (buf->failed) return;
+
+    if (buf->size + length + 1 > buf->capacity) {
+        size_t new_capacity = buf->capacity ? buf->capacity : 4096;
+        while (buf->size + length + 1 > new_capacity) new_capacity *= 2;
+        char* new_data = realloc(buf->data, new_capacity);
+        if (!new_data) {
+            buf->failed = true;
+            return;
+        }
+        buf->data = new_data;
+        buf->capacity = new_capacity;
+    }
+
+    memcpy(buf->data + buf->size, text, length);
+    buf->size += length;
+    buf->data[buf->size] = '\0';
+}
+
+static void hr_buf_puts(HRIR_Buffer* buf, const char* text) {
+    hr_buf_append(buf, text, strlen(text));
+}
+
+static void hr_buf_printf(HRIR_Buffer* buf, const char* format, ...) {
+    char scratch[128];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(scratch, sizeof(scratch), format, args);
+    va_end(args);
+
+    if (length < 0) {
+        buf->failed = true;
+    } else if ((size_t)length < sizeof(scratch)) {
+        hr_buf_append(buf, scratch, (size_t)length);
+    } else {
+        char* large = malloc((size_t)length + 1);
+        if (!large) {
+            buf->failed = true;
+            return;
+        }
+        va_start(args, format);
+        vsnprintf(large, (size_t)length + 1, format, args);
+        va_end(args);
+        hr_buf_append(buf, large, (size_t)length);
+        free(large);
+    }
+}
+
+// Append text as a quoted JSON string
+static void hr_buf_json_string(HRIR_Buffer* buf, const char* text) {
+    hr_buf_append(buf, "\"", 1);
+    const char* run = text;
+    for (const char* p = text; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c != '"' && c != '\\' && c >= 0x20) continue;
+
+        hr_buf_append(buf, run, (size_t)(p - run));
+        switch (c) {
+            case '"': hr_buf_puts(buf, "\\\""); break;
+            case '\\': hr_buf_puts(buf, "\\\\"); break;
+            case '\n': hr_buf_puts(buf, "\\n"); break;
+            case '\r': hr_buf_puts(buf, "\\r"); break;
+            case '\t': hr_buf_puts(buf, "\\t"); break;
+            default: hr_buf_printf(buf, "\\u%04x", c); break;
+        }
+        run = p + 1;
+    }
+    hr_buf_append(buf, run, strlen(run));
+    hr_buf_append(buf, "\"", 1);
+}
+
+char* hr_ir_serialize_program(HRIR_Program* program) {
+    if (!program) return NULL;
+
+    HRIR_Buffer buf = {0};
+
+    hr_buf_puts(&buf, "{\n");
+    hr_buf_puts(&buf, "  \"source_name\": ");
+    hr_buf_json_string(&buf, program->source_name ? program->source_name : "");
+    hr_buf_puts(&buf, ",\n");
+    hr_buf_printf(&buf, "  \"cell_count\": %zu,\n", program->cell_count);
+    hr_buf_puts(&buf, "  \"cells\": [\n");
+
+    for (size_t i = 0; i < program->cell_count; i++) {
+        hr_buf_puts(&buf, "    {\n");
+        hr_buf_printf(&buf, "      \"id\": %u,\n", program->ids[i]);
+        hr_buf_puts(&buf, "      \"opcode\": ");
+        hr_buf_json_string(&buf, hr_ir_get_opcode_name(program, i));
+        hr_buf_puts(&buf, ",\n      \"args\": [");
+
+        for (size_t j = 0; j < program->arg_counts[i]; j++) {
+            if (j > 0) hr_buf_puts(&buf, ", ");
+            hr_buf_json_string(&buf, hr_ir_const_text(program,
+                               program->args[program->arg_offsets[i] + j]));
+        }
+
+        hr_buf_puts(&buf, "],\n");
+        hr_buf_printf(&buf, "      \"is_reversible\": %s\n",
+                      (program->flags[i] & HRIR_FLAG_REVERSIBLE) ? "true" : "false");
+        hr_buf_puts(&buf, "    }");
+
+        if (i < program->cell_count - 1) {
+            hr_buf_puts(&buf, ",");
+        }
+        hr_buf_puts(&buf, "\n");
+    }
+
+    hr_buf_puts(&buf, "  ]\n");
+    hr_buf_puts(&buf, "}\n");
+
+    if (buf.failed) {
+        free(buf.data);
+        return NULL;
+    }
+    return buf.data;
+}
+
+// =============================================================================
+// RUNTIME EXECUTION API
+// =============================================================================
+
+HRIR_Runtime* hr_ir_create_runtime(const HRIR_Program* program) {
+    if (!program) return NULL;
+
+    HRIR_Runtime* runtime = calloc(1, sizeof(HRIR_Runtime));
+    if (!runtime) return NULL;
+
+    runtime->program = program;
+    runtime->checkpoint = 0;
+    runtime->pc = 0;
+    hr_ir_tape_init(&runtime->tape);
+    runtime->exec_counts = NULL;
+    runtime->results = NULL;
+    runtime->cell_state_count = 0;
+    hr_ir_checkpoints_init(runtime);
+    runtime->replaying = false;
+    runtime->recomputing = false;
+    runtime->input_values = NULL;
+    runtime->input_positions = NULL;
+    runtime->input_count = 0;
+    runtime->input_capacity = 0;
+    runtime->recompute = NULL;
+    runtime->horizon = 0;
+    runtime->archive = NULL;
+    runtime->registers = NULL;
+    runtime->register_count = 0;
+    runtime->memory = NULL;
+    runtime->memory_size = 0;
+    runtime->shared = NULL;
+    runtime->steps_executed = 0;
+    runtime->rollbacks = 0;
+    runtime->profile = NULL;
+    runtime->peak_tape_bytes = 0;
+    runtime->error = HRIR_SUCCESS;
+    runtime->last_error = NULL;
+
+    return runtime;
+}
+
+static bool hr_ir_fail(HRIR_Runtime* runtime, HRIR_Error error, const char* message) {
+    runtime->error = error;
+    free((void*)runtime->last_error);
+    runtime->last_error = strdup(message);
+    return false;
+}
+
+// Cells may be appended after the runtime was created; grow registers to match
+static bool hr_ir_sync_registers(HRIR_Runtime* runtime) {
+    size_t needed = runtime->program->pool.register_count;
+    if (needed <= runtime->register_count) return true;
+    if (!hr_ir_own_state(runtime)) return false;
+
+    HRIR_Value* registers = realloc(runtime->registers, needed * sizeof(HRIR_Value));
+    if (!registers) return false;
+
+    for (size_t i = runtime->register_count; i < needed; i++) {
+        registers[i] = hr_ir_value_int(0);
+    }
+    runtime->registers = registers;
+    runtime->register_count = needed;
+    return true;
+}
+
+// Same for the per-cell execution state
+static bool hr_ir_sync_cells(HRIR_Runtime* runtime) {
+    size_t needed = runtime->program->cell_count;
+    if (needed <= runtime->cell_state_count) return true;
+
+    uint32_t* exec_counts = realloc(runtime->exec_counts, needed * sizeof(uint32_t));
+    if (!exec_counts) return false;
+    runtime->exec_counts = exec_counts;
+
+    HRIR_Value* results = realloc(runtime->results, needed * sizeof(HRIR_Value));
+    if (!results) return false;
+    runtime->results = results;
+
+    size_t added = needed - runtime->cell_state_count;
+    memset(exec_counts + runtime->cell_state_count, 0, added * sizeof(uint32_t));
+    memset(results + runtime->cell_state_count, 0, added * sizeof(HRIR_Value));
+    runtime->cell_state_count = needed;
+    return true;
+}
+
+bool hr_ir_ensure_memory(HRIR_Runtime* runtime, size_t address) {
+    if (address < runtime->memory_size) return true;
+
+    size_t new_size = runtime->memory_size ? runtime->memory_size : 64;
+    while (new_size <= address) new_size *= 2;
+    if (new_size > HRIR_MEMORY_LIMIT) new_size = HRIR_MEMORY_LIMIT;
+
+    HRIR_Value* memory = realloc(runtime->memory, new_size * sizeof(HRIR_Value));
+    if (!memory) return false;
+
+    memset(memory + runtime->memory_size, 0, (new_size - runtime->memory_size) * sizeof(HRIR_Value));
+    runtime->memory = memory;
+    runtime->memory_size = new_size;
+    return true;
+}
+
+// Resolve an argument to a value: literals are immediates, symbols read registers
+bool hr_ir_operand(HRIR_Runtime* runtime, uint32_t const_id, HRIR_Value* out) {
+    const HRIR_Const* entry = &runtime->program->pool.entries[const_id];
+
+    if (entry->kind == HRIR_CONST_NUMBER) {
+        *out = entry->value;
+    } else if (entry->kind == HRIR_CONST_SYMBOL) {
+        *out = runtime->registers[entry->reg];
+    } else {
+        return false;
+    }
+
+    if (out->type == HRIR_VALUE_NONE) {
+        *out = hr_ir_value_int(0);
+    }
+    return true;
+}
+
+// Destination register of argument `position`, defaulting to "result"
+bool hr_ir_destination(HRIR_Runtime* runtime, const uint32_t* args, size_t arg_count,
+                       size_t position, uint32_t* reg) {
+    if (position >= arg_count) {
+        *reg = HRIR_RESULT_REGISTER;
+        return true;
+    }
+
+    const HRIR_Const* entry = &runtime->program->pool.entries[args[position]];
+    if (entry->kind != HRIR_CONST_SYMBOL) return false;
 
-    HRIR_Cell* cell = calloc(1, sizeof(HRIR_Cell));
-    if (!cell) return NULL;
+    *reg = entry->reg;
+    return true;
+}
 
-    cell->opcode = strdup(opcode);
-    if (!cell->opcode) {
-        free(cell);
-        return NULL;
-    }
+bool hr_ir_is_true(HRIR_Value value) {
+    return value.type == HRIR_VALUE_FLOAT ? value.as.f != 0.0 : value.as.i != 0;
+}
 
-    cell->arg_count = arg_count;
-    if (arg_count > 0) {
-        cell->args = calloc(arg_count + 1, sizeof(char*)); // +1 for NULL terminator
-        if (!cell->args) {
-            free(cell->opcode);
-            free(cell);
-            return NULL;
-        }
+static double hr_ir_as_float(HRIR_Value value) {
+    return value.type == HRIR_VALUE_FLOAT ? value.as.f : (double)value.as.i;
+}
 
-        for (size_t i = 0; i < arg_count; i++) {
-            if (args[i]) {
-                cell->args[i] = strdup(args[i]);
-                if (!cell->args[i]) {
-                    // Cleanup on failure
-                    for (size_t j = 0; j < i; j++) {
-                        free(cell->args[j]);
-                    }
-                    free(cell->args);
-                    free(cell->opcode);
-                    free(cell);
-                    return NULL;
+// Integer arithmetic wraps; mixed operands promote to float
+static bool hr_ir_arithmetic(HRIR_Opcode op, HRIR_Value a, HRIR_Value b, HRIR_Value* out) {
+    if (a.type == HRIR_VALUE_INT && b.type == HRIR_VALUE_INT) {
+        uint64_t x = (uint64_t)a.as.i;
+        uint64_t y = (uint64_t)b.as.i;
+        switch (op) {
+            case HRIR_OPC_ADD: *out = hr_ir_value_int((int64_t)(x + y)); return true;
+            case HRIR_OPC_SUBTRACT: *out = hr_ir_value_int((int64_t)(x - y)); return true;
+            case HRIR_OPC_MULTIPLY: *out = hr_ir_value_int((int64_t)(x * y)); return true;
+            default:
+                if (b.as.i == 0) return false;
+                if (a.as.i == INT64_MIN && b.as.i == -1) {
+                    *out = hr_ir_value_int(INT64_MIN);
+                } else {
+                    *out = hr_ir_value_int(a.as.i / b.as.i);
                 }
-            }
+                return true;
         }
     }
 
-    cell->is_reversible = true; // Default to reversible
-    cell->executed = false;
-    cell->result = NULL;
-
-    return cell;
+    double x = hr_ir_as_float(a);
+    double y = hr_ir_as_float(b);
+    switch (op) {
+        case HRIR_OPC_ADD: *out = hr_ir_value_float(x + y); return true;
+        case HRIR_OPC_SUBTRACT: *out = hr_ir_value_float(x - y); return true;
+        case HRIR_OPC_MULTIPLY: *out = hr_ir_value_float(x * y); return true;
+        default:
+            if (y == 0.0) return false;
+            *out = hr_ir_value_float(x / y);
+            return true;
+    }
 }
 
-HRIR_Cell* hr_ir_create_inverse(HRIR_Cell* cell) {
-    if (!cell || !cell->is_reversible) return NULL;
-
-    // Create inverse based on operation
-    const char* inverse_opcode = NULL;
-    if (strcmp(cell->opcode, HRIR_OP_ADD) == 0) {
-        inverse_opcode = HRIR_OP_SUBTRACT;
-    } else if (strcmp(cell->opcode, HRIR_OP_SUBTRACT) == 0) {
-        inverse_opcode = HRIR_OP_ADD;
-    } else if (strcmp(cell->opcode, HRIR_OP_MULTIPLY) == 0) {
-        inverse_opcode = HRIR_OP_DIVIDE;
-    } else if (strcmp(cell->opcode, HRIR_OP_DIVIDE) == 0) {
-        inverse_opcode = HRIR_OP_MULTIPLY;
+static HRIR_Value hr_ir_compare(HRIR_Opcode op, HRIR_Value a, HRIR_Value b) {
+    int order;
+    if (a.type == HRIR_VALUE_INT && b.type == HRIR_VALUE_INT) {
+        order = (a.as.i > b.as.i) - (a.as.i < b.as.i);
     } else {
-        // For complex operations, return NULL (not invertible)
-        return NULL;
+        double x = hr_ir_as_float(a);
+        double y = hr_ir_as_float(b);
+        order = (x > y) - (x < y);
     }
 
-    return hr_ir_create_cell(inverse_opcode, cell->args, cell->arg_count);
+    switch (op) {
+        case HRIR_OPC_EQUAL: return hr_ir_value_int(order == 0);
+        case HRIR_OPC_LESS: return hr_ir_value_int(order < 0);
+        default: return hr_ir_value_int(order > 0);
+    }
 }
 
-void hr_ir_set_cell_meta(HRIR_Cell* cell, const char* source_location,
-                        uint32_t line_number, const char* canonical_path) {
-    if (!cell) return;
-
-    if (source_location) {
-        cell->source_location = strdup(source_location);
-    }
-    cell->line_number = line_number;
-    if (canonical_path) {
-        cell->canonical_path = strdup(canonical_path);
+bool hr_ir_eval_binary(HRIR_Opcode op, HRIR_Value a, HRIR_Value b, HRIR_Value* out) {
+    if (op >= HRIR_OPC_EQUAL) {
+        *out = hr_ir_compare(op, a, b);
+        return true;
     }
+    return hr_ir_arithmetic(op, a, b, out);
 }
 
-void hr_ir_free_cell(HRIR_Cell* cell) {
-    if (!cell) return;
+bool hr_ir_find_index(const HRIR_Program* program, uint32_t id, size_t* index) {
+    if (program->id_slots) {
+        size_t mask = program->id_slot_capacity - 1;
+        for (size_t slot = hr_ir_id_hash(id) & mask; program->id_slots[slot] != 0; slot = (slot + 1) & mask) {
+            size_t candidate = program->id_slots[slot] - 1;
+            if (program->ids[candidate] == id) {
+                *index = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
 
-    free((void*)cell->opcode);
-    if (cell->args) {
-        for (size_t i = 0; i < cell->arg_count; i++) {
-            free((void*)cell->args[i]);
+    // Ids increase with position so binary search works
+    size_t low = 0;
+    size_t high = program->cell_count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (program->ids[mid] < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
-        free(cell->args);
     }
 
-    free((void*)cell->source_location);
-    free((void*)cell->canonical_path);
+    if (low >= program->cell_count || program->ids[low] != id) return false;
+    *index = low;
+    return true;
+}
 
-    // Note: result cleanup depends on result type
-    if (cell->result) {
-        free(cell->result);
+// Jump targets are cell ids
+bool hr_ir_jump_target(const HRIR_Program* program, HRIR_Value target, size_t* index) {
+    if (target.type != HRIR_VALUE_INT || target.as.i <= 0 || target.as.i > UINT32_MAX) {
+        return false;
     }
+    return hr_ir_find_index(program, (uint32_t)target.as.i, index);
+}
 
-    if (cell->inverse) {
-        hr_ir_free_cell(cell->inverse);
+bool hr_ir_address(HRIR_Value value, uint32_t* address) {
+    if (value.type != HRIR_VALUE_INT || value.as.i < 0 || value.as.i >= HRIR_MEMORY_LIMIT) {
+        return false;
     }
+    *address = (uint32_t)value.as.i;
+    return true;
+}
 
-    free(cell);
+// Integer add/subtract into one of its own operands loses nothing: the old
+// value is recomputed from the result and the other operand on undo
+bool hr_ir_is_exact_update(HRIR_Runtime* runtime, HRIR_Opcode op, const uint32_t* args,
+                           uint32_t dest, HRIR_Value a, HRIR_Value b) {
+    if (op != HRIR_OPC_ADD && op != HRIR_OPC_SUBTRACT) return false;
+    if (a.type != HRIR_VALUE_INT || b.type != HRIR_VALUE_INT) return false;
+    if (runtime->registers[dest].type != HRIR_VALUE_INT) return false;
+
+    const HRIR_Const* first = &runtime->program->pool.entries[args[0]];
+    const HRIR_Const* second = &runtime->program->pool.entries[args[1]];
+    bool first_is_dest = first->kind == HRIR_CONST_SYMBOL && first->reg == dest;
+    bool second_is_dest = second->kind == HRIR_CONST_SYMBOL && second->reg == dest;
+    return first_is_dest != second_is_dest;
 }
 
-// =============================================================================
-// PROGRAM MANAGEMENT API
-// =============================================================================
+// Undo a record-less step; only exact add/subtract updates and in-place
+// integer vector updates change state
+static void hr_ir_invert_step(HRIR_Runtime* runtime, size_t index) {
+    const HRIR_Program* program = runtime->program;
+    HRIR_Opcode op = (HRIR_Opcode)program->opcodes[index];
+    if (op == HRIR_OPC_VADD || op == HRIR_OPC_VSUB || op == HRIR_OPC_VXOR) {
+        // Operands are registers and literals the step did not change
+        HRIR_Effect effect;
+        if (hr_ir_evaluate(runtime, index, &effect) && effect.slot_kind == HRIR_SLOT_RANGE) {
+            HRIR_Value* memory = runtime->memory;
+            hr_ir_vector_invert(op, memory + effect.slot, memory + effect.sources[0],
+                                memory + effect.sources[1], effect.count);
+        }
+        return;
+    }
+    if (op != HRIR_OPC_ADD && op != HRIR_OPC_SUBTRACT) return;
 
-HRIR_Program* hr_ir_create_program(const char* source_name) {
-    HRIR_Program* program = calloc(1, sizeof(HRIR_Program));
-    if (!program) return NULL;
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    uint32_t dest = HRIR_RESULT_REGISTER;
+    HRIR_Value other;
+    hr_ir_destination(runtime, args, program->arg_counts[index], 2, &dest);
 
-    program->cells = calloc(16, sizeof(HRIR_Cell*)); // Initial capacity 16
-    if (!program->cells) {
-        free(program);
-        return NULL;
+    HRIR_Value* target = &runtime->registers[dest];
+    uint64_t result = (uint64_t)target->as.i;
+    const HRIR_Const* first = &program->pool.entries[args[0]];
+
+    if (first->kind == HRIR_CONST_SYMBOL && first->reg == dest) {
+        hr_ir_operand(runtime, args[1], &other);
+        uint64_t y = (uint64_t)other.as.i;
+        target->as.i = (int64_t)(op == HRIR_OPC_ADD ? result - y : result + y);
+    } else {
+        hr_ir_operand(runtime, args[0], &other);
+        uint64_t x = (uint64_t)other.as.i;
+        target->as.i = (int64_t)(op == HRIR_OPC_ADD ? result - x : x - result);
     }
+}
 
-    program->capacity = 16;
-    program->cell_count = 0;
-    program->pc = 0;
-    program->tape = NULL;
-    program->tape_size = 0;
-    program->next_id = 1;
+static void hr_ir_print_cell(HRIR_Runtime* runtime, const uint32_t* args, size_t arg_count) {
+    for (size_t i = 0; i < arg_count; i++) {
+        const HRIR_Const* entry = &runtime->program->pool.entries[args[i]];
+        HRIR_Value value;
+
+        if (i > 0) printf(" ");
+        if (entry->kind == HRIR_CONST_SYMBOL && hr_ir_operand(runtime, args[i], &value)) {
+            if (value.type == HRIR_VALUE_FLOAT) {
+                printf("%g", value.as.f);
+            } else {
+                printf("%lld", (long long)value.as.i);
+            }
+        } else {
+            printf("%s", hr_ir_const_text(runtime->program, args[i]));
+        }
+    }
+    printf("\n");
+}
 
-    if (source_name) {
-        program->source_name = strdup(source_name);
+static bool hr_ir_read_value(HRIR_Value* out) {
+    char line[128];
+    if (!fgets(line, sizeof(line), stdin)) return false;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    HRIR_Const parsed = { .length = (uint32_t)strlen(line) };
+    hr_ir_classify(&parsed, line);
+    if (parsed.kind != HRIR_CONST_NUMBER) return false;
+
+    *out = parsed.value;
+    return true;
+}
+
+size_t hr_ir_input_index(const HRIR_Runtime* runtime, uint64_t position) {
+    size_t low = 0;
+    size_t high = runtime->input_count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (runtime->input_positions[mid] < position) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
     }
+    return low;
+}
 
-    return program;
+bool hr_ir_reserve_inputs(HRIR_Runtime* runtime, size_t count) {
+    if (count <= runtime->input_capacity) return true;
+
+    size_t new_capacity = runtime->input_capacity ? runtime->input_capacity * 2 : 16;
+    while (new_capacity < count) new_capacity *= 2;
+    HRIR_Value* values = realloc(runtime->input_values, new_capacity * sizeof(HRIR_Value));
+    if (!values) return false;
+    runtime->input_values = values;
+    uint64_t* positions = realloc(runtime->input_positions, new_capacity * sizeof(uint64_t));
+    if (!positions) return false;
+    runtime->input_positions = positions;
+    runtime->input_capacity = new_capacity;
+    return true;
 }
 
-bool hr_ir_add_cell(HRIR_Program* program, HRIR_Cell* cell) {
-    if (!program || !cell) return false;
+// Reads consume stdin once; replays reuse the value logged for that position
+// (hr_ir_rollback_to lays down the target branch's log before replaying)
+static bool hr_ir_read_input(HRIR_Runtime* runtime, HRIR_Value* out) {
+    uint64_t position = hr_ir_get_position(runtime);
+    size_t low = hr_ir_input_index(runtime, position);
 
-    // Expand capacity if needed
-    if (program->cell_count >= program->capacity) {
-        size_t new_capacity = program->capacity * 2;
-        HRIR_Cell** new_cells = realloc(program->cells, new_capacity * sizeof(HRIR_Cell*));
-        if (!new_cells) return false;
+    if (runtime->replaying) {
+        if (low >= runtime->input_count || runtime->input_positions[low] != position) return false;
+        *out = runtime->input_values[low];
+        return true;
+    }
+
+    if (!hr_ir_read_value(out)) return false;
+
+    // History from this position on is being rewritten
+    runtime->input_count = low;
+    if (!hr_ir_reserve_inputs(runtime, low + 1)) return false;
+    runtime->input_values[runtime->input_count] = *out;
+    runtime->input_positions[runtime->input_count] = position;
+    runtime->input_count++;
+    return true;
+}
+
+static bool hr_ir_reject(HRIR_Effect* effect, HRIR_Error error, const char* message) {
+    effect->error = error;
+    effect->message = message;
+    return false;
+}
 
-        program->cells = new_cells;
-        program->capacity = new_capacity;
+// Vector operands: `dst a b n`, `dst a factor n` (vscale) or `dest a n`
+// (vsum). Every range is grown into memory first, so kernels never check
+// bounds, and a destination range must be a source range or miss it.
+static bool hr_ir_evaluate_vector(HRIR_Runtime* runtime, HRIR_Opcode op, const uint32_t* args,
+                                  size_t arg_count, HRIR_Effect* effect) {
+    bool sum = op == HRIR_OPC_VSUM;
+    size_t length_arg = sum ? 2 : 3;
+    effect->factor = hr_ir_value_int(0);
+    HRIR_Value length;
+    if (arg_count <= length_arg || !hr_ir_operand(runtime, args[length_arg], &length) ||
+        length.type != HRIR_VALUE_INT || length.as.i < 0 || length.as.i > HRIR_MEMORY_LIMIT) {
+        return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Expected a vector length");
+    }
+    uint32_t count = (uint32_t)length.as.i;
+
+    // Destination (except vsum) then one or two sources
+    uint32_t starts[3];
+    size_t first = sum ? 1 : 0;
+    size_t last = op == HRIR_OPC_VSCALE || sum ? 1 : 2;
+    for (size_t i = first; i <= last; i++) {
+        HRIR_Value start;
+        uint32_t* address = &starts[i - first];
+        if (!hr_ir_operand(runtime, args[i], &start) || !hr_ir_address(start, address) ||
+            count > HRIR_MEMORY_LIMIT - *address) {
+            return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Vector range outside memory");
+        }
+        if (count > 0 && !hr_ir_ensure_memory(runtime, *address + count - 1)) {
+            return hr_ir_reject(effect, HRIR_ERROR_MEMORY_ALLOCATION, "Memory allocation failed");
+        }
     }
 
-    // Assign ID and add cell
-    cell->id = program->next_id++;
-    program->cells[program->cell_count++] = cell;
+    if (sum) {
+        if (!hr_ir_destination(runtime, args, arg_count, 0, &effect->slot)) {
+            return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Destination must be a register");
+        }
+        effect->value = count ? hr_ir_vector_sum(runtime->memory + starts[0], count) : hr_ir_value_int(0);
+        effect->slot_kind = HRIR_SLOT_REGISTER;
+        return true;
+    }
 
-    // Ensure reversible cells have an inverse available for validation/debugging
-    if (cell->is_reversible && cell->inverse == NULL) {
-        HRIR_Cell* inv = hr_ir_create_inverse(cell);
-        if (inv) {
-            cell->inverse = inv; // Note: inverse->inverse is not set to avoid recursion
+    if (op == HRIR_OPC_VSCALE) {
+        if (!hr_ir_operand(runtime, args[2], &effect->factor)) {
+            return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Expected a numeric factor");
+        }
+        starts[2] = starts[1];
+    }
+    for (size_t i = 1; i < 3; i++) {
+        if (starts[0] != starts[i] && starts[0] < starts[i] + count && starts[i] < starts[0] + count) {
+            return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Vector ranges overlap");
         }
     }
 
+    effect->slot = starts[0];
+    effect->sources[0] = starts[1];
+    effect->sources[1] = starts[2];
+    effect->count = count;
+    effect->value.type = HRIR_VALUE_NONE;
+    effect->slot_kind = count > 0 ? HRIR_SLOT_RANGE : HRIR_SLOT_NONE;
+
+    // In place over one operand: integer ranges are recomputed from the result
+    effect->exact = op != HRIR_OPC_VSCALE && (starts[0] == starts[1]) != (starts[0] == starts[2]);
     return true;
 }
 
-HRIR_Cell* hr_ir_get_cell_by_id(HRIR_Program* program, uint32_t id) {
-    if (!program) return NULL;
+bool hr_ir_evaluate(HRIR_Runtime* runtime, size_t index, HRIR_Effect* effect) {
+    const HRIR_Program* program = runtime->program;
+    HRIR_Opcode op = (HRIR_Opcode)program->opcodes[index];
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    size_t arg_count = program->arg_counts[index];
+    HRIR_Value a, b;
+
+    effect->slot_kind = HRIR_SLOT_NONE;
+    effect->slot = 0;
+    effect->exact = false;
+    effect->value = hr_ir_value_int(0);
+    effect->next_pc = index + 1;
+    effect->error = HRIR_SUCCESS;
+    effect->message = NULL;
+
+    switch (op) {
+        case HRIR_OPC_ADD:
+        case HRIR_OPC_SUBTRACT:
+        case HRIR_OPC_MULTIPLY:
+        case HRIR_OPC_DIVIDE:
+        case HRIR_OPC_EQUAL:
+        case HRIR_OPC_LESS:
+        case HRIR_OPC_GREATER:
+            if (arg_count < 2 || !hr_ir_operand(runtime, args[0], &a) ||
+                !hr_ir_operand(runtime, args[1], &b)) {
+                return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Expected two numeric operands");
+            }
+            if (!hr_ir_destination(runtime, args, arg_count, 2, &effect->slot)) {
+                return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Destination must be a register");
+            }
+            if (!hr_ir_eval_binary(op, a, b, &effect->value)) {
+                return hr_ir_reject(effect, HRIR_ERROR_EXECUTION_FAILED, "Division by zero");
+            }
+            effect->slot_kind = HRIR_SLOT_REGISTER;
+            effect->exact = hr_ir_is_exact_update(runtime, op, args, effect->slot, a, b);
+            break;
+
+        case HRIR_OPC_JUMP:
+        case HRIR_OPC_JUMP_IF: {
+            size_t target_arg = op == HRIR_OPC_JUMP ? 0 : 1;
+            if (arg_count <= target_arg) {
+                return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Missing jump target");
+            }
+            bool taken = true;
+            if (op == HRIR_OPC_JUMP_IF) {
+                if (!hr_ir_operand(runtime, args[0], &a)) {
+                    return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Condition must be numeric");
+                }
+                taken = hr_ir_is_true(a);
+            }
+            if (taken && (!hr_ir_operand(runtime, args[target_arg], &b) ||
+                          !hr_ir_jump_target(program, b, &effect->next_pc))) {
+                return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Jump target not found");
+            }
+            break;
+        }
 
-    for (size_t i = 0; i < program->cell_count; i++) {
-        if (program->cells[i]->id == id) {
-            return program->cells[i];
+        case HRIR_OPC_LOAD: {
+            uint32_t address;
+            if (arg_count < 2 || !hr_ir_destination(runtime, args, arg_count, 0, &effect->slot) ||
+                !hr_ir_operand(runtime, args[1], &a) || !hr_ir_address(a, &address)) {
+                return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Expected load dest address");
+            }
+            effect->value = address < runtime->memory_size ? runtime->memory[address] : hr_ir_value_int(0);
+            if (effect->value.type == HRIR_VALUE_NONE) effect->value = hr_ir_value_int(0);
+            effect->slot_kind = HRIR_SLOT_REGISTER;
+            break;
         }
+
+        case HRIR_OPC_STORE:
+            if (arg_count < 2 || !hr_ir_operand(runtime, args[0], &a) ||
+                !hr_ir_address(a, &effect->slot) || !hr_ir_operand(runtime, args[1], &effect->value)) {
+                return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Expected store address src");
+            }
+            if (!hr_ir_ensure_memory(runtime, effect->slot)) {
+                return hr_ir_reject(effect, HRIR_ERROR_MEMORY_ALLOCATION, "Memory allocation failed");
+            }
+            effect->slot_kind = HRIR_SLOT_MEMORY;
+            break;
+
+        case HRIR_OPC_PRINT:
+            if (!runtime->replaying) {
+                hr_ir_print_cell(runtime, args, arg_count);
+            }
+            break;
+
+        case HRIR_OPC_READ:
+            if (!hr_ir_destination(runtime, args, arg_count, 0, &effect->slot)) {
+                return hr_ir_reject(effect, HRIR_ERROR_INVALID_OPERATION, "Destination must be a register");
+            }
+            if (!hr_ir_read_input(runtime, &effect->value)) {
+                return hr_ir_reject(effect, HRIR_ERROR_EXECUTION_FAILED, "Expected a number on input");
+            }
+            effect->slot_kind = HRIR_SLOT_REGISTER;
+            break;
+
+        case HRIR_OPC_VADD:
+        case HRIR_OPC_VSUB:
+        case HRIR_OPC_VXOR:
+        case HRIR_OPC_VSCALE:
+        case HRIR_OPC_VSUM:
+            return hr_ir_evaluate_vector(runtime, op, args, arg_count, effect);
+
+        default:
+            break; // Custom opcodes carry no built-in semantics
     }
-    return NULL;
-}
 
-HRIR_Cell* hr_ir_get_cell(HRIR_Program* program, size_t index) {
-    if (!program || index >= program->cell_count) return NULL;
-    return program->cells[index];
+    return true;
 }
 
-void hr_ir_free_program(HRIR_Program* program) {
-    if (!program) return;
+bool hr_ir_prepare_store(HRIR_Runtime* runtime, size_t index) {
+    const HRIR_Program* program = runtime->program;
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    HRIR_Value a;
+    uint32_t address;
 
-    for (size_t i = 0; i < program->cell_count; i++) {
-        hr_ir_free_cell(program->cells[i]);
+    if (program->opcodes[index] != HRIR_OPC_STORE || program->arg_counts[index] < 2 ||
+        !hr_ir_operand(runtime, args[0], &a) || !hr_ir_address(a, &address)) {
+        return true; // Nothing to grow; evaluation reports malformed stores
     }
-    free(program->cells);
+    return hr_ir_ensure_memory(runtime, address);
+}
 
-    if (program->tape) {
-        for (size_t i = 0; i < program->tape_size; i++) {
-            free(program->tape[i]);
-        }
-        free(program->tape);
-    }
+HRIR_Value* hr_ir_effect_target(HRIR_Runtime* runtime, const HRIR_Effect* effect) {
+    if (effect->slot_kind == HRIR_SLOT_REGISTER) return &runtime->registers[effect->slot];
+    if (effect->slot_kind == HRIR_SLOT_MEMORY) return &runtime->memory[effect->slot];
+    return NULL;
+}
 
-    free((void*)program->source_name);
-    free(program);
+static void hr_ir_profile_step(HRIR_Runtime* runtime, size_t index, size_t tape_before) {
+    HRIR_OpcodeStats* entry = &runtime->profile[runtime->program->opcodes[index]];
+    entry->executions++;
+    if (runtime->tape.bytes > tape_before) entry->tape_bytes += runtime->tape.bytes - tape_before;
+    if (runtime->tape.bytes > runtime->peak_tape_bytes) runtime->peak_tape_bytes = runtime->tape.bytes;
 }
 
-// =============================================================================
-// SERIALIZATION API
-// =============================================================================
+static uint64_t hr_ir_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
 
-char* hr_ir_serialize_program(HRIR_Program* program) {
-    if (!program) return NULL;
+// Record the old value on the tape, unless the step can be inverted from the
+// state it leaves behind, and advance the runtime past the cell. The effect
+// has already been written to its target.
+bool hr_ir_commit_step(HRIR_Runtime* runtime, size_t index, const HRIR_Effect* effect, HRIR_Value old_value) {
+    bool has_target = effect->slot_kind != HRIR_SLOT_NONE;
+    size_t tape_before = runtime->tape.bytes;
+
+    if (effect->next_pc == index + 1 && (!has_target || effect->exact)) {
+        hr_ir_tape_skip(&runtime->tape);
+    } else if (!hr_ir_tape_record(&runtime->tape, index, effect->next_pc, effect->slot_kind,
+                                  effect->slot, old_value, effect->value)) {
+        return hr_ir_fail(runtime, HRIR_ERROR_MEMORY_ALLOCATION, "Tape allocation failed");
+    }
 
-    // Simple JSON serialization
-    size_t buffer_size = 4096;
-    char* json = calloc(1, buffer_size);
-    if (!json) return NULL;
+    return hr_ir_finish_step(runtime, index, effect, tape_before);
+}
 
-    size_t pos = 0;
-    pos += snprintf(json + pos, buffer_size - pos, "{\n");
-    pos += snprintf(json + pos, buffer_size - pos, "  \"source_name\": \"%s\",\n",
-                   program->source_name ? program->source_name : "");
-    pos += snprintf(json + pos, buffer_size - pos, "  \"cell_count\": %zu,\n", program->cell_count);
-    pos += snprintf(json + pos, buffer_size - pos, "  \"cells\": [\n");
+bool hr_ir_finish_step(HRIR_Runtime* runtime, size_t index, const HRIR_Effect* effect, size_t tape_before) {
+    bool has_target = effect->slot_kind != HRIR_SLOT_NONE;
 
-    for (size_t i = 0; i < program->cell_count; i++) {
-        HRIR_Cell* cell = program->cells[i];
-        pos += snprintf(json + pos, buffer_size - pos, "    {\n");
-        pos += snprintf(json + pos, buffer_size - pos, "      \"id\": %u,\n", cell->id);
-        pos += snprintf(json + pos, buffer_size - pos, "      \"opcode\": \"%s\",\n", cell->opcode);
-        pos += snprintf(json + pos, buffer_size - pos, "      \"args\": [");
+    if (!runtime->recomputing) {
+        runtime->exec_counts[index]++;
+        runtime->results[index] = has_target ? effect->value : (HRIR_Value){ .type = HRIR_VALUE_NONE };
+        if (runtime->profile) hr_ir_profile_step(runtime, index, tape_before);
+    }
 
-        for (size_t j = 0; j < cell->arg_count; j++) {
-            pos += snprintf(json + pos, buffer_size - pos, "\"%s\"", cell->args[j]);
-            if (j < cell->arg_count - 1) pos += snprintf(json + pos, buffer_size - pos, ", ");
-        }
+    runtime->steps_executed++;
+    runtime->pc = effect->next_pc;
 
-        pos += snprintf(json + pos, buffer_size - pos, "],\n");
-        pos += snprintf(json + pos, buffer_size - pos, "      \"is_reversible\": %s,\n",
-                       cell->is_reversible ? "true" : "false");
-        pos += snprintf(json + pos, buffer_size - pos, "      \"executed\": %s\n",
-                       cell->executed ? "true" : "false");
-        pos += snprintf(json + pos, buffer_size - pos, "    }");
+    if (runtime->recompute && !hr_ir_recompute_after_step(runtime)) {
+        // The step stands and stays on the tape, but execution stops here
+        return hr_ir_fail(runtime, HRIR_ERROR_MEMORY_ALLOCATION, "Memory budget cannot hold a snapshot");
+    }
+    return true;
+}
 
-        if (i < program->cell_count - 1) {
-            pos += snprintf(json + pos, buffer_size - pos, ",");
-        }
-        pos += snprintf(json + pos, buffer_size - pos, "\n");
+bool hr_ir_sync_runtime(HRIR_Runtime* runtime) {
+    if (hr_ir_own_state(runtime) && hr_ir_sync_registers(runtime) && hr_ir_sync_cells(runtime)) {
+        return true;
     }
+    return hr_ir_fail(runtime, HRIR_ERROR_MEMORY_ALLOCATION, "Register file allocation failed");
+}
 
-    pos += snprintf(json + pos, buffer_size - pos, "  ]\n");
-    pos += snprintf(json + pos, buffer_size - pos, "}\n");
+// A vector step over a memory range. An in-place integer update runs first
+// and, if every slot turned out to be an integer, needs no record; otherwise
+// the part already applied is inverted and the old range goes on the tape.
+static bool hr_ir_execute_range(HRIR_Runtime* runtime, size_t index, const HRIR_Effect* effect) {
+    HRIR_Opcode op = (HRIR_Opcode)runtime->program->opcodes[index];
+    HRIR_Value* dst = runtime->memory + effect->slot;
+    const HRIR_Value* a = runtime->memory + effect->sources[0];
+    const HRIR_Value* b = runtime->memory + effect->sources[1];
+    size_t tape_before = runtime->tape.bytes;
+
+    if (effect->exact) {
+        size_t applied = hr_ir_vector_apply(op, dst, a, b, effect->factor, effect->count, true);
+        if (applied == effect->count) {
+            hr_ir_tape_skip(&runtime->tape);
+            return hr_ir_finish_step(runtime, index, effect, tape_before);
+        }
+        hr_ir_vector_invert(op, dst, a, b, applied);
+    }
 
-    return json;
+    if (!hr_ir_tape_record_range(&runtime->tape, index, effect->next_pc, effect->slot, dst, effect->count)) {
+        return hr_ir_fail(runtime, HRIR_ERROR_MEMORY_ALLOCATION, "Tape allocation failed");
+    }
+    hr_ir_vector_apply(op, dst, a, b, effect->factor, effect->count, false);
+    return hr_ir_finish_step(runtime, index, effect, tape_before);
 }
 
-// =============================================================================
-// RUNTIME EXECUTION API
-// =============================================================================
+static bool hr_ir_execute_cell(HRIR_Runtime* runtime, size_t index) {
+    HRIR_Effect effect;
+    if (!hr_ir_evaluate(runtime, index, &effect)) {
+        return hr_ir_fail(runtime, effect.error, effect.message);
+    }
+    if (effect.slot_kind == HRIR_SLOT_RANGE) return hr_ir_execute_range(runtime, index, &effect);
 
-HRIR_Runtime* hr_ir_create_runtime(HRIR_Program* program) {
-    if (!program) return NULL;
+    HRIR_Value* target = hr_ir_effect_target(runtime, &effect);
+    HRIR_Value old_value = target ? *target : effect.value;
+    if (target) *target = effect.value;
 
-    HRIR_Runtime* runtime = calloc(1, sizeof(HRIR_Runtime));
-    if (!runtime) return NULL;
+    if (!hr_ir_commit_step(runtime, index, &effect, old_value)) {
+        if (target) *target = old_value;
+        return false;
+    }
+    return true;
+}
 
-    runtime->program = program;
-    runtime->checkpoint = 0;
-    runtime->steps_executed = 0;
-    runtime->rollbacks = 0;
-    runtime->last_error = NULL;
+bool hr_ir_execute(HRIR_Runtime* runtime, size_t index) {
+    if (!runtime->profile) return hr_ir_execute_cell(runtime, index);
 
-    return runtime;
+    // A failing step is timed too; it is not counted as an execution
+    uint64_t start = hr_ir_now_ns();
+    bool ok = hr_ir_execute_cell(runtime, index);
+    runtime->profile[runtime->program->opcodes[index]].nanoseconds += hr_ir_now_ns() - start;
+    return ok;
 }
 
 bool hr_ir_step(HRIR_Runtime* runtime) {
     if (!runtime || !runtime->program) return false;
 
-    if (runtime->program->pc >= runtime->program->cell_count) {
+    if (runtime->pc >= runtime->program->cell_count) {
         return false; // Program complete
     }
 
-    HRIR_Cell* cell = runtime->program->cells[runtime->program->pc];
-
-    // Simple execution simulation
-    // In a real implementation, this would execute the actual operation
-    cell->executed = true;
-    cell->result = strdup("executed"); // Placeholder result
+    if (!hr_ir_sync_runtime(runtime)) return false;
 
-    runtime->steps_executed++;
-    runtime->program->pc++;
-
-    return true;
+    return hr_ir_execute(runtime, runtime->pc);
 }
 
 bool hr_ir_run(HRIR_Runtime* runtime) {
-    if (!runtime) return false;
+    if (!runtime || !runtime->program) return false;
 
-    while (hr_ir_step(runtime)) {
-        // Continue until completion or error
+    // Fused heads take their whole group per dispatch
+    const HRIR_Program* program = runtime->program;
+    while (runtime->pc < program->cell_count) {
+        bool fused = (program->flags[runtime->pc] & HRIR_FLAG_FUSED_MASK) != 0;
+        if (!(fused ? hr_ir_step_fused(runtime) : hr_ir_step(runtime))) break;
     }
 
-    return runtime->program->pc >= runtime->program->cell_count;
+    return runtime->pc >= program->cell_count;
 }
 
 bool hr_ir_undo(HRIR_Runtime* runtime) {
-    if (!runtime || !runtime->program || runtime->program->pc == 0) {
+    if (!runtime || !runtime->program || hr_ir_get_position(runtime) == 0) {
         return false;
     }
+    if (!hr_ir_own_state(runtime)) return false;
 
-    runtime->program->pc--;
-    HRIR_Cell* cell = runtime->program->cells[runtime->program->pc];
+    if (runtime->tape.steps == 0) {
+        // Tape before this point was dropped for a memory budget
+        return runtime->recompute && hr_ir_recompute_undo(runtime);
+    }
 
-    // Undo execution
-    cell->executed = false;
-    if (cell->result) {
-        free(cell->result);
-        cell->result = NULL;
+    size_t pc_before;
+
+    // Restore the overwritten slot
+    HRIR_TapeUndo undone = hr_ir_tape_undo(&runtime->tape, runtime->pc, runtime->registers,
+                                           runtime->memory, &pc_before);
+    if (undone == HRIR_TAPE_EMPTY) return false;
+    if (undone == HRIR_TAPE_FAILED) {
+        return hr_ir_fail(runtime, HRIR_ERROR_MEMORY_ALLOCATION, "Tape allocation failed");
+    }
+    if (undone == HRIR_TAPE_IMPLICIT) {
+        hr_ir_invert_step(runtime, pc_before);
     }
+    runtime->pc = pc_before;
+    hr_ir_checkpoints_retreat(runtime);
+
+    // Undo execution
+    hr_ir_cell_undone(runtime, runtime->pc);
 
     runtime->steps_executed--;
     runtime->rollbacks++;
@@ -345,36 +1822,104 @@ bool hr_ir_undo(HRIR_Runtime* runtime) {
     return true;
 }
 
-bool hr_ir_checkpoint(HRIR_Runtime* runtime) {
-    if (!runtime) return false;
+void hr_ir_cell_undone(HRIR_Runtime* runtime, size_t index) {
+    if (index >= runtime->cell_state_count || runtime->exec_counts[index] == 0) return;
 
-    runtime->checkpoint = runtime->program->pc;
-    return true;
+    runtime->exec_counts[index]--;
+    runtime->results[index].type = HRIR_VALUE_NONE;
+    if (runtime->profile) runtime->profile[runtime->program->opcodes[index]].undos++;
 }
 
-bool hr_ir_rollback(HRIR_Runtime* runtime) {
-    if (!runtime) return false;
+bool hr_ir_cell_executed(HRIR_Runtime* runtime, size_t index) {
+    return runtime && index < runtime->cell_state_count && runtime->exec_counts[index] > 0;
+}
 
-    while (runtime->program->pc > runtime->checkpoint) {
-        if (!hr_ir_undo(runtime)) return false;
-    }
+HRIR_Value hr_ir_cell_result(HRIR_Runtime* runtime, size_t index) {
+    HRIR_Value none = { .type = HRIR_VALUE_NONE };
+    if (!runtime || index >= runtime->cell_state_count) return none;
+    return runtime->results[index];
+}
 
-    return true;
+uint64_t hr_ir_get_position(HRIR_Runtime* runtime) {
+    if (!runtime) return 0;
+    return runtime->tape.base + runtime->tape.steps;
 }
 
 size_t hr_ir_get_pc(HRIR_Runtime* runtime) {
-    return runtime && runtime->program ? runtime->program->pc : 0;
+    return runtime ? runtime->pc : 0;
 }
 
 bool hr_ir_is_complete(HRIR_Runtime* runtime) {
-    return runtime && runtime->program &&
-           runtime->program->pc >= runtime->program->cell_count;
+    return runtime && runtime->program && runtime->pc >= runtime->program->cell_count;
+}
+
+HRIR_Value hr_ir_value_int(int64_t i) {
+    HRIR_Value value;
+    value.type = HRIR_VALUE_INT;
+    value.as.i = i;
+    return value;
+}
+
+HRIR_Value hr_ir_value_float(double f) {
+    HRIR_Value value;
+    value.type = HRIR_VALUE_FLOAT;
+    value.as.f = f;
+    return value;
+}
+
+// Register slot of a named symbol, or -1 if the program never mentions it
+static long hr_ir_register_of(HRIR_Runtime* runtime, const char* name) {
+    if (!name || !hr_ir_sync_registers(runtime)) return -1;
+
+    uint32_t id = hr_ir_find_const(runtime->program, name, strlen(name));
+    if (id == HRIR_NO_CONST || runtime->program->pool.entries[id].kind != HRIR_CONST_SYMBOL) {
+        return -1;
+    }
+    return (long)runtime->program->pool.entries[id].reg;
+}
+
+HRIR_Value hr_ir_get_register(HRIR_Runtime* runtime, const char* name) {
+    HRIR_Value none = { .type = HRIR_VALUE_NONE };
+    if (!runtime) return none;
+
+    long reg = hr_ir_register_of(runtime, name);
+    return reg < 0 ? none : runtime->registers[reg];
+}
+
+bool hr_ir_set_register(HRIR_Runtime* runtime, const char* name, HRIR_Value value) {
+    if (!runtime) return false;
+
+    long reg = hr_ir_register_of(runtime, name);
+    if (reg < 0 || !hr_ir_own_state(runtime)) return false;
+
+    runtime->registers[reg] = value;
+    return true;
+}
+
+HRIR_Value hr_ir_get_memory(HRIR_Runtime* runtime, size_t address) {
+    if (!runtime || address >= runtime->memory_size ||
+        runtime->memory[address].type == HRIR_VALUE_NONE) {
+        return hr_ir_value_int(0);
+    }
+    return runtime->memory[address];
 }
 
 void hr_ir_free_runtime(HRIR_Runtime* runtime) {
     if (!runtime) return;
 
     // Note: program is owned by caller, don't free here
+    hr_ir_release_state(runtime);
+    hr_ir_checkpoints_free(runtime);
+    hr_ir_recompute_free(runtime);
+    hr_ir_tape_free(&runtime->tape);
+    if (runtime->archive) fclose(runtime->archive);
+    free(runtime->exec_counts);
+    free(runtime->results);
+    free(runtime->input_values);
+    free(runtime->input_positions);
+    free(runtime->registers);
+    free(runtime->memory);
+    free(runtime->profile);
     free((void*)runtime->last_error);
     free(runtime);
 }
@@ -414,7 +1959,7 @@ HRIR_Cell* hr_ir_from_d_term_operation(const char* operation,
 // DEBUGGING & INSPECTION API
 // =============================================================================
 
-HRIR_Stats hr_ir_get_stats(HRIR_Program* program) {
+HRIR_Stats hr_ir_get_stats(const HRIR_Program* program) {
     HRIR_Stats stats = {0};
 
     if (!program) return stats;
@@ -422,21 +1967,114 @@ HRIR_Stats hr_ir_get_stats(HRIR_Program* program) {
     stats.total_cells = program->cell_count;
 
     for (size_t i = 0; i < program->cell_count; i++) {
-        HRIR_Cell* cell = program->cells[i];
-        if (cell->is_reversible) {
+        if (program->flags[i] & HRIR_FLAG_REVERSIBLE) {
             stats.r_term_cells++;
         } else {
             stats.d_term_cells++;
         }
-        if (cell->executed) {
+    }
+
+    return stats;
+}
+
+HRIR_Stats hr_ir_get_runtime_stats(HRIR_Runtime* runtime) {
+    HRIR_Stats stats = {0};
+    if (!runtime) return stats;
+
+    stats = hr_ir_get_stats(runtime->program);
+    for (size_t i = 0; i < runtime->cell_state_count; i++) {
+        if (runtime->exec_counts[i] > 0) {
             stats.executed_cells++;
         }
     }
+    stats.checkpoint_count = runtime->checkpoint_count;
+    stats.tape_bytes = runtime->tape.bytes;
+    stats.tape_chunks = runtime->tape.chunk_count;
+
+    if (runtime->profile) {
+        stats.profiled = true;
+        stats.peak_tape_bytes = runtime->peak_tape_bytes;
+        memcpy(stats.opcodes, runtime->profile, sizeof(stats.opcodes));
+    }
+    if (stats.peak_tape_bytes < stats.tape_bytes) stats.peak_tape_bytes = stats.tape_bytes;
 
     return stats;
 }
 
-void hr_ir_dump_program(HRIR_Program* program) {
+bool hr_ir_set_profiling(HRIR_Runtime* runtime, bool enabled) {
+    if (!runtime) return false;
+
+    if (!enabled) {
+        free(runtime->profile);
+        runtime->profile = NULL;
+        return true;
+    }
+    if (!runtime->profile) {
+        runtime->profile = calloc(HRIR_OPC_COUNT, sizeof(HRIR_OpcodeStats));
+        if (!runtime->profile) return false;
+        runtime->peak_tape_bytes = runtime->tape.bytes;
+    }
+    return true;
+}
+
+char* hr_ir_stats_to_json(const HRIR_Stats* stats) {
+    if (!stats) return NULL;
+
+    HRIR_Buffer buf = {0};
+
+    hr_buf_puts(&buf, "{\n");
+    hr_buf_printf(&buf, "  \"total_cells\": %zu,\n", stats->total_cells);
+    hr_buf_printf(&buf, "  \"r_term_cells\": %zu,\n", stats->r_term_cells);
+    hr_buf_printf(&buf, "  \"d_term_cells\": %zu,\n", stats->d_term_cells);
+    hr_buf_printf(&buf, "  \"executed_cells\": %zu,\n", stats->executed_cells);
+    hr_buf_printf(&buf, "  \"checkpoint_count\": %zu,\n", stats->checkpoint_count);
+    hr_buf_printf(&buf, "  \"tape_bytes\": %zu,\n", stats->tape_bytes);
+    hr_buf_printf(&buf, "  \"tape_chunks\": %zu,\n", stats->tape_chunks);
+    hr_buf_printf(&buf, "  \"peak_tape_bytes\": %zu,\n", stats->peak_tape_bytes);
+    hr_buf_printf(&buf, "  \"profiled\": %s,\n", stats->profiled ? "true" : "false");
+    hr_buf_puts(&buf, "  \"opcodes\": {");
+
+    bool first = true;
+    for (size_t op = 0; op < HRIR_OPC_COUNT; op++) {
+        const HRIR_OpcodeStats* entry = &stats->opcodes[op];
+        if (entry->executions == 0 && entry->undos == 0 && entry->nanoseconds == 0) continue;
+
+        hr_buf_puts(&buf, first ? "\n    " : ",\n    ");
+        hr_buf_json_string(&buf, hr_ir_opcode_names[op]);
+        hr_buf_printf(&buf, ": {\"executions\": %llu, \"undos\": %llu, ",
+                      (unsigned long long)entry->executions, (unsigned long long)entry->undos);
+        hr_buf_printf(&buf, "\"nanoseconds\": %llu, \"tape_bytes\": %llu}",
+                      (unsigned long long)entry->nanoseconds, (unsigned long long)entry->tape_bytes);
+        first = false;
+    }
+
+    hr_buf_puts(&buf, first ? "}\n" : "\n  }\n");
+    hr_buf_puts(&buf, "}\n");
+
+    if (buf.failed) {
+        free(buf.data);
+        return NULL;
+    }
+    return buf.data;
+}
+
+// Listing of a program, with execution status when a runtime is given
+static void hr_ir_dump_cells(const HRIR_Program* program, HRIR_Runtime* runtime) {
+    for (size_t i = 0; i < program->cell_count; i++) {
+        printf("  [%zu] %s(", i, hr_ir_get_opcode_name(program, i));
+        for (size_t j = 0; j < program->arg_counts[i]; j++) {
+            printf("%s", hr_ir_const_text(program, program->args[program->arg_offsets[i] + j]));
+            if (j < (size_t)program->arg_counts[i] - 1) printf(", ");
+        }
+        printf(") %s", (program->flags[i] & HRIR_FLAG_REVERSIBLE) ? "[R]" : "[D]");
+        if (runtime) {
+            printf(" %s", hr_ir_cell_executed(runtime, i) ? "[EXEC]" : "[PENDING]");
+        }
+        printf("\n");
+    }
+}
+
+void hr_ir_dump_program(const HRIR_Program* program) {
     if (!program) {
         printf("HRIR Program: NULL\n");
         return;
@@ -444,19 +2082,7 @@ void hr_ir_dump_program(HRIR_Program* program) {
 
     printf("HRIR Program: %s\n", program->source_name ? program->source_name : "<unnamed>");
     printf("  Cells: %zu\n", program->cell_count);
-    printf("  PC: %zu\n", program->pc);
-
-    for (size_t i = 0; i < program->cell_count; i++) {
-        HRIR_Cell* cell = program->cells[i];
-        printf("  [%zu] %s(", i, cell->opcode);
-        for (size_t j = 0; j < cell->arg_count; j++) {
-            printf("%s", cell->args[j]);
-            if (j < cell->arg_count - 1) printf(", ");
-        }
-        printf(") %s %s\n",
-               cell->is_reversible ? "[R]" : "[D]",
-               cell->executed ? "[EXEC]" : "[PENDING]");
-    }
+    hr_ir_dump_cells(program, NULL);
 }
 
 void hr_ir_dump_runtime(HRIR_Runtime* runtime) {
@@ -469,9 +2095,26 @@ void hr_ir_dump_runtime(HRIR_Runtime* runtime) {
     printf("  Steps executed: %zu\n", runtime->steps_executed);
     printf("  Rollbacks: %zu\n", runtime->rollbacks);
     printf("  Checkpoint: %zu\n", runtime->checkpoint);
+    printf("  PC: %zu\n", runtime->pc);
+    {
+        const HRIR_Tape* tape = &runtime->tape;
+        printf("  Tape: %llu steps, %llu records, %zu bytes in %zu chunks\n",
+               (unsigned long long)tape->steps, (unsigned long long)tape->records,
+               tape->bytes, tape->chunk_count);
+    }
+
+    HRIR_Value result = hr_ir_get_register(runtime, "result");
+    if (result.type == HRIR_VALUE_FLOAT) {
+        printf("  Result: %g\n", result.as.f);
+    } else if (result.type == HRIR_VALUE_INT) {
+        printf("  Result: %lld\n", (long long)result.as.i);
+    }
 
     if (runtime->program) {
-        hr_ir_dump_program(runtime->program);
+        const HRIR_Program* program = runtime->program;
+        printf("HRIR Program: %s\n", program->source_name ? program->source_name : "<unnamed>");
+        printf("  Cells: %zu\n", program->cell_count);
+        hr_ir_dump_cells(program, runtime);
     }
 }
 
@@ -480,8 +2123,7 @@ void hr_ir_dump_runtime(HRIR_Runtime* runtime) {
 // =============================================================================
 
 HRIR_Error hr_ir_get_last_error(HRIR_Runtime* runtime) {
-    // Simplified - no error tracking implemented yet
-    return HRIR_SUCCESS;
+    return runtime ? runtime->error : HRIR_ERROR_INVALID_PROGRAM;
 }
 
 const char* hr_ir_get_error_message(HRIR_Error error) {
@@ -7,6 +7,7 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 // =============================================================================
 // L1 HRIR - HOMOICONIC REVERSIBLE IR
@@ -28,37 +29,304 @@ typedef struct HRIR_Cell {
     uint32_t line_number;     // Line in source
     const char* canonical_path; // Proto.Actor.Func path
 
-    // Execution state
+    // Caller-owned state; runtimes track execution in HRIR_Runtime instead
     bool executed;            // Has this cell been executed?
     void* result;            // Execution result (if any)
+
+    // Program arena holding this cell and its strings, NULL = heap allocated
+    struct HRIR_Arena* arena;
 } HRIR_Cell;
 
-// HRIR Program - Array of cells representing the program
+// =============================================================================
+// COMPACT PROGRAM ENCODING
+// =============================================================================
+
+// Built-in opcodes; anything else is encoded as HRIR_OPC_CUSTOM
+typedef enum {
+    HRIR_OPC_ADD = 0,
+    HRIR_OPC_SUBTRACT,
+    HRIR_OPC_MULTIPLY,
+    HRIR_OPC_DIVIDE,
+    HRIR_OPC_EQUAL,
+    HRIR_OPC_LESS,
+    HRIR_OPC_GREATER,
+    HRIR_OPC_JUMP,
+    HRIR_OPC_JUMP_IF,
+    HRIR_OPC_PRINT,
+    HRIR_OPC_READ,
+    HRIR_OPC_STORE,
+    HRIR_OPC_LOAD,
+    HRIR_OPC_CUSTOM,          // Opcode name kept in cold metadata
+    HRIR_OPC_VADD,            // Vector opcodes follow custom so stored images keep their values
+    HRIR_OPC_VSUB,
+    HRIR_OPC_VXOR,
+    HRIR_OPC_VSCALE,
+    HRIR_OPC_VSUM,
+    HRIR_OPC_COUNT
+} HRIR_Opcode;
+
+// Typed scalar value (pre-parsed literals)
+typedef enum {
+    HRIR_VALUE_NONE = 0,
+    HRIR_VALUE_INT,
+    HRIR_VALUE_FLOAT
+} HRIR_ValueType;
+
+typedef struct {
+    uint8_t type;             // HRIR_ValueType
+    union {
+        int64_t i;
+        double f;
+    } as;
+} HRIR_Value;
+
+// Constant pool entry kinds
+typedef enum {
+    HRIR_CONST_NUMBER = 0,    // Numeric literal ("5", "2.5")
+    HRIR_CONST_SYMBOL,        // Identifier ("result", "x"), owns a register
+    HRIR_CONST_STRING         // Anything else ("Hello from HRIR!")
+} HRIR_ConstKind;
+
+typedef struct {
+    uint32_t offset;          // Text offset in pool bytes (NUL-terminated)
+    uint32_t length;          // Text length
+    uint32_t hash;            // FNV-1a of text
+    uint32_t reg;             // Register slot (symbols only)
+    uint8_t kind;             // HRIR_ConstKind
+    HRIR_Value value;         // Pre-parsed literal (numbers only)
+} HRIR_Const;
+
+// Program-wide interned constant/argument pool
+typedef struct {
+    char* bytes;              // Concatenated NUL-terminated texts
+    size_t bytes_size;
+    size_t bytes_capacity;
+    HRIR_Const* entries;      // Indexed by const id
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t* slots;          // Open-addressed table of const id + 1 (0 = empty)
+    uint32_t slot_capacity;   // Power of two
+    uint32_t register_count;  // Distinct symbols seen
+} HRIR_ConstPool;
+
+#define HRIR_NO_CONST UINT32_MAX
+#define HRIR_RESULT_REGISTER 0  // "result" is always the first symbol interned
+
+// Cold per-cell metadata, kept out of the hot arrays
+typedef struct {
+    uint32_t source_location; // Const id or HRIR_NO_CONST
+    uint32_t canonical_path;  // Const id or HRIR_NO_CONST
+    uint32_t opcode_name;     // Const id of the name for HRIR_OPC_CUSTOM
+    uint32_t line_number;
+} HRIR_CellMeta;
+
+// Argument runs shared between cells (hr_ir_set_hash_consing). Only the runs
+// in args[] are shared; each position keeps its own opcode, flags, offset and
+// count in the per-cell arrays.
+typedef struct {
+    uint64_t* slots;          // Open-addressed (offset << 16 | count), 0 = empty
+    uint32_t capacity;        // Power of two; 0 = hash-consing off
+    uint32_t count;           // Distinct runs in the table
+    size_t shared_cells;      // Cells that reuse a stored run
+    size_t saved_slots;       // Argument slots those cells did not store
+} HRIR_BodyTable;
+
+// Per-cell flags
+#define HRIR_FLAG_REVERSIBLE 0x01
+#define HRIR_FLAG_FUSED_SHIFT 1
+#define HRIR_FLAG_FUSED_MASK 0x0E    // HRIR_Superinstruction of a fused head
+
+// Undo tape: a chain of fixed-size chunks holding delta-encoded step records.
+// Fall-through steps that are exactly invertible from the resulting state
+// (no-ops, integer add/subtract into one of their own operands) write no
+// record; the rest store the overwritten value as a difference (integers) or
+// XOR (floats) against the new value, varint packed.
+#define HRIR_TAPE_CHUNK_SIZE (64 * 1024)
+
+typedef struct HRIR_TapeChunk {
+    struct HRIR_TapeChunk* prev;  // Older chunk
+    size_t used;                  // Bytes in use
+    uint32_t refs;                // Tapes and newer chunks holding it; shared when > 1
+    uint8_t bytes[];              // HRIR_TAPE_CHUNK_SIZE bytes
+} HRIR_TapeChunk;
+
+typedef struct {
+    HRIR_TapeChunk* head;    // Newest chunk
+    HRIR_TapeChunk* spare;   // Retired empty chunk, reused at the next boundary
+    size_t chunk_count;
+    uint64_t base;           // Steps dropped from the front (bounded-memory mode)
+    uint64_t steps;          // Undoable steps, with or without a record
+    uint64_t records;        // Records stored
+    uint64_t implicit;       // Record-less steps since the newest record
+    size_t bytes;            // Encoded bytes in use
+} HRIR_Tape;
+
+// Tape archive segment header. hr_ir_commit appends one segment per call: this
+// header followed by `bytes` bytes of records, oldest first, in the layout
+// described in hr_ir_tape.c (walk them backwards by the trailing length byte).
+#define HRIR_TAPE_SEGMENT_MAGIC 0x54495248u  // "HRIT"
+#define HRIR_TAPE_SEGMENT_VERSION 1
+
+typedef struct {
+    uint32_t magic;          // HRIR_TAPE_SEGMENT_MAGIC
+    uint32_t version;        // HRIR_TAPE_SEGMENT_VERSION
+    uint64_t position;       // History position of the segment's first step
+    uint64_t steps;          // Steps covered, with or without a record
+    uint64_t records;        // Records that follow
+    uint64_t implicit;       // Record-less steps after the newest record
+    uint64_t bytes;          // Record bytes that follow
+} HRIR_TapeSegment;
+
+// Bump arena: allocations are never freed one by one, the chunks are
+// released together when the owning program is freed
+typedef struct HRIR_ArenaChunk {
+    struct HRIR_ArenaChunk* prev; // Older chunk
+    size_t used;                  // Bytes in use
+    size_t size;                  // Bytes available
+    unsigned char bytes[];
+} HRIR_ArenaChunk;
+
+typedef struct HRIR_Arena {
+    HRIR_ArenaChunk* head;   // Newest chunk, the only one allocated from
+    size_t chunk_count;
+    size_t bytes_used;
+} HRIR_Arena;
+
+// HRIR Program - Cells stored as parallel arrays over a shared constant pool.
+// A program holds no execution state: once built, any number of runtimes
+// (on any threads) may execute it concurrently. Building it and the lazy
+// hr_ir_get_cell views are single-threaded.
 typedef struct HRIR_Program {
-    HRIR_Cell** cells;       // Array of cells
+    // Hot per-cell arrays, indexed by cell position
+    uint8_t* opcodes;        // HRIR_Opcode
+    uint8_t* flags;          // HRIR_FLAG_*
+    uint32_t* ids;           // Stable cell ids
+    uint32_t* arg_offsets;   // First slot in args[]
+    uint16_t* arg_counts;    // Number of arguments
+    HRIR_CellMeta* meta;     // Cold metadata (source mapping)
     size_t cell_count;       // Number of cells
     size_t capacity;         // Allocated capacity
 
-    // Execution state
-    size_t pc;              // Program counter
-    void** tape;            // Reversible execution tape
-    size_t tape_size;       // Tape size
+    // Argument slots (const ids) and the constant pool they index
+    uint32_t* args;
+    size_t arg_count;
+    size_t arg_capacity;
+    HRIR_ConstPool pool;
+    HRIR_BodyTable bodies;   // Hash-consed argument runs (off unless enabled)
+
+    // Accessor views, materialized on demand by hr_ir_get_cell into the arena.
+    // Cells handed over by hr_ir_add_cell stay on the heap and are counted in
+    // heap_cells; only then does freeing the program walk the views.
+    HRIR_Cell** cells;
+    HRIR_Arena arena;
+    size_t heap_cells;
+
+    // Binary image (hr_ir_load_binary) that the arrays above point into while
+    // the program is unchanged; the first growth copies them to the heap.
+    void* image;
+    size_t image_size;
+    bool image_mapped;       // mmap'ed rather than read into one heap block
+
+    // Cell lookup by id: open-addressed table of position + 1 (0 = empty),
+    // kept up to date on append. NULL (binary images, failed growth) falls
+    // back to a binary search over ids.
+    uint32_t* id_slots;
+    size_t id_slot_capacity; // Power of two
 
     // Metadata
     const char* source_name; // Original source filename
     uint32_t next_id;       // Next cell ID to assign
 } HRIR_Program;
 
-// HRIR Runtime - Execution environment
+// Error codes
+typedef enum {
+    HRIR_SUCCESS = 0,
+    HRIR_ERROR_INVALID_CELL,
+    HRIR_ERROR_INVALID_PROGRAM,
+    HRIR_ERROR_EXECUTION_FAILED,
+    HRIR_ERROR_MEMORY_ALLOCATION,
+    HRIR_ERROR_INVALID_OPERATION,
+    HRIR_ERROR_IRREVERSIBLE_OPERATION,
+    HRIR_ERROR_CHECKPOINT_NOT_FOUND
+} HRIR_Error;
+
+#define HRIR_MEMORY_LIMIT (1u << 24)  // Highest addressable memory cell + 1
+
+// Checkpoint - Bookmarked tape position; checkpoints form a tree where each
+// one's parent is the checkpoint it was created after on the same path
+typedef struct {
+    const char* name;        // NULL for anonymous checkpoints
+    uint64_t position;       // Tape step count
+    size_t pc;               // Program counter when created
+    int parent;              // Parent checkpoint id (-1 = execution start)
+    uint32_t depth;          // Number of ancestors
+    bool fingerprinted;      // Created with hr_ir_set_checkpoint_verification on
+    uint64_t fingerprint;    // Hash of registers and memory when created
+    HRIR_Value* inputs;      // Values read since the parent checkpoint, so
+    uint64_t* input_positions; // replaying this branch reads its own input
+    size_t input_count;
+} HRIR_Checkpoint;
+
+// Per-opcode profile of a runtime, collected while hr_ir_set_profiling is on
+typedef struct {
+    uint64_t executions;
+    uint64_t undos;
+    uint64_t nanoseconds;    // Wall time evaluating and committing its steps
+    uint64_t tape_bytes;     // Tape bytes written by its steps
+} HRIR_OpcodeStats;
+
+// HRIR Runtime - Execution environment; owns all per-run state
 typedef struct HRIR_Runtime {
-    HRIR_Program* program;   // Current program
-    size_t checkpoint;       // Last checkpoint position
+    const HRIR_Program* program; // Shared, never written by the runtime
+    size_t checkpoint;       // Tape step count at last checkpoint
+
+    // Execution state
+    size_t pc;               // Program counter
+    HRIR_Tape tape;          // Reversible execution tape
+    uint32_t* exec_counts;   // Per cell: steps of this cell in the current history
+    HRIR_Value* results;     // Per cell: value written by its latest step (NONE if undone)
+    size_t cell_state_count; // Cells covered by exec_counts and results
+
+    // Checkpoint tree
+    HRIR_Checkpoint* checkpoints; // Indexed by checkpoint id
+    size_t checkpoint_count;
+    size_t checkpoint_capacity;
+    int* checkpoint_names;   // Open-addressed name table of id + 1 (0 = empty)
+    size_t checkpoint_name_capacity;
+    int active_checkpoint;   // Deepest checkpoint on the current path (-1 = none)
+    int last_checkpoint;     // Most recently created checkpoint (-1 = none)
+    bool verify_checkpoints; // Fingerprint new checkpoints, check them on rollback_to
+
+    // Replay of recorded history (checkpoint branches, recompute)
+    bool replaying;          // Suppresses print; read takes values from the input log
+    bool recomputing;        // Rebuilding tape for history already counted per cell
+    HRIR_Value* input_values; // Values returned by read, ordered by position
+    uint64_t* input_positions;
+    size_t input_count;
+    size_t input_capacity;
+
+    // Bounded-memory reverse execution, see hr_ir_set_memory_budget
+    struct HRIR_Recompute* recompute; // NULL = keep the full tape
+
+    // Committed horizon, see hr_ir_commit
+    uint64_t horizon;        // History before this position cannot be undone
+    FILE* archive;           // Receives the tape released by each commit, or NULL
+
+    // Register and memory file
+    HRIR_Value* registers;   // Indexed by symbol register slot
+    size_t register_count;
+    HRIR_Value* memory;      // Addressed by load/store
+    size_t memory_size;
+    struct HRIR_SharedState* shared; // Arrays borrowed from a fork until the first write, or NULL
 
     // Statistics
     size_t steps_executed;   // Total execution steps
     size_t rollbacks;        // Number of rollbacks performed
+    HRIR_OpcodeStats* profile; // Indexed by opcode, NULL unless profiling
+    size_t peak_tape_bytes;  // Highest tape.bytes seen while profiling
 
     // Error handling
+    HRIR_Error error;        // Last error code
     const char* last_error;  // Last error message
 } HRIR_Runtime;
 
@@ -66,17 +334,22 @@ typedef struct HRIR_Runtime {
 // CELL CREATION API
 // =============================================================================
 
-// Create a new HRIR cell
+// Create a new HRIR cell (one allocation holding the cell, args and strings)
 HRIR_Cell* hr_ir_create_cell(const char* opcode, const char** args, size_t arg_count);
 
-// Create inverse cell for a given cell
+// Create inverse cell for a given cell, allocated where the cell is. The
+// inverse shares the cell's operands and is valid as long as the cell.
 HRIR_Cell* hr_ir_create_inverse(HRIR_Cell* cell);
 
+// Inverse of a cell, created on first request and kept in cell->inverse
+// (NULL if the cell is irreversible or its opcode has no inverse)
+HRIR_Cell* hr_ir_get_inverse(HRIR_Cell* cell);
+
 // Set cell metadata
 void hr_ir_set_cell_meta(HRIR_Cell* cell, const char* source_location,
                         uint32_t line_number, const char* canonical_path);
 
-// Free cell resources
+// Free cell resources (no-op for views in a program arena)
 void hr_ir_free_cell(HRIR_Cell* cell);
 
 // =============================================================================
@@ -86,21 +359,89 @@ void hr_ir_free_cell(HRIR_Cell* cell);
 // Create new HRIR program
 HRIR_Program* hr_ir_create_program(const char* source_name);
 
-// Add cell to program
+// Add cell to program (program takes ownership; the cell becomes its view).
+// Cells already owned by a program's arena are rejected.
 bool hr_ir_add_cell(HRIR_Program* program, HRIR_Cell* cell);
 
+// Add cells in order, as hr_ir_add_cell does for each, after reserving room for
+// all of them at once. Either every cell is added or none is (the caller then
+// keeps them all).
+bool hr_ir_add_cells(HRIR_Program* program, HRIR_Cell** cells, size_t count);
+
+// Make room for `cells` more cells holding `args` arguments in total, so a
+// program of known size is built without regrowing its arrays
+bool hr_ir_reserve(HRIR_Program* program, size_t cells, size_t args);
+
+// Append a cell straight into the compact encoding, returns its id (0 on failure)
+uint32_t hr_ir_emit(HRIR_Program* program, const char* opcode,
+                    const char** args, size_t arg_count, bool is_reversible);
+
+// Set metadata of an encoded cell by index
+bool hr_ir_set_meta(HRIR_Program* program, size_t index, const char* source_location,
+                    uint32_t line_number, const char* canonical_path);
+
+// Share identical argument runs between cells. This is argument-run sharing
+// only: every position still stores its opcode, flags, run offset and count
+// (8 bytes) besides its id and metadata, so a repeated cell costs those
+// instead of its whole run. Enabling also folds the cells already in the
+// program.
+bool hr_ir_set_hash_consing(HRIR_Program* program, bool enabled);
+
+// Intern text into the constant pool, returns its const id (HRIR_NO_CONST on failure)
+uint32_t hr_ir_intern(HRIR_Program* program, const char* text, size_t length);
+
+// Look up interned text without adding it (HRIR_NO_CONST if absent)
+uint32_t hr_ir_find_const(const HRIR_Program* program, const char* text, size_t length);
+
+// Constant pool access
+const HRIR_Const* hr_ir_get_const(const HRIR_Program* program, uint32_t const_id);
+const char* hr_ir_const_text(const HRIR_Program* program, uint32_t const_id);
+
+// Opcode mapping
+HRIR_Opcode hr_ir_opcode_from_name(const char* name);
+const char* hr_ir_opcode_name(HRIR_Opcode opcode);
+const char* hr_ir_get_opcode_name(const HRIR_Program* program, size_t index);
+
+// Opcode that undoes an opcode over the same operands (HRIR_OPC_COUNT if none)
+HRIR_Opcode hr_ir_inverse_opcode(HRIR_Opcode opcode);
+
+// Whether the cell at index is reversible and has an inverse, without building it
+bool hr_ir_has_inverse(const HRIR_Program* program, size_t index);
+
 // Get cell by ID
 HRIR_Cell* hr_ir_get_cell_by_id(HRIR_Program* program, uint32_t id);
 
-// Get cell by index
+// Get cell by index (views carry no execution state, see hr_ir_cell_executed)
 HRIR_Cell* hr_ir_get_cell(HRIR_Program* program, size_t index);
 
 // Serialize program to JSON
 char* hr_ir_serialize_program(HRIR_Program* program);
 
-// Deserialize program from JSON
+// Deserialize program from JSON (the hr_ir_serialize_program schema; cells
+// may also carry source_location, line_number and canonical_path). Cell ids
+// are kept and must increase.
 HRIR_Program* hr_ir_deserialize_program(const char* json);
 
+// Same for a buffer that need not be NUL-terminated. On failure returns NULL
+// and, if error_message is given, a message with line and column that the
+// caller frees.
+HRIR_Program* hr_ir_parse_program(const char* json, size_t length, char** error_message);
+
+// Encode program in the binary .hrirb format (header, cell columns, constant
+// pool, checksum); *size receives the byte count. Caller frees the buffer.
+void* hr_ir_serialize_binary(HRIR_Program* program, size_t* size);
+
+// Write the binary format to path
+bool hr_ir_save_binary(HRIR_Program* program, const char* path);
+
+// Map a .hrirb file and use its arrays in place; nothing is allocated per
+// cell. Images are native-endian and rejected on any other ABI. On failure
+// returns NULL and, if error_message is given, a message the caller frees.
+HRIR_Program* hr_ir_load_binary(const char* path, char** error_message);
+
+// Same for an image already in memory (copied once into the program)
+HRIR_Program* hr_ir_read_binary(const void* data, size_t size, char** error_message);
+
 // Free program resources
 void hr_ir_free_program(HRIR_Program* program);
 
@@ -108,16 +449,27 @@ void hr_ir_free_program(HRIR_Program* program);
 // RUNTIME EXECUTION API
 // =============================================================================
 
-// Create runtime for program
-HRIR_Runtime* hr_ir_create_runtime(HRIR_Program* program);
-
-// Execute one step
+// Create runtime for program; the program must outlive it and stay unchanged
+// while runtimes on other threads execute it
+HRIR_Runtime* hr_ir_create_runtime(const HRIR_Program* program);
+
+// Fork runtime at its current point. The child shares the program, the
+// registers, memory and per-cell state, and every tape chunk recorded so far;
+// whichever side writes first copies the arrays, and tape chunks are never
+// written while shared, so parent and child can each run, undo into the
+// shared prefix and be freed in any order. Checkpoints and the input log are
+// copied, so the child can restore the parent's checkpoints. A fork inherits
+// the memory budget with its own copy of the snapshots (not profiling), so it
+// can undo back as far as the parent could. Forks may run on separate threads.
+HRIR_Runtime* hr_ir_fork(HRIR_Runtime* runtime);
+
+// Execute one step (records the overwritten state on the tape)
 bool hr_ir_step(HRIR_Runtime* runtime);
 
 // Execute until completion or error
 bool hr_ir_run(HRIR_Runtime* runtime);
 
-// Undo last step
+// Undo last step, restoring the overwritten register or memory cell
 bool hr_ir_undo(HRIR_Runtime* runtime);
 
 // Create checkpoint
@@ -126,10 +478,116 @@ bool hr_ir_checkpoint(HRIR_Runtime* runtime);
 // Rollback to last checkpoint
 bool hr_ir_rollback(HRIR_Runtime* runtime);
 
+// Create a checkpoint at the current tape position, returns its id (-1 on failure).
+// A later checkpoint with the same name shadows the earlier one.
+int hr_ir_create_checkpoint(HRIR_Runtime* runtime, const char* name);
+
+// Find the newest checkpoint with this name (-1 if none)
+int hr_ir_find_checkpoint(HRIR_Runtime* runtime, const char* name);
+
+// Move to any checkpoint (-1 = execution start): undo back to the common
+// ancestor, then re-execute forward along the target's branch. Registers
+// changed with hr_ir_set_register are not part of the recorded history; a
+// replay that misses them fails only for fingerprinted checkpoints.
+bool hr_ir_rollback_to(HRIR_Runtime* runtime, int checkpoint_id);
+
+// Fingerprint registers and memory at each new checkpoint and have
+// hr_ir_rollback_to fail with HRIR_ERROR_EXECUTION_FAILED when a replay does
+// not reproduce it. Off by default: it costs a pass over registers and memory
+// per checkpoint created and per rollback to a fingerprinted one.
+bool hr_ir_set_checkpoint_verification(HRIR_Runtime* runtime, bool enabled);
+
 // Get current execution state
 size_t hr_ir_get_pc(HRIR_Runtime* runtime);
 bool hr_ir_is_complete(HRIR_Runtime* runtime);
 
+// Per-cell execution state of this runtime
+bool hr_ir_cell_executed(HRIR_Runtime* runtime, size_t index);
+HRIR_Value hr_ir_cell_result(HRIR_Runtime* runtime, size_t index);
+
+// Number of steps in the current execution history
+uint64_t hr_ir_get_position(HRIR_Runtime* runtime);
+
+// Bound the memory used for reverse execution. Instead of a full tape the
+// runtime keeps state snapshots at adaptive intervals and only the tape since
+// the newest one; undo past it restores the nearest earlier snapshot and
+// re-executes forward. The interval doubles whenever snapshots outgrow half
+// the budget; a budget too small for two keeps only the newest. False for a
+// budget below one snapshot of the current state plus one tape chunk, and a
+// step fails (after applying) once a snapshot no longer fits or cannot be
+// allocated. 0 restores full-tape mode (from the current position on). A
+// budget drops tape before it is committed, so it cannot be set while a tape
+// archive is open (false).
+bool hr_ir_set_memory_budget(HRIR_Runtime* runtime, size_t bytes);
+
+// Memory versus recompute report for bounded-memory reverse execution
+typedef struct {
+    size_t memory_budget;        // Requested bound in bytes (0 = full tape)
+    size_t memory_used;          // Snapshots plus allocated tape chunks
+    size_t snapshot_count;
+    uint64_t snapshot_interval;  // Current steps between snapshots
+    uint64_t steps_recomputed;   // Steps re-executed to serve undo
+    uint64_t steps_undone;       // Steps undone in total
+} HRIR_ReverseStats;
+
+HRIR_ReverseStats hr_ir_get_reverse_stats(HRIR_Runtime* runtime);
+
+// Declare that no undo will reach before the current position. The tape up to
+// here is released (after being appended to the archive, if one is set), the
+// input log before it is dropped, and with a memory budget the snapshots are
+// replaced by one at the horizon. Checkpoints whose path back to the current
+// one passes behind the horizon can no longer be rolled back to. A long run
+// that commits periodically keeps its reverse-execution memory flat.
+bool hr_ir_commit(HRIR_Runtime* runtime);
+
+// Append the tape released by every later hr_ir_commit to the file at path,
+// as HRIR_TapeSegment headers each followed by its records; NULL stops
+// archiving. The archive holds the whole committed history, so it cannot be
+// opened while a memory budget is set (false): the budget drops tape at
+// every snapshot.
+bool hr_ir_set_tape_archive(HRIR_Runtime* runtime, const char* path);
+
+// Def-use schedule for parallel execution. Straight-line runs of arithmetic,
+// comparison, load, store and custom cells are split into a DAG of register
+// and memory dependencies (read-after-write, write-after-write and
+// write-after-read) and levelled into waves of mutually independent cells.
+typedef struct HRIR_Schedule HRIR_Schedule;
+
+typedef struct {
+    size_t blocks;               // Straight-line blocks analysed
+    size_t parallel_blocks;      // Blocks with a wave of two or more cells
+    size_t cells;                // Cells inside blocks
+    size_t edges;                // Dependency edges
+    size_t waves;                // Waves over all blocks
+    size_t widest_wave;
+} HRIR_ScheduleStats;
+
+// Build the schedule for a program (NULL on allocation failure). It stays
+// valid while the program's existing cells are unchanged.
+HRIR_Schedule* hr_ir_build_schedule(const HRIR_Program* program);
+HRIR_ScheduleStats hr_ir_get_schedule_stats(const HRIR_Schedule* schedule);
+
+// Cells the cell at index must wait for; count 0 outside blocks
+const uint32_t* hr_ir_schedule_predecessors(const HRIR_Schedule* schedule, size_t index,
+                                            size_t* count);
+
+void hr_ir_free_schedule(HRIR_Schedule* schedule);
+
+// Execute until completion or error, running each wave of a scheduled block
+// on up to `threads` threads (0 = one per online CPU). The history is
+// recorded in program order, so undo, checkpoints and replay behave exactly
+// as after hr_ir_run. Blocks entered mid-way, runtimes with a memory budget
+// and blocks that fail run step by step, reporting the same error at the same
+// cell as hr_ir_run.
+bool hr_ir_run_parallel(HRIR_Runtime* runtime, const HRIR_Schedule* schedule, size_t threads);
+
+// Register and memory access (setting does not record on the tape)
+HRIR_Value hr_ir_value_int(int64_t i);
+HRIR_Value hr_ir_value_float(double f);
+HRIR_Value hr_ir_get_register(HRIR_Runtime* runtime, const char* name);
+bool hr_ir_set_register(HRIR_Runtime* runtime, const char* name, HRIR_Value value);
+HRIR_Value hr_ir_get_memory(HRIR_Runtime* runtime, size_t address);
+
 // Free runtime resources
 void hr_ir_free_runtime(HRIR_Runtime* runtime);
 
@@ -148,8 +606,95 @@ HRIR_Cell* hr_ir_from_d_term_operation(const char* operation,
 // Validate HRIR program invariants
 bool hr_ir_validate_program(HRIR_Program* program, char** error_message);
 
-// Optimize HRIR program
-bool hr_ir_optimize_program(HRIR_Program* program);
+// Peephole optimizer report
+typedef struct {
+    size_t cells_before;
+    size_t cells_removed;
+    size_t inverse_pairs;     // Adjacent cells that undid each other
+    size_t constants_folded;  // Cells rewritten to load a known constant
+    size_t jumps_removed;     // Jumps to the next cell and never-taken branches
+    size_t jumps_simplified;  // Always-taken branches turned into jumps
+} HRIR_OptimizeStats;
+
+// Optimize HRIR program in place. Facts are tracked per basic block, so the
+// result is exact for any register values at entry, but registers must not be
+// changed from outside while a run is in progress. Surviving cells keep their
+// ids and source metadata; views of changed or removed cells are released.
+// No runtime may be using the program. stats may be NULL.
+bool hr_ir_optimize_program(HRIR_Program* program, HRIR_OptimizeStats* stats);
+
+// Value numbering report
+typedef struct {
+    size_t cells_before;
+    size_t cells_removed;     // Recomputed a value the destination already held
+    size_t extended_blocks;   // Trees of single-predecessor blocks numbered together
+    size_t values;            // Distinct value numbers assigned
+} HRIR_ValueNumberStats;
+
+// Remove arithmetic and comparison cells whose destination already holds the
+// value they compute, matching operands by value number through earlier cells
+// and `multiply x 1` copies. Numbering carries across blocks with a single
+// predecessor and restarts at merge points. Same preconditions and guarantees
+// as hr_ir_optimize_program; stats may be NULL.
+bool hr_ir_value_number_program(HRIR_Program* program, HRIR_ValueNumberStats* stats);
+
+// Superinstructions: a fused head and the cells after it run in one dispatch
+// of hr_ir_run through a handler for the pattern (hr_ir_step still executes
+// one cell). The group's tape steps are written together, but every cell
+// keeps its own, so a group's inverse is its cells' inverses in reverse order
+// and undo, positions and checkpoints are the same as without fusion.
+typedef enum {
+    HRIR_SUPER_NONE,
+    HRIR_SUPER_COMPARE_BRANCH,  // equal/less/greater, then jump_if
+    HRIR_SUPER_LOAD_OP_STORE,   // load, arithmetic, store
+    HRIR_SUPER_OP_OP,           // two arithmetic cells
+    HRIR_SUPER_OP_JUMP,         // arithmetic, then jump (loop back edge)
+    HRIR_SUPER_COUNT
+} HRIR_Superinstruction;
+
+typedef struct {
+    size_t fused[HRIR_SUPER_COUNT]; // Groups formed, by superinstruction
+    size_t cells_covered;           // Cells inside a group
+} HRIR_FuseStats;
+
+// Mark fusible cell groups, replacing earlier marks. With a profile (a
+// runtime that has executed this program) only groups whose head ran more
+// than once are fused; otherwise every match of the table is. stats may be
+// NULL. No runtime may be executing the program.
+bool hr_ir_fuse_program(HRIR_Program* program, const HRIR_Runtime* profile, HRIR_FuseStats* stats);
+
+// Superinstruction headed by the cell at index (HRIR_SUPER_NONE if none)
+HRIR_Superinstruction hr_ir_get_superinstruction(const HRIR_Program* program, size_t index);
+
+// Cells a superinstruction covers (0 for HRIR_SUPER_NONE)
+size_t hr_ir_superinstruction_length(HRIR_Superinstruction super);
+
+// =============================================================================
+// NATIVE BACKEND
+// =============================================================================
+
+// Ahead-of-time translation to C. The generated code runs on the runtime's
+// own registers and tape, so results, per-cell state and the undo history are
+// exactly the interpreter's; memory, I/O and custom cells call back into the
+// interpreter. Not available under Emscripten.
+typedef struct HRIR_Native HRIR_Native;
+
+// Self-contained C translation unit for the program (caller frees)
+char* hr_ir_emit_c(const HRIR_Program* program);
+
+// Emit and compile into a shared object with the system C compiler ($CC,
+// default cc). On failure error_message, if given, holds the compiler output.
+bool hr_ir_compile_native(const HRIR_Program* program, const char* so_path, char** error_message);
+
+// dlopen a compiled object and check it was built from this program (use a
+// path with a '/' for a file outside the library search path)
+HRIR_Native* hr_ir_load_native(const char* so_path, const HRIR_Program* program, char** error_message);
+
+// Run to completion or error like hr_ir_run (which it defers to while a
+// memory budget is set). The runtime must belong to the loaded program.
+bool hr_ir_run_native(HRIR_Runtime* runtime, const HRIR_Native* native);
+
+void hr_ir_free_native(HRIR_Native* native);
 
 // =============================================================================
 // BUILT-IN OPERATIONS (L1 Core)
@@ -178,6 +723,37 @@ extern const char* HRIR_OP_READ;
 extern const char* HRIR_OP_STORE;
 extern const char* HRIR_OP_LOAD;
 
+// Vector operations over memory ranges (R-term)
+extern const char* HRIR_OP_VADD;
+extern const char* HRIR_OP_VSUB;
+extern const char* HRIR_OP_VXOR;
+extern const char* HRIR_OP_VSCALE;
+extern const char* HRIR_OP_VSUM;
+
+// Operand conventions: symbols name registers, numeric literals are
+// immediates. Arithmetic and comparisons take `a b [dest]` (dest defaults to
+// "result"), jump takes a target cell id, jump_if `cond target`, load
+// `dest address`, store `address src`, read `[dest]`. Vector operations take
+// start addresses and a length: vadd/vsub/vxor `dst a b n` (slot by slot, as
+// add/subtract, or xor of the payload bits keeping a's type), vscale
+// `dst a factor n`, vsum `dest a n` into a register. A destination range must
+// be one of its sources or not overlap them. Other opcodes are no-ops.
+
+// Instruction set used by the vector kernels, chosen from the CPU on first
+// use. Results are identical on every one (float sums always add in four
+// interleaved partial sums).
+typedef enum {
+    HRIR_VECTOR_SCALAR = 0,
+    HRIR_VECTOR_SSE2,
+    HRIR_VECTOR_AVX2
+} HRIR_VectorIsa;
+
+HRIR_VectorIsa hr_ir_vector_isa(void);
+const char* hr_ir_vector_isa_name(HRIR_VectorIsa isa);
+
+// Force an instruction set (false if this CPU or build lacks it)
+bool hr_ir_set_vector_isa(HRIR_VectorIsa isa);
+
 // =============================================================================
 // DEBUGGING & INSPECTION API
 // =============================================================================
@@ -189,12 +765,30 @@ typedef struct {
     size_t d_term_cells;
     size_t executed_cells;
     size_t checkpoint_count;
+    size_t tape_bytes;           // Encoded tape bytes in use
+    size_t tape_chunks;
+    size_t peak_tape_bytes;      // Highest tape_bytes while profiling
+    bool profiled;               // opcodes below were collected
+    HRIR_OpcodeStats opcodes[HRIR_OPC_COUNT];
 } HRIR_Stats;
 
-HRIR_Stats hr_ir_get_stats(HRIR_Program* program);
+HRIR_Stats hr_ir_get_stats(const HRIR_Program* program);
+
+// Program statistics plus this runtime's executed cells, checkpoints, tape
+// and, when profiling, per-opcode counters
+HRIR_Stats hr_ir_get_runtime_stats(HRIR_Runtime* runtime);
+
+// Count executions, undos, time and tape bytes per opcode from now on.
+// Disabling discards the counters. Time is measured for sequential steps
+// (hr_ir_step, hr_ir_run); parallel waves are counted without it, and
+// hr_ir_run_native interprets while profiling.
+bool hr_ir_set_profiling(HRIR_Runtime* runtime, bool enabled);
+
+// Stats as a JSON object; opcodes that never ran are left out. Caller frees.
+char* hr_ir_stats_to_json(const HRIR_Stats* stats);
 
 // Dump program to stdout (debug)
-void hr_ir_dump_program(HRIR_Program* program);
+void hr_ir_dump_program(const HRIR_Program* program);
 
 // Dump runtime state (debug)
 void hr_ir_dump_runtime(HRIR_Runtime* runtime);
@@ -203,17 +797,6 @@ void hr_ir_dump_runtime(HRIR_Runtime* runtime);
 // ERROR HANDLING
 // =============================================================================
 
-typedef enum {
-    HRIR_SUCCESS = 0,
-    HRIR_ERROR_INVALID_CELL,
-    HRIR_ERROR_INVALID_PROGRAM,
-    HRIR_ERROR_EXECUTION_FAILED,
-    HRIR_ERROR_MEMORY_ALLOCATION,
-    HRIR_ERROR_INVALID_OPERATION,
-    HRIR_ERROR_IRREVERSIBLE_OPERATION,
-    HRIR_ERROR_CHECKPOINT_NOT_FOUND
-} HRIR_Error;
-
 // Get last error from runtime
 HRIR_Error hr_ir_get_last_error(HRIR_Runtime* runtime);
 const char* hr_ir_get_error_message(HRIR_Error error);
@@ -0,0 +1,435 @@
+// rio-riovn-merged/src/hr_ir_binary.c
+// L1 HRIR Binary Format - memory-mappable .hrirb images
+//
+// An image is the program's own arrays laid end to end behind a fixed
+// header: the cell columns (opcodes, flags, ids, arg offsets and counts,
+// metadata), the argument slots, and the constant pool with its hash table
+// and text. Every section starts on an 8-byte boundary, so loading is one
+// mmap, a checksum and bounds pass, and pointing the program's arrays at the
+// sections. The program stays on the image until it first grows.
+
+#define _POSIX_C_SOURCE 200809L
+#include "hr_ir_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define HRIR_BINARY_MAGIC "HRIB"
+#define HRIR_BINARY_VERSION 1
+#define HRIR_BINARY_BYTE_ORDER 0x01020304u
+
+typedef enum {
+    HRIR_SECTION_OPCODES,
+    HRIR_SECTION_FLAGS,
+    HRIR_SECTION_IDS,
+    HRIR_SECTION_ARG_OFFSETS,
+    HRIR_SECTION_ARG_COUNTS,
+    HRIR_SECTION_META,
+    HRIR_SECTION_ARGS,
+    HRIR_SECTION_CONSTS,
+    HRIR_SECTION_SLOTS,
+    HRIR_SECTION_BYTES,
+    HRIR_SECTION_NAME,
+    HRIR_SECTION_COUNT
+} HRIR_BinarySection;
+
+typedef struct {
+    char magic[4];            // "HRIB"
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t byte_order;      // HRIR_BINARY_BYTE_ORDER as written
+    uint16_t const_size;      // sizeof(HRIR_Const) of the writer
+    uint16_t meta_size;       // sizeof(HRIR_CellMeta) of the writer
+    uint64_t file_size;
+    uint64_t checksum;        // Over every byte after the header
+    uint32_t cell_count;
+    uint32_t arg_count;
+    uint32_t const_count;
+    uint32_t slot_capacity;   // Power of two (0 = empty pool)
+    uint32_t register_count;
+    uint32_t next_id;
+    uint32_t bytes_size;      // Constant text bytes
+    uint32_t name_length;     // Source name bytes (no terminator)
+    uint64_t offsets[HRIR_SECTION_COUNT];
+} HRIR_BinaryHeader;
+
+static size_t hr_ir_align8(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+// Word-wise multiply-xor hash; the image length is always a multiple of 8
+static uint64_t hr_ir_binary_checksum(const unsigned char* data, size_t size) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 1099511628211ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// Byte count of each section for the counts in a header
+static void hr_ir_section_sizes(const HRIR_BinaryHeader* header, size_t sizes[HRIR_SECTION_COUNT]) {
+    size_t cells = header->cell_count;
+    sizes[HRIR_SECTION_OPCODES] = cells * sizeof(uint8_t);
+    sizes[HRIR_SECTION_FLAGS] = cells * sizeof(uint8_t);
+    sizes[HRIR_SECTION_IDS] = cells * sizeof(uint32_t);
+    sizes[HRIR_SECTION_ARG_OFFSETS] = cells * sizeof(uint32_t);
+    sizes[HRIR_SECTION_ARG_COUNTS] = cells * sizeof(uint16_t);
+    sizes[HRIR_SECTION_META] = cells * sizeof(HRIR_CellMeta);
+    sizes[HRIR_SECTION_ARGS] = (size_t)header->arg_count * sizeof(uint32_t);
+    sizes[HRIR_SECTION_CONSTS] = (size_t)header->const_count * sizeof(HRIR_Const);
+    sizes[HRIR_SECTION_SLOTS] = (size_t)header->slot_capacity * sizeof(uint32_t);
+    sizes[HRIR_SECTION_BYTES] = header->bytes_size;
+    sizes[HRIR_SECTION_NAME] = header->name_length;
+}
+
+// =============================================================================
+// WRITER
+// =============================================================================
+
+void* hr_ir_serialize_binary(HRIR_Program* program, size_t* size) {
+    if (!program || !size) return NULL;
+
+    const HRIR_ConstPool* pool = &program->pool;
+    size_t name_length = program->source_name ? strlen(program->source_name) : 0;
+    if (program->cell_count > UINT32_MAX || program->arg_count > UINT32_MAX ||
+        pool->bytes_size > UINT32_MAX || name_length > UINT32_MAX) {
+        return NULL;
+    }
+
+    HRIR_BinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HRIR_BINARY_MAGIC, 4);
+    header.version = HRIR_BINARY_VERSION;
+    header.header_size = sizeof(HRIR_BinaryHeader);
+    header.byte_order = HRIR_BINARY_BYTE_ORDER;
+    header.const_size = sizeof(HRIR_Const);
+    header.meta_size = sizeof(HRIR_CellMeta);
+    header.cell_count = (uint32_t)program->cell_count;
+    header.arg_count = (uint32_t)program->arg_count;
+    header.const_count = pool->count;
+    header.slot_capacity = pool->slot_capacity;
+    header.register_count = pool->register_count;
+    header.next_id = program->next_id;
+    header.bytes_size = (uint32_t)pool->bytes_size;
+    header.name_length = (uint32_t)name_length;
+
+    size_t sizes[HRIR_SECTION_COUNT];
+    hr_ir_section_sizes(&header, sizes);
+    size_t offset = hr_ir_align8(sizeof(header));
+    for (int s = 0; s < HRIR_SECTION_COUNT; s++) {
+        header.offsets[s] = offset;
+        offset += hr_ir_align8(sizes[s]);
+    }
+    header.file_size = offset;
+
+    unsigned char* image = calloc(1, offset);
+    if (!image) return NULL;
+
+    const void* sources[HRIR_SECTION_COUNT] = {
+        program->opcodes, program->flags, program->ids, program->arg_offsets,
+        program->arg_counts, program->meta, program->args, NULL, pool->slots,
+        pool->bytes, program->source_name
+    };
+    for (int s = 0; s < HRIR_SECTION_COUNT; s++) {
+        if (sizes[s] > 0 && sources[s]) memcpy(image + header.offsets[s], sources[s], sizes[s]);
+    }
+
+    // Constants field by field, so struct padding is written as zeros
+    HRIR_Const* consts = (HRIR_Const*)(image + header.offsets[HRIR_SECTION_CONSTS]);
+    for (uint32_t id = 0; id < pool->count; id++) {
+        const HRIR_Const* entry = &pool->entries[id];
+        consts[id].offset = entry->offset;
+        consts[id].length = entry->length;
+        consts[id].hash = entry->hash;
+        consts[id].reg = entry->reg;
+        consts[id].kind = entry->kind;
+        consts[id].value.type = entry->value.type;
+        if (entry->value.type == HRIR_VALUE_FLOAT) {
+            consts[id].value.as.f = entry->value.as.f;
+        } else {
+            consts[id].value.as.i = entry->value.as.i;
+        }
+    }
+
+    header.checksum = hr_ir_binary_checksum(image + header.header_size,
+                                            offset - header.header_size);
+    memcpy(image, &header, sizeof(header));
+
+    *size = offset;
+    return image;
+}
+
+bool hr_ir_save_binary(HRIR_Program* program, const char* path) {
+    if (!program || !path) return false;
+
+    size_t size = 0;
+    void* image = hr_ir_serialize_binary(program, &size);
+    if (!image) return false;
+
+    FILE* file = fopen(path, "wb");
+    bool ok = file && fwrite(image, 1, size, file) == size;
+    if (file && fclose(file) != 0) ok = false;
+    free(image);
+    return ok;
+}
+
+// =============================================================================
+// READER
+// =============================================================================
+
+static HRIR_Program* hr_ir_binary_fail(char** error_message, const char* message) {
+    if (error_message) *error_message = strdup(message);
+    return NULL;
+}
+
+// Check the header, checksum and every index the arrays hold
+static const char* hr_ir_validate_image(const unsigned char* image, size_t size) {
+    if (size < sizeof(HRIR_BinaryHeader)) return "File is too short for an HRIR image";
+
+    HRIR_BinaryHeader header;
+    memcpy(&header, image, sizeof(header));
+    if (memcmp(header.magic, HRIR_BINARY_MAGIC, 4) != 0) return "Not an HRIR binary image";
+    if (header.version != HRIR_BINARY_VERSION) return "Unsupported HRIR binary version";
+    if (header.byte_order != HRIR_BINARY_BYTE_ORDER || header.header_size != sizeof(header) ||
+        header.const_size != sizeof(HRIR_Const) || header.meta_size != sizeof(HRIR_CellMeta)) {
+        return "HRIR image was written for a different platform";
+    }
+    if (header.file_size != size || size % 8 != 0) return "HRIR image size does not match its header";
+    if (hr_ir_binary_checksum(image + header.header_size, size - header.header_size) != header.checksum) {
+        return "HRIR image checksum mismatch";
+    }
+
+    size_t sizes[HRIR_SECTION_COUNT];
+    hr_ir_section_sizes(&header, sizes);
+    for (int s = 0; s < HRIR_SECTION_COUNT; s++) {
+        uint64_t offset = header.offsets[s];
+        if (offset % 8 != 0 || offset < header.header_size || offset > size || sizes[s] > size - offset) {
+            return "HRIR image section out of bounds";
+        }
+    }
+
+    // The pool: texts inside the byte section, NUL-terminated, and a table
+    // of valid ids that leaves at least one slot empty
+    const HRIR_Const* consts = (const HRIR_Const*)(image + header.offsets[HRIR_SECTION_CONSTS]);
+    const char* bytes = (const char*)(image + header.offsets[HRIR_SECTION_BYTES]);
+    for (uint32_t id = 0; id < header.const_count; id++) {
+        if ((uint64_t)consts[id].offset + consts[id].length >= header.bytes_size ||
+            bytes[consts[id].offset + consts[id].length] != '\0') {
+            return "HRIR image constant out of bounds";
+        }
+        if (consts[id].kind == HRIR_CONST_SYMBOL && consts[id].reg >= header.register_count) {
+            return "HRIR image register out of range";
+        }
+    }
+    if (header.slot_capacity & (header.slot_capacity - 1)) return "HRIR image hash table size is not a power of two";
+    if (header.const_count > 0 && header.const_count >= header.slot_capacity) {
+        return "HRIR image hash table is too small";
+    }
+    const uint32_t* slots = (const uint32_t*)(image + header.offsets[HRIR_SECTION_SLOTS]);
+    for (uint32_t i = 0; i < header.slot_capacity; i++) {
+        if (slots[i] > header.const_count) return "HRIR image hash table entry out of range";
+    }
+
+    const uint32_t* args = (const uint32_t*)(image + header.offsets[HRIR_SECTION_ARGS]);
+    for (uint32_t i = 0; i < header.arg_count; i++) {
+        if (args[i] >= header.const_count) return "HRIR image argument out of range";
+    }
+
+    // Cells: known opcodes, argument runs inside args[], increasing ids
+    const uint8_t* opcodes = image + header.offsets[HRIR_SECTION_OPCODES];
+    const uint32_t* ids = (const uint32_t*)(image + header.offsets[HRIR_SECTION_IDS]);
+    const uint32_t* arg_offsets = (const uint32_t*)(image + header.offsets[HRIR_SECTION_ARG_OFFSETS]);
+    const uint16_t* arg_counts = (const uint16_t*)(image + header.offsets[HRIR_SECTION_ARG_COUNTS]);
+    const HRIR_CellMeta* meta = (const HRIR_CellMeta*)(image + header.offsets[HRIR_SECTION_META]);
+    for (uint32_t i = 0; i < header.cell_count; i++) {
+        if (opcodes[i] >= HRIR_OPC_COUNT) return "HRIR image has an unknown opcode";
+        if ((uint64_t)arg_offsets[i] + arg_counts[i] > header.arg_count) {
+            return "HRIR image cell arguments out of range";
+        }
+        if (ids[i] == 0 || (i > 0 && ids[i] <= ids[i - 1]) || ids[i] >= header.next_id) {
+            return "HRIR image cell ids must increase";
+        }
+        uint32_t names[3] = {meta[i].source_location, meta[i].canonical_path, meta[i].opcode_name};
+        for (int k = 0; k < 3; k++) {
+            if (names[k] != HRIR_NO_CONST && names[k] >= header.const_count) {
+                return "HRIR image metadata out of range";
+            }
+        }
+        if (opcodes[i] == HRIR_OPC_CUSTOM && meta[i].opcode_name == HRIR_NO_CONST) {
+            return "HRIR image custom cell has no opcode name";
+        }
+    }
+    return NULL;
+}
+
+// Build a program over a validated image; the program owns the image after
+static HRIR_Program* hr_ir_adopt_image(unsigned char* image, size_t size, bool mapped,
+                                       char** error_message) {
+    const char* problem = hr_ir_validate_image(image, size);
+    if (problem) return hr_ir_binary_fail(error_message, problem);
+
+    HRIR_BinaryHeader header;
+    memcpy(&header, image, sizeof(header));
+
+    HRIR_Program* program = calloc(1, sizeof(HRIR_Program));
+    if (!program) return hr_ir_binary_fail(error_message, "Out of memory");
+
+    // One view slot per cell; views themselves stay lazy
+    program->cells = calloc(header.cell_count ? header.cell_count : 1, sizeof(HRIR_Cell*));
+    program->source_name = malloc(header.name_length + 1);
+    if (!program->cells || !program->source_name) {
+        free(program->cells);
+        free((void*)program->source_name);
+        free(program);
+        return hr_ir_binary_fail(error_message, "Out of memory");
+    }
+    memcpy((char*)program->source_name, image + header.offsets[HRIR_SECTION_NAME], header.name_length);
+    ((char*)program->source_name)[header.name_length] = '\0';
+
+    program->opcodes = image + header.offsets[HRIR_SECTION_OPCODES];
+    program->flags = image + header.offsets[HRIR_SECTION_FLAGS];
+    program->ids = (uint32_t*)(image + header.offsets[HRIR_SECTION_IDS]);
+    program->arg_offsets = (uint32_t*)(image + header.offsets[HRIR_SECTION_ARG_OFFSETS]);
+    program->arg_counts = (uint16_t*)(image + header.offsets[HRIR_SECTION_ARG_COUNTS]);
+    program->meta = (HRIR_CellMeta*)(image + header.offsets[HRIR_SECTION_META]);
+    program->cell_count = header.cell_count;
+    program->capacity = header.cell_count;
+
+    program->args = (uint32_t*)(image + header.offsets[HRIR_SECTION_ARGS]);
+    program->arg_count = header.arg_count;
+    program->arg_capacity = header.arg_count;
+
+    HRIR_ConstPool* pool = &program->pool;
+    pool->bytes = (char*)(image + header.offsets[HRIR_SECTION_BYTES]);
+    pool->bytes_size = header.bytes_size;
+    pool->bytes_capacity = header.bytes_size;
+    pool->entries = (HRIR_Const*)(image + header.offsets[HRIR_SECTION_CONSTS]);
+    pool->count = header.const_count;
+    pool->capacity = header.const_count;
+    pool->slots = (uint32_t*)(image + header.offsets[HRIR_SECTION_SLOTS]);
+    pool->slot_capacity = header.slot_capacity;
+    pool->register_count = header.register_count;
+
+    program->next_id = header.next_id;
+    program->image = image;
+    program->image_size = size;
+    program->image_mapped = mapped;
+    return program;
+}
+
+HRIR_Program* hr_ir_read_binary(const void* data, size_t size, char** error_message) {
+    if (error_message) *error_message = NULL;
+    if (!data) return hr_ir_binary_fail(error_message, "No image given");
+
+    unsigned char* image = malloc(size ? size : 1);
+    if (!image) return hr_ir_binary_fail(error_message, "Out of memory");
+    memcpy(image, data, size);
+
+    HRIR_Program* program = hr_ir_adopt_image(image, size, false, error_message);
+    if (!program) free(image);
+    return program;
+}
+
+HRIR_Program* hr_ir_load_binary(const char* path, char** error_message) {
+    if (error_message) *error_message = NULL;
+    if (!path) return hr_ir_binary_fail(error_message, "No path given");
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return hr_ir_binary_fail(error_message, "Cannot open HRIR image");
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return hr_ir_binary_fail(error_message, "Cannot read HRIR image");
+    }
+    size_t size = (size_t)info.st_size;
+
+    // Private mapping: pages are shared with the page cache until written
+    void* image = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) return hr_ir_binary_fail(error_message, "Cannot map HRIR image");
+
+    HRIR_Program* program = hr_ir_adopt_image(image, size, true, error_message);
+    if (!program) munmap(image, size);
+    return program;
+}
+
+// =============================================================================
+// LEAVING THE IMAGE
+// =============================================================================
+
+void hr_ir_release_image(HRIR_Program* program) {
+    if (!program->image) return;
+    if (program->image_mapped) {
+        munmap(program->image, program->image_size);
+    } else {
+        free(program->image);
+    }
+    program->image = NULL;
+    program->image_size = 0;
+}
+
+static void* hr_ir_copy_out(const void* data, size_t size, size_t capacity) {
+    void* copy = malloc(capacity ? capacity : 1);
+    if (copy && size > 0) memcpy(copy, data, size);
+    return copy;
+}
+
+bool hr_ir_detach_image(HRIR_Program* program) {
+    if (!program->image) return true;
+
+    HRIR_ConstPool* pool = &program->pool;
+    size_t cells = program->cell_count > 16 ? program->cell_count : 16;
+    size_t arg_capacity = program->arg_count > 64 ? program->arg_count : 64;
+    uint32_t const_capacity = pool->count > 64 ? pool->count : 64;
+    size_t bytes_capacity = pool->bytes_size > 1024 ? pool->bytes_size : 1024;
+    size_t n = program->cell_count;
+
+    void* copies[10] = {
+        hr_ir_copy_out(program->opcodes, n * sizeof(uint8_t), cells * sizeof(uint8_t)),
+        hr_ir_copy_out(program->flags, n * sizeof(uint8_t), cells * sizeof(uint8_t)),
+        hr_ir_copy_out(program->ids, n * sizeof(uint32_t), cells * sizeof(uint32_t)),
+        hr_ir_copy_out(program->arg_offsets, n * sizeof(uint32_t), cells * sizeof(uint32_t)),
+        hr_ir_copy_out(program->arg_counts, n * sizeof(uint16_t), cells * sizeof(uint16_t)),
+        hr_ir_copy_out(program->meta, n * sizeof(HRIR_CellMeta), cells * sizeof(HRIR_CellMeta)),
+        hr_ir_copy_out(program->args, program->arg_count * sizeof(uint32_t), arg_capacity * sizeof(uint32_t)),
+        hr_ir_copy_out(pool->entries, pool->count * sizeof(HRIR_Const), const_capacity * sizeof(HRIR_Const)),
+        hr_ir_copy_out(pool->slots, pool->slot_capacity * sizeof(uint32_t), pool->slot_capacity * sizeof(uint32_t)),
+        hr_ir_copy_out(pool->bytes, pool->bytes_size, bytes_capacity),
+    };
+    HRIR_Cell** views = realloc(program->cells, cells * sizeof(HRIR_Cell*));
+
+    bool ok = views != NULL;
+    for (int i = 0; i < 10; i++) ok = ok && copies[i] != NULL;
+    if (views) program->cells = views;
+    if (!ok) {
+        for (int i = 0; i < 10; i++) free(copies[i]);
+        return false;
+    }
+    memset(program->cells + program->capacity, 0, (cells - program->capacity) * sizeof(HRIR_Cell*));
+
+    program->opcodes = copies[0];
+    program->flags = copies[1];
+    program->ids = copies[2];
+    program->arg_offsets = copies[3];
+    program->arg_counts = copies[4];
+    program->meta = copies[5];
+    program->capacity = cells;
+    program->args = copies[6];
+    program->arg_capacity = arg_capacity;
+    pool->entries = copies[7];
+    pool->capacity = const_capacity;
+    pool->slots = copies[8];
+    pool->bytes = copies[9];
+    pool->bytes_capacity = bytes_capacity;
+
+    hr_ir_release_image(program);
+    return true;
+}
@@ -0,0 +1,396 @@
+// rio-riovn-merged/src/hr_ir_checkpoint.c
+// L1 HRIR Checkpoint Tree - named bookmarks into the undo tape
+//
+// A checkpoint is a tape position plus the input read since its parent
+// checkpoint, so creating one is an O(1) append (plus a copy of that input).
+// Moving to a checkpoint undoes back to the nearest common ancestor of the
+// current path and the target, lays down the input log of the target's
+// branch and re-executes forward; the cost is the tree distance in steps,
+// independent of program length. With verification on, each checkpoint also
+// fingerprints the state, and a replay that does not arrive at it (the state
+// was edited with hr_ir_set_register along the way) is reported as diverged
+// rather than left looking like the checkpoint.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hr_ir_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+// =============================================================================
+// LIFECYCLE
+// =============================================================================
+
+void hr_ir_checkpoints_init(HRIR_Runtime* runtime) {
+    runtime->checkpoints = NULL;
+    runtime->checkpoint_count = 0;
+    runtime->checkpoint_capacity = 0;
+    runtime->checkpoint_names = NULL;
+    runtime->checkpoint_name_capacity = 0;
+    runtime->active_checkpoint = -1;
+    runtime->last_checkpoint = -1;
+    runtime->verify_checkpoints = false;
+}
+
+void hr_ir_checkpoints_free(HRIR_Runtime* runtime) {
+    for (size_t i = 0; i < runtime->checkpoint_count; i++) {
+        free((void*)runtime->checkpoints[i].name);
+        free(runtime->checkpoints[i].inputs);
+        free(runtime->checkpoints[i].input_positions);
+    }
+    free(runtime->checkpoints);
+    free(runtime->checkpoint_names);
+    hr_ir_checkpoints_init(runtime);
+}
+
+bool hr_ir_checkpoints_copy(HRIR_Runtime* fork, const HRIR_Runtime* runtime) {
+    hr_ir_checkpoints_init(fork);
+    fork->active_checkpoint = runtime->active_checkpoint;
+    fork->last_checkpoint = runtime->last_checkpoint;
+    fork->verify_checkpoints = runtime->verify_checkpoints;
+    if (runtime->checkpoint_count == 0) return true;
+
+    fork->checkpoints = malloc(runtime->checkpoint_count * sizeof(HRIR_Checkpoint));
+    if (!fork->checkpoints) return false;
+    fork->checkpoint_capacity = runtime->checkpoint_count;
+
+    for (size_t i = 0; i < runtime->checkpoint_count; i++) {
+        const HRIR_Checkpoint* source = &runtime->checkpoints[i];
+        HRIR_Checkpoint* checkpoint = &fork->checkpoints[i];
+        *checkpoint = *source;
+        checkpoint->name = NULL;
+        checkpoint->inputs = NULL;
+        checkpoint->input_positions = NULL;
+        fork->checkpoint_count = i + 1;
+
+        if (source->name && !(checkpoint->name = strdup(source->name))) return false;
+        if (source->input_count > 0) {
+            checkpoint->inputs = malloc(source->input_count * sizeof(HRIR_Value));
+            checkpoint->input_positions = malloc(source->input_count * sizeof(uint64_t));
+            if (!checkpoint->inputs || !checkpoint->input_positions) return false;
+            memcpy(checkpoint->inputs, source->inputs, source->input_count * sizeof(HRIR_Value));
+            memcpy(checkpoint->input_positions, source->input_positions, source->input_count * sizeof(uint64_t));
+        }
+    }
+
+    if (runtime->checkpoint_name_capacity > 0) {
+        size_t size = runtime->checkpoint_name_capacity * sizeof(int);
+        fork->checkpoint_names = malloc(size);
+        if (!fork->checkpoint_names) return false;
+        memcpy(fork->checkpoint_names, runtime->checkpoint_names, size);
+        fork->checkpoint_name_capacity = runtime->checkpoint_name_capacity;
+    }
+    return true;
+}
+
+void hr_ir_checkpoints_retreat(HRIR_Runtime* runtime) {
+    uint64_t position = hr_ir_get_position(runtime);
+    while (runtime->active_checkpoint >= 0 &&
+           runtime->checkpoints[runtime->active_checkpoint].position > position) {
+        runtime->active_checkpoint = runtime->checkpoints[runtime->active_checkpoint].parent;
+    }
+}
+
+// =============================================================================
+// NAME TABLE
+// =============================================================================
+
+// Slot holding name, or the empty slot where it would go
+static size_t checkpoint_probe(HRIR_Runtime* runtime, const char* name) {
+    size_t mask = runtime->checkpoint_name_capacity - 1;
+    size_t slot = hr_ir_hash(name, strlen(name)) & mask;
+
+    while (runtime->checkpoint_names[slot] != 0) {
+        const HRIR_Checkpoint* checkpoint = &runtime->checkpoints[runtime->checkpoint_names[slot] - 1];
+        if (strcmp(checkpoint->name, name) == 0) break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static bool checkpoint_names_grow(HRIR_Runtime* runtime) {
+    size_t old_capacity = runtime->checkpoint_name_capacity;
+    int* old_names = runtime->checkpoint_names;
+    size_t new_capacity = old_capacity ? old_capacity * 2 : 64;
+
+    int* names = calloc(new_capacity, sizeof(int));
+    if (!names) return false;
+
+    runtime->checkpoint_names = names;
+    runtime->checkpoint_name_capacity = new_capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_names[i] != 0) {
+            const char* name = runtime->checkpoints[old_names[i] - 1].name;
+            names[checkpoint_probe(runtime, name)] = old_names[i];
+        }
+    }
+
+    free(old_names);
+    return true;
+}
+
+int hr_ir_find_checkpoint(HRIR_Runtime* runtime, const char* name) {
+    if (!runtime || !name || runtime->checkpoint_name_capacity == 0) return -1;
+
+    size_t slot = checkpoint_probe(runtime, name);
+    return runtime->checkpoint_names[slot] - 1;
+}
+
+// =============================================================================
+// CREATION
+// =============================================================================
+
+// FNV-1a over the registers and memory cells that hold a value. Blank slots
+// (none or integer 0) are skipped so that files grown by a later branch
+// do not change the hash.
+static uint64_t checkpoint_fingerprint(const HRIR_Runtime* runtime) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const HRIR_Value* files[2] = { runtime->registers, runtime->memory };
+    size_t sizes[2] = { runtime->register_count, runtime->memory_size };
+
+    for (size_t f = 0; f < 2; f++) {
+        for (size_t i = 0; i < sizes[f]; i++) {
+            HRIR_Value value = files[f][i];
+            if (value.type == HRIR_VALUE_NONE || (value.type == HRIR_VALUE_INT && value.as.i == 0)) continue;
+
+            uint64_t words[3] = { (uint64_t)i << 1 | f, value.type, (uint64_t)value.as.i };
+            for (size_t w = 0; w < 3; w++) {
+                hash ^= words[w];
+                hash *= 0x100000001b3ULL;
+            }
+        }
+    }
+    return hash;
+}
+
+int hr_ir_create_checkpoint(HRIR_Runtime* runtime, const char* name) {
+    if (!runtime || !runtime->program || runtime->checkpoint_count >= INT32_MAX) return -1;
+
+    if (runtime->checkpoint_count >= runtime->checkpoint_capacity) {
+        size_t new_capacity = runtime->checkpoint_capacity ? runtime->checkpoint_capacity * 2 : 16;
+        HRIR_Checkpoint* checkpoints = realloc(runtime->checkpoints,
+                                               new_capacity * sizeof(HRIR_Checkpoint));
+        if (!checkpoints) return -1;
+        runtime->checkpoints = checkpoints;
+        runtime->checkpoint_capacity = new_capacity;
+    }
+
+    // Keep the name table at most half full
+    if (name && (runtime->checkpoint_count + 1) * 2 > runtime->checkpoint_name_capacity) {
+        if (!checkpoint_names_grow(runtime)) return -1;
+    }
+
+    // Input read on the way here from the parent checkpoint
+    int parent = runtime->active_checkpoint;
+    uint64_t position = hr_ir_get_position(runtime);
+    size_t first = hr_ir_input_index(runtime, parent >= 0 ? runtime->checkpoints[parent].position : 0);
+    size_t input_count = hr_ir_input_index(runtime, position) - first;
+    HRIR_Value* inputs = NULL;
+    uint64_t* input_positions = NULL;
+    char* copy = NULL;
+
+    bool ok = !name || (copy = strdup(name)) != NULL;
+    if (ok && input_count > 0) {
+        inputs = malloc(input_count * sizeof(HRIR_Value));
+        input_positions = malloc(input_count * sizeof(uint64_t));
+        ok = inputs && input_positions;
+    }
+    if (!ok) {
+        free(copy);
+        free(inputs);
+        free(input_positions);
+        return -1;
+    }
+    if (input_count > 0) {
+        memcpy(inputs, runtime->input_values + first, input_count * sizeof(HRIR_Value));
+        memcpy(input_positions, runtime->input_positions + first, input_count * sizeof(uint64_t));
+    }
+
+    int id = (int)runtime->checkpoint_count++;
+    HRIR_Checkpoint* checkpoint = &runtime->checkpoints[id];
+    checkpoint->name = copy;
+    checkpoint->position = position;
+    checkpoint->pc = runtime->pc;
+    checkpoint->parent = parent;
+    checkpoint->depth = parent >= 0 ? runtime->checkpoints[parent].depth + 1 : 0;
+    checkpoint->fingerprinted = runtime->verify_checkpoints;
+    checkpoint->fingerprint = checkpoint->fingerprinted ? checkpoint_fingerprint(runtime) : 0;
+    checkpoint->inputs = inputs;
+    checkpoint->input_positions = input_positions;
+    checkpoint->input_count = input_count;
+
+    if (name) {
+        runtime->checkpoint_names[checkpoint_probe(runtime, name)] = id + 1;
+    }
+
+    runtime->active_checkpoint = id;
+    runtime->last_checkpoint = id;
+    runtime->checkpoint = (size_t)checkpoint->position;
+    return id;
+}
+
+bool hr_ir_checkpoint(HRIR_Runtime* runtime) {
+    return hr_ir_create_checkpoint(runtime, NULL) >= 0;
+}
+
+// =============================================================================
+// ROLLBACK
+// =============================================================================
+
+static uint32_t checkpoint_depth(HRIR_Runtime* runtime, int id) {
+    return id >= 0 ? runtime->checkpoints[id].depth + 1 : 0;
+}
+
+static int checkpoint_parent(HRIR_Runtime* runtime, int id) {
+    return id >= 0 ? runtime->checkpoints[id].parent : -1;
+}
+
+static uint64_t checkpoint_position(HRIR_Runtime* runtime, int id) {
+    return id >= 0 ? runtime->checkpoints[id].position : 0;
+}
+
+// Replace the input log past the ancestor with the reads of the branch
+// from the ancestor down to target
+static bool checkpoint_lay_inputs(HRIR_Runtime* runtime, int ancestor, int target) {
+    size_t keep = hr_ir_input_index(runtime, checkpoint_position(runtime, ancestor));
+    size_t count = keep;
+    for (int id = target; id != ancestor; id = checkpoint_parent(runtime, id)) {
+        count += runtime->checkpoints[id].input_count;
+    }
+    if (!hr_ir_reserve_inputs(runtime, count)) return false;
+
+    // Walk up from the target, filling from the end
+    size_t end = count;
+    for (int id = target; id != ancestor; id = checkpoint_parent(runtime, id)) {
+        const HRIR_Checkpoint* checkpoint = &runtime->checkpoints[id];
+        end -= checkpoint->input_count;
+        if (checkpoint->input_count == 0) continue;
+        memcpy(runtime->input_values + end, checkpoint->inputs, checkpoint->input_count * sizeof(HRIR_Value));
+        memcpy(runtime->input_positions + end, checkpoint->input_positions,
+               checkpoint->input_count * sizeof(uint64_t));
+    }
+    runtime->input_count = count;
+    return true;
+}
+
+bool hr_ir_rollback_to(HRIR_Runtime* runtime, int checkpoint_id) {
+    if (!runtime || !runtime->program) return false;
+    if (checkpoint_id < -1 || checkpoint_id >= (int)runtime->checkpoint_count) {
+        runtime->error = HRIR_ERROR_CHECKPOINT_NOT_FOUND;
+        return false;
+    }
+
+    // Nearest common ancestor of the current path and the target
+    int a = runtime->active_checkpoint;
+    int b = checkpoint_id;
+    while (checkpoint_depth(runtime, a) > checkpoint_depth(runtime, b)) a = checkpoint_parent(runtime, a);
+    while (checkpoint_depth(runtime, b) > checkpoint_depth(runtime, a)) b = checkpoint_parent(runtime, b);
+    while (a != b) {
+        a = checkpoint_parent(runtime, a);
+        b = checkpoint_parent(runtime, b);
+    }
+
+    // Undo never crosses the committed horizon
+    uint64_t ancestor = checkpoint_position(runtime, a);
+    if (ancestor < runtime->horizon) {
+        runtime->error = HRIR_ERROR_CHECKPOINT_NOT_FOUND;
+        free((void*)runtime->last_error);
+        runtime->last_error = strdup("Checkpoint is behind the committed horizon");
+        return false;
+    }
+    uint64_t start = hr_ir_get_position(runtime);
+    while (hr_ir_get_position(runtime) > ancestor) {
+        if (!hr_ir_undo(runtime)) return false;
+    }
+    if (!checkpoint_lay_inputs(runtime, a, checkpoint_id)) {
+        runtime->error = HRIR_ERROR_MEMORY_ALLOCATION;
+        return false;
+    }
+
+    // Re-execute the target's branch without repeating its output
+    uint64_t target = checkpoint_position(runtime, checkpoint_id);
+    bool replaying = runtime->replaying;
+    runtime->replaying = true;
+    while (hr_ir_get_position(runtime) < target) {
+        if (!hr_ir_step(runtime)) {
+            runtime->replaying = replaying;
+            return false;
+        }
+    }
+    runtime->replaying = replaying;
+
+    // Edits outside the tape are not replayed; a rollback that stays put keeps them
+    const HRIR_Checkpoint* checkpoint = checkpoint_id >= 0 ? &runtime->checkpoints[checkpoint_id] : NULL;
+    bool moved = start != ancestor || target != ancestor;
+    if (checkpoint && (runtime->pc != checkpoint->pc ||
+                       (moved && checkpoint->fingerprinted &&
+                        checkpoint_fingerprint(runtime) != checkpoint->fingerprint))) {
+        runtime->error = HRIR_ERROR_EXECUTION_FAILED;
+        free((void*)runtime->last_error);
+        runtime->last_error = strdup("Replay diverged from checkpoint");
+        return false;
+    }
+
+    runtime->active_checkpoint = checkpoint_id;
+    return true;
+}
+
+bool hr_ir_set_checkpoint_verification(HRIR_Runtime* runtime, bool enabled) {
+    if (!runtime) return false;
+    runtime->verify_checkpoints = enabled;
+    return true;
+}
+
+bool hr_ir_rollback(HRIR_Runtime* runtime) {
+    if (!runtime) return false;
+    return hr_ir_rollback_to(runtime, runtime->last_checkpoint);
+}
+
+// =============================================================================
+// COMMITTED HORIZON
+// =============================================================================
+
+bool hr_ir_commit(HRIR_Runtime* runtime) {
+    if (!runtime || !runtime->program) return false;
+
+    if (runtime->archive && !hr_ir_tape_archive(&runtime->tape, runtime->archive)) {
+        runtime->error = HRIR_ERROR_EXECUTION_FAILED;
+        free((void*)runtime->last_error);
+        runtime->last_error = strdup("Tape archive write failed");
+        return false;
+    }
+
+    if (runtime->recompute) {
+        if (!hr_ir_recompute_commit(runtime)) {
+            runtime->error = HRIR_ERROR_MEMORY_ALLOCATION;
+            return false;
+        }
+    } else {
+        hr_ir_tape_commit(&runtime->tape);
+    }
+    runtime->horizon = hr_ir_get_position(runtime);
+
+    // Replay never starts before the horizon, so older reads are not needed
+    size_t dropped = 0;
+    while (dropped < runtime->input_count && runtime->input_positions[dropped] < runtime->horizon) dropped++;
+    if (dropped > 0) {
+        runtime->input_count -= dropped;
+        memmove(runtime->input_values, runtime->input_values + dropped, runtime->input_count * sizeof(HRIR_Value));
+        memmove(runtime->input_positions, runtime->input_positions + dropped, runtime->input_count * sizeof(uint64_t));
+    }
+    return true;
+}
+
+bool hr_ir_set_tape_archive(HRIR_Runtime* runtime, const char* path) {
+    if (!runtime) return false;
+
+    if (runtime->archive) {
+        fclose(runtime->archive);
+        runtime->archive = NULL;
+    }
+    if (!path) return true;
+    if (runtime->recompute) return false; // Snapshots drop tape the archive would miss
+
+    runtime->archive = fopen(path, "ab");
+    return runtime->archive != NULL;
+}
@@ -0,0 +1,149 @@
+// rio-riovn-merged/src/hr_ir_fork.c
+// L1 HRIR Forking - copy-on-write child runtimes for what-if exploration
+//
+// A fork starts out holding the same register, memory and per-cell arrays as
+// its parent, through one reference-counted HRIR_SharedState. The first side
+// to write copies them (the last holder keeps them without a copy), so
+// creating and discarding a branch that never runs costs a few small
+// allocations. The tape prefix is shared chunk by chunk, see hr_ir_tape.c.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hr_ir_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct HRIR_SharedState {
+    uint32_t refs;           // Runtimes holding the arrays
+    HRIR_Value* registers;
+    HRIR_Value* memory;
+    uint32_t* exec_counts;
+    HRIR_Value* results;
+} HRIR_SharedState;
+
+static void fork_free_arrays(HRIR_SharedState* shared) {
+    free(shared->registers);
+    free(shared->memory);
+    free(shared->exec_counts);
+    free(shared->results);
+    free(shared);
+}
+
+static void* fork_copy(const void* data, size_t size, bool* ok) {
+    if (!data || size == 0) return NULL;
+
+    void* copy = malloc(size);
+    if (!copy) {
+        *ok = false;
+        return NULL;
+    }
+    memcpy(copy, data, size);
+    return copy;
+}
+
+// =============================================================================
+// SHARED STATE
+// =============================================================================
+
+bool hr_ir_own_state(HRIR_Runtime* runtime) {
+    HRIR_SharedState* shared = runtime->shared;
+    if (!shared) return true;
+
+    // Nobody else holds the arrays, and only a holder can fork: keep them
+    if (__atomic_load_n(&shared->refs, __ATOMIC_ACQUIRE) == 1) {
+        free(shared);
+        runtime->shared = NULL;
+        return true;
+    }
+
+    bool ok = true;
+    HRIR_Value* registers = fork_copy(runtime->registers, runtime->register_count * sizeof(HRIR_Value), &ok);
+    HRIR_Value* memory = fork_copy(runtime->memory, runtime->memory_size * sizeof(HRIR_Value), &ok);
+    uint32_t* exec_counts = fork_copy(runtime->exec_counts, runtime->cell_state_count * sizeof(uint32_t), &ok);
+    HRIR_Value* results = fork_copy(runtime->results, runtime->cell_state_count * sizeof(HRIR_Value), &ok);
+    if (!ok) {
+        free(registers);
+        free(memory);
+        free(exec_counts);
+        free(results);
+        return false;
+    }
+
+    runtime->registers = registers;
+    runtime->memory = memory;
+    runtime->exec_counts = exec_counts;
+    runtime->results = results;
+    runtime->shared = NULL;
+
+    // The other holders may have let go meanwhile
+    if (__atomic_sub_fetch(&shared->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        fork_free_arrays(shared);
+    }
+    return true;
+}
+
+void hr_ir_release_state(HRIR_Runtime* runtime) {
+    HRIR_SharedState* shared = runtime->shared;
+    if (!shared) return;
+
+    runtime->shared = NULL;
+    if (__atomic_sub_fetch(&shared->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(shared);
+        return; // The runtime frees the arrays as its own
+    }
+
+    runtime->registers = NULL;
+    runtime->memory = NULL;
+    runtime->exec_counts = NULL;
+    runtime->results = NULL;
+}
+
+// =============================================================================
+// FORK
+// =============================================================================
+
+HRIR_Runtime* hr_ir_fork(HRIR_Runtime* runtime) {
+    if (!runtime || !runtime->program) return NULL;
+
+    HRIR_Runtime* fork = hr_ir_create_runtime(runtime->program);
+    if (!fork) return NULL;
+
+    bool ok = true;
+    fork->input_values = fork_copy(runtime->input_values, runtime->input_count * sizeof(HRIR_Value), &ok);
+    fork->input_positions = fork_copy(runtime->input_positions, runtime->input_count * sizeof(uint64_t), &ok);
+    fork->input_count = ok ? runtime->input_count : 0;
+    fork->input_capacity = fork->input_count;
+    ok = ok && hr_ir_checkpoints_copy(fork, runtime) && hr_ir_recompute_copy(fork, runtime);
+
+    HRIR_SharedState* shared = runtime->shared;
+    if (ok && !shared) {
+        shared = malloc(sizeof(HRIR_SharedState));
+        if (shared) {
+            *shared = (HRIR_SharedState){ 1, runtime->registers, runtime->memory,
+                                          runtime->exec_counts, runtime->results };
+            runtime->shared = shared;
+        }
+    }
+    if (!ok || !shared) {
+        hr_ir_free_runtime(fork);
+        return NULL;
+    }
+    __atomic_add_fetch(&shared->refs, 1, __ATOMIC_RELAXED);
+
+    fork->shared = shared;
+    fork->registers = runtime->registers;
+    fork->register_count = runtime->register_count;
+    fork->memory = runtime->memory;
+    fork->memory_size = runtime->memory_size;
+    fork->exec_counts = runtime->exec_counts;
+    fork->results = runtime->results;
+    fork->cell_state_count = runtime->cell_state_count;
+
+    hr_ir_tape_share(&runtime->tape, &fork->tape);
+    fork->horizon = runtime->horizon;
+    fork->checkpoint = runtime->checkpoint;
+    fork->pc = runtime->pc;
+    fork->steps_executed = runtime->steps_executed;
+    fork->rollbacks = runtime->rollbacks;
+    return fork;
+}
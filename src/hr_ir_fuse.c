@@ -0,0 +1,342 @@
+// rio-riovn-merged/src/hr_ir_fuse.c
+// L1 HRIR Superinstructions - fusing frequent opcode sequences
+//
+// A static table lists the sequences worth one dispatch: compare-and-branch,
+// load/arithmetic/store updates of a memory slot, back-to-back arithmetic and
+// the arithmetic-then-jump that closes most loops. Groups are chosen left to
+// right without overlap, longest pattern first, and recorded in the head
+// cell's flags. Each pattern has its own handler: load/op/store resolves the
+// slot address once, compare-and-branch branches on the comparison it just
+// computed, and every group's tape steps are written together. The records
+// are the ones separate steps would write, so undo, positions and
+// checkpoints do not see fusion. Marks are checked against the cells at
+// dispatch, so stale ones (after the program is edited) cannot change a
+// result.
+
+#define _POSIX_C_SOURCE 200809L
+#include "hr_ir_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Opcode classes the table matches on
+typedef enum {
+    FUSE_ARITH,          // add, subtract, multiply, divide
+    FUSE_COMPARE,        // equal, less, greater
+    FUSE_LOAD,
+    FUSE_STORE,
+    FUSE_JUMP,
+    FUSE_JUMP_IF,
+    FUSE_OTHER
+} HRIR_FuseClass;
+
+typedef struct {
+    HRIR_Superinstruction super;
+    size_t length;
+    HRIR_FuseClass classes[3];
+} HRIR_FusePattern;
+
+// Longest first, so a load/op/store is not split into a shorter pair
+static const HRIR_FusePattern fuse_patterns[] = {
+    { HRIR_SUPER_LOAD_OP_STORE,   3, { FUSE_LOAD, FUSE_ARITH, FUSE_STORE } },
+    { HRIR_SUPER_COMPARE_BRANCH,  2, { FUSE_COMPARE, FUSE_JUMP_IF } },
+    { HRIR_SUPER_OP_JUMP,         2, { FUSE_ARITH, FUSE_JUMP } },
+    { HRIR_SUPER_OP_OP,           2, { FUSE_ARITH, FUSE_ARITH } },
+};
+
+#define FUSE_PATTERN_COUNT (sizeof(fuse_patterns) / sizeof(fuse_patterns[0]))
+
+static HRIR_FuseClass fuse_class(HRIR_Opcode op) {
+    switch (op) {
+        case HRIR_OPC_ADD:
+        case HRIR_OPC_SUBTRACT:
+        case HRIR_OPC_MULTIPLY:
+        case HRIR_OPC_DIVIDE:
+            return FUSE_ARITH;
+        case HRIR_OPC_EQUAL:
+        case HRIR_OPC_LESS:
+        case HRIR_OPC_GREATER:
+            return FUSE_COMPARE;
+        case HRIR_OPC_LOAD:
+            return FUSE_LOAD;
+        case HRIR_OPC_STORE:
+            return FUSE_STORE;
+        case HRIR_OPC_JUMP:
+            return FUSE_JUMP;
+        case HRIR_OPC_JUMP_IF:
+            return FUSE_JUMP_IF;
+        default:
+            return FUSE_OTHER;
+    }
+}
+
+static bool fuse_matches(const HRIR_Program* program, size_t index, const HRIR_FusePattern* pattern) {
+    if (index + pattern->length > program->cell_count) return false;
+    for (size_t k = 0; k < pattern->length; k++) {
+        if (fuse_class((HRIR_Opcode)program->opcodes[index + k]) != pattern->classes[k]) return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// FUSION PASS
+// =============================================================================
+
+size_t hr_ir_superinstruction_length(HRIR_Superinstruction super) {
+    for (size_t p = 0; p < FUSE_PATTERN_COUNT; p++) {
+        if (fuse_patterns[p].super == super) return fuse_patterns[p].length;
+    }
+    return 0;
+}
+
+HRIR_Superinstruction hr_ir_get_superinstruction(const HRIR_Program* program, size_t index) {
+    if (!program || index >= program->cell_count) return HRIR_SUPER_NONE;
+    return (HRIR_Superinstruction)((program->flags[index] & HRIR_FLAG_FUSED_MASK) >> HRIR_FLAG_FUSED_SHIFT);
+}
+
+bool hr_ir_fuse_program(HRIR_Program* program, const HRIR_Runtime* profile, HRIR_FuseStats* stats) {
+    if (!program) return false;
+    if (profile && profile->program != program) return false;
+
+    HRIR_FuseStats local;
+    memset(&local, 0, sizeof(local));
+
+    for (size_t i = 0; i < program->cell_count; i++) {
+        program->flags[i] &= (uint8_t)~HRIR_FLAG_FUSED_MASK;
+    }
+
+    size_t i = 0;
+    while (i < program->cell_count) {
+        bool hot = !profile || (i < profile->cell_state_count && profile->exec_counts[i] > 1);
+        const HRIR_FusePattern* chosen = NULL;
+        for (size_t p = 0; hot && p < FUSE_PATTERN_COUNT && !chosen; p++) {
+            if (fuse_matches(program, i, &fuse_patterns[p])) chosen = &fuse_patterns[p];
+        }
+        if (!chosen) {
+            i++;
+            continue;
+        }
+
+        program->flags[i] |= (uint8_t)(chosen->super << HRIR_FLAG_FUSED_SHIFT);
+        local.fused[chosen->super]++;
+        local.cells_covered += chosen->length;
+        i += chosen->length;
+    }
+
+    if (stats) *stats = local;
+    return true;
+}
+
+// =============================================================================
+// FUSED DISPATCH
+// =============================================================================
+
+// A group being executed: cells are applied in order, then their tape steps
+// are committed together
+typedef struct {
+    HRIR_TapeEntry entries[3];
+    size_t count;
+} HRIR_FuseGroup;
+
+static const HRIR_FusePattern* fuse_pattern(HRIR_Superinstruction super) {
+    for (size_t p = 0; p < FUSE_PATTERN_COUNT; p++) {
+        if (fuse_patterns[p].super == super) return &fuse_patterns[p];
+    }
+    return NULL;
+}
+
+// Write value to the slot and remember what it overwrote
+static void fuse_apply(HRIR_Runtime* runtime, HRIR_FuseGroup* group, size_t index, size_t next_pc,
+                       uint8_t slot_kind, uint32_t slot, bool exact, HRIR_Value value) {
+    HRIR_Value* target = NULL;
+    if (slot_kind == HRIR_SLOT_REGISTER) target = &runtime->registers[slot];
+    if (slot_kind == HRIR_SLOT_MEMORY) target = &runtime->memory[slot];
+
+    HRIR_TapeEntry* entry = &group->entries[group->count++];
+    entry->pc_before = index;
+    entry->pc_after = next_pc;
+    entry->slot_kind = slot_kind;
+    entry->slot = slot;
+    entry->implicit = next_pc == index + 1 && (!target || exact);
+    entry->old_value = target ? *target : value;
+    entry->new_value = value;
+    if (target) *target = value;
+}
+
+// Tape the applied cells and count them as steps. If the tape cannot take
+// them they are reverted, newest first, and none of the group happened.
+static bool fuse_commit(HRIR_Runtime* runtime, const HRIR_FuseGroup* group) {
+    if (group->count == 0) return true;
+
+    if (!hr_ir_tape_record_group(&runtime->tape, group->entries, group->count)) {
+        for (size_t k = group->count; k-- > 0;) {
+            const HRIR_TapeEntry* entry = &group->entries[k];
+            if (entry->slot_kind == HRIR_SLOT_REGISTER) runtime->registers[entry->slot] = entry->old_value;
+            if (entry->slot_kind == HRIR_SLOT_MEMORY) runtime->memory[entry->slot] = entry->old_value;
+        }
+        runtime->error = HRIR_ERROR_MEMORY_ALLOCATION;
+        free((void*)runtime->last_error);
+        runtime->last_error = strdup("Tape allocation failed");
+        return false;
+    }
+
+    // What hr_ir_finish_step does per cell, without profile or memory budget
+    for (size_t k = 0; k < group->count; k++) {
+        const HRIR_TapeEntry* entry = &group->entries[k];
+        runtime->exec_counts[entry->pc_before]++;
+        runtime->results[entry->pc_before] = entry->slot_kind != HRIR_SLOT_NONE ?
+            entry->new_value : (HRIR_Value){ .type = HRIR_VALUE_NONE };
+        runtime->steps_executed++;
+        runtime->pc = entry->pc_after;
+    }
+    return true;
+}
+
+// Arithmetic or comparison at index into its destination register. False,
+// with nothing applied, for a cell that would fail.
+static bool fuse_binary(HRIR_Runtime* runtime, HRIR_FuseGroup* group, size_t index, HRIR_Value* result) {
+    const HRIR_Program* program = runtime->program;
+    HRIR_Opcode op = (HRIR_Opcode)program->opcodes[index];
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    size_t arg_count = program->arg_counts[index];
+    HRIR_Value a, b;
+    uint32_t dest;
+
+    if (arg_count < 2 || !hr_ir_operand(runtime, args[0], &a) || !hr_ir_operand(runtime, args[1], &b) ||
+        !hr_ir_destination(runtime, args, arg_count, 2, &dest) || !hr_ir_eval_binary(op, a, b, result)) {
+        return false;
+    }
+    bool exact = hr_ir_is_exact_update(runtime, op, args, dest, a, b);
+    fuse_apply(runtime, group, index, index + 1, HRIR_SLOT_REGISTER, dest, exact, *result);
+    return true;
+}
+
+// Unconditional jump at index
+static bool fuse_jump(HRIR_Runtime* runtime, HRIR_FuseGroup* group, size_t index) {
+    const HRIR_Program* program = runtime->program;
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    HRIR_Value target;
+    size_t next_pc;
+
+    if (program->arg_counts[index] < 1 || !hr_ir_operand(runtime, args[0], &target) ||
+        !hr_ir_jump_target(program, target, &next_pc)) {
+        return false;
+    }
+    fuse_apply(runtime, group, index, next_pc, HRIR_SLOT_NONE, 0, false, hr_ir_value_int(0));
+    return true;
+}
+
+// `load t addr; op; store addr src`: the store reuses the load's address
+// unless the group overwrote the register it was read from, and stores the
+// op's result straight from the local when src is the op's destination
+static void fuse_load_op_store(HRIR_Runtime* runtime, HRIR_FuseGroup* group, size_t head) {
+    const HRIR_Program* program = runtime->program;
+    const HRIR_Const* pool = program->pool.entries;
+    const uint32_t* load_args = program->args + program->arg_offsets[head];
+    HRIR_Value a;
+    uint32_t dest;
+    uint32_t address;
+
+    if (program->arg_counts[head] < 2 || !hr_ir_destination(runtime, load_args, 2, 0, &dest) ||
+        !hr_ir_operand(runtime, load_args[1], &a) || !hr_ir_address(a, &address)) {
+        return;
+    }
+    HRIR_Value loaded = address < runtime->memory_size ? runtime->memory[address] : hr_ir_value_int(0);
+    if (loaded.type == HRIR_VALUE_NONE) loaded = hr_ir_value_int(0);
+    fuse_apply(runtime, group, head, head + 1, HRIR_SLOT_REGISTER, dest, false, loaded);
+
+    HRIR_Value result;
+    if (!fuse_binary(runtime, group, head + 1, &result)) return;
+    uint32_t written = group->entries[1].slot;
+
+    size_t store = head + 2;
+    const uint32_t* args = program->args + program->arg_offsets[store];
+    if (program->arg_counts[store] < 2) return;
+
+    const HRIR_Const* where = &pool[args[0]];
+    bool same_address = args[0] == load_args[1] &&
+                        (where->kind != HRIR_CONST_SYMBOL || (where->reg != dest && where->reg != written));
+    if (!same_address && (!hr_ir_operand(runtime, args[0], &a) || !hr_ir_address(a, &address))) return;
+
+    HRIR_Value value = result;
+    const HRIR_Const* source = &pool[args[1]];
+    bool from_result = source->kind == HRIR_CONST_SYMBOL && source->reg == written;
+    if (!from_result && !hr_ir_operand(runtime, args[1], &value)) return;
+    if (!hr_ir_ensure_memory(runtime, address)) return;
+
+    fuse_apply(runtime, group, store, store + 1, HRIR_SLOT_MEMORY, address, false, value);
+}
+
+// `compare a b flag; jump_if flag target`: branches on the comparison
+// without reading flag back
+static void fuse_compare_branch(HRIR_Runtime* runtime, HRIR_FuseGroup* group, size_t head) {
+    const HRIR_Program* program = runtime->program;
+    HRIR_Value flag;
+    if (!fuse_binary(runtime, group, head, &flag)) return;
+
+    size_t branch = head + 1;
+    const uint32_t* args = program->args + program->arg_offsets[branch];
+    if (program->arg_counts[branch] < 2) return;
+
+    const HRIR_Const* condition = &program->pool.entries[args[0]];
+    bool taken;
+    if (condition->kind == HRIR_CONST_SYMBOL && condition->reg == group->entries[0].slot) {
+        taken = flag.as.i != 0; // Comparisons yield integer 0 or 1
+    } else {
+        HRIR_Value a;
+        if (!hr_ir_operand(runtime, args[0], &a)) return;
+        taken = hr_ir_is_true(a);
+    }
+
+    size_t next_pc = branch + 1;
+    HRIR_Value target;
+    if (taken && (!hr_ir_operand(runtime, args[1], &target) || !hr_ir_jump_target(program, target, &next_pc))) {
+        return;
+    }
+    fuse_apply(runtime, group, branch, next_pc, HRIR_SLOT_NONE, 0, false, hr_ir_value_int(0));
+}
+
+bool hr_ir_step_fused(HRIR_Runtime* runtime) {
+    if (!hr_ir_sync_runtime(runtime)) return false;
+
+    const HRIR_Program* program = runtime->program;
+    size_t head = runtime->pc;
+    HRIR_Superinstruction super = hr_ir_get_superinstruction(program, head);
+    const HRIR_FusePattern* pattern = fuse_pattern(super);
+    size_t length = pattern ? pattern->length : 1;
+    if (length > program->cell_count - head) length = program->cell_count - head;
+
+    // A profile times each cell and a memory budget snapshots between steps,
+    // so both take the group one cell at a time, as do stale marks
+    HRIR_FuseGroup group;
+    group.count = 0;
+    if (pattern && !runtime->profile && !runtime->recompute && fuse_matches(program, head, pattern)) {
+        switch (super) {
+            case HRIR_SUPER_LOAD_OP_STORE:
+                fuse_load_op_store(runtime, &group, head);
+                break;
+            case HRIR_SUPER_COMPARE_BRANCH:
+                fuse_compare_branch(runtime, &group, head);
+                break;
+            case HRIR_SUPER_OP_JUMP: {
+                HRIR_Value result;
+                if (fuse_binary(runtime, &group, head, &result)) fuse_jump(runtime, &group, head + 1);
+                break;
+            }
+            case HRIR_SUPER_OP_OP: {
+                HRIR_Value result;
+                if (fuse_binary(runtime, &group, head, &result)) fuse_binary(runtime, &group, head + 1, &result);
+                break;
+            }
+            default:
+                break;
+        }
+        if (!fuse_commit(runtime, &group)) return false;
+    }
+
+    // A cell the handler stopped at runs on its own and fails as a step would
+    for (size_t k = group.count; k < length; k++) {
+        if (runtime->pc != head + k) break; // Control left the group
+        if (!hr_ir_execute(runtime, head + k)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,249 @@
+// rio-riovn-merged/src/hr_ir_internal.h
+// L1 HRIR internals shared between the HRIR implementation files
+
+#ifndef HR_IR_INTERNAL_H
+#define HR_IR_INTERNAL_H
+
+#include "hr_ir.h"
+
+// FNV-1a hash shared by the constant pool and name tables
+uint32_t hr_ir_hash(const char* text, size_t length);
+
+// Index of the cell with this id
+bool hr_ir_find_index(const HRIR_Program* program, uint32_t id, size_t* index);
+
+// Rebuild the id lookup table after cells were removed or reordered
+void hr_ir_index_ids(HRIR_Program* program);
+
+// Evaluate arithmetic or comparison exactly as a step would (false on division by zero)
+bool hr_ir_eval_binary(HRIR_Opcode op, HRIR_Value a, HRIR_Value b, HRIR_Value* out);
+
+// Drop one execution of the cell at index from the runtime's per-cell state
+void hr_ir_cell_undone(HRIR_Runtime* runtime, size_t index);
+
+// First input log entry read at or after position
+size_t hr_ir_input_index(const HRIR_Runtime* runtime, uint64_t position);
+
+// Make room for count input log entries
+bool hr_ir_reserve_inputs(HRIR_Runtime* runtime, size_t count);
+
+// Make room for one more cell with arg_count arguments
+bool hr_ir_reserve_cell(HRIR_Program* program, size_t arg_count);
+
+// Append a cell whose arg_count const ids are already at program->args +
+// program->arg_count (space from hr_ir_reserve_cell); returns its index.
+// id must exceed every id in the program.
+size_t hr_ir_push_cell(HRIR_Program* program, HRIR_Opcode op, uint32_t opcode_name,
+                       size_t arg_count, uint8_t flags, uint32_t id);
+
+// Move arrays that still point into a binary image onto the heap, with room
+// to grow, and release the image
+bool hr_ir_detach_image(HRIR_Program* program);
+
+// Unmap or free the binary image
+void hr_ir_release_image(HRIR_Program* program);
+
+// Give the cell at index an argument run of its own and return it for writing
+// (runs may be shared by hash-consing); NULL on allocation failure
+uint32_t* hr_ir_own_args(HRIR_Program* program, size_t index);
+
+// Drop the materialized view of the cell at index
+void hr_ir_release_view(HRIR_Program* program, size_t index);
+
+// Bump allocation from an arena (zeroed, NULL on failure)
+void* hr_ir_arena_alloc(HRIR_Arena* arena, size_t size);
+void hr_ir_arena_free(HRIR_Arena* arena);
+
+// =============================================================================
+// STEP EFFECTS (hr_ir.c)
+// =============================================================================
+
+// What executing one cell does: the slot it overwrites and where control goes
+typedef struct {
+    uint8_t slot_kind;       // HRIR_SlotKind
+    uint32_t slot;
+    bool exact;              // Invertible from the state it leaves behind
+    HRIR_Value value;
+    uint32_t count;          // Slots written from slot on (HRIR_SLOT_RANGE)
+    uint32_t sources[2];     // Vector source ranges (the same twice for vscale)
+    HRIR_Value factor;       // vscale operand
+    size_t next_pc;
+    HRIR_Error error;        // Set when evaluation fails
+    const char* message;
+} HRIR_Effect;
+
+// Grow registers and per-cell state to match the program
+bool hr_ir_sync_runtime(HRIR_Runtime* runtime);
+
+// Operand decoding shared by hr_ir_evaluate and the fused handlers
+bool hr_ir_operand(HRIR_Runtime* runtime, uint32_t const_id, HRIR_Value* out);
+bool hr_ir_destination(HRIR_Runtime* runtime, const uint32_t* args, size_t arg_count,
+                       size_t position, uint32_t* reg);
+bool hr_ir_address(HRIR_Value value, uint32_t* address);
+bool hr_ir_jump_target(const HRIR_Program* program, HRIR_Value target, size_t* index);
+bool hr_ir_is_true(HRIR_Value value);
+
+// Whether an arithmetic step into dest is invertible from the state it leaves
+// behind (checked before dest is written)
+bool hr_ir_is_exact_update(HRIR_Runtime* runtime, HRIR_Opcode op, const uint32_t* args,
+                           uint32_t dest, HRIR_Value a, HRIR_Value b);
+
+// Grow memory to cover address (false on allocation failure)
+bool hr_ir_ensure_memory(HRIR_Runtime* runtime, size_t address);
+
+// Evaluate the cell at index against the current state without changing it
+// (print and read still perform their I/O; store may grow memory)
+bool hr_ir_evaluate(HRIR_Runtime* runtime, size_t index, HRIR_Effect* effect);
+
+// Register or memory slot the effect writes, or NULL
+HRIR_Value* hr_ir_effect_target(HRIR_Runtime* runtime, const HRIR_Effect* effect);
+
+// Grow memory so evaluating the store at index allocates nothing (false on
+// allocation failure)
+bool hr_ir_prepare_store(HRIR_Runtime* runtime, size_t index);
+
+// Record an applied effect on the tape and advance pc past the cell (see
+// hr_ir_finish_step for a failure after the step was applied)
+bool hr_ir_commit_step(HRIR_Runtime* runtime, size_t index, const HRIR_Effect* effect, HRIR_Value old_value);
+
+// Count a step already on the tape (tape_before: tape bytes before it) and
+// advance pc past the cell. False if the memory budget could not take its
+// snapshot; the step has still been applied.
+bool hr_ir_finish_step(HRIR_Runtime* runtime, size_t index, const HRIR_Effect* effect, size_t tape_before);
+
+// Evaluate, write and commit the cell at index (runtime already synced)
+bool hr_ir_execute(HRIR_Runtime* runtime, size_t index);
+
+// Run the fused group headed at the pc in one dispatch through the handler
+// for its pattern; same result, tape and position as stepping each cell
+bool hr_ir_step_fused(HRIR_Runtime* runtime);
+
+// =============================================================================
+// UNDO TAPE (hr_ir_tape.c)
+// =============================================================================
+
+// Slot overwritten by a step
+typedef enum {
+    HRIR_SLOT_NONE = 0,
+    HRIR_SLOT_REGISTER,
+    HRIR_SLOT_MEMORY,
+    HRIR_SLOT_RANGE          // Effects only: count memory slots, taped one by one
+} HRIR_SlotKind;
+
+// Outcome of popping one step off the tape
+typedef enum {
+    HRIR_TAPE_EMPTY = 0,     // Nothing to undo
+    HRIR_TAPE_IMPLICIT,      // Record-less step: caller inverts cell at pc - 1
+    HRIR_TAPE_RESTORED,      // Record applied, pc_before filled in
+    HRIR_TAPE_FAILED         // Copying shared chunks failed; nothing changed
+} HRIR_TapeUndo;
+
+void hr_ir_tape_init(HRIR_Tape* tape);
+void hr_ir_tape_free(HRIR_Tape* tape);
+
+// Count a fall-through step that is exactly invertible from the current state
+void hr_ir_tape_skip(HRIR_Tape* tape);
+
+// Record a step; old_value is encoded as a delta against new_value
+bool hr_ir_tape_record(HRIR_Tape* tape, size_t pc_before, size_t pc_after,
+                       uint8_t slot_kind, uint32_t slot,
+                       HRIR_Value old_value, HRIR_Value new_value);
+
+// One step of a fused group, already applied
+typedef struct {
+    size_t pc_before;
+    size_t pc_after;
+    uint8_t slot_kind;       // HRIR_SlotKind (not RANGE)
+    uint32_t slot;
+    bool implicit;           // Falls through and is invertible: no record
+    HRIR_Value old_value;
+    HRIR_Value new_value;
+} HRIR_TapeEntry;
+
+// Record a fused group's steps with one reservation. Each entry is still its
+// own step with the record hr_ir_tape_record or hr_ir_tape_skip would give
+// it, so undo inverts the group one cell at a time. All or nothing: false
+// leaves the tape unchanged.
+bool hr_ir_tape_record_group(HRIR_Tape* tape, const HRIR_TapeEntry* entries, size_t count);
+
+// Record a step about to overwrite memory[slot .. slot + count): the current
+// values are stored raw, one record per slot, and undone together
+bool hr_ir_tape_record_range(HRIR_Tape* tape, size_t pc_before, size_t pc_after, uint32_t slot,
+                             const HRIR_Value* old_values, size_t count);
+
+// Drop every record; the steps they covered move into tape->base
+void hr_ir_tape_discard(HRIR_Tape* tape);
+
+// Drop every record like hr_ir_tape_discard, keeping one chunk for reuse
+void hr_ir_tape_commit(HRIR_Tape* tape);
+
+// Append the tape as one HRIR_TapeSegment to file (false on write failure)
+bool hr_ir_tape_archive(const HRIR_Tape* tape, FILE* file);
+
+// Start fork as a copy of tape sharing all its chunks
+void hr_ir_tape_share(const HRIR_Tape* tape, HRIR_Tape* fork);
+
+// Pop the newest step, restoring the slot it overwrote
+HRIR_TapeUndo hr_ir_tape_undo(HRIR_Tape* tape, size_t pc_after,
+                              HRIR_Value* registers, HRIR_Value* memory,
+                              size_t* pc_before);
+
+// =============================================================================
+// CHECKPOINT TREE (hr_ir_checkpoint.c)
+// =============================================================================
+
+void hr_ir_checkpoints_init(HRIR_Runtime* runtime);
+void hr_ir_checkpoints_free(HRIR_Runtime* runtime);
+
+// Keep the active checkpoint on the current path after an undo
+void hr_ir_checkpoints_retreat(HRIR_Runtime* runtime);
+
+// Give fork its own copy of runtime's checkpoint tree
+bool hr_ir_checkpoints_copy(HRIR_Runtime* fork, const HRIR_Runtime* runtime);
+
+// =============================================================================
+// BOUNDED-MEMORY REVERSE EXECUTION (hr_ir_recompute.c)
+// =============================================================================
+
+// Called after every successful step: snapshot and thin as the budget requires
+bool hr_ir_recompute_after_step(HRIR_Runtime* runtime);
+
+// Undo one step past the start of the tape by restoring a snapshot and re-executing
+bool hr_ir_recompute_undo(HRIR_Runtime* runtime);
+
+// Replace every snapshot with one at the current state, dropping the tape
+bool hr_ir_recompute_commit(HRIR_Runtime* runtime);
+
+// Give a fork its own copy of the parent's snapshots and budget
+bool hr_ir_recompute_copy(HRIR_Runtime* fork, const HRIR_Runtime* runtime);
+
+void hr_ir_recompute_free(HRIR_Runtime* runtime);
+
+// =============================================================================
+// VECTOR KERNELS (hr_ir_vector.c)
+// =============================================================================
+
+// dst[k] = a[k] op b[k] for vadd, vsub and vxor, a[k] * factor for vscale.
+// dst is a or b, or disjoint from both. With integers_only it stops at the
+// first slot whose operands are not all integers; returns the slots applied.
+size_t hr_ir_vector_apply(HRIR_Opcode op, HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b,
+                          HRIR_Value factor, size_t count, bool integers_only);
+
+// Exactly undo an in-place integer vadd, vsub or vxor (dst is a or b)
+void hr_ir_vector_invert(HRIR_Opcode op, HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b,
+                         size_t count);
+
+// vsum: wrapping integer sum, or a float sum if any slot holds a float
+HRIR_Value hr_ir_vector_sum(const HRIR_Value* values, size_t count);
+
+// =============================================================================
+// FORKING (hr_ir_fork.c)
+// =============================================================================
+
+// Copy registers, memory and per-cell state shared with a fork before writing
+bool hr_ir_own_state(HRIR_Runtime* runtime);
+
+// Let go of shared state; arrays still used by a fork are left alone
+void hr_ir_release_state(HRIR_Runtime* runtime);
+
+#endif // HR_IR_INTERNAL_H
@@ -0,0 +1,506 @@
+// rio-riovn-merged/src/hr_ir_json.c
+// L1 HRIR JSON Loader - single-pass reader for hr_ir_serialize_program output
+//
+// The document is read once, front to back, and every cell is appended
+// straight into the program's parallel arrays. Strings without escapes are
+// interned directly from the input; only escaped strings are decoded, into
+// one reused scratch buffer. Cell ids are kept, so jump targets stay valid.
+
+#include "hr_ir_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char* start;
+    const char* p;
+    const char* end;
+    HRIR_Program* program;
+    char* scratch;           // Decoded text of the last escaped string
+    size_t scratch_capacity;
+    const char* error;       // First error; parsing stops there
+    const char* error_at;
+} HRIR_JsonReader;
+
+// A string token: either a slice of the input or the decoded scratch text
+typedef struct {
+    const char* text;
+    size_t length;
+} HRIR_JsonString;
+
+static bool json_fail(HRIR_JsonReader* reader, const char* message) {
+    if (!reader->error) {
+        reader->error = message;
+        reader->error_at = reader->p;
+    }
+    return false;
+}
+
+// =============================================================================
+// TOKENS
+// =============================================================================
+
+static void json_skip_space(HRIR_JsonReader* reader) {
+    const char* p = reader->p;
+    while (p < reader->end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+    reader->p = p;
+}
+
+// Consume c after optional whitespace
+static bool json_accept(HRIR_JsonReader* reader, char c) {
+    json_skip_space(reader);
+    if (reader->p < reader->end && *reader->p == c) {
+        reader->p++;
+        return true;
+    }
+    return false;
+}
+
+static bool json_expect(HRIR_JsonReader* reader, char c, const char* message) {
+    return json_accept(reader, c) || json_fail(reader, message);
+}
+
+static bool json_scratch_reserve(HRIR_JsonReader* reader, size_t needed) {
+    if (needed <= reader->scratch_capacity) return true;
+
+    size_t new_capacity = reader->scratch_capacity ? reader->scratch_capacity : 256;
+    while (new_capacity < needed) new_capacity *= 2;
+    char* scratch = realloc(reader->scratch, new_capacity);
+    if (!scratch) return json_fail(reader, "Out of memory");
+    reader->scratch = scratch;
+    reader->scratch_capacity = new_capacity;
+    return true;
+}
+
+static int json_hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool json_hex4(HRIR_JsonReader* reader, uint32_t* out) {
+    if (reader->end - reader->p < 4) return json_fail(reader, "Truncated \\u escape");
+
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = json_hex(reader->p[i]);
+        if (digit < 0) return json_fail(reader, "Invalid \\u escape");
+        value = value << 4 | (uint32_t)digit;
+    }
+    reader->p += 4;
+    *out = value;
+    return true;
+}
+
+static size_t json_put_utf8(char* out, uint32_t code) {
+    if (code < 0x80) {
+        out[0] = (char)code;
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = (char)(0xc0 | code >> 6);
+        out[1] = (char)(0x80 | (code & 0x3f));
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = (char)(0xe0 | code >> 12);
+        out[1] = (char)(0x80 | (code >> 6 & 0x3f));
+        out[2] = (char)(0x80 | (code & 0x3f));
+        return 3;
+    }
+    out[0] = (char)(0xf0 | code >> 18);
+    out[1] = (char)(0x80 | (code >> 12 & 0x3f));
+    out[2] = (char)(0x80 | (code >> 6 & 0x3f));
+    out[3] = (char)(0x80 | (code & 0x3f));
+    return 4;
+}
+
+// Decode the escaped remainder of a string whose plain prefix is [begin, p)
+static bool json_decode_string(HRIR_JsonReader* reader, const char* begin, HRIR_JsonString* out) {
+    size_t length = (size_t)(reader->p - begin);
+    if (!json_scratch_reserve(reader, length + 64)) return false;
+    memcpy(reader->scratch, begin, length);
+
+    while (reader->p < reader->end) {
+        char c = *reader->p++;
+        if (c == '"') {
+            out->text = reader->scratch;
+            out->length = length;
+            return true;
+        }
+        if ((unsigned char)c < 0x20) return json_fail(reader, "Control character in string");
+
+        // Worst case per input byte is a 4-byte sequence from a surrogate pair
+        if (!json_scratch_reserve(reader, length + 8)) return false;
+
+        if (c != '\\') {
+            reader->scratch[length++] = c;
+            continue;
+        }
+        if (reader->p >= reader->end) break;
+
+        char e = *reader->p++;
+        switch (e) {
+            case '"': reader->scratch[length++] = '"'; break;
+            case '\\': reader->scratch[length++] = '\\'; break;
+            case '/': reader->scratch[length++] = '/'; break;
+            case 'b': reader->scratch[length++] = '\b'; break;
+            case 'f': reader->scratch[length++] = '\f'; break;
+            case 'n': reader->scratch[length++] = '\n'; break;
+            case 'r': reader->scratch[length++] = '\r'; break;
+            case 't': reader->scratch[length++] = '\t'; break;
+            case 'u': {
+                uint32_t code;
+                if (!json_hex4(reader, &code)) return false;
+                if (code >= 0xd800 && code < 0xdc00) {
+                    uint32_t low;
+                    if (reader->end - reader->p < 2 || reader->p[0] != '\\' || reader->p[1] != 'u') {
+                        return json_fail(reader, "Unpaired surrogate in \\u escape");
+                    }
+                    reader->p += 2;
+                    if (!json_hex4(reader, &low)) return false;
+                    if (low < 0xdc00 || low >= 0xe000) return json_fail(reader, "Unpaired surrogate in \\u escape");
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                } else if (code >= 0xdc00 && code < 0xe000) {
+                    return json_fail(reader, "Unpaired surrogate in \\u escape");
+                }
+                // Pool texts are NUL-terminated
+                if (code == 0) return json_fail(reader, "NUL character in string");
+                length += json_put_utf8(reader->scratch + length, code);
+                break;
+            }
+            default:
+                return json_fail(reader, "Invalid escape in string");
+        }
+    }
+    return json_fail(reader, "Unterminated string");
+}
+
+static bool json_string(HRIR_JsonReader* reader, HRIR_JsonString* out) {
+    if (!json_expect(reader, '"', "Expected a string")) return false;
+
+    // Fast path: no escapes, point into the input
+    const char* begin = reader->p;
+    const char* p = begin;
+    while (p < reader->end && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20) p++;
+    reader->p = p;
+
+    if (p < reader->end && *p == '"') {
+        reader->p++;
+        out->text = begin;
+        out->length = (size_t)(p - begin);
+        return true;
+    }
+    return json_decode_string(reader, begin, out);
+}
+
+static bool json_key_is(const HRIR_JsonString* key, const char* name) {
+    size_t length = strlen(name);
+    return key->length == length && memcmp(key->text, name, length) == 0;
+}
+
+// Non-negative integer that fits in max
+static bool json_unsigned(HRIR_JsonReader* reader, uint64_t max, uint64_t* out) {
+    json_skip_space(reader);
+    const char* p = reader->p;
+    if (p >= reader->end || *p < '0' || *p > '9') return json_fail(reader, "Expected a non-negative integer");
+
+    uint64_t value = 0;
+    while (p < reader->end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (uint64_t)(*p - '0');
+        if (value > max) return json_fail(reader, "Integer out of range");
+        p++;
+    }
+    if (p < reader->end && (*p == '.' || *p == 'e' || *p == 'E')) {
+        return json_fail(reader, "Expected a non-negative integer");
+    }
+    reader->p = p;
+    *out = value;
+    return true;
+}
+
+static bool json_literal(HRIR_JsonReader* reader, const char* word) {
+    size_t length = strlen(word);
+    if ((size_t)(reader->end - reader->p) < length || memcmp(reader->p, word, length) != 0) return false;
+    reader->p += length;
+    return true;
+}
+
+static bool json_bool(HRIR_JsonReader* reader, bool* out) {
+    json_skip_space(reader);
+    if (json_literal(reader, "true")) {
+        *out = true;
+        return true;
+    }
+    if (json_literal(reader, "false")) {
+        *out = false;
+        return true;
+    }
+    return json_fail(reader, "Expected true or false");
+}
+
+// Number token as written, for numeric arguments
+static bool json_number_text(HRIR_JsonReader* reader, HRIR_JsonString* out) {
+    json_skip_space(reader);
+    const char* begin = reader->p;
+    const char* p = begin;
+    if (p < reader->end && *p == '-') p++;
+    while (p < reader->end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' ||
+                               *p == '+' || *p == '-')) {
+        p++;
+    }
+    if (p == begin || (p == begin + 1 && *begin == '-')) return json_fail(reader, "Expected a value");
+    reader->p = p;
+    out->text = begin;
+    out->length = (size_t)(p - begin);
+    return true;
+}
+
+// Skip any value of an unknown key
+static bool json_skip_value(HRIR_JsonReader* reader, int depth) {
+    if (depth > 64) return json_fail(reader, "Nesting too deep");
+    json_skip_space(reader);
+    if (reader->p >= reader->end) return json_fail(reader, "Expected a value");
+
+    HRIR_JsonString text;
+    switch (*reader->p) {
+        case '"':
+            return json_string(reader, &text);
+        case '{':
+            reader->p++;
+            if (json_accept(reader, '}')) return true;
+            do {
+                if (!json_string(reader, &text) || !json_expect(reader, ':', "Expected ':'") ||
+                    !json_skip_value(reader, depth + 1)) {
+                    return false;
+                }
+            } while (json_accept(reader, ','));
+            return json_expect(reader, '}', "Expected ',' or '}'");
+        case '[':
+            reader->p++;
+            if (json_accept(reader, ']')) return true;
+            do {
+                if (!json_skip_value(reader, depth + 1)) return false;
+            } while (json_accept(reader, ','));
+            return json_expect(reader, ']', "Expected ',' or ']'");
+        case 't':
+        case 'f': {
+            bool value;
+            return json_bool(reader, &value);
+        }
+        case 'n':
+            return json_literal(reader, "null") || json_fail(reader, "Expected a value");
+        default:
+            return json_number_text(reader, &text);
+    }
+}
+
+// =============================================================================
+// SCHEMA
+// =============================================================================
+
+static uint32_t json_intern(HRIR_JsonReader* reader, const HRIR_JsonString* text) {
+    uint32_t id = hr_ir_intern(reader->program, text->text, text->length);
+    if (id == HRIR_NO_CONST) json_fail(reader, "Constant pool full");
+    return id;
+}
+
+// "args": [...], interned straight into the program's argument slots
+static bool json_cell_args(HRIR_JsonReader* reader, size_t* count) {
+    HRIR_Program* program = reader->program;
+    if (!json_expect(reader, '[', "Expected '[' for args")) return false;
+    *count = 0;
+    if (json_accept(reader, ']')) return true;
+
+    do {
+        HRIR_JsonString text;
+        json_skip_space(reader);
+        bool ok = reader->p < reader->end && *reader->p == '"' ? json_string(reader, &text)
+                                                                : json_number_text(reader, &text);
+        if (!ok) return false;
+        if (!hr_ir_reserve_cell(program, *count + 1)) return json_fail(reader, "Too many arguments");
+
+        uint32_t id = json_intern(reader, &text);
+        if (id == HRIR_NO_CONST) return false;
+        program->args[program->arg_count + (*count)++] = id;
+    } while (json_accept(reader, ','));
+
+    return json_expect(reader, ']', "Expected ',' or ']' in args");
+}
+
+static bool json_cell(HRIR_JsonReader* reader) {
+    HRIR_Program* program = reader->program;
+    const char* cell_start = reader->p;
+
+    uint64_t id = program->next_id;
+    uint64_t line_number = 0;
+    HRIR_Opcode op = HRIR_OPC_COUNT;
+    uint32_t opcode_name = HRIR_NO_CONST;
+    uint32_t source_location = HRIR_NO_CONST;
+    uint32_t canonical_path = HRIR_NO_CONST;
+    bool is_reversible = true;
+    bool has_args = false;
+    size_t arg_count = 0;
+
+    if (!json_expect(reader, '{', "Expected '{' for a cell")) return false;
+    if (!hr_ir_reserve_cell(program, 0)) return json_fail(reader, "Out of memory");
+
+    if (!json_accept(reader, '}')) {
+        do {
+            HRIR_JsonString key;
+            if (!json_string(reader, &key) || !json_expect(reader, ':', "Expected ':'")) return false;
+
+            if (json_key_is(&key, "id")) {
+                if (!json_unsigned(reader, UINT32_MAX - 1, &id)) return false;
+            } else if (json_key_is(&key, "opcode")) {
+                HRIR_JsonString name;
+                char builtin[16];
+                if (!json_string(reader, &name)) return false;
+                op = HRIR_OPC_CUSTOM;
+                if (name.length < sizeof(builtin)) {
+                    memcpy(builtin, name.text, name.length);
+                    builtin[name.length] = '\0';
+                    op = hr_ir_opcode_from_name(builtin);
+                }
+                opcode_name = HRIR_NO_CONST;
+                if (op == HRIR_OPC_CUSTOM && (opcode_name = json_intern(reader, &name)) == HRIR_NO_CONST) {
+                    return false;
+                }
+            } else if (json_key_is(&key, "args")) {
+                if (has_args) return json_fail(reader, "Duplicate args");
+                if (!json_cell_args(reader, &arg_count)) return false;
+                has_args = true;
+            } else if (json_key_is(&key, "is_reversible")) {
+                if (!json_bool(reader, &is_reversible)) return false;
+            } else if (json_key_is(&key, "source_location")) {
+                HRIR_JsonString text;
+                if (!json_string(reader, &text)) return false;
+                if ((source_location = json_intern(reader, &text)) == HRIR_NO_CONST) return false;
+            } else if (json_key_is(&key, "canonical_path")) {
+                HRIR_JsonString text;
+                if (!json_string(reader, &text)) return false;
+                if ((canonical_path = json_intern(reader, &text)) == HRIR_NO_CONST) return false;
+            } else if (json_key_is(&key, "line_number")) {
+                if (!json_unsigned(reader, UINT32_MAX, &line_number)) return false;
+            } else if (!json_skip_value(reader, 0)) {
+                return false;
+            }
+        } while (json_accept(reader, ','));
+
+        if (!json_expect(reader, '}', "Expected ',' or '}' in cell")) return false;
+    }
+
+    if (op == HRIR_OPC_COUNT) {
+        reader->p = cell_start;
+        return json_fail(reader, "Cell has no opcode");
+    }
+    if (id == 0 || (program->cell_count > 0 && id <= program->ids[program->cell_count - 1])) {
+        reader->p = cell_start;
+        return json_fail(reader, "Cell ids must be positive and increasing");
+    }
+
+    size_t index = hr_ir_push_cell(program, op, opcode_name, arg_count,
+                                   is_reversible ? HRIR_FLAG_REVERSIBLE : 0, (uint32_t)id);
+    program->meta[index].source_location = source_location;
+    program->meta[index].canonical_path = canonical_path;
+    program->meta[index].line_number = (uint32_t)line_number;
+    return true;
+}
+
+static bool json_program(HRIR_JsonReader* reader) {
+    HRIR_Program* program = reader->program;
+    bool has_cells = false;
+    bool has_count = false;
+    uint64_t cell_count = 0;
+
+    if (!json_expect(reader, '{', "Expected '{' at the start of the program")) return false;
+    if (json_accept(reader, '}')) return json_fail(reader, "Program has no cells array");
+
+    do {
+        HRIR_JsonString key;
+        if (!json_string(reader, &key) || !json_expect(reader, ':', "Expected ':'")) return false;
+
+        if (json_key_is(&key, "source_name")) {
+            HRIR_JsonString name;
+            if (!json_string(reader, &name)) return false;
+            char* copy = malloc(name.length + 1);
+            if (!copy) return json_fail(reader, "Out of memory");
+            memcpy(copy, name.text, name.length);
+            copy[name.length] = '\0';
+            free((void*)program->source_name);
+            program->source_name = copy;
+        } else if (json_key_is(&key, "cell_count")) {
+            if (!json_unsigned(reader, UINT32_MAX, &cell_count)) return false;
+            has_count = true;
+
+            // Size the arrays up front; a cell takes at least 16 bytes of text
+            size_t plausible = (size_t)(reader->end - reader->p) / 16;
+            size_t cells = cell_count < plausible ? (size_t)cell_count : plausible;
+            if (!hr_ir_reserve(program, cells, 0)) return json_fail(reader, "Out of memory");
+        } else if (json_key_is(&key, "cells")) {
+            if (has_cells) return json_fail(reader, "Duplicate cells array");
+            has_cells = true;
+            if (!json_expect(reader, '[', "Expected '[' for cells")) return false;
+            if (!json_accept(reader, ']')) {
+                do {
+                    if (!json_cell(reader)) return false;
+                } while (json_accept(reader, ','));
+                if (!json_expect(reader, ']', "Expected ',' or ']' in cells")) return false;
+            }
+        } else if (!json_skip_value(reader, 0)) {
+            return false;
+        }
+    } while (json_accept(reader, ','));
+
+    if (!json_expect(reader, '}', "Expected ',' or '}' in program")) return false;
+    if (!has_cells) return json_fail(reader, "Program has no cells array");
+    if (has_count && cell_count != program->cell_count) {
+        return json_fail(reader, "cell_count does not match the cells array");
+    }
+
+    json_skip_space(reader);
+    if (reader->p != reader->end) return json_fail(reader, "Unexpected text after the program");
+    return true;
+}
+
+// =============================================================================
+// LOADER API
+// =============================================================================
+
+HRIR_Program* hr_ir_parse_program(const char* json, size_t length, char** error_message) {
+    if (error_message) *error_message = NULL;
+    if (!json) return NULL;
+
+    HRIR_JsonReader reader = { .start = json, .p = json, .end = json + length };
+    reader.program = hr_ir_create_program(NULL);
+    if (!reader.program) return NULL;
+
+    bool ok = json_program(&reader);
+    free(reader.scratch);
+
+    if (!ok) {
+        if (error_message && reader.error) {
+            size_t line = 1, column = 1;
+            for (const char* p = reader.start; p < reader.error_at; p++) {
+                if (*p == '\n') {
+                    line++;
+                    column = 1;
+                } else {
+                    column++;
+                }
+            }
+            char message[160];
+            snprintf(message, sizeof(message), "%s at line %zu, column %zu", reader.error, line, column);
+            *error_message = malloc(strlen(message) + 1);
+            if (*error_message) strcpy(*error_message, message);
+        }
+        hr_ir_free_program(reader.program);
+        return NULL;
+    }
+    return reader.program;
+}
+
+HRIR_Program* hr_ir_deserialize_program(const char* json) {
+    return json ? hr_ir_parse_program(json, strlen(json), NULL) : NULL;
+}
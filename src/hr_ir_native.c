@@ -0,0 +1,578 @@
+// rio-riovn-merged/src/hr_ir_native.c
+// L1 HRIR Native Backend - ahead-of-time translation to C
+//
+// Each cell becomes a labelled block of straight-line C: operands are
+// resolved to register slots or immediates at translation time, literal
+// jump targets become gotos, and the commit (tape record or implicit step,
+// per-cell state, step count) is written inline. The generated code works on
+// the runtime's own registers and tape, so the history it leaves is the one
+// the interpreter would have left and hr_ir_undo, checkpoints and replay work
+// unchanged. Cells it does not specialize (memory, vector ops, I/O, custom
+// opcodes, malformed operands, division by zero, dynamic jump targets) call
+// back into the interpreter for that one cell and continue through a pc
+// dispatch.
+//
+// The translation unit includes only standard headers and talks to the
+// runtime through HRIR_NativeContext; it is compiled by the system C
+// compiler ($CC, default cc) into a shared object and loaded with dlopen.
+
+#define _POSIX_C_SOURCE 200809L
+#include "hr_ir_internal.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef __EMSCRIPTEN__
+#include <dlfcn.h>
+#endif
+
+#define HRIR_NATIVE_ABI 1
+
+// Shared with the generated code, which declares an identical struct
+typedef struct {
+    void* runtime;
+    HRIR_Value* registers;
+    uint32_t* exec_counts;
+    HRIR_Value* results;
+    uint64_t* tape_steps;
+    uint64_t* tape_implicit;
+    size_t* steps_executed;
+    size_t* pc;
+    bool (*step)(void* runtime, size_t index);
+    bool (*record)(void* runtime, size_t index, size_t next_pc, int slot_kind, uint32_t slot,
+                   HRIR_Value old_value, HRIR_Value new_value);
+} HRIR_NativeContext;
+
+typedef int (*HRIR_NativeEntry)(HRIR_NativeContext* context);
+
+struct HRIR_Native {
+    void* handle;
+    HRIR_NativeEntry entry;
+    const HRIR_Program* program; // The program the object was checked against
+};
+
+// Identity of the cells a translation unit was generated from
+static uint64_t native_fingerprint(const HRIR_Program* program) {
+    uint64_t hash = 1469598103934665603ULL;
+    uint64_t words[4];
+    for (size_t i = 0; i < program->cell_count; i++) {
+        words[0] = program->opcodes[i];
+        words[1] = program->ids[i];
+        words[2] = program->arg_counts[i];
+        words[3] = program->pool.register_count;
+        for (int w = 0; w < 4; w++) hash = (hash ^ words[w]) * 1099511628211ULL;
+
+        const uint32_t* args = program->args + program->arg_offsets[i];
+        for (size_t j = 0; j < program->arg_counts[i]; j++) {
+            const HRIR_Const* entry = &program->pool.entries[args[j]];
+            const char* text = program->pool.bytes + entry->offset;
+            for (uint32_t k = 0; k <= entry->length; k++) {
+                hash = (hash ^ (unsigned char)text[k]) * 1099511628211ULL;
+            }
+        }
+    }
+    return hash ^ program->cell_count;
+}
+
+// =============================================================================
+// C EMITTER
+// =============================================================================
+
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+    bool failed;
+} HRIR_NativeBuffer;
+
+static void native_printf(HRIR_NativeBuffer* out, const char* format, ...) {
+    if (out->failed) return;
+
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(out->data ? out->data + out->size : NULL,
+                               out->data ? out->capacity - out->size : 0, format, args);
+        va_end(args);
+        if (length < 0) {
+            out->failed = true;
+            return;
+        }
+        if (out->data && out->size + (size_t)length < out->capacity) {
+            out->size += (size_t)length;
+            return;
+        }
+
+        size_t capacity = out->capacity ? out->capacity * 2 : 65536;
+        while (capacity <= out->size + (size_t)length) capacity *= 2;
+        char* data = realloc(out->data, capacity);
+        if (!data) {
+            out->failed = true;
+            return;
+        }
+        out->data = data;
+        out->capacity = capacity;
+    }
+}
+
+static const char* native_prelude =
+    "#include <stdint.h>\n"
+    "#include <stddef.h>\n"
+    "#include <stdbool.h>\n"
+    "#include <string.h>\n"
+    "\n"
+    "typedef struct { uint8_t type; union { int64_t i; double f; } as; } hrir_value;\n"
+    "\n"
+    "typedef struct {\n"
+    "    void* runtime;\n"
+    "    hrir_value* registers;\n"
+    "    uint32_t* exec_counts;\n"
+    "    hrir_value* results;\n"
+    "    uint64_t* tape_steps;\n"
+    "    uint64_t* tape_implicit;\n"
+    "    size_t* steps_executed;\n"
+    "    size_t* pc;\n"
+    "    bool (*step)(void* runtime, size_t index);\n"
+    "    bool (*record)(void* runtime, size_t index, size_t next_pc, int slot_kind, uint32_t slot,\n"
+    "                   hrir_value old_value, hrir_value new_value);\n"
+    "} hrir_context;\n"
+    "\n"
+    "static inline hrir_value v_int(int64_t i) { hrir_value v; v.type = T_INT; v.as.i = i; return v; }\n"
+    "static inline hrir_value v_float(double f) { hrir_value v; v.type = T_FLOAT; v.as.f = f; return v; }\n"
+    "static inline hrir_value v_none(void) { hrir_value v; memset(&v, 0, sizeof(v)); v.type = T_NONE; return v; }\n"
+    "static inline hrir_value v_int_bits(uint64_t bits) { return v_int((int64_t)bits); }\n"
+    "static inline hrir_value v_float_bits(uint64_t bits) { double f; memcpy(&f, &bits, 8); return v_float(f); }\n"
+    "static inline hrir_value v_reg(hrir_value v) { return v.type == T_NONE ? v_int(0) : v; }\n"
+    "static inline double v_as_float(hrir_value v) { return v.type == T_FLOAT ? v.as.f : (double)v.as.i; }\n"
+    "static inline bool v_true(hrir_value v) { return v.type == T_FLOAT ? v.as.f != 0.0 : v.as.i != 0; }\n"
+    "\n"
+    "static inline bool v_arith(int op, hrir_value a, hrir_value b, hrir_value* out) {\n"
+    "    if (a.type == T_INT && b.type == T_INT) {\n"
+    "        uint64_t x = (uint64_t)a.as.i, y = (uint64_t)b.as.i;\n"
+    "        switch (op) {\n"
+    "            case OP_ADD: *out = v_int((int64_t)(x + y)); return true;\n"
+    "            case OP_SUBTRACT: *out = v_int((int64_t)(x - y)); return true;\n"
+    "            case OP_MULTIPLY: *out = v_int((int64_t)(x * y)); return true;\n"
+    "            default:\n"
+    "                if (b.as.i == 0) return false;\n"
+    "                *out = v_int(a.as.i == INT64_MIN && b.as.i == -1 ? INT64_MIN : a.as.i / b.as.i);\n"
+    "                return true;\n"
+    "        }\n"
+    "    }\n"
+    "    double x = v_as_float(a), y = v_as_float(b);\n"
+    "    switch (op) {\n"
+    "        case OP_ADD: *out = v_float(x + y); return true;\n"
+    "        case OP_SUBTRACT: *out = v_float(x - y); return true;\n"
+    "        case OP_MULTIPLY: *out = v_float(x * y); return true;\n"
+    "        default:\n"
+    "            if (y == 0.0) return false;\n"
+    "            *out = v_float(x / y);\n"
+    "            return true;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "static inline hrir_value v_compare(int op, hrir_value a, hrir_value b) {\n"
+    "    int order;\n"
+    "    if (a.type == T_INT && b.type == T_INT) {\n"
+    "        order = (a.as.i > b.as.i) - (a.as.i < b.as.i);\n"
+    "    } else {\n"
+    "        double x = v_as_float(a), y = v_as_float(b);\n"
+    "        order = (x > y) - (x < y);\n"
+    "    }\n"
+    "    if (op == OP_EQUAL) return v_int(order == 0);\n"
+    "    if (op == OP_LESS) return v_int(order < 0);\n"
+    "    return v_int(order > 0);\n"
+    "}\n"
+    "\n"
+    "// Interpreter for one cell, then resume wherever it left the pc\n"
+    "#define FALLBACK(i) do { *ctx->pc = (i); if (!ctx->step(ctx->runtime, (i))) return 0; goto dispatch; } while (0)\n"
+    "\n"
+    "// Per-cell state and step count, as the interpreter's commit keeps them\n"
+    "#define COMMITTED(i, value) do { ctx->exec_counts[i]++; ctx->results[i] = (value); (*ctx->steps_executed)++; } while (0)\n"
+    "\n"
+    "// A fall-through step exactly invertible from the state it leaves\n"
+    "#define IMPLICIT() do { (*ctx->tape_steps)++; (*ctx->tape_implicit)++; } while (0)\n"
+    "\n";
+
+// An operand as C: an immediate, a register read, or NULL for anything the
+// interpreter rejects
+static bool native_operand(const HRIR_Program* program, uint32_t const_id, char* out, size_t size) {
+    const HRIR_Const* entry = &program->pool.entries[const_id];
+    if (entry->kind == HRIR_CONST_SYMBOL) {
+        snprintf(out, size, "v_reg(regs[%u])", entry->reg);
+    } else if (entry->kind == HRIR_CONST_NUMBER && entry->value.type == HRIR_VALUE_FLOAT) {
+        uint64_t bits;
+        memcpy(&bits, &entry->value.as.f, sizeof(bits));
+        snprintf(out, size, "v_float_bits(0x%016llxULL)", (unsigned long long)bits);
+    } else if (entry->kind == HRIR_CONST_NUMBER) {
+        snprintf(out, size, "v_int_bits(0x%016llxULL)", (unsigned long long)(uint64_t)entry->value.as.i);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Index of a literal jump target, if it names a cell
+static bool native_target(const HRIR_Program* program, uint32_t const_id, size_t* index) {
+    const HRIR_Const* entry = &program->pool.entries[const_id];
+    if (entry->kind != HRIR_CONST_NUMBER || entry->value.type != HRIR_VALUE_INT ||
+        entry->value.as.i <= 0 || entry->value.as.i > UINT32_MAX) {
+        return false;
+    }
+    return hr_ir_find_index(program, (uint32_t)entry->value.as.i, index);
+}
+
+// Record-or-skip for a step with no target that continues at next
+static void native_emit_branch(HRIR_NativeBuffer* out, size_t index, size_t next) {
+    if (next == index + 1) {
+        native_printf(out, "        IMPLICIT();\n");
+    } else {
+        native_printf(out, "        if (!ctx->record(ctx->runtime, %zu, %zu, %d, 0, v_int(0), v_int(0))) "
+                           "{ *ctx->pc = %zu; return 0; }\n", index, next, HRIR_SLOT_NONE, index);
+    }
+    native_printf(out, "        COMMITTED(%zu, v_none());\n", index);
+    native_printf(out, "        goto L%zu;\n", next);
+}
+
+static void native_emit_binary(HRIR_NativeBuffer* out, const HRIR_Program* program, size_t index) {
+    HRIR_Opcode op = (HRIR_Opcode)program->opcodes[index];
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    size_t arg_count = program->arg_counts[index];
+    char a[64], b[64];
+
+    uint32_t dest = HRIR_RESULT_REGISTER;
+    if (arg_count > 2) {
+        const HRIR_Const* entry = &program->pool.entries[args[2]];
+        if (entry->kind != HRIR_CONST_SYMBOL) arg_count = 0; // Rejected by the interpreter
+        dest = entry->reg;
+    }
+    if (arg_count < 2 || !native_operand(program, args[0], a, sizeof(a)) ||
+        !native_operand(program, args[1], b, sizeof(b))) {
+        native_printf(out, "    FALLBACK(%zu);\n", index);
+        return;
+    }
+
+    // Integer add/subtract into exactly one of its own operands writes no record
+    const HRIR_Const* first = &program->pool.entries[args[0]];
+    const HRIR_Const* second = &program->pool.entries[args[1]];
+    bool first_is_dest = first->kind == HRIR_CONST_SYMBOL && first->reg == dest;
+    bool second_is_dest = second->kind == HRIR_CONST_SYMBOL && second->reg == dest;
+    bool may_be_exact = (op == HRIR_OPC_ADD || op == HRIR_OPC_SUBTRACT) && first_is_dest != second_is_dest;
+
+    native_printf(out, "    {\n");
+    native_printf(out, "        hrir_value a = %s, b = %s, v;\n", a, b);
+    if (op >= HRIR_OPC_EQUAL) {
+        native_printf(out, "        v = v_compare(%d, a, b);\n", op);
+    } else {
+        native_printf(out, "        if (!v_arith(%d, a, b, &v)) FALLBACK(%zu);\n", op, index);
+    }
+    if (may_be_exact) {
+        native_printf(out, "        bool exact = a.type == T_INT && b.type == T_INT && regs[%u].type == T_INT;\n", dest);
+    } else {
+        native_printf(out, "        bool exact = false;\n");
+    }
+    native_printf(out, "        hrir_value old = regs[%u];\n", dest);
+    native_printf(out, "        regs[%u] = v;\n", dest);
+    native_printf(out, "        if (exact) IMPLICIT();\n");
+    native_printf(out, "        else if (!ctx->record(ctx->runtime, %zu, %zu, %d, %u, old, v)) "
+                       "{ regs[%u] = old; *ctx->pc = %zu; return 0; }\n",
+                  index, index + 1, HRIR_SLOT_REGISTER, dest, dest, index);
+    native_printf(out, "        COMMITTED(%zu, v);\n", index);
+    native_printf(out, "    }\n");
+}
+
+static void native_emit_cell(HRIR_NativeBuffer* out, const HRIR_Program* program, size_t index) {
+    HRIR_Opcode op = (HRIR_Opcode)program->opcodes[index];
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    size_t arg_count = program->arg_counts[index];
+    size_t target;
+    char condition[64];
+
+    native_printf(out, "L%zu:\n", index);
+    switch (op) {
+        case HRIR_OPC_ADD:
+        case HRIR_OPC_SUBTRACT:
+        case HRIR_OPC_MULTIPLY:
+        case HRIR_OPC_DIVIDE:
+        case HRIR_OPC_EQUAL:
+        case HRIR_OPC_LESS:
+        case HRIR_OPC_GREATER:
+            native_emit_binary(out, program, index);
+            break;
+
+        case HRIR_OPC_JUMP:
+            if (arg_count < 1 || !native_target(program, args[0], &target)) {
+                native_printf(out, "    FALLBACK(%zu);\n", index);
+                break;
+            }
+            native_printf(out, "    {\n");
+            native_emit_branch(out, index, target);
+            native_printf(out, "    }\n");
+            break;
+
+        case HRIR_OPC_JUMP_IF:
+            if (arg_count < 2 || !native_operand(program, args[0], condition, sizeof(condition))) {
+                native_printf(out, "    FALLBACK(%zu);\n", index);
+                break;
+            }
+            native_printf(out, "    if (v_true(%s)) {\n", condition);
+            if (native_target(program, args[1], &target)) {
+                native_emit_branch(out, index, target);
+            } else {
+                native_printf(out, "        FALLBACK(%zu);\n", index);
+            }
+            native_printf(out, "    } else {\n");
+            native_printf(out, "        IMPLICIT();\n");
+            native_printf(out, "        COMMITTED(%zu, v_none());\n", index);
+            native_printf(out, "    }\n");
+            break;
+
+        default:
+            // Memory, vector, I/O and custom cells never jump: the interpreter runs
+            // the cell and control falls through
+            native_printf(out, "    *ctx->pc = %zu;\n", index);
+            native_printf(out, "    if (!ctx->step(ctx->runtime, %zu)) return 0;\n", index);
+            break;
+    }
+}
+
+char* hr_ir_emit_c(const HRIR_Program* program) {
+    if (!program) return NULL;
+
+    HRIR_NativeBuffer out = {0};
+    native_printf(&out, "// Generated from HRIR program \"%s\" (%zu cells); do not edit\n",
+                  program->source_name ? program->source_name : "", program->cell_count);
+    native_printf(&out, "#define T_NONE %d\n#define T_INT %d\n#define T_FLOAT %d\n",
+                  HRIR_VALUE_NONE, HRIR_VALUE_INT, HRIR_VALUE_FLOAT);
+    native_printf(&out, "#define OP_ADD %d\n#define OP_SUBTRACT %d\n#define OP_MULTIPLY %d\n",
+                  HRIR_OPC_ADD, HRIR_OPC_SUBTRACT, HRIR_OPC_MULTIPLY);
+    native_printf(&out, "#define OP_EQUAL %d\n#define OP_LESS %d\n\n", HRIR_OPC_EQUAL, HRIR_OPC_LESS);
+    native_printf(&out, "%s", native_prelude);
+
+    native_printf(&out, "const uint32_t hrir_native_abi = %d;\n", HRIR_NATIVE_ABI);
+    native_printf(&out, "const uint32_t hrir_native_value_size = %zu;\n", sizeof(HRIR_Value));
+    native_printf(&out, "const uint64_t hrir_native_fingerprint = 0x%016llxULL;\n\n",
+                  (unsigned long long)native_fingerprint(program));
+
+    native_printf(&out, "int hrir_native_run(hrir_context* ctx) {\n");
+    native_printf(&out, "    hrir_value* const regs = ctx->registers;\n");
+    native_printf(&out, "dispatch:\n");
+    native_printf(&out, "    switch (*ctx->pc) {\n");
+    for (size_t i = 0; i < program->cell_count; i++) {
+        native_printf(&out, "        case %zu: goto L%zu;\n", i, i);
+    }
+    native_printf(&out, "        default: return *ctx->pc == %zu;\n", program->cell_count);
+    native_printf(&out, "    }\n\n");
+
+    for (size_t i = 0; i < program->cell_count; i++) {
+        native_emit_cell(&out, program, i);
+    }
+    native_printf(&out, "L%zu:\n", program->cell_count);
+    native_printf(&out, "    *ctx->pc = %zu;\n", program->cell_count);
+    native_printf(&out, "    return 1;\n");
+    native_printf(&out, "}\n");
+
+    if (out.failed) {
+        free(out.data);
+        return NULL;
+    }
+    return out.data;
+}
+
+// =============================================================================
+// BUILD AND LOAD
+// =============================================================================
+
+static bool native_fail(char** error_message, const char* format, ...) {
+    if (!error_message) return false;
+
+    char message[1024];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    *error_message = strdup(message);
+    return false;
+}
+
+#ifdef __EMSCRIPTEN__
+
+bool hr_ir_compile_native(const HRIR_Program* program, const char* so_path, char** error_message) {
+    (void)program;
+    (void)so_path;
+    if (error_message) *error_message = NULL;
+    return native_fail(error_message, "Native compilation is not available on this platform");
+}
+
+HRIR_Native* hr_ir_load_native(const char* so_path, const HRIR_Program* program, char** error_message) {
+    (void)so_path;
+    (void)program;
+    if (error_message) *error_message = NULL;
+    native_fail(error_message, "Native loading is not available on this platform");
+    return NULL;
+}
+
+void hr_ir_free_native(HRIR_Native* native) {
+    free(native);
+}
+
+#else
+
+bool hr_ir_compile_native(const HRIR_Program* program, const char* so_path, char** error_message) {
+    if (error_message) *error_message = NULL;
+    if (!program || !so_path) return native_fail(error_message, "No program or output path");
+    if (strchr(so_path, '\'')) return native_fail(error_message, "Output path may not contain quotes");
+
+    char* source = hr_ir_emit_c(program);
+    if (!source) return native_fail(error_message, "Out of memory");
+
+    size_t path_length = strlen(so_path) + 3;
+    char* source_path = malloc(path_length);
+    if (!source_path) {
+        free(source);
+        return native_fail(error_message, "Out of memory");
+    }
+    snprintf(source_path, path_length, "%s.c", so_path);
+
+    FILE* file = fopen(source_path, "w");
+    bool written = file && fputs(source, file) >= 0;
+    if (file && fclose(file) != 0) written = false;
+    free(source);
+    if (!written) {
+        remove(source_path);
+        free(source_path);
+        return native_fail(error_message, "Cannot write %s.c", so_path);
+    }
+
+    const char* compiler = getenv("CC");
+    if (!compiler || !*compiler) compiler = "cc";
+    size_t command_length = strlen(compiler) + 2 * strlen(so_path) + 64;
+    char* command = malloc(command_length);
+    if (!command) {
+        remove(source_path);
+        free(source_path);
+        return native_fail(error_message, "Out of memory");
+    }
+    snprintf(command, command_length, "%s -O2 -shared -fPIC -o '%s' '%s' 2>&1",
+             compiler, so_path, source_path);
+
+    // Keep the first lines of compiler output for the error message
+    char output[512] = "";
+    size_t used = 0;
+    FILE* pipe = popen(command, "r");
+    int status = -1;
+    if (pipe) {
+        char line[256];
+        while (fgets(line, sizeof(line), pipe)) {
+            size_t length = strlen(line);
+            if (used + length < sizeof(output)) {
+                memcpy(output + used, line, length + 1);
+                used += length;
+            }
+        }
+        status = pclose(pipe);
+    }
+    free(command);
+    remove(source_path);
+    free(source_path);
+
+    if (status != 0) return native_fail(error_message, "C compiler failed: %s", output);
+    return true;
+}
+
+HRIR_Native* hr_ir_load_native(const char* so_path, const HRIR_Program* program, char** error_message) {
+    if (error_message) *error_message = NULL;
+    if (!so_path || !program) {
+        native_fail(error_message, "No shared object or program");
+        return NULL;
+    }
+
+    void* handle = dlopen(so_path, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        native_fail(error_message, "dlopen failed: %s", dlerror());
+        return NULL;
+    }
+
+    const uint32_t* abi = dlsym(handle, "hrir_native_abi");
+    const uint32_t* value_size = dlsym(handle, "hrir_native_value_size");
+    const uint64_t* fingerprint = dlsym(handle, "hrir_native_fingerprint");
+    void* entry = dlsym(handle, "hrir_native_run");
+    const char* problem = NULL;
+    if (!abi || !value_size || !fingerprint || !entry) {
+        problem = "Not an HRIR native object";
+    } else if (*abi != HRIR_NATIVE_ABI || *value_size != sizeof(HRIR_Value)) {
+        problem = "HRIR native object was built for a different ABI";
+    } else if (*fingerprint != native_fingerprint(program)) {
+        problem = "HRIR native object was built from a different program";
+    }
+
+    HRIR_Native* native = problem ? NULL : malloc(sizeof(HRIR_Native));
+    if (!native) {
+        dlclose(handle);
+        native_fail(error_message, "%s", problem ? problem : "Out of memory");
+        return NULL;
+    }
+
+    native->handle = handle;
+    // Object-to-function pointer conversion through memcpy, as dlsym requires
+    memcpy(&native->entry, &entry, sizeof(native->entry));
+    native->program = program;
+    return native;
+}
+
+void hr_ir_free_native(HRIR_Native* native) {
+    if (!native) return;
+    dlclose(native->handle);
+    free(native);
+}
+
+#endif
+
+// =============================================================================
+// EXECUTION
+// =============================================================================
+
+static bool native_step(void* runtime, size_t index) {
+    return hr_ir_execute(runtime, index);
+}
+
+static bool native_record(void* opaque, size_t index, size_t next_pc, int slot_kind, uint32_t slot,
+                          HRIR_Value old_value, HRIR_Value new_value) {
+    HRIR_Runtime* runtime = opaque;
+    if (hr_ir_tape_record(&runtime->tape, index, next_pc, (uint8_t)slot_kind, slot, old_value, new_value)) {
+        return true;
+    }
+    runtime->error = HRIR_ERROR_MEMORY_ALLOCATION;
+    free((void*)runtime->last_error);
+    runtime->last_error = strdup("Tape allocation failed");
+    return false;
+}
+
+bool hr_ir_run_native(HRIR_Runtime* runtime, const HRIR_Native* native) {
+    if (!runtime || !runtime->program || !native) return false;
+
+    if (runtime->program != native->program) {
+        runtime->error = HRIR_ERROR_INVALID_OPERATION;
+        return false;
+    }
+
+    // Snapshots and profiles are taken per step by the interpreter's commit
+    if (runtime->recompute || runtime->profile) return hr_ir_run(runtime);
+    if (runtime->pc >= runtime->program->cell_count) return true;
+    if (!hr_ir_sync_runtime(runtime)) return false;
+
+    HRIR_NativeContext context = {
+        .runtime = runtime,
+        .registers = runtime->registers,
+        .exec_counts = runtime->exec_counts,
+        .results = runtime->results,
+        .tape_steps = &runtime->tape.steps,
+        .tape_implicit = &runtime->tape.implicit,
+        .steps_executed = &runtime->steps_executed,
+        .pc = &runtime->pc,
+        .step = native_step,
+        .record = native_record,
+    };
+    return native->entry(&context) == 1;
+}
@@ -0,0 +1,870 @@
+// rio-riovn-merged/src/hr_ir_optimize.c
+// L1 HRIR Peephole Optimizer - reversible-aware rewrites of the compact encoding
+//
+// Facts about registers are tracked per basic block (a block starts at every
+// jump target and after every unconditional jump), so a rewrite never depends
+// on the path that reached a cell. Rewrites:
+//   - adjacent cells that exactly undo each other are removed
+//   - arithmetic and comparisons over known register values become constants
+//   - jumps to the next cell and never-taken branches are removed, and
+//     always-taken branches become plain jumps
+// Surviving cells keep their ids; jumps into removed cells are redirected.
+// A separate value-numbering pass removes pure cells that recompute a value
+// their destination already holds.
+
+#include "hr_ir_internal.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Cell fate
+#define OPT_KEEP    0
+#define OPT_REMOVE  1
+#define OPT_CHANGED 2    // Rewritten in place, view must be rebuilt
+
+// What the current block has established about a register
+typedef struct {
+    uint32_t block;      // Block the fact belongs to; stale otherwise
+    uint8_t type;        // HRIR_ValueType, NONE = unknown
+    bool known;          // value is the register's content
+    HRIR_Value value;
+} HRIR_RegisterFact;
+
+// An argument as seen by the optimizer
+typedef struct {
+    uint8_t kind;        // HRIR_ConstKind
+    uint32_t reg;        // Symbols only
+    uint8_t type;        // Known type, NONE = unknown
+    bool known;
+    HRIR_Value value;
+} HRIR_OptOperand;
+
+typedef struct {
+    HRIR_Program* program;
+    HRIR_RegisterFact* facts;
+    uint32_t block;
+    uint8_t* fate;
+    bool* is_target;
+    HRIR_OptimizeStats stats;
+} HRIR_Optimizer;
+
+// =============================================================================
+// OPERANDS AND FACTS
+// =============================================================================
+
+static void opt_operand(HRIR_Optimizer* opt, uint32_t const_id, HRIR_OptOperand* out) {
+    const HRIR_Const* entry = &opt->program->pool.entries[const_id];
+    memset(out, 0, sizeof(*out));
+    out->kind = entry->kind;
+
+    if (entry->kind == HRIR_CONST_NUMBER) {
+        out->type = entry->value.type;
+        out->known = true;
+        out->value = entry->value;
+    } else if (entry->kind == HRIR_CONST_SYMBOL) {
+        const HRIR_RegisterFact* fact = &opt->facts[entry->reg];
+        out->reg = entry->reg;
+        if (fact->block == opt->block) {
+            out->type = fact->type;
+            out->known = fact->known;
+            out->value = fact->value;
+        }
+    }
+}
+
+static void opt_learn(HRIR_Optimizer* opt, uint32_t reg, uint8_t type, const HRIR_Value* value) {
+    HRIR_RegisterFact* fact = &opt->facts[reg];
+    fact->block = opt->block;
+    fact->type = type;
+    fact->known = value != NULL;
+    if (value) fact->value = *value;
+}
+
+// Destination register of argument `position`, defaulting to "result"
+static bool opt_destination(const HRIR_Program* program, const uint32_t* args, size_t arg_count,
+                            size_t position, uint32_t* reg) {
+    if (position >= arg_count) {
+        *reg = HRIR_RESULT_REGISTER;
+        return true;
+    }
+
+    const HRIR_Const* entry = &program->pool.entries[args[position]];
+    if (entry->kind != HRIR_CONST_SYMBOL) return false;
+
+    *reg = entry->reg;
+    return true;
+}
+
+static bool opt_is_register(const HRIR_Program* program, uint32_t const_id, uint32_t reg) {
+    const HRIR_Const* entry = &program->pool.entries[const_id];
+    return entry->kind == HRIR_CONST_SYMBOL && entry->reg == reg;
+}
+
+static bool opt_literal_int(const HRIR_Program* program, uint32_t const_id, int64_t* out) {
+    const HRIR_Const* entry = &program->pool.entries[const_id];
+    if (entry->kind != HRIR_CONST_NUMBER || entry->value.type != HRIR_VALUE_INT) return false;
+    *out = entry->value.as.i;
+    return true;
+}
+
+// Index of a literal jump target
+static bool opt_target(const HRIR_Program* program, uint32_t const_id, size_t* index) {
+    int64_t id;
+    if (!opt_literal_int(program, const_id, &id) || id <= 0 || id > UINT32_MAX) return false;
+    return hr_ir_find_index(program, (uint32_t)id, index);
+}
+
+static uint32_t opt_intern_number(HRIR_Program* program, const char* text) {
+    return hr_ir_intern(program, text, strlen(text));
+}
+
+// =============================================================================
+// JUMP TARGETS
+// =============================================================================
+
+// Mark every cell a jump can land on; false if a target is computed at run time
+static bool opt_mark_targets(HRIR_Optimizer* opt) {
+    const HRIR_Program* program = opt->program;
+
+    for (size_t i = 0; i < program->cell_count; i++) {
+        HRIR_Opcode op = (HRIR_Opcode)program->opcodes[i];
+        if (op != HRIR_OPC_JUMP && op != HRIR_OPC_JUMP_IF) continue;
+
+        size_t position = op == HRIR_OPC_JUMP ? 0 : 1;
+        if (program->arg_counts[i] <= position) continue;
+
+        uint32_t target_arg = program->args[program->arg_offsets[i] + position];
+        if (program->pool.entries[target_arg].kind == HRIR_CONST_SYMBOL) return false;
+
+        size_t index;
+        if (opt_target(program, target_arg, &index)) {
+            opt->is_target[index] = true;
+        }
+    }
+    return true;
+}
+
+static bool opt_targets_next(const HRIR_Program* program, uint32_t const_id, size_t index) {
+    size_t target;
+    return index + 1 < program->cell_count && opt_target(program, const_id, &target) &&
+           target == index + 1;
+}
+
+// =============================================================================
+// PEEPHOLE PASSES
+// =============================================================================
+
+// `op x y x` followed by its inverse leaves x exactly as it was when integer
+// add/subtract wrap, or when multiply/divide use a unit factor (no rounding)
+static bool opt_cancels(HRIR_Optimizer* opt, size_t index) {
+    const HRIR_Program* program = opt->program;
+    size_t next = index + 1;
+    if (next >= program->cell_count || opt->is_target[index] || opt->is_target[next]) return false;
+
+    HRIR_Opcode first = (HRIR_Opcode)program->opcodes[index];
+    HRIR_Opcode inverse = hr_ir_inverse_opcode(first);
+    if (inverse == HRIR_OPC_COUNT || program->opcodes[next] != inverse) return false;
+    if (program->arg_counts[index] < 2 || program->arg_counts[next] < 2) return false;
+
+    const uint32_t* a = program->args + program->arg_offsets[index];
+    const uint32_t* b = program->args + program->arg_offsets[next];
+    uint32_t x, x_next;
+    if (!opt_destination(program, a, program->arg_counts[index], 2, &x) ||
+        !opt_destination(program, b, program->arg_counts[next], 2, &x_next) || x != x_next) {
+        return false;
+    }
+
+    // The updated register comes first, except for add and multiply which commute
+    uint32_t y[2];
+    const uint32_t* cells[2] = { a, b };
+    HRIR_Opcode ops[2] = { first, inverse };
+    for (int k = 0; k < 2; k++) {
+        bool commutes = ops[k] == HRIR_OPC_ADD || ops[k] == HRIR_OPC_MULTIPLY;
+        bool x_first = opt_is_register(program, cells[k][0], x);
+        bool x_second = opt_is_register(program, cells[k][1], x);
+        if (x_first && !x_second) {
+            y[k] = cells[k][1];
+        } else if (commutes && x_second && !x_first) {
+            y[k] = cells[k][0];
+        } else {
+            return false;
+        }
+    }
+    if (y[0] != y[1]) return false;
+
+    // An empty x reads as int 0, so the pair would write it: x must be typed
+    const HRIR_RegisterFact* updated = &opt->facts[x];
+    if (first == HRIR_OPC_MULTIPLY || first == HRIR_OPC_DIVIDE) {
+        int64_t factor;
+        return updated->block == opt->block &&
+               (updated->type == HRIR_VALUE_INT || updated->type == HRIR_VALUE_FLOAT) &&
+               opt_literal_int(program, y[0], &factor) && (factor == 1 || factor == -1);
+    }
+
+    HRIR_OptOperand other;
+    opt_operand(opt, y[0], &other);
+    return updated->block == opt->block && updated->type == HRIR_VALUE_INT &&
+           other.type == HRIR_VALUE_INT;
+}
+
+// Rewrite a cell to write a constant: `add K 0 [dest]` or `multiply K 1 [dest]`
+static bool opt_fold(HRIR_Optimizer* opt, size_t index, HRIR_Value value) {
+    HRIR_Program* program = opt->program;
+    char text[40];
+
+    if (value.type == HRIR_VALUE_INT) {
+        snprintf(text, sizeof(text), "%lld", (long long)value.as.i);
+    } else {
+        if (!isfinite(value.as.f)) return true; // No literal spells it; leave the cell
+        snprintf(text, sizeof(text), "%.17g", value.as.f);
+        if (text[strcspn(text, ".e")] == '\0') strcat(text, ".0"); // Stay a float literal
+    }
+
+    uint32_t constant = opt_intern_number(program, text);
+    uint32_t identity = opt_intern_number(program, value.type == HRIR_VALUE_INT ? "0" : "1");
+    if (constant == HRIR_NO_CONST || identity == HRIR_NO_CONST) return false;
+
+    uint32_t* args = hr_ir_own_args(program, index);
+    if (!args) return false;
+    args[0] = constant;
+    args[1] = identity;
+    program->opcodes[index] = value.type == HRIR_VALUE_INT ? HRIR_OPC_ADD : HRIR_OPC_MULTIPLY;
+    opt->fate[index] = OPT_CHANGED;
+    opt->stats.constants_folded++;
+    return true;
+}
+
+static bool opt_binary(HRIR_Optimizer* opt, size_t index) {
+    const HRIR_Program* program = opt->program;
+    HRIR_Opcode op = (HRIR_Opcode)program->opcodes[index];
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    size_t arg_count = program->arg_counts[index];
+    uint32_t dest;
+
+    // Malformed cells fail at run time before writing anything
+    if (arg_count < 2 || !opt_destination(program, args, arg_count, 2, &dest)) return true;
+
+    HRIR_OptOperand a, b;
+    opt_operand(opt, args[0], &a);
+    opt_operand(opt, args[1], &b);
+    if (a.kind == HRIR_CONST_STRING || b.kind == HRIR_CONST_STRING) return true;
+
+    if (a.known && b.known) {
+        HRIR_Value value;
+        if (!hr_ir_eval_binary(op, a.value, b.value, &value)) return true; // Division by zero
+
+        // An in-place add/subtract needs no tape record; folding would add one
+        bool in_place = (op == HRIR_OPC_ADD || op == HRIR_OPC_SUBTRACT) &&
+                        ((a.kind == HRIR_CONST_SYMBOL && a.reg == dest) ||
+                         (b.kind == HRIR_CONST_SYMBOL && b.reg == dest));
+        bool reads_register = a.kind == HRIR_CONST_SYMBOL || b.kind == HRIR_CONST_SYMBOL;
+        if (reads_register && !in_place && !opt_fold(opt, index, value)) return false;
+
+        opt_learn(opt, dest, value.type, &value);
+        return true;
+    }
+
+    uint8_t type = HRIR_VALUE_NONE;
+    if (op >= HRIR_OPC_EQUAL || (a.type == HRIR_VALUE_INT && b.type == HRIR_VALUE_INT)) {
+        type = HRIR_VALUE_INT;
+    } else if (a.type == HRIR_VALUE_FLOAT || b.type == HRIR_VALUE_FLOAT) {
+        type = HRIR_VALUE_FLOAT;
+    }
+    opt_learn(opt, dest, type, NULL);
+    return true;
+}
+
+// Returns whether control can continue into the next cell within the block
+static bool opt_branch(HRIR_Optimizer* opt, size_t index) {
+    HRIR_Program* program = opt->program;
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    size_t arg_count = program->arg_counts[index];
+
+    if (program->opcodes[index] == HRIR_OPC_JUMP) {
+        if (arg_count >= 1 && opt_targets_next(program, args[0], index)) {
+            opt->fate[index] = OPT_REMOVE;
+            opt->stats.jumps_removed++;
+            return true;
+        }
+        return false;
+    }
+
+    if (arg_count < 2) return true;
+
+    HRIR_OptOperand condition;
+    opt_operand(opt, args[0], &condition);
+    if (condition.kind == HRIR_CONST_STRING) return true;
+
+    if (opt_targets_next(program, args[1], index)) {
+        opt->fate[index] = OPT_REMOVE;
+        opt->stats.jumps_removed++;
+        return true;
+    }
+    if (!condition.known) return true;
+
+    bool taken = condition.value.type == HRIR_VALUE_FLOAT ? condition.value.as.f != 0.0
+                                                          : condition.value.as.i != 0;
+    if (!taken) {
+        opt->fate[index] = OPT_REMOVE;
+        opt->stats.jumps_removed++;
+        return true;
+    }
+
+    // Drop the condition: `jump_if c target` becomes `jump target`
+    program->opcodes[index] = HRIR_OPC_JUMP;
+    program->arg_offsets[index]++;
+    program->arg_counts[index] = 1;
+    opt->fate[index] = OPT_CHANGED;
+    opt->stats.jumps_simplified++;
+    return false;
+}
+
+static void opt_overwrite(HRIR_Optimizer* opt, size_t index, size_t position) {
+    const HRIR_Program* program = opt->program;
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    uint32_t dest;
+
+    if (opt_destination(program, args, program->arg_counts[index], position, &dest)) {
+        opt_learn(opt, dest, HRIR_VALUE_NONE, NULL);
+    }
+}
+
+// =============================================================================
+// COMPACTION
+// =============================================================================
+
+static bool opt_compact(HRIR_Optimizer* opt) {
+    HRIR_Program* program = opt->program;
+    size_t count = program->cell_count;
+
+    // A removed jump or jump target with nothing surviving after it stays: a
+    // jump landing on it must still reach the end of the program. Pairs are
+    // never cancelled across a target, and any other removed cell is
+    // redundant on its own, so keeping it changes nothing.
+    size_t alive = count;
+    for (size_t i = count; i-- > 0;) {
+        HRIR_Opcode op = (HRIR_Opcode)program->opcodes[i];
+        bool jump = op == HRIR_OPC_JUMP || op == HRIR_OPC_JUMP_IF;
+        if (opt->fate[i] == OPT_REMOVE && alive == count && (jump || opt->is_target[i])) {
+            opt->fate[i] = OPT_KEEP;
+            if (jump) opt->stats.jumps_removed--;
+        }
+        if (opt->fate[i] != OPT_REMOVE) alive = i;
+    }
+
+    size_t* successor = malloc(count * sizeof(size_t));
+    if (!successor) return false;
+    alive = count;
+    for (size_t i = count; i-- > 0;) {
+        if (opt->fate[i] != OPT_REMOVE) alive = i;
+        successor[i] = alive;
+    }
+
+    // Jumps into removed cells move on to the next surviving cell
+    for (size_t i = 0; i < count; i++) {
+        HRIR_Opcode op = (HRIR_Opcode)program->opcodes[i];
+        if (opt->fate[i] == OPT_REMOVE || (op != HRIR_OPC_JUMP && op != HRIR_OPC_JUMP_IF)) continue;
+
+        size_t position = op == HRIR_OPC_JUMP ? 0 : 1;
+        size_t target;
+        if (program->arg_counts[i] <= position) continue;
+        uint32_t arg = program->args[program->arg_offsets[i] + position];
+        if (!opt_target(program, arg, &target) || opt->fate[target] != OPT_REMOVE) continue;
+
+        char text[16];
+        snprintf(text, sizeof(text), "%u", program->ids[successor[target]]);
+        uint32_t id = opt_intern_number(program, text);
+        uint32_t* args = id == HRIR_NO_CONST ? NULL : hr_ir_own_args(program, i);
+        if (!args) {
+            free(successor);
+            return false;
+        }
+        args[position] = id;
+        opt->fate[i] = OPT_CHANGED;
+    }
+    free(successor);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (opt->fate[i] != OPT_KEEP) {
+            hr_ir_release_view(program, i);
+        }
+        if (opt->fate[i] == OPT_REMOVE) continue;
+
+        program->opcodes[kept] = program->opcodes[i];
+        program->flags[kept] = program->flags[i];
+        program->ids[kept] = program->ids[i];
+        program->arg_offsets[kept] = program->arg_offsets[i];
+        program->arg_counts[kept] = program->arg_counts[i];
+        program->meta[kept] = program->meta[i];
+        program->cells[kept] = program->cells[i];
+        kept++;
+    }
+
+    program->cell_count = kept;
+    hr_ir_index_ids(program);
+    opt->stats.cells_removed = count - kept;
+    return true;
+}
+
+// =============================================================================
+// DRIVER
+// =============================================================================
+
+bool hr_ir_optimize_program(HRIR_Program* program, HRIR_OptimizeStats* stats) {
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (!program) return false;
+
+    HRIR_Optimizer opt = { .program = program };
+    opt.stats.cells_before = program->cell_count;
+    if (program->cell_count == 0) return true;
+
+    size_t registers = program->pool.register_count ? program->pool.register_count : 1;
+    opt.facts = calloc(registers, sizeof(HRIR_RegisterFact));
+    opt.fate = calloc(program->cell_count, sizeof(uint8_t));
+    opt.is_target = calloc(program->cell_count, sizeof(bool));
+
+    bool ok = opt.facts && opt.fate && opt.is_target;
+
+    // With computed jump targets any cell may start a block; leave it alone
+    if (ok && opt_mark_targets(&opt)) {
+        bool new_block = true;
+        for (size_t i = 0; ok && i < program->cell_count; i++) {
+            if (new_block || opt.is_target[i]) {
+                opt.block++;
+                new_block = false;
+            }
+
+            switch ((HRIR_Opcode)program->opcodes[i]) {
+                case HRIR_OPC_ADD:
+                case HRIR_OPC_SUBTRACT:
+                case HRIR_OPC_MULTIPLY:
+                case HRIR_OPC_DIVIDE:
+                    if (opt_cancels(&opt, i)) {
+                        opt.fate[i] = OPT_REMOVE;
+                        opt.fate[i + 1] = OPT_REMOVE;
+                        opt.stats.inverse_pairs++;
+                        i++;
+                        break;
+                    }
+                    // fall through
+                case HRIR_OPC_EQUAL:
+                case HRIR_OPC_LESS:
+                case HRIR_OPC_GREATER:
+                    ok = opt_binary(&opt, i);
+                    break;
+
+                case HRIR_OPC_JUMP:
+                case HRIR_OPC_JUMP_IF:
+                    new_block = !opt_branch(&opt, i);
+                    break;
+
+                case HRIR_OPC_LOAD:
+                case HRIR_OPC_READ:
+                case HRIR_OPC_VSUM:
+                    opt_overwrite(&opt, i, 0);
+                    break;
+
+                default:
+                    break; // Store, print, vector and custom cells write no register
+            }
+        }
+
+        if (ok) ok = opt_compact(&opt);
+    }
+
+    // On failure the program keeps the rewrites made so far, which are each exact
+    for (size_t i = 0; !ok && opt.fate && i < program->cell_count; i++) {
+        if (opt.fate[i] == OPT_CHANGED) {
+            hr_ir_release_view(program, i);
+        }
+    }
+
+    free(opt.facts);
+    free(opt.fate);
+    free(opt.is_target);
+
+    if (ok && stats) *stats = opt.stats;
+    return ok;
+}
+
+// =============================================================================
+// VALUE NUMBERING
+// =============================================================================
+//
+// Superlocal value numbering: a block with a single predecessor continues that
+// predecessor's numbering, so each tree of such blocks (an extended basic
+// block) is numbered in one depth-first walk and every definition seen on the
+// way dominates the cells below it. Merge points start over with every
+// register unknown. A pure cell whose destination already holds the value it
+// computes is removed; it would rewrite identical bits, so registers, the tape
+// and every undo are unchanged.
+
+typedef struct {
+    uint32_t number;     // Value number, valid when root matches
+    uint32_t root;
+} HRIR_RegisterNumber;
+
+typedef struct {
+    uint32_t reg;
+    HRIR_RegisterNumber previous;
+} HRIR_NumberUndo;
+
+typedef struct {
+    uint32_t op;
+    uint32_t a;
+    uint32_t b;
+    uint32_t number;     // 0 = empty slot
+} HRIR_Expression;
+
+typedef struct {
+    size_t start;
+    size_t end;
+    size_t successors[2];
+    uint8_t successor_count;
+    uint32_t predecessors;
+} HRIR_NumberBlock;
+
+typedef struct {
+    HRIR_Optimizer* opt;
+    HRIR_RegisterNumber* registers;
+    uint32_t root;
+    uint32_t* literals;          // Per const id, 0 = not numbered yet
+    uint32_t literal_count;
+    bool* typed;                 // Per value number: never reads as NONE
+    uint32_t value_count;
+    uint32_t value_capacity;
+    HRIR_Expression* expressions;
+    size_t expression_count;
+    size_t expression_capacity;  // Power of two
+    HRIR_NumberUndo* log;
+    size_t log_count;
+    size_t log_capacity;
+    HRIR_ValueNumberStats stats;
+} HRIR_Numbering;
+
+static uint32_t vn_fresh(HRIR_Numbering* vn, bool typed) {
+    if (vn->value_count + 1 >= vn->value_capacity) {
+        uint32_t capacity = vn->value_capacity ? vn->value_capacity * 2 : 256;
+        bool* grown = realloc(vn->typed, capacity * sizeof(bool));
+        if (!grown) return 0;
+        vn->typed = grown;
+        vn->value_capacity = capacity;
+    }
+    uint32_t number = ++vn->value_count;
+    vn->typed[number] = typed;
+    return number;
+}
+
+// Registers first read in a tree get an opaque number of their own
+static uint32_t vn_register(HRIR_Numbering* vn, uint32_t reg) {
+    HRIR_RegisterNumber* slot = &vn->registers[reg];
+    if (slot->root != vn->root) {
+        slot->number = vn_fresh(vn, false);
+        slot->root = vn->root;
+    }
+    return slot->number;
+}
+
+static bool vn_assign(HRIR_Numbering* vn, uint32_t reg, uint32_t number) {
+    if (vn->log_count == vn->log_capacity) {
+        size_t capacity = vn->log_capacity ? vn->log_capacity * 2 : 64;
+        HRIR_NumberUndo* grown = realloc(vn->log, capacity * sizeof(HRIR_NumberUndo));
+        if (!grown) return false;
+        vn->log = grown;
+        vn->log_capacity = capacity;
+    }
+    vn->log[vn->log_count].reg = reg;
+    vn->log[vn->log_count].previous = vn->registers[reg];
+    vn->log_count++;
+
+    vn->registers[reg].number = number;
+    vn->registers[reg].root = vn->root;
+    return true;
+}
+
+static void vn_rewind(HRIR_Numbering* vn, size_t mark) {
+    while (vn->log_count > mark) {
+        vn->log_count--;
+        vn->registers[vn->log[vn->log_count].reg] = vn->log[vn->log_count].previous;
+    }
+}
+
+// Number of an argument; 0 for strings, which fail the cell at run time
+static uint32_t vn_operand(HRIR_Numbering* vn, uint32_t const_id, bool* ok) {
+    const HRIR_Const* entry = &vn->opt->program->pool.entries[const_id];
+    uint32_t number = 0;
+
+    if (entry->kind == HRIR_CONST_SYMBOL) {
+        number = vn_register(vn, entry->reg);
+    } else if (entry->kind == HRIR_CONST_NUMBER) {
+        if (const_id >= vn->literal_count) return 0; // Interned during the pass
+        number = vn->literals[const_id];
+        if (!number) number = vn->literals[const_id] = vn_fresh(vn, true);
+    } else {
+        return 0;
+    }
+
+    if (!number) *ok = false;
+    return number;
+}
+
+static uint64_t vn_hash(uint32_t op, uint32_t a, uint32_t b) {
+    uint64_t h = ((uint64_t)a << 32 | b) * 0x9E3779B97F4A7C15ULL;
+    return (h ^ (h >> 29) ^ op) * 0xBF58476D1CE4E5B9ULL;
+}
+
+static bool vn_grow_expressions(HRIR_Numbering* vn) {
+    size_t capacity = vn->expression_capacity ? vn->expression_capacity * 2 : 256;
+    HRIR_Expression* table = calloc(capacity, sizeof(HRIR_Expression));
+    if (!table) return false;
+
+    for (size_t i = 0; i < vn->expression_capacity; i++) {
+        const HRIR_Expression* entry = &vn->expressions[i];
+        if (!entry->number) continue;
+        size_t slot = vn_hash(entry->op, entry->a, entry->b) & (capacity - 1);
+        while (table[slot].number) slot = (slot + 1) & (capacity - 1);
+        table[slot] = *entry;
+    }
+
+    free(vn->expressions);
+    vn->expressions = table;
+    vn->expression_capacity = capacity;
+    return true;
+}
+
+// Value number of `op a b`, assigning a new one the first time it is seen
+static uint32_t vn_expression(HRIR_Numbering* vn, uint32_t op, uint32_t a, uint32_t b) {
+    if ((vn->expression_count + 1) * 2 > vn->expression_capacity && !vn_grow_expressions(vn)) {
+        return 0;
+    }
+
+    size_t mask = vn->expression_capacity - 1;
+    size_t slot = vn_hash(op, a, b) & mask;
+    while (vn->expressions[slot].number) {
+        const HRIR_Expression* entry = &vn->expressions[slot];
+        if (entry->op == op && entry->a == a && entry->b == b) return entry->number;
+        slot = (slot + 1) & mask;
+    }
+
+    uint32_t number = vn_fresh(vn, true);
+    if (!number) return 0;
+    vn->expressions[slot] = (HRIR_Expression){ op, a, b, number };
+    vn->expression_count++;
+    return number;
+}
+
+static bool vn_binary(HRIR_Numbering* vn, size_t index) {
+    const HRIR_Program* program = vn->opt->program;
+    HRIR_Opcode op = (HRIR_Opcode)program->opcodes[index];
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    size_t arg_count = program->arg_counts[index];
+    uint32_t dest;
+
+    // Malformed cells fail at run time before writing anything
+    if (arg_count < 2 || !opt_destination(program, args, arg_count, 2, &dest)) return true;
+
+    bool ok = true;
+    uint32_t a = vn_operand(vn, args[0], &ok);
+    uint32_t b = vn_operand(vn, args[1], &ok);
+    if (!ok) return false;
+    if (!a || !b) return true;
+
+    // `multiply x 1` copies x exactly once x holds a typed value; operands
+    // are never swapped, as a commuted float sum may differ in a NaN payload
+    int64_t factor;
+    uint32_t value;
+    if (op == HRIR_OPC_MULTIPLY && vn->typed[a] && opt_literal_int(program, args[1], &factor) &&
+        factor == 1) {
+        value = a;
+    } else {
+        value = vn_expression(vn, op, a, b);
+        if (!value) return false;
+    }
+
+    uint32_t current = vn_register(vn, dest);
+    if (!current) return false;
+    if (current == value) {
+        vn->opt->fate[index] = OPT_REMOVE;
+        return true;
+    }
+    return vn_assign(vn, dest, value);
+}
+
+static bool vn_block(HRIR_Numbering* vn, const HRIR_NumberBlock* block) {
+    const HRIR_Program* program = vn->opt->program;
+
+    for (size_t i = block->start; i < block->end; i++) {
+        switch ((HRIR_Opcode)program->opcodes[i]) {
+            case HRIR_OPC_ADD:
+            case HRIR_OPC_SUBTRACT:
+            case HRIR_OPC_MULTIPLY:
+            case HRIR_OPC_DIVIDE:
+            case HRIR_OPC_EQUAL:
+            case HRIR_OPC_LESS:
+            case HRIR_OPC_GREATER:
+                if (!vn_binary(vn, i)) return false;
+                break;
+
+            case HRIR_OPC_LOAD:
+            case HRIR_OPC_READ:
+            case HRIR_OPC_VSUM: {
+                const uint32_t* args = program->args + program->arg_offsets[i];
+                uint32_t dest;
+                if (opt_destination(program, args, program->arg_counts[i], 0, &dest)) {
+                    uint32_t number = vn_fresh(vn, false);
+                    if (!number || !vn_assign(vn, dest, number)) return false;
+                }
+                break;
+            }
+
+            default:
+                break; // Store, print, jumps, vector and custom cells write no register
+        }
+    }
+    return true;
+}
+
+// Split the program into basic blocks and link each to where control goes next
+static HRIR_NumberBlock* vn_blocks(HRIR_Optimizer* opt, size_t* block_count, size_t** block_of) {
+    const HRIR_Program* program = opt->program;
+    size_t count = program->cell_count;
+
+    *block_of = malloc(count * sizeof(size_t));
+    HRIR_NumberBlock* blocks = calloc(count, sizeof(HRIR_NumberBlock));
+    if (!*block_of || !blocks) {
+        free(blocks);
+        return NULL;
+    }
+
+    size_t blocks_used = 0;
+    for (size_t i = 0; i < count; i++) {
+        HRIR_Opcode previous = i ? (HRIR_Opcode)program->opcodes[i - 1] : HRIR_OPC_COUNT;
+        if (i == 0 || opt->is_target[i] || previous == HRIR_OPC_JUMP || previous == HRIR_OPC_JUMP_IF) {
+            blocks[blocks_used++].start = i;
+        }
+        (*block_of)[i] = blocks_used - 1;
+        blocks[blocks_used - 1].end = i + 1;
+    }
+
+    for (size_t k = 0; k < blocks_used; k++) {
+        HRIR_NumberBlock* block = &blocks[k];
+        size_t last = block->end - 1;
+        HRIR_Opcode op = (HRIR_Opcode)program->opcodes[last];
+        size_t arg_count = program->arg_counts[last];
+        const uint32_t* args = program->args + program->arg_offsets[last];
+        bool falls_through = op != HRIR_OPC_JUMP && (op != HRIR_OPC_JUMP_IF || arg_count >= 2);
+        size_t position = op == HRIR_OPC_JUMP ? 0 : 1;
+        size_t target;
+
+        if (falls_through && block->end < count) {
+            block->successors[block->successor_count++] = k + 1;
+        }
+        // A target that does not resolve fails the run when taken
+        if ((op == HRIR_OPC_JUMP || op == HRIR_OPC_JUMP_IF) && arg_count > position &&
+            opt_target(program, args[position], &target)) {
+            block->successors[block->successor_count++] = (*block_of)[target];
+        }
+    }
+
+    blocks[0].predecessors = 1; // Entry
+    for (size_t k = 0; k < blocks_used; k++) {
+        for (uint8_t s = 0; s < blocks[k].successor_count; s++) {
+            blocks[blocks[k].successors[s]].predecessors++;
+        }
+    }
+
+    *block_count = blocks_used;
+    return blocks;
+}
+
+typedef struct {
+    size_t block;
+    size_t mark;         // Log position to rewind to when leaving the block
+    uint8_t next;        // Next successor to visit
+} HRIR_NumberFrame;
+
+static bool vn_number_program(HRIR_Numbering* vn) {
+    HRIR_Optimizer* opt = vn->opt;
+    size_t block_count = 0;
+    size_t* block_of = NULL;
+    HRIR_NumberBlock* blocks = vn_blocks(opt, &block_count, &block_of);
+    HRIR_NumberFrame* stack = blocks ? malloc(block_count * sizeof(HRIR_NumberFrame)) : NULL;
+    bool ok = stack != NULL;
+
+    // Every block with a single predecessor hangs below it, so each tree is
+    // walked exactly once from its root
+    for (size_t root = 0; ok && root < block_count; root++) {
+        if (root > 0 && blocks[root].predecessors == 1) continue;
+
+        vn->root++;
+        vn->stats.extended_blocks++;
+        size_t depth = 0;
+        stack[depth++] = (HRIR_NumberFrame){ root, vn->log_count, 0 };
+        ok = vn_block(vn, &blocks[root]);
+
+        while (ok && depth > 0) {
+            HRIR_NumberFrame* frame = &stack[depth - 1];
+            const HRIR_NumberBlock* block = &blocks[frame->block];
+            if (frame->next == block->successor_count) {
+                vn_rewind(vn, frame->mark);
+                depth--;
+                continue;
+            }
+
+            size_t child = block->successors[frame->next++];
+            if (blocks[child].predecessors != 1) continue;
+            stack[depth++] = (HRIR_NumberFrame){ child, vn->log_count, 0 };
+            ok = vn_block(vn, &blocks[child]);
+        }
+    }
+
+    free(stack);
+    free(blocks);
+    free(block_of);
+    return ok;
+}
+
+bool hr_ir_value_number_program(HRIR_Program* program, HRIR_ValueNumberStats* stats) {
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (!program) return false;
+
+    HRIR_Optimizer opt = { .program = program };
+    HRIR_Numbering vn = { .opt = &opt };
+    vn.stats.cells_before = program->cell_count;
+    if (program->cell_count == 0) return true;
+
+    size_t registers = program->pool.register_count ? program->pool.register_count : 1;
+    opt.fate = calloc(program->cell_count, sizeof(uint8_t));
+    opt.is_target = calloc(program->cell_count, sizeof(bool));
+    vn.registers = calloc(registers, sizeof(HRIR_RegisterNumber));
+    vn.literal_count = program->pool.count;
+    vn.literals = calloc(vn.literal_count ? vn.literal_count : 1, sizeof(uint32_t));
+
+    bool ok = opt.fate && opt.is_target && vn.registers && vn.literals;
+
+    // With computed jump targets any cell may start a block; leave it alone
+    if (ok && opt_mark_targets(&opt)) {
+        ok = vn_number_program(&vn) && opt_compact(&opt);
+        vn.stats.cells_removed = opt.stats.cells_removed;
+        vn.stats.values = vn.value_count;
+    }
+
+    for (size_t i = 0; !ok && opt.fate && i < program->cell_count; i++) {
+        if (opt.fate[i] == OPT_CHANGED) {
+            hr_ir_release_view(program, i);
+        }
+    }
+
+    free(opt.fate);
+    free(opt.is_target);
+    free(vn.registers);
+    free(vn.literals);
+    free(vn.typed);
+    free(vn.expressions);
+    free(vn.log);
+
+    if (ok && stats) *stats = vn.stats;
+    return ok;
+}
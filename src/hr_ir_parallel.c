@@ -0,0 +1,697 @@
+// rio-riovn-merged/src/hr_ir_parallel.c
+// L1 HRIR Parallel Execution - def-use DAG and wave scheduling
+//
+// Straight-line runs of cells without control flow or I/O form blocks. Within
+// a block every cell depends on the cells that last wrote what it reads
+// (read-after-write), last wrote what it writes (write-after-write) and read
+// what it writes since (write-after-read). A cell's wave is one past the
+// deepest of its predecessors, so the cells of a wave touch disjoint slots
+// and can run concurrently.
+//
+// Results are written as each wave completes, but the tape is only written
+// once the whole block has, in program order. Program order is a topological
+// order of the DAG, so the recorded history is exactly the one hr_ir_run
+// would produce and undo rewinds in a valid reverse topological order.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "hr_ir_internal.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Waves narrower than this run on the calling thread
+#define HRIR_PARALLEL_MIN_WAVE 1024
+#define HRIR_PARALLEL_CHUNK    256
+
+#define SCHEDULE_NONE UINT32_MAX
+
+typedef struct {
+    uint32_t start;          // First cell
+    uint32_t end;            // One past the last cell
+    uint32_t first_wave;     // Index into wave_offsets
+    uint32_t wave_count;
+} HRIR_ScheduleBlock;
+
+struct HRIR_Schedule {
+    const HRIR_Program* program;
+    size_t cell_count;
+    uint32_t* block_at;      // Per cell: parallel block starting here, or SCHEDULE_NONE
+    HRIR_ScheduleBlock* blocks;
+    size_t block_count;
+    size_t block_capacity;
+    uint32_t* wave_offsets;  // Per wave start in wave_cells; each block adds its end
+    uint32_t* wave_cells;    // Cell indices grouped by wave
+    size_t wave_count;
+    uint32_t* pred_offsets;  // Per cell start in preds, plus one past the end
+    uint32_t* preds;
+    size_t pred_count;
+    size_t pred_capacity;
+    size_t widest_block;     // Cells in the largest parallel block
+    HRIR_ScheduleStats stats;
+};
+
+// =============================================================================
+// DEPENDENCY ANALYSIS
+// =============================================================================
+
+// Reader of a slot since its last write
+typedef struct {
+    uint32_t cell;
+    uint32_t next;
+} HRIR_ReaderNode;
+
+// Per-slot state, valid only while stamp matches the current block
+typedef struct {
+    uint32_t stamp;
+    uint32_t writer;         // Last writer in this block, or SCHEDULE_NONE
+    uint32_t readers;        // Head of reader list, or SCHEDULE_NONE
+} HRIR_SlotState;
+
+// Literal memory address to slot, valid only while stamp matches
+typedef struct {
+    uint32_t stamp;
+    uint32_t address;
+    uint32_t slot;
+} HRIR_AddressEntry;
+
+typedef struct {
+    HRIR_Schedule* schedule;
+    const HRIR_Program* program;
+    uint32_t stamp;          // Current block
+    HRIR_SlotState* slots;   // Registers, then memory slots of the block
+    size_t register_count;
+    uint32_t memory_slots;   // Memory slots handed out in this block
+    bool dynamic_memory;     // Block has a computed address: memory is one slot
+    HRIR_AddressEntry* addresses;
+    size_t address_mask;
+    HRIR_ReaderNode* readers;
+    uint32_t reader_count;
+    uint32_t* seen;          // Per cell: last cell that took it as predecessor
+    uint32_t* level;         // Per cell: wave within its block
+    bool* is_target;
+} HRIR_Analysis;
+
+static bool schedule_cell_kind(HRIR_Opcode op) {
+    switch (op) {
+        case HRIR_OPC_ADD:
+        case HRIR_OPC_SUBTRACT:
+        case HRIR_OPC_MULTIPLY:
+        case HRIR_OPC_DIVIDE:
+        case HRIR_OPC_EQUAL:
+        case HRIR_OPC_LESS:
+        case HRIR_OPC_GREATER:
+        case HRIR_OPC_LOAD:
+        case HRIR_OPC_STORE:
+        case HRIR_OPC_CUSTOM:
+            return true;
+        default:
+            return false; // Control flow, I/O and vector ops keep their order
+    }
+}
+
+// Literal memory address of an argument
+static bool schedule_literal_address(const HRIR_Program* program, uint32_t const_id, uint32_t* address) {
+    const HRIR_Const* entry = &program->pool.entries[const_id];
+    if (entry->kind != HRIR_CONST_NUMBER || entry->value.type != HRIR_VALUE_INT ||
+        entry->value.as.i < 0 || entry->value.as.i >= HRIR_MEMORY_LIMIT) {
+        return false;
+    }
+    *address = (uint32_t)entry->value.as.i;
+    return true;
+}
+
+// Index of a literal jump target
+static bool schedule_jump_target(const HRIR_Program* program, uint32_t const_id, size_t* index) {
+    const HRIR_Const* entry = &program->pool.entries[const_id];
+    if (entry->kind != HRIR_CONST_NUMBER || entry->value.type != HRIR_VALUE_INT ||
+        entry->value.as.i <= 0 || entry->value.as.i > UINT32_MAX) {
+        return false;
+    }
+    return hr_ir_find_index(program, (uint32_t)entry->value.as.i, index);
+}
+
+static void schedule_mark_targets(HRIR_Analysis* analysis) {
+    const HRIR_Program* program = analysis->program;
+
+    for (size_t i = 0; i < program->cell_count; i++) {
+        HRIR_Opcode op = (HRIR_Opcode)program->opcodes[i];
+        if (op != HRIR_OPC_JUMP && op != HRIR_OPC_JUMP_IF) continue;
+
+        size_t position = op == HRIR_OPC_JUMP ? 0 : 1;
+        size_t index;
+        if (program->arg_counts[i] > position &&
+            schedule_jump_target(program, program->args[program->arg_offsets[i] + position], &index)) {
+            analysis->is_target[index] = true;
+        }
+    }
+}
+
+static HRIR_SlotState* schedule_slot(HRIR_Analysis* analysis, size_t slot) {
+    HRIR_SlotState* state = &analysis->slots[slot];
+    if (state->stamp != analysis->stamp) {
+        state->stamp = analysis->stamp;
+        state->writer = SCHEDULE_NONE;
+        state->readers = SCHEDULE_NONE;
+    }
+    return state;
+}
+
+static size_t schedule_register_slot(HRIR_Analysis* analysis, uint32_t const_id, bool* found) {
+    const HRIR_Const* entry = &analysis->program->pool.entries[const_id];
+    *found = entry->kind == HRIR_CONST_SYMBOL;
+    return entry->reg;
+}
+
+static size_t schedule_memory_slot(HRIR_Analysis* analysis, uint32_t const_id) {
+    uint32_t address;
+    if (analysis->dynamic_memory || !schedule_literal_address(analysis->program, const_id, &address)) {
+        return analysis->register_count;
+    }
+
+    size_t probe = (address * 2654435761u) & analysis->address_mask;
+    while (analysis->addresses[probe].stamp == analysis->stamp &&
+           analysis->addresses[probe].address != address) {
+        probe = (probe + 1) & analysis->address_mask;
+    }
+
+    HRIR_AddressEntry* entry = &analysis->addresses[probe];
+    if (entry->stamp != analysis->stamp) {
+        entry->stamp = analysis->stamp;
+        entry->address = address;
+        entry->slot = analysis->memory_slots++;
+    }
+    return analysis->register_count + entry->slot;
+}
+
+static bool schedule_add_pred(HRIR_Analysis* analysis, uint32_t cell, uint32_t pred) {
+    if (pred == SCHEDULE_NONE || pred == cell || analysis->seen[pred] == cell) return true;
+    analysis->seen[pred] = cell;
+
+    HRIR_Schedule* schedule = analysis->schedule;
+    if (schedule->pred_count >= schedule->pred_capacity) {
+        size_t new_capacity = schedule->pred_capacity ? schedule->pred_capacity * 2 : 256;
+        uint32_t* preds = realloc(schedule->preds, new_capacity * sizeof(uint32_t));
+        if (!preds) return false;
+        schedule->preds = preds;
+        schedule->pred_capacity = new_capacity;
+    }
+    schedule->preds[schedule->pred_count++] = pred;
+
+    if (analysis->level[pred] + 1 > analysis->level[cell]) {
+        analysis->level[cell] = analysis->level[pred] + 1;
+    }
+    return true;
+}
+
+// Collect the slots a cell reads and writes (up to three reads, one write)
+static size_t schedule_cell_slots(HRIR_Analysis* analysis, size_t index, size_t* reads, size_t* write,
+                                  bool* writes) {
+    const HRIR_Program* program = analysis->program;
+    const uint32_t* args = program->args + program->arg_offsets[index];
+    size_t arg_count = program->arg_counts[index];
+    size_t read_count = 0;
+    bool found;
+
+    *writes = false;
+    switch ((HRIR_Opcode)program->opcodes[index]) {
+        case HRIR_OPC_LOAD:
+            if (arg_count < 2) break; // Fails on evaluation
+            *write = schedule_register_slot(analysis, args[0], writes);
+            reads[read_count] = schedule_register_slot(analysis, args[1], &found);
+            if (found) read_count++;
+            reads[read_count++] = schedule_memory_slot(analysis, args[1]);
+            break;
+
+        case HRIR_OPC_STORE:
+            if (arg_count < 2) break;
+            for (size_t i = 0; i < 2; i++) {
+                reads[read_count] = schedule_register_slot(analysis, args[i], &found);
+                if (found) read_count++;
+            }
+            *write = schedule_memory_slot(analysis, args[0]);
+            *writes = true;
+            break;
+
+        case HRIR_OPC_CUSTOM:
+            break; // No built-in semantics
+
+        default:
+            for (size_t i = 0; i < arg_count && i < 2; i++) {
+                reads[read_count] = schedule_register_slot(analysis, args[i], &found);
+                if (found) read_count++;
+            }
+            if (arg_count > 2) {
+                *write = schedule_register_slot(analysis, args[2], writes);
+            } else {
+                *write = HRIR_RESULT_REGISTER;
+                *writes = true;
+            }
+            break;
+    }
+    return read_count;
+}
+
+static bool schedule_block(HRIR_Analysis* analysis, uint32_t start, uint32_t end) {
+    HRIR_Schedule* schedule = analysis->schedule;
+    const HRIR_Program* program = analysis->program;
+
+    analysis->stamp++;
+    analysis->memory_slots = 0;
+    analysis->reader_count = 0;
+    analysis->dynamic_memory = false;
+
+    // One computed address anywhere makes every memory access depend on the others
+    for (uint32_t i = start; i < end && !analysis->dynamic_memory; i++) {
+        HRIR_Opcode op = (HRIR_Opcode)program->opcodes[i];
+        if ((op == HRIR_OPC_LOAD || op == HRIR_OPC_STORE) && program->arg_counts[i] >= 2) {
+            size_t position = op == HRIR_OPC_LOAD ? 1 : 0;
+            uint32_t address;
+            analysis->dynamic_memory = !schedule_literal_address(
+                program, program->args[program->arg_offsets[i] + position], &address);
+        }
+    }
+
+    uint32_t levels = 0;
+    for (uint32_t i = start; i < end; i++) {
+        size_t reads[3];
+        size_t write = 0;
+        bool writes;
+        size_t read_count = schedule_cell_slots(analysis, i, reads, &write, &writes);
+
+        schedule->pred_offsets[i] = (uint32_t)schedule->pred_count;
+        analysis->level[i] = 0;
+
+        for (size_t r = 0; r < read_count; r++) {
+            if (!schedule_add_pred(analysis, i, schedule_slot(analysis, reads[r])->writer)) return false;
+        }
+
+        if (writes) {
+            HRIR_SlotState* state = schedule_slot(analysis, write);
+            if (!schedule_add_pred(analysis, i, state->writer)) return false;
+            for (uint32_t node = state->readers; node != SCHEDULE_NONE; node = analysis->readers[node].next) {
+                if (!schedule_add_pred(analysis, i, analysis->readers[node].cell)) return false;
+            }
+            state->writer = i;
+            state->readers = SCHEDULE_NONE;
+        }
+
+        for (size_t r = 0; r < read_count; r++) {
+            HRIR_SlotState* state = schedule_slot(analysis, reads[r]);
+            HRIR_ReaderNode* node = &analysis->readers[analysis->reader_count];
+            node->cell = i;
+            node->next = state->readers;
+            state->readers = analysis->reader_count++;
+        }
+
+        if (analysis->level[i] + 1 > levels) levels = analysis->level[i] + 1;
+    }
+    schedule->pred_offsets[end] = (uint32_t)schedule->pred_count;
+
+    // Counting sort by level gives the waves, each in program order
+    uint32_t first_wave = (uint32_t)schedule->wave_count;
+    uint32_t* offsets = schedule->wave_offsets + first_wave;
+    memset(offsets, 0, (levels + 1) * sizeof(uint32_t));
+    for (uint32_t i = start; i < end; i++) offsets[analysis->level[i] + 1]++;
+
+    size_t widest = 0;
+    offsets[0] = start;
+    for (uint32_t w = 0; w < levels; w++) {
+        if (offsets[w + 1] > widest) widest = offsets[w + 1];
+        offsets[w + 1] += offsets[w];
+    }
+    for (uint32_t i = start; i < end; i++) {
+        schedule->wave_cells[offsets[analysis->level[i]]++] = i;
+    }
+    // Filling advanced each offset to the next wave's start; shift back
+    memmove(offsets + 1, offsets, levels * sizeof(uint32_t));
+    offsets[0] = start;
+    schedule->wave_count += levels + 1;
+
+    schedule->stats.blocks++;
+    schedule->stats.cells += end - start;
+    schedule->stats.waves += levels;
+    if (widest > schedule->stats.widest_wave) schedule->stats.widest_wave = widest;
+
+    if (widest < 2) return true; // Nothing to gain over stepping
+
+    if (schedule->block_count >= schedule->block_capacity) {
+        size_t new_capacity = schedule->block_capacity ? schedule->block_capacity * 2 : 16;
+        HRIR_ScheduleBlock* blocks = realloc(schedule->blocks, new_capacity * sizeof(HRIR_ScheduleBlock));
+        if (!blocks) return false;
+        schedule->blocks = blocks;
+        schedule->block_capacity = new_capacity;
+    }
+
+    HRIR_ScheduleBlock* block = &schedule->blocks[schedule->block_count];
+    block->start = start;
+    block->end = end;
+    block->first_wave = first_wave;
+    block->wave_count = levels;
+    schedule->block_at[start] = (uint32_t)schedule->block_count++;
+    schedule->stats.parallel_blocks++;
+    if (end - start > schedule->widest_block) schedule->widest_block = end - start;
+    return true;
+}
+
+// =============================================================================
+// SCHEDULE API
+// =============================================================================
+
+HRIR_Schedule* hr_ir_build_schedule(const HRIR_Program* program) {
+    if (!program || program->cell_count >= SCHEDULE_NONE) return NULL;
+
+    HRIR_Schedule* schedule = calloc(1, sizeof(HRIR_Schedule));
+    if (!schedule) return NULL;
+
+    size_t cells = program->cell_count;
+    size_t address_capacity = 16;
+    while (address_capacity < cells * 2) address_capacity *= 2;
+
+    schedule->program = program;
+    schedule->cell_count = cells;
+    schedule->block_at = malloc((cells + 1) * sizeof(uint32_t));
+    schedule->wave_offsets = malloc((cells * 2 + 1) * sizeof(uint32_t));
+    schedule->wave_cells = malloc((cells + 1) * sizeof(uint32_t));
+    schedule->pred_offsets = calloc(cells + 1, sizeof(uint32_t));
+
+    HRIR_Analysis analysis = { .schedule = schedule, .program = program };
+    analysis.register_count = program->pool.register_count;
+    analysis.slots = calloc(analysis.register_count + cells + 1, sizeof(HRIR_SlotState));
+    analysis.addresses = calloc(address_capacity, sizeof(HRIR_AddressEntry));
+    analysis.address_mask = address_capacity - 1;
+    analysis.readers = malloc((cells * 3 + 1) * sizeof(HRIR_ReaderNode));
+    analysis.seen = malloc((cells + 1) * sizeof(uint32_t));
+    analysis.level = malloc((cells + 1) * sizeof(uint32_t));
+    analysis.is_target = calloc(cells + 1, sizeof(bool));
+
+    bool ok = schedule->block_at && schedule->wave_offsets && schedule->wave_cells &&
+              schedule->pred_offsets && analysis.slots && analysis.addresses &&
+              analysis.readers && analysis.seen && analysis.level && analysis.is_target;
+
+    if (ok) {
+        memset(analysis.seen, 0xff, (cells + 1) * sizeof(uint32_t));
+        for (size_t i = 0; i <= cells; i++) schedule->block_at[i] = SCHEDULE_NONE;
+        schedule_mark_targets(&analysis);
+
+        size_t i = 0;
+        while (ok && i < cells) {
+            if (!schedule_cell_kind((HRIR_Opcode)program->opcodes[i])) {
+                schedule->pred_offsets[i + 1] = (uint32_t)schedule->pred_count;
+                i++;
+                continue;
+            }
+
+            size_t end = i + 1;
+            while (end < cells && !analysis.is_target[end] &&
+                   schedule_cell_kind((HRIR_Opcode)program->opcodes[end])) {
+                end++;
+            }
+            ok = schedule_block(&analysis, (uint32_t)i, (uint32_t)end);
+            i = end;
+        }
+        schedule->stats.edges = schedule->pred_count;
+    }
+
+    free(analysis.slots);
+    free(analysis.addresses);
+    free(analysis.readers);
+    free(analysis.seen);
+    free(analysis.level);
+    free(analysis.is_target);
+
+    if (!ok) {
+        hr_ir_free_schedule(schedule);
+        return NULL;
+    }
+    return schedule;
+}
+
+HRIR_ScheduleStats hr_ir_get_schedule_stats(const HRIR_Schedule* schedule) {
+    HRIR_ScheduleStats stats = {0};
+    return schedule ? schedule->stats : stats;
+}
+
+const uint32_t* hr_ir_schedule_predecessors(const HRIR_Schedule* schedule, size_t index, size_t* count) {
+    if (count) *count = 0;
+    if (!schedule || index >= schedule->cell_count) return NULL;
+
+    uint32_t begin = schedule->pred_offsets[index];
+    if (count) *count = schedule->pred_offsets[index + 1] - begin;
+    return schedule->preds ? schedule->preds + begin : NULL;
+}
+
+void hr_ir_free_schedule(HRIR_Schedule* schedule) {
+    if (!schedule) return;
+
+    free(schedule->block_at);
+    free(schedule->blocks);
+    free(schedule->wave_offsets);
+    free(schedule->wave_cells);
+    free(schedule->pred_offsets);
+    free(schedule->preds);
+    free(schedule);
+}
+
+// =============================================================================
+// THREAD POOL
+// =============================================================================
+
+typedef struct {
+    HRIR_Runtime* runtime;
+    uint32_t base;               // First cell of the running block
+    HRIR_Effect* effects;        // Per block position
+    HRIR_Value* old_values;
+    bool* done;
+
+    // Current wave, shared with the workers under lock
+    const uint32_t* cells;
+    size_t count;
+    size_t next;
+    bool failed;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t idle;
+    uint64_t generation;
+    size_t pending;              // Workers still on the current wave
+    bool stop;
+    pthread_t* threads;
+    size_t thread_count;
+} HRIR_Parallel;
+
+// Evaluate and apply cells [begin, end) of the current wave
+static bool parallel_cells(HRIR_Parallel* par, size_t begin, size_t end) {
+    HRIR_Runtime* runtime = par->runtime;
+
+    for (size_t k = begin; k < end; k++) {
+        uint32_t cell = par->cells[k];
+        size_t position = cell - par->base;
+        HRIR_Effect* effect = &par->effects[position];
+
+        if (!hr_ir_evaluate(runtime, cell, effect)) return false;
+
+        HRIR_Value* target = hr_ir_effect_target(runtime, effect);
+        par->old_values[position] = target ? *target : effect->value;
+        if (target) *target = effect->value;
+        par->done[position] = true;
+    }
+    return true;
+}
+
+// Take chunks until the wave is exhausted; called and returns with lock held
+static void parallel_drain(HRIR_Parallel* par) {
+    while (!par->failed && par->next < par->count) {
+        size_t begin = par->next;
+        size_t end = begin + HRIR_PARALLEL_CHUNK < par->count ? begin + HRIR_PARALLEL_CHUNK : par->count;
+        par->next = end;
+
+        pthread_mutex_unlock(&par->lock);
+        bool ok = parallel_cells(par, begin, end);
+        pthread_mutex_lock(&par->lock);
+
+        if (!ok) par->failed = true;
+    }
+}
+
+static void* parallel_worker(void* arg) {
+    HRIR_Parallel* par = arg;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&par->lock);
+    for (;;) {
+        while (!par->stop && par->generation == seen) {
+            pthread_cond_wait(&par->work, &par->lock);
+        }
+        if (par->stop) break;
+
+        seen = par->generation;
+        parallel_drain(par);
+        if (--par->pending == 0) pthread_cond_signal(&par->idle);
+    }
+    pthread_mutex_unlock(&par->lock);
+    return NULL;
+}
+
+// Run one wave; false if any of its cells failed to evaluate
+static bool parallel_wave(HRIR_Parallel* par, const uint32_t* cells, size_t count) {
+    par->cells = cells;
+    par->count = count;
+
+    if (par->thread_count == 0 || count < HRIR_PARALLEL_MIN_WAVE) {
+        return parallel_cells(par, 0, count);
+    }
+
+    pthread_mutex_lock(&par->lock);
+    par->next = 0;
+    par->failed = false;
+    par->pending = par->thread_count;
+    par->generation++;
+    pthread_cond_broadcast(&par->work);
+
+    parallel_drain(par);
+    while (par->pending > 0) {
+        pthread_cond_wait(&par->idle, &par->lock);
+    }
+    bool ok = !par->failed;
+    pthread_mutex_unlock(&par->lock);
+    return ok;
+}
+
+static void parallel_stop(HRIR_Parallel* par) {
+    if (par->thread_count > 0) {
+        pthread_mutex_lock(&par->lock);
+        par->stop = true;
+        pthread_cond_broadcast(&par->work);
+        pthread_mutex_unlock(&par->lock);
+
+        for (size_t i = 0; i < par->thread_count; i++) {
+            pthread_join(par->threads[i], NULL);
+        }
+    }
+
+    pthread_mutex_destroy(&par->lock);
+    pthread_cond_destroy(&par->work);
+    pthread_cond_destroy(&par->idle);
+    free(par->threads);
+    free(par->effects);
+    free(par->old_values);
+    free(par->done);
+}
+
+static bool parallel_start(HRIR_Parallel* par, HRIR_Runtime* runtime, const HRIR_Schedule* schedule,
+                           size_t threads) {
+    memset(par, 0, sizeof(*par));
+    par->runtime = runtime;
+    pthread_mutex_init(&par->lock, NULL);
+    pthread_cond_init(&par->work, NULL);
+    pthread_cond_init(&par->idle, NULL);
+
+    size_t scratch = schedule->widest_block ? schedule->widest_block : 1;
+    par->effects = malloc(scratch * sizeof(HRIR_Effect));
+    par->old_values = malloc(scratch * sizeof(HRIR_Value));
+    par->done = malloc(scratch * sizeof(bool));
+    if (!par->effects || !par->old_values || !par->done) return false;
+
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1;
+    }
+
+    // Workers only pay off when some wave is wide enough to hand out
+    if (threads < 2 || schedule->stats.widest_wave < HRIR_PARALLEL_MIN_WAVE) return true;
+
+    par->threads = malloc((threads - 1) * sizeof(pthread_t));
+    if (!par->threads) return true;
+
+    // Without thread support (e.g. WebAssembly builds) the caller runs every wave
+    while (par->thread_count < threads - 1 &&
+           pthread_create(&par->threads[par->thread_count], NULL, parallel_worker, par) == 0) {
+        par->thread_count++;
+    }
+    return true;
+}
+
+// =============================================================================
+// EXECUTION
+// =============================================================================
+
+// Undo the writes of the block in reverse program order, from position `from` down
+static void parallel_restore(HRIR_Parallel* par, size_t from, size_t count) {
+    for (size_t i = count; i-- > from;) {
+        if (!par->done[i]) continue;
+        HRIR_Value* target = hr_ir_effect_target(par->runtime, &par->effects[i]);
+        if (target) *target = par->old_values[i];
+    }
+}
+
+static bool parallel_block(HRIR_Parallel* par, const HRIR_Schedule* schedule, const HRIR_ScheduleBlock* block) {
+    HRIR_Runtime* runtime = par->runtime;
+    size_t count = block->end - block->start;
+    bool ok = true;
+
+    par->base = block->start;
+    memset(par->done, 0, count * sizeof(bool));
+
+    for (uint32_t w = 0; ok && w < block->wave_count; w++) {
+        const uint32_t* offsets = schedule->wave_offsets + block->first_wave + w;
+        const uint32_t* cells = schedule->wave_cells + offsets[0];
+        size_t wave_size = offsets[1] - offsets[0];
+
+        // Memory must not move while workers read it
+        for (size_t k = 0; ok && k < wave_size; k++) {
+            ok = hr_ir_prepare_store(runtime, cells[k]);
+        }
+        if (ok) ok = parallel_wave(par, cells, wave_size);
+    }
+
+    if (!ok) {
+        // Re-run step by step so the error and history match hr_ir_run exactly
+        parallel_restore(par, 0, count);
+        while (runtime->pc >= block->start && runtime->pc < block->end) {
+            if (!hr_ir_step(runtime)) return false;
+        }
+        return true;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!hr_ir_commit_step(runtime, block->start + i, &par->effects[i], par->old_values[i])) {
+            // A failed snapshot leaves the cell itself committed
+            parallel_restore(par, runtime->pc > block->start + i ? i + 1 : i, count);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool hr_ir_run_parallel(HRIR_Runtime* runtime, const HRIR_Schedule* schedule, size_t threads) {
+    if (!runtime || !runtime->program || !schedule || schedule->program != runtime->program ||
+        schedule->cell_count > runtime->program->cell_count) {
+        return false;
+    }
+    if (!hr_ir_sync_runtime(runtime)) return false;
+
+    HRIR_Parallel par;
+    if (!parallel_start(&par, runtime, schedule, threads)) {
+        parallel_stop(&par);
+        return hr_ir_run(runtime);
+    }
+
+    const HRIR_Program* program = runtime->program;
+    bool ok = true;
+    while (ok && runtime->pc < program->cell_count) {
+        size_t pc = runtime->pc;
+        uint32_t block = pc < schedule->cell_count ? schedule->block_at[pc] : SCHEDULE_NONE;
+
+        // Snapshots are taken between single steps, so a memory budget steps
+        if (block != SCHEDULE_NONE && !runtime->recompute) {
+            ok = parallel_block(&par, schedule, &schedule->blocks[block]);
+        } else {
+            ok = hr_ir_step(runtime);
+        }
+    }
+
+    parallel_stop(&par);
+    return runtime->pc >= program->cell_count;
+}
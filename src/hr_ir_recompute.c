@@ -0,0 +1,312 @@
+// rio-riovn-merged/src/hr_ir_recompute.c
+// L1 HRIR Bounded-Memory Reverse Execution - sparse snapshots plus recompute
+//
+// With a memory budget the runtime keeps full state snapshots every
+// `interval` steps (sooner if the tape would take the total past the budget)
+// and only the tape since the newest one. Undo past the
+// start of the tape restores the nearest earlier snapshot and re-executes
+// forward, which rebuilds the tape for the following undos. Whenever the
+// snapshots outgrow half the budget every other one is dropped and the
+// interval doubles, so memory stays bounded while recompute per undone step
+// stays proportional to the interval. A budget must hold at least one
+// snapshot and one tape chunk; a step that cannot keep to it fails.
+
+#include "hr_ir_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HRIR_RECOMPUTE_MIN_INTERVAL 64
+
+typedef struct {
+    uint64_t position;       // Steps in history when taken
+    size_t pc;
+    HRIR_Value* registers;   // Registers followed by memory, one allocation
+    size_t register_count;
+    HRIR_Value* memory;
+    size_t memory_size;
+    size_t bytes;            // Accounted size
+} HRIR_Snapshot;
+
+struct HRIR_Recompute {
+    size_t budget;           // Bytes for snapshots plus tape
+    uint64_t interval;       // Steps between snapshots
+    HRIR_Snapshot* snapshots; // Ordered by position
+    size_t count;
+    size_t capacity;
+    size_t snapshot_bytes;
+    uint64_t steps_recomputed;
+};
+
+// =============================================================================
+// SNAPSHOTS
+// =============================================================================
+
+static size_t recompute_tape_bytes(const HRIR_Tape* tape) {
+    size_t chunks = tape->chunk_count + (tape->spare ? 1 : 0);
+    return chunks * (sizeof(HRIR_TapeChunk) + HRIR_TAPE_CHUNK_SIZE);
+}
+
+static void snapshot_free(HRIR_Snapshot* snapshot) {
+    free(snapshot->registers);
+}
+
+static bool snapshot_take(HRIR_Runtime* runtime, struct HRIR_Recompute* recompute) {
+    if (recompute->count >= recompute->capacity) {
+        size_t new_capacity = recompute->capacity ? recompute->capacity * 2 : 16;
+        HRIR_Snapshot* snapshots = realloc(recompute->snapshots, new_capacity * sizeof(HRIR_Snapshot));
+        if (!snapshots) return false;
+        recompute->snapshots = snapshots;
+        recompute->capacity = new_capacity;
+    }
+
+    size_t values = runtime->register_count + runtime->memory_size;
+    HRIR_Value* copy = malloc((values ? values : 1) * sizeof(HRIR_Value));
+    if (!copy) return false;
+
+    if (runtime->register_count > 0) {
+        memcpy(copy, runtime->registers, runtime->register_count * sizeof(HRIR_Value));
+    }
+    if (runtime->memory_size > 0) {
+        memcpy(copy + runtime->register_count, runtime->memory, runtime->memory_size * sizeof(HRIR_Value));
+    }
+
+    HRIR_Snapshot* snapshot = &recompute->snapshots[recompute->count++];
+    snapshot->position = hr_ir_get_position(runtime);
+    snapshot->pc = runtime->pc;
+    snapshot->registers = copy;
+    snapshot->register_count = runtime->register_count;
+    snapshot->memory = copy + runtime->register_count;
+    snapshot->memory_size = runtime->memory_size;
+    snapshot->bytes = sizeof(HRIR_Snapshot) + values * sizeof(HRIR_Value);
+    recompute->snapshot_bytes += snapshot->bytes;
+
+    // The snapshot now covers everything the tape held
+    hr_ir_tape_discard(&runtime->tape);
+    return true;
+}
+
+static void snapshot_restore(HRIR_Runtime* runtime, const HRIR_Snapshot* snapshot) {
+    for (size_t i = 0; i < runtime->register_count; i++) {
+        runtime->registers[i] = i < snapshot->register_count ? snapshot->registers[i]
+                                                              : hr_ir_value_int(0);
+    }
+    if (runtime->memory_size > 0) {
+        memset(runtime->memory, 0, runtime->memory_size * sizeof(HRIR_Value));
+        memcpy(runtime->memory, snapshot->memory, snapshot->memory_size * sizeof(HRIR_Value));
+    }
+    runtime->pc = snapshot->pc;
+
+    HRIR_Tape* tape = &runtime->tape;
+    hr_ir_tape_free(tape);
+    tape->base = snapshot->position;
+}
+
+// Bytes a snapshot of the current state would take
+static size_t snapshot_bytes(const HRIR_Runtime* runtime) {
+    return sizeof(HRIR_Snapshot) + (runtime->register_count + runtime->memory_size) * sizeof(HRIR_Value);
+}
+
+// The least a budget can hold: one snapshot plus the tape chunk being filled
+static size_t recompute_floor(const HRIR_Runtime* runtime) {
+    return snapshot_bytes(runtime) + sizeof(HRIR_TapeChunk) + HRIR_TAPE_CHUNK_SIZE;
+}
+
+// Drop every other snapshot (keeping the first and newest) and double the
+// interval. A budget too tight for two snapshots gives up the first one, and
+// with it the history before the newest.
+static void snapshot_thin(struct HRIR_Recompute* recompute) {
+    size_t chunk = sizeof(HRIR_TapeChunk) + HRIR_TAPE_CHUNK_SIZE;
+    if (recompute->count == 2 && recompute->snapshot_bytes + chunk > recompute->budget) {
+        recompute->snapshot_bytes -= recompute->snapshots[0].bytes;
+        snapshot_free(&recompute->snapshots[0]);
+        recompute->snapshots[0] = recompute->snapshots[1];
+        recompute->count = 1;
+    }
+
+    while (recompute->snapshot_bytes > recompute->budget / 2 && recompute->count > 2) {
+        size_t kept = 0;
+        for (size_t i = 0; i < recompute->count; i++) {
+            if (i % 2 == 0 || i == recompute->count - 1) {
+                recompute->snapshots[kept++] = recompute->snapshots[i];
+            } else {
+                recompute->snapshot_bytes -= recompute->snapshots[i].bytes;
+                snapshot_free(&recompute->snapshots[i]);
+            }
+        }
+        recompute->count = kept;
+        recompute->interval *= 2;
+    }
+}
+
+// =============================================================================
+// POLICY
+// =============================================================================
+
+bool hr_ir_set_memory_budget(HRIR_Runtime* runtime, size_t bytes) {
+    if (!runtime || !runtime->program) return false;
+
+    if (bytes == 0) {
+        hr_ir_recompute_free(runtime);
+        return true;
+    }
+    if (bytes < recompute_floor(runtime)) return false;
+    if (runtime->archive) return false; // Snapshots drop tape the archive would miss
+
+    if (!runtime->recompute) {
+        struct HRIR_Recompute* recompute = calloc(1, sizeof(struct HRIR_Recompute));
+        if (!recompute) return false;
+
+        recompute->interval = HRIR_RECOMPUTE_MIN_INTERVAL;
+        recompute->budget = bytes;
+
+        // Anchor at the current state; earlier tape is not kept
+        if (!snapshot_take(runtime, recompute)) {
+            free(recompute);
+            return false;
+        }
+        runtime->recompute = recompute;
+    }
+
+    runtime->recompute->budget = bytes;
+    snapshot_thin(runtime->recompute);
+    return true;
+}
+
+bool hr_ir_recompute_after_step(HRIR_Runtime* runtime) {
+    struct HRIR_Recompute* recompute = runtime->recompute;
+    const HRIR_Tape* tape = &runtime->tape;
+
+    size_t tape_bytes = recompute_tape_bytes(tape);
+    if (tape->steps < recompute->interval && tape_bytes + recompute->snapshot_bytes <= recompute->budget) {
+        return true;
+    }
+
+    // State grown past the budget cannot be snapshotted within it
+    if (recompute->budget < recompute_floor(runtime)) return false;
+    if (!snapshot_take(runtime, recompute)) return false;
+    snapshot_thin(recompute);
+    return true;
+}
+
+bool hr_ir_recompute_undo(HRIR_Runtime* runtime) {
+    struct HRIR_Recompute* recompute = runtime->recompute;
+    uint64_t target = hr_ir_get_position(runtime) - 1;
+
+    // Nearest snapshot at or before the target
+    size_t index = recompute->count;
+    while (index > 0 && recompute->snapshots[index - 1].position > target) index--;
+    if (index == 0) return false;
+    index--;
+
+    // Snapshots past the target describe a future that is being undone
+    for (size_t i = index + 1; i < recompute->count; i++) {
+        recompute->snapshot_bytes -= recompute->snapshots[i].bytes;
+        snapshot_free(&recompute->snapshots[i]);
+    }
+    recompute->count = index + 1;
+
+    size_t steps_executed = runtime->steps_executed;
+    snapshot_restore(runtime, &recompute->snapshots[index]);
+
+    // Per-cell state already counts these steps; only the tape is rebuilt
+    bool replaying = runtime->replaying;
+    runtime->replaying = true;
+    runtime->recomputing = true;
+    while (hr_ir_get_position(runtime) < target) {
+        if (!hr_ir_step(runtime)) {
+            runtime->replaying = replaying;
+            runtime->recomputing = false;
+            return false;
+        }
+        recompute->steps_recomputed++;
+    }
+    runtime->replaying = replaying;
+    runtime->recomputing = false;
+
+    hr_ir_cell_undone(runtime, runtime->pc);
+
+    runtime->steps_executed = steps_executed - 1;
+    runtime->rollbacks++;
+    hr_ir_checkpoints_retreat(runtime);
+    return true;
+}
+
+bool hr_ir_recompute_commit(HRIR_Runtime* runtime) {
+    struct HRIR_Recompute* recompute = runtime->recompute;
+    size_t earlier = recompute->count;
+    if (!snapshot_take(runtime, recompute)) return false;
+
+    for (size_t i = 0; i < earlier; i++) {
+        recompute->snapshot_bytes -= recompute->snapshots[i].bytes;
+        snapshot_free(&recompute->snapshots[i]);
+    }
+    recompute->snapshots[0] = recompute->snapshots[earlier];
+    recompute->count = 1;
+    return true;
+}
+
+bool hr_ir_recompute_copy(HRIR_Runtime* fork, const HRIR_Runtime* runtime) {
+    const struct HRIR_Recompute* recompute = runtime->recompute;
+    if (!recompute) return true;
+
+    struct HRIR_Recompute* copy = malloc(sizeof(struct HRIR_Recompute));
+    if (!copy) return false;
+    *copy = *recompute;
+    copy->snapshots = malloc((recompute->capacity ? recompute->capacity : 1) * sizeof(HRIR_Snapshot));
+    copy->count = 0;
+    fork->recompute = copy;
+    if (!copy->snapshots) {
+        free(copy);
+        fork->recompute = NULL;
+        return false;
+    }
+
+    for (size_t i = 0; i < recompute->count; i++) {
+        const HRIR_Snapshot* snapshot = &recompute->snapshots[i];
+        size_t values = snapshot->register_count + snapshot->memory_size;
+        HRIR_Value* registers = malloc((values ? values : 1) * sizeof(HRIR_Value));
+        if (!registers) return false; // Freed with the fork
+        memcpy(registers, snapshot->registers, values * sizeof(HRIR_Value));
+
+        copy->snapshots[i] = *snapshot;
+        copy->snapshots[i].registers = registers;
+        copy->snapshots[i].memory = registers + snapshot->register_count;
+        copy->count++;
+    }
+    return true;
+}
+
+void hr_ir_recompute_free(HRIR_Runtime* runtime) {
+    struct HRIR_Recompute* recompute = runtime->recompute;
+    if (!recompute) return;
+
+    for (size_t i = 0; i < recompute->count; i++) {
+        snapshot_free(&recompute->snapshots[i]);
+    }
+    free(recompute->snapshots);
+    free(recompute);
+    runtime->recompute = NULL;
+}
+
+// =============================================================================
+// REPORTING
+// =============================================================================
+
+HRIR_ReverseStats hr_ir_get_reverse_stats(HRIR_Runtime* runtime) {
+    HRIR_ReverseStats stats = {0};
+    if (!runtime || !runtime->program) return stats;
+
+    stats.memory_used = recompute_tape_bytes(&runtime->tape);
+    stats.steps_undone = runtime->rollbacks;
+
+    struct HRIR_Recompute* recompute = runtime->recompute;
+    if (recompute) {
+        stats.memory_budget = recompute->budget;
+        stats.memory_used += recompute->snapshot_bytes;
+        stats.snapshot_count = recompute->count;
+        stats.snapshot_interval = recompute->interval;
+        stats.steps_recomputed = recompute->steps_recomputed;
+    }
+
+    return stats;
+}
@@ -0,0 +1,436 @@
+// rio-riovn-merged/src/hr_ir_tape.c
+// L1 HRIR Undo Tape - chunked, delta-encoded step records
+//
+// Record layout (newest record at the end of the head chunk):
+//   [header][gap varint][pc delta varint?][slot varint?][value delta varint?][length]
+// The trailing length byte lets undo walk records backwards. A step that
+// overwrites a memory range writes one raw record per slot; all but the
+// newest are marked as parts of the record that follows them.
+
+#include "hr_ir_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Header bits
+#define TAPE_SLOT_MASK   0x03    // HRIR_SlotKind
+#define TAPE_HAS_PC      0x04    // Step did not fall through
+#define TAPE_TYPE_CHANGE 0x08    // Old value stored raw (type differs)
+#define TAPE_OLD_TYPE_SHIFT 4    // Old HRIR_ValueType when TYPE_CHANGE
+#define TAPE_PART        0x40    // Same step as the next record
+
+// Largest possible record: header, 4 varints, length byte
+#define TAPE_RECORD_MAX (1 + 10 + 10 + 5 + 10 + 1)
+
+// =============================================================================
+// VARINT ENCODING
+// =============================================================================
+
+static size_t tape_put_varint(uint8_t* out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static uint64_t tape_get_varint(const uint8_t** in) {
+    const uint8_t* p = *in;
+    uint64_t value = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        value |= (uint64_t)(*p++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= (uint64_t)*p++ << shift;
+    *in = p;
+    return value;
+}
+
+static uint64_t tape_zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t tape_unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static uint64_t tape_float_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double tape_bits_float(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// =============================================================================
+// CHUNK MANAGEMENT
+// =============================================================================
+
+void hr_ir_tape_init(HRIR_Tape* tape) {
+    memset(tape, 0, sizeof(HRIR_Tape));
+}
+
+// Chunks are shared between forked tapes and never written while shared
+static bool tape_shared(HRIR_TapeChunk* chunk) {
+    return __atomic_load_n(&chunk->refs, __ATOMIC_ACQUIRE) > 1;
+}
+
+static void tape_retain(HRIR_TapeChunk* chunk) {
+    if (chunk) __atomic_add_fetch(&chunk->refs, 1, __ATOMIC_RELAXED);
+}
+
+// Drop one reference to chunk, freeing the chunks nothing else holds
+static void tape_release(HRIR_TapeChunk* chunk) {
+    while (chunk && __atomic_sub_fetch(&chunk->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        HRIR_TapeChunk* prev = chunk->prev;
+        free(chunk);
+        chunk = prev;
+    }
+}
+
+void hr_ir_tape_free(HRIR_Tape* tape) {
+    tape_release(tape->head);
+    free(tape->spare);
+    hr_ir_tape_init(tape);
+}
+
+void hr_ir_tape_share(const HRIR_Tape* tape, HRIR_Tape* fork) {
+    *fork = *tape;
+    fork->spare = NULL;
+    tape_retain(fork->head);
+}
+
+void hr_ir_tape_discard(HRIR_Tape* tape) {
+    uint64_t base = tape->base + tape->steps;
+    hr_ir_tape_free(tape);
+    tape->base = base;
+}
+
+void hr_ir_tape_commit(HRIR_Tape* tape) {
+    HRIR_TapeChunk* spare = tape->spare;
+    tape->spare = NULL;
+    hr_ir_tape_discard(tape);
+    tape->spare = spare;
+}
+
+// Make room for one record, opening a new chunk when the head is full
+static HRIR_TapeChunk* tape_new_chunk(HRIR_Tape* tape) {
+    HRIR_TapeChunk* chunk = tape->spare;
+    if (chunk) {
+        tape->spare = NULL;
+    } else {
+        chunk = malloc(sizeof(HRIR_TapeChunk) + HRIR_TAPE_CHUNK_SIZE);
+        if (!chunk) return NULL;
+    }
+    chunk->refs = 1;
+    return chunk;
+}
+
+// Make room for room bytes of records, opening a new chunk when the head is
+// full. A shared head is left as it is: the new chunk links to it instead.
+static uint8_t* tape_reserve(HRIR_Tape* tape, size_t room) {
+    if (tape->head && tape->head->used + room <= HRIR_TAPE_CHUNK_SIZE &&
+        !tape_shared(tape->head)) {
+        return tape->head->bytes + tape->head->used;
+    }
+
+    HRIR_TapeChunk* chunk = tape_new_chunk(tape);
+    if (!chunk) return NULL;
+
+    chunk->prev = tape->head; // Takes over the tape's reference
+    chunk->used = 0;
+    tape->head = chunk;
+    tape->chunk_count++;
+    return chunk->bytes;
+}
+
+// =============================================================================
+// RECORDING
+// =============================================================================
+
+void hr_ir_tape_skip(HRIR_Tape* tape) {
+    tape->steps++;
+    tape->implicit++;
+}
+
+// Encode one record at the head; the caller updates the step counters
+static bool tape_write(HRIR_Tape* tape, uint8_t flags, size_t pc_before, size_t pc_after,
+                       uint8_t slot_kind, uint32_t slot,
+                       HRIR_Value old_value, HRIR_Value new_value) {
+    uint8_t* out = tape_reserve(tape, TAPE_RECORD_MAX);
+    if (!out) return false;
+
+    uint8_t header = flags | (slot_kind & TAPE_SLOT_MASK);
+    if (pc_after != pc_before + 1) header |= TAPE_HAS_PC;
+
+    bool type_change = slot_kind != HRIR_SLOT_NONE &&
+                       (old_value.type != new_value.type || old_value.type == HRIR_VALUE_NONE);
+    if (type_change) {
+        header |= TAPE_TYPE_CHANGE | (uint8_t)(old_value.type << TAPE_OLD_TYPE_SHIFT);
+    }
+
+    size_t n = 0;
+    out[n++] = header;
+    n += tape_put_varint(out + n, tape->implicit);
+
+    if (header & TAPE_HAS_PC) {
+        n += tape_put_varint(out + n, tape_zigzag((int64_t)pc_after - (int64_t)pc_before));
+    }
+
+    if (slot_kind != HRIR_SLOT_NONE) {
+        n += tape_put_varint(out + n, slot);
+
+        if (type_change) {
+            if (old_value.type == HRIR_VALUE_INT) {
+                n += tape_put_varint(out + n, tape_zigzag(old_value.as.i));
+            } else if (old_value.type == HRIR_VALUE_FLOAT) {
+                n += tape_put_varint(out + n, tape_float_bits(old_value.as.f));
+            }
+        } else if (old_value.type == HRIR_VALUE_INT) {
+            // Difference against the new value; small for counters and accumulators
+            uint64_t delta = (uint64_t)old_value.as.i - (uint64_t)new_value.as.i;
+            n += tape_put_varint(out + n, tape_zigzag((int64_t)delta));
+        } else {
+            n += tape_put_varint(out + n, tape_float_bits(old_value.as.f) ^
+                                          tape_float_bits(new_value.as.f));
+        }
+    }
+
+    out[n] = (uint8_t)(n + 1);
+    n++;
+
+    tape->head->used += n;
+    tape->bytes += n;
+    tape->records++;
+    tape->implicit = 0;
+    return true;
+}
+
+// Remove the newest record, retiring the head chunk once it empties
+static void tape_drop(HRIR_Tape* tape) {
+    HRIR_TapeChunk* chunk = tape->head;
+    size_t length = chunk->bytes[chunk->used - 1];
+
+    chunk->used -= length;
+    tape->bytes -= length;
+    tape->records--;
+
+    if (chunk->used == 0) {
+        tape->head = chunk->prev; // The chunk's reference passes to the tape
+        tape->chunk_count--;
+        free(tape->spare);
+        tape->spare = chunk;
+    }
+}
+
+bool hr_ir_tape_record(HRIR_Tape* tape, size_t pc_before, size_t pc_after,
+                       uint8_t slot_kind, uint32_t slot,
+                       HRIR_Value old_value, HRIR_Value new_value) {
+    if (!tape_write(tape, 0, pc_before, pc_after, slot_kind, slot, old_value, new_value)) return false;
+    tape->steps++;
+    return true;
+}
+
+bool hr_ir_tape_record_group(HRIR_Tape* tape, const HRIR_TapeEntry* entries, size_t count) {
+    // Every record of the group then fits the head chunk, so no write can
+    // fail. Nothing is reserved without a record: the head is never empty.
+    size_t records = 0;
+    for (size_t k = 0; k < count; k++) {
+        if (!entries[k].implicit) records++;
+    }
+    if (records > 0 && !tape_reserve(tape, records * TAPE_RECORD_MAX)) return false;
+
+    for (size_t k = 0; k < count; k++) {
+        const HRIR_TapeEntry* entry = &entries[k];
+        if (entry->implicit) {
+            hr_ir_tape_skip(tape);
+            continue;
+        }
+        tape_write(tape, 0, entry->pc_before, entry->pc_after, entry->slot_kind, entry->slot,
+                   entry->old_value, entry->new_value);
+        tape->steps++;
+    }
+    return true;
+}
+
+bool hr_ir_tape_record_range(HRIR_Tape* tape, size_t pc_before, size_t pc_after, uint32_t slot,
+                             const HRIR_Value* old_values, size_t count) {
+    HRIR_Value none = { .type = HRIR_VALUE_NONE }; // Forces the raw encoding
+    uint64_t implicit = tape->implicit;
+
+    for (size_t k = 0; k < count; k++) {
+        bool last = k + 1 == count;
+        if (!tape_write(tape, last ? 0 : TAPE_PART, pc_before, last ? pc_after : pc_before + 1,
+                        HRIR_SLOT_MEMORY, slot + (uint32_t)k, old_values[k], none)) {
+            while (k-- > 0) tape_drop(tape);
+            tape->implicit = implicit;
+            return false;
+        }
+    }
+    tape->steps++;
+    return true;
+}
+
+// =============================================================================
+// UNDO
+// =============================================================================
+
+static bool tape_is_part(const HRIR_TapeChunk* chunk, size_t used) {
+    return (chunk->bytes[used - chunk->bytes[used - 1]] & TAPE_PART) != 0;
+}
+
+// Chunks holding the newest step: one record, or a PART-linked run of them
+static size_t tape_step_chunks(const HRIR_Tape* tape) {
+    const HRIR_TapeChunk* chunk = tape->head;
+    size_t used = chunk->used - chunk->bytes[chunk->used - 1];
+    uint64_t older = tape->records - 1;
+    size_t chunks = 1;
+
+    while (older > 0) {
+        if (used == 0) {
+            chunk = chunk->prev;
+            used = chunk->used;
+            chunks++;
+        }
+        if (!tape_is_part(chunk, used)) break;
+        used -= chunk->bytes[used - 1];
+        older--;
+    }
+    return chunks;
+}
+
+// Copy the newest count chunks that are shared before popping from them. A
+// failure leaves copies made so far in place; they hold the same records.
+static bool tape_own_chunks(HRIR_Tape* tape, size_t count) {
+    HRIR_TapeChunk** link = &tape->head;
+    for (size_t k = 0; k < count && *link; k++) {
+        HRIR_TapeChunk* shared = *link;
+        if (tape_shared(shared)) {
+            HRIR_TapeChunk* chunk = tape_new_chunk(tape);
+            if (!chunk) return false;
+
+            memcpy(chunk->bytes, shared->bytes, shared->used);
+            chunk->used = shared->used;
+            chunk->prev = shared->prev;
+            tape_retain(chunk->prev);
+            tape_release(shared);
+            *link = chunk;
+        }
+        link = &(*link)->prev;
+    }
+    return true;
+}
+
+// Restore the slot named by the newest record of an owned head and drop the
+// record; returns its header
+static uint8_t tape_apply(HRIR_Tape* tape, size_t pc_after, HRIR_Value* registers, HRIR_Value* memory,
+                          size_t* pc_before, uint64_t* gap) {
+    HRIR_TapeChunk* chunk = tape->head;
+    size_t length = chunk->bytes[chunk->used - 1];
+    const uint8_t* p = chunk->bytes + chunk->used - length;
+
+    uint8_t header = *p++;
+    *gap = tape_get_varint(&p);
+
+    *pc_before = pc_after - 1;
+    if (header & TAPE_HAS_PC) {
+        *pc_before = (size_t)((int64_t)pc_after - tape_unzigzag(tape_get_varint(&p)));
+    }
+
+    uint8_t slot_kind = header & TAPE_SLOT_MASK;
+    if (slot_kind != HRIR_SLOT_NONE) {
+        uint32_t slot = (uint32_t)tape_get_varint(&p);
+        HRIR_Value* target = slot_kind == HRIR_SLOT_REGISTER ? &registers[slot] : &memory[slot];
+
+        if (header & TAPE_TYPE_CHANGE) {
+            uint8_t old_type = (header >> TAPE_OLD_TYPE_SHIFT) & 0x03;
+            target->type = old_type;
+            if (old_type == HRIR_VALUE_INT) {
+                target->as.i = tape_unzigzag(tape_get_varint(&p));
+            } else if (old_type == HRIR_VALUE_FLOAT) {
+                target->as.f = tape_bits_float(tape_get_varint(&p));
+            } else {
+                target->as.i = 0;
+            }
+        } else if (target->type == HRIR_VALUE_INT) {
+            uint64_t delta = (uint64_t)tape_unzigzag(tape_get_varint(&p));
+            target->as.i = (int64_t)((uint64_t)target->as.i + delta);
+        } else {
+            target->as.f = tape_bits_float(tape_float_bits(target->as.f) ^ tape_get_varint(&p));
+        }
+    }
+
+    tape_drop(tape);
+    return header;
+}
+
+static bool tape_newest_is_part(const HRIR_Tape* tape) {
+    return tape->head && tape->records > 0 && tape_is_part(tape->head, tape->head->used);
+}
+
+HRIR_TapeUndo hr_ir_tape_undo(HRIR_Tape* tape, size_t pc_after,
+                              HRIR_Value* registers, HRIR_Value* memory,
+                              size_t* pc_before) {
+    if (tape->steps == 0) return HRIR_TAPE_EMPTY;
+
+    if (tape->implicit > 0) {
+        tape->implicit--;
+        tape->steps--;
+        *pc_before = pc_after - 1;
+        return HRIR_TAPE_IMPLICIT;
+    }
+
+    // Every chunk of the step is made private first, so a range step is
+    // restored whole or not at all
+    if (!tape_own_chunks(tape, tape_step_chunks(tape))) return HRIR_TAPE_FAILED;
+
+    uint64_t gap;
+    tape_apply(tape, pc_after, registers, memory, pc_before, &gap);
+
+    // The rest of a range step, newest slot first
+    while (gap == 0 && tape_newest_is_part(tape)) {
+        size_t part_pc;
+        tape_apply(tape, pc_after, registers, memory, &part_pc, &gap);
+    }
+
+    tape->steps--;
+    tape->implicit = gap;
+    return HRIR_TAPE_RESTORED;
+}
+
+// =============================================================================
+// ARCHIVE
+// =============================================================================
+
+bool hr_ir_tape_archive(const HRIR_Tape* tape, FILE* file) {
+    if (tape->steps == 0) return true;
+
+    HRIR_TapeSegment segment = {
+        HRIR_TAPE_SEGMENT_MAGIC, HRIR_TAPE_SEGMENT_VERSION,
+        tape->base, tape->steps, tape->records, tape->implicit, tape->bytes
+    };
+    if (fwrite(&segment, sizeof(segment), 1, file) != 1) return false;
+
+    // Chunks link newest to oldest; the segment holds them oldest first
+    const HRIR_TapeChunk** chunks = malloc((tape->chunk_count ? tape->chunk_count : 1) * sizeof(*chunks));
+    if (!chunks) return false;
+
+    size_t count = 0;
+    for (const HRIR_TapeChunk* chunk = tape->head; chunk && count < tape->chunk_count; chunk = chunk->prev) {
+        chunks[count++] = chunk;
+    }
+
+    bool ok = true;
+    while (ok && count > 0) {
+        const HRIR_TapeChunk* chunk = chunks[--count];
+        ok = fwrite(chunk->bytes, 1, chunk->used, file) == chunk->used;
+    }
+    free(chunks);
+    return ok && fflush(file) == 0;
+}
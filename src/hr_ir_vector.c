@@ -0,0 +1,429 @@
+// rio-riovn-merged/src/hr_ir_vector.c
+// L1 HRIR Vector Kernels - vadd, vsub, vxor, vscale and vsum over memory
+//
+// Memory is an array of tagged HRIR_Values: a tag half and a payload half of
+// eight bytes each. A kernel takes the leading run of slots whose operands
+// share one type. Integer kernels work on whole slots, SSE2 one slot per
+// instruction and AVX2 two, and copy the tag half of the first operand
+// through. Float kernels first gather the payload halves of two (SSE2) or
+// four (AVX2) slots into one register, so no float instruction ever sees a
+// tag, which as a double is a denormal that would set MXCSR flags and take
+// the slow path. The slot it stops at goes through the scalar rules of the
+// matching opcode and the kernel resumes after it. There is no 64-bit
+// integer multiply before AVX-512, so integer vscale stays scalar. Kernels
+// are picked from the CPU once; float sums add in four interleaved partial
+// sums on every instruction set, so a history replays identically anywhere.
+
+#include "hr_ir_internal.h"
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HRIR_VECTOR_X86 1
+#include <immintrin.h>
+#define HRIR_AVX2 __attribute__((target("avx2")))
+#endif
+
+// The kernels rely on the tag in the low half of a slot, the payload in the high half
+typedef char hr_ir_vector_layout[sizeof(HRIR_Value) == 16 && offsetof(HRIR_Value, as) == 8 ? 1 : -1];
+
+// Apply one opcode to the leading slots of one type, returns how many
+typedef size_t (*HRIR_VectorKernel)(HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b,
+                                    double factor, size_t count);
+
+typedef struct {
+    const char* name;
+    HRIR_VectorKernel vadd[2];   // [0] integers, [1] floats; NULL = scalar
+    HRIR_VectorKernel vsub[2];
+    HRIR_VectorKernel vxor[2];
+    HRIR_VectorKernel vscale;    // Float slots times a factor
+    // Wrapping sum of the leading integer slots, added to *sum
+    size_t (*sum_int)(const HRIR_Value* values, size_t count, uint64_t* sum);
+    // Groups of four float slots added lane by lane, returns the groups taken
+    size_t (*sum_float)(const HRIR_Value* values, size_t groups, double lanes[4]);
+} HRIR_VectorKernels;
+
+static bool vector_floats(const HRIR_Value* values) {
+    return values[0].type == HRIR_VALUE_FLOAT && values[1].type == HRIR_VALUE_FLOAT &&
+           values[2].type == HRIR_VALUE_FLOAT && values[3].type == HRIR_VALUE_FLOAT;
+}
+
+static double vector_as_float(HRIR_Value value) {
+    if (value.type == HRIR_VALUE_FLOAT) return value.as.f;
+    return value.type == HRIR_VALUE_INT ? (double)value.as.i : 0.0;
+}
+
+// =============================================================================
+// SCALAR
+// =============================================================================
+
+// One slot by the scalar rules: vadd, vsub and vscale as add, subtract and
+// multiply; vxor flips the payload bits of x by those of y and keeps x's type
+static HRIR_Value vector_scalar(HRIR_Opcode op, HRIR_Value x, HRIR_Value y) {
+    if (x.type == HRIR_VALUE_NONE) x = hr_ir_value_int(0);
+    if (y.type == HRIR_VALUE_NONE) y = hr_ir_value_int(0);
+
+    HRIR_Value out = x;
+    switch (op) {
+        case HRIR_OPC_VADD: hr_ir_eval_binary(HRIR_OPC_ADD, x, y, &out); break;
+        case HRIR_OPC_VSUB: hr_ir_eval_binary(HRIR_OPC_SUBTRACT, x, y, &out); break;
+        case HRIR_OPC_VSCALE: hr_ir_eval_binary(HRIR_OPC_MULTIPLY, x, y, &out); break;
+        default: out.as.i = x.as.i ^ y.as.i; break;
+    }
+    return out;
+}
+
+static size_t scalar_sum_int(const HRIR_Value* values, size_t count, uint64_t* sum) {
+    size_t k = 0;
+    for (; k < count && values[k].type == HRIR_VALUE_INT; k++) {
+        *sum += (uint64_t)values[k].as.i;
+    }
+    return k;
+}
+
+static size_t scalar_sum_float(const HRIR_Value* values, size_t groups, double lanes[4]) {
+    size_t g = 0;
+    for (; g < groups && vector_floats(values + 4 * g); g++) {
+        for (size_t j = 0; j < 4; j++) lanes[j] += values[4 * g + j].as.f;
+    }
+    return g;
+}
+
+#ifdef HRIR_VECTOR_X86
+
+// =============================================================================
+// SSE2
+// =============================================================================
+
+// Payload half of r, tag half of x
+static inline __m128i sse2_tagged(__m128i r, __m128i x) {
+    return _mm_castpd_si128(_mm_move_sd(_mm_castsi128_pd(r), _mm_castsi128_pd(x)));
+}
+
+#define VECTOR_SSE2_BINARY(name, value_type, op)                                        \
+    static size_t name(HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b,       \
+                       double factor, size_t count) {                                   \
+        (void)factor;                                                                   \
+        size_t k = 0;                                                                   \
+        for (; k < count && a[k].type == (value_type) && b[k].type == (value_type); k++) { \
+            __m128i x = _mm_loadu_si128((const __m128i*)&a[k]);                         \
+            __m128i y = _mm_loadu_si128((const __m128i*)&b[k]);                         \
+            _mm_storeu_si128((__m128i*)&dst[k], sse2_tagged(op(x, y), x));              \
+        }                                                                               \
+        return k;                                                                       \
+    }
+
+VECTOR_SSE2_BINARY(sse2_vadd_int, HRIR_VALUE_INT, _mm_add_epi64)
+VECTOR_SSE2_BINARY(sse2_vsub_int, HRIR_VALUE_INT, _mm_sub_epi64)
+VECTOR_SSE2_BINARY(sse2_vxor_int, HRIR_VALUE_INT, _mm_xor_si128)
+VECTOR_SSE2_BINARY(sse2_vxor_float, HRIR_VALUE_FLOAT, _mm_xor_si128)
+
+static inline bool sse2_float_pair(const HRIR_Value* values) {
+    return values[0].type == HRIR_VALUE_FLOAT && values[1].type == HRIR_VALUE_FLOAT;
+}
+
+// Payloads of two slots in, results back beside the tags of x0 and x1
+static inline __m128d sse2_payloads(__m128d x0, __m128d x1) {
+    return _mm_unpackhi_pd(x0, x1);
+}
+
+static inline void sse2_store_payloads(HRIR_Value* dst, __m128d r, __m128d x0, __m128d x1) {
+    _mm_storeu_pd((double*)&dst[0], _mm_shuffle_pd(x0, r, 0x0));
+    _mm_storeu_pd((double*)&dst[1], _mm_shuffle_pd(x1, r, 0x2));
+}
+
+#define VECTOR_SSE2_FLOAT(name, op)                                                     \
+    static size_t name(HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b,       \
+                       double factor, size_t count) {                                   \
+        (void)factor;                                                                   \
+        size_t k = 0;                                                                   \
+        for (; k + 1 < count && sse2_float_pair(a + k) && sse2_float_pair(b + k); k += 2) { \
+            __m128d x0 = _mm_loadu_pd((const double*)&a[k]);                            \
+            __m128d x1 = _mm_loadu_pd((const double*)&a[k + 1]);                        \
+            __m128d y = sse2_payloads(_mm_loadu_pd((const double*)&b[k]),                \
+                                      _mm_loadu_pd((const double*)&b[k + 1]));          \
+            sse2_store_payloads(dst + k, op(sse2_payloads(x0, x1), y), x0, x1);         \
+        }                                                                               \
+        return k;                                                                       \
+    }
+
+VECTOR_SSE2_FLOAT(sse2_vadd_float, _mm_add_pd)
+VECTOR_SSE2_FLOAT(sse2_vsub_float, _mm_sub_pd)
+
+static size_t sse2_vscale(HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b,
+                          double factor, size_t count) {
+    (void)b;
+    __m128d f = _mm_set1_pd(factor);
+    size_t k = 0;
+    for (; k + 1 < count && sse2_float_pair(a + k); k += 2) {
+        __m128d x0 = _mm_loadu_pd((const double*)&a[k]);
+        __m128d x1 = _mm_loadu_pd((const double*)&a[k + 1]);
+        sse2_store_payloads(dst + k, _mm_mul_pd(sse2_payloads(x0, x1), f), x0, x1);
+    }
+    return k;
+}
+
+static size_t sse2_sum_int(const HRIR_Value* values, size_t count, uint64_t* sum) {
+    __m128i acc = _mm_setzero_si128();
+    size_t k = 0;
+    for (; k < count && values[k].type == HRIR_VALUE_INT; k++) {
+        acc = _mm_add_epi64(acc, _mm_loadu_si128((const __m128i*)&values[k]));
+    }
+    *sum += (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc));
+    return k;
+}
+
+static size_t sse2_sum_float(const HRIR_Value* values, size_t groups, double lanes[4]) {
+    __m128d low = _mm_loadu_pd(lanes);
+    __m128d high = _mm_loadu_pd(lanes + 2);
+    size_t g = 0;
+    for (; g < groups && vector_floats(values + 4 * g); g++) {
+        const double* v = (const double*)(values + 4 * g);
+        low = _mm_add_pd(low, _mm_unpackhi_pd(_mm_loadu_pd(v), _mm_loadu_pd(v + 2)));
+        high = _mm_add_pd(high, _mm_unpackhi_pd(_mm_loadu_pd(v + 4), _mm_loadu_pd(v + 6)));
+    }
+    _mm_storeu_pd(lanes, low);
+    _mm_storeu_pd(lanes + 2, high);
+    return g;
+}
+
+// =============================================================================
+// AVX2
+// =============================================================================
+
+// Payload halves of r, tag halves of x
+static inline HRIR_AVX2 __m256i avx2_tagged(__m256i r, __m256i x) {
+    return _mm256_blend_epi32(r, x, 0x33);
+}
+
+#define VECTOR_AVX2_BINARY(name, value_type, op)                                          \
+    static HRIR_AVX2 size_t name(HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b, \
+                                 double factor, size_t count) {                           \
+        (void)factor;                                                                     \
+        size_t k = 0;                                                                     \
+        for (; k + 1 < count && a[k].type == (value_type) && a[k + 1].type == (value_type) && \
+               b[k].type == (value_type) && b[k + 1].type == (value_type); k += 2) {      \
+            __m256i x = _mm256_loadu_si256((const __m256i*)&a[k]);                        \
+            __m256i y = _mm256_loadu_si256((const __m256i*)&b[k]);                        \
+            _mm256_storeu_si256((__m256i*)&dst[k], avx2_tagged(op(x, y), x));             \
+        }                                                                                 \
+        return k;                                                                         \
+    }
+
+VECTOR_AVX2_BINARY(avx2_vadd_int, HRIR_VALUE_INT, _mm256_add_epi64)
+VECTOR_AVX2_BINARY(avx2_vsub_int, HRIR_VALUE_INT, _mm256_sub_epi64)
+VECTOR_AVX2_BINARY(avx2_vxor_int, HRIR_VALUE_INT, _mm256_xor_si256)
+VECTOR_AVX2_BINARY(avx2_vxor_float, HRIR_VALUE_FLOAT, _mm256_xor_si256)
+
+// Payloads of four slots in (lane order 0, 2, 1, 3), results back beside the
+// tags of the slot pairs x0 and x1
+static inline HRIR_AVX2 __m256d avx2_payloads(__m256d x0, __m256d x1) {
+    return _mm256_unpackhi_pd(x0, x1);
+}
+
+static inline HRIR_AVX2 void avx2_store_payloads(HRIR_Value* dst, __m256d r, __m256d x0, __m256d x1) {
+    _mm256_storeu_pd((double*)&dst[0], _mm256_shuffle_pd(x0, r, 0x0));
+    _mm256_storeu_pd((double*)&dst[2], _mm256_shuffle_pd(x1, r, 0xA));
+}
+
+#define VECTOR_AVX2_FLOAT(name, op)                                                       \
+    static HRIR_AVX2 size_t name(HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b, \
+                                 double factor, size_t count) {                           \
+        (void)factor;                                                                     \
+        size_t k = 0;                                                                     \
+        for (; k + 3 < count && vector_floats(a + k) && vector_floats(b + k); k += 4) {   \
+            __m256d x0 = _mm256_loadu_pd((const double*)&a[k]);                           \
+            __m256d x1 = _mm256_loadu_pd((const double*)&a[k + 2]);                       \
+            __m256d y = avx2_payloads(_mm256_loadu_pd((const double*)&b[k]),               \
+                                      _mm256_loadu_pd((const double*)&b[k + 2]));         \
+            avx2_store_payloads(dst + k, op(avx2_payloads(x0, x1), y), x0, x1);           \
+        }                                                                                 \
+        return k;                                                                         \
+    }
+
+VECTOR_AVX2_FLOAT(avx2_vadd_float, _mm256_add_pd)
+VECTOR_AVX2_FLOAT(avx2_vsub_float, _mm256_sub_pd)
+
+static HRIR_AVX2 size_t avx2_vscale(HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b,
+                                    double factor, size_t count) {
+    (void)b;
+    __m256d f = _mm256_set1_pd(factor);
+    size_t k = 0;
+    for (; k + 3 < count && vector_floats(a + k); k += 4) {
+        __m256d x0 = _mm256_loadu_pd((const double*)&a[k]);
+        __m256d x1 = _mm256_loadu_pd((const double*)&a[k + 2]);
+        avx2_store_payloads(dst + k, _mm256_mul_pd(avx2_payloads(x0, x1), f), x0, x1);
+    }
+    return k;
+}
+
+static HRIR_AVX2 size_t avx2_sum_int(const HRIR_Value* values, size_t count, uint64_t* sum) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t k = 0;
+    for (; k + 1 < count && values[k].type == HRIR_VALUE_INT && values[k + 1].type == HRIR_VALUE_INT; k += 2) {
+        acc = _mm256_add_epi64(acc, _mm256_loadu_si256((const __m256i*)&values[k]));
+    }
+    uint64_t halves[4];
+    _mm256_storeu_si256((__m256i*)halves, acc);
+    *sum += halves[1] + halves[3];
+    return k;
+}
+
+static HRIR_AVX2 size_t avx2_sum_float(const HRIR_Value* values, size_t groups, double lanes[4]) {
+    // Unpacking two slot pairs yields lanes in the order 0, 2, 1, 3
+    __m256d acc = _mm256_set_pd(lanes[3], lanes[1], lanes[2], lanes[0]);
+    size_t g = 0;
+    for (; g < groups && vector_floats(values + 4 * g); g++) {
+        const double* v = (const double*)(values + 4 * g);
+        acc = _mm256_add_pd(acc, _mm256_unpackhi_pd(_mm256_loadu_pd(v), _mm256_loadu_pd(v + 4)));
+    }
+    double out[4];
+    _mm256_storeu_pd(out, acc);
+    lanes[0] = out[0];
+    lanes[2] = out[1];
+    lanes[1] = out[2];
+    lanes[3] = out[3];
+    return g;
+}
+
+#endif // HRIR_VECTOR_X86
+
+// =============================================================================
+// DISPATCH
+// =============================================================================
+
+// Indexed by HRIR_VectorIsa
+static const HRIR_VectorKernels vector_kernels[] = {
+    { "scalar", { NULL, NULL }, { NULL, NULL }, { NULL, NULL }, NULL,
+      scalar_sum_int, scalar_sum_float },
+#ifdef HRIR_VECTOR_X86
+    { "sse2", { sse2_vadd_int, sse2_vadd_float }, { sse2_vsub_int, sse2_vsub_float },
+      { sse2_vxor_int, sse2_vxor_float }, sse2_vscale, sse2_sum_int, sse2_sum_float },
+    { "avx2", { avx2_vadd_int, avx2_vadd_float }, { avx2_vsub_int, avx2_vsub_float },
+      { avx2_vxor_int, avx2_vxor_float }, avx2_vscale, avx2_sum_int, avx2_sum_float },
+#endif
+};
+
+#define VECTOR_ISA_COUNT (sizeof(vector_kernels) / sizeof(vector_kernels[0]))
+
+static int vector_selected = -1; // HRIR_VectorIsa, -1 until first use
+
+static bool vector_supported(HRIR_VectorIsa isa) {
+    if ((size_t)isa >= VECTOR_ISA_COUNT) return false;
+#ifdef HRIR_VECTOR_X86
+    if (isa == HRIR_VECTOR_AVX2) {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+    return true; // SSE2 is part of x86-64
+}
+
+HRIR_VectorIsa hr_ir_vector_isa(void) {
+    int isa = __atomic_load_n(&vector_selected, __ATOMIC_RELAXED);
+    if (isa < 0) {
+        isa = (int)VECTOR_ISA_COUNT - 1;
+        while (isa > 0 && !vector_supported((HRIR_VectorIsa)isa)) isa--;
+        __atomic_store_n(&vector_selected, isa, __ATOMIC_RELAXED);
+    }
+    return (HRIR_VectorIsa)isa;
+}
+
+bool hr_ir_set_vector_isa(HRIR_VectorIsa isa) {
+    if (!vector_supported(isa)) return false;
+    __atomic_store_n(&vector_selected, (int)isa, __ATOMIC_RELAXED);
+    return true;
+}
+
+const char* hr_ir_vector_isa_name(HRIR_VectorIsa isa) {
+    switch (isa) {
+        case HRIR_VECTOR_SCALAR: return "scalar";
+        case HRIR_VECTOR_SSE2: return "sse2";
+        case HRIR_VECTOR_AVX2: return "avx2";
+        default: return "unknown";
+    }
+}
+
+static HRIR_VectorKernel vector_kernel(const HRIR_VectorKernels* kernels, HRIR_Opcode op,
+                                       HRIR_Value x, HRIR_Value y, bool integers_only) {
+    if (integers_only && x.type != HRIR_VALUE_INT) return NULL;
+    if (op == HRIR_OPC_VSCALE) return x.type == HRIR_VALUE_FLOAT ? kernels->vscale : NULL;
+    if (x.type != y.type || x.type == HRIR_VALUE_NONE) return NULL;
+
+    int floats = x.type == HRIR_VALUE_FLOAT;
+    switch (op) {
+        case HRIR_OPC_VADD: return kernels->vadd[floats];
+        case HRIR_OPC_VSUB: return kernels->vsub[floats];
+        default: return kernels->vxor[floats];
+    }
+}
+
+// =============================================================================
+// OPERATIONS
+// =============================================================================
+
+size_t hr_ir_vector_apply(HRIR_Opcode op, HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b,
+                          HRIR_Value factor, size_t count, bool integers_only) {
+    const HRIR_VectorKernels* kernels = &vector_kernels[hr_ir_vector_isa()];
+    bool scale = op == HRIR_OPC_VSCALE;
+    double f = vector_as_float(factor);
+    size_t k = 0;
+
+    while (k < count) {
+        HRIR_Value y = scale ? factor : b[k];
+        HRIR_VectorKernel kernel = vector_kernel(kernels, op, a[k], y, integers_only);
+        if (kernel) {
+            k += kernel(dst + k, a + k, b + k, f, count - k);
+            if (k == count) break;
+            y = scale ? factor : b[k];
+        }
+
+        if (integers_only && (a[k].type != HRIR_VALUE_INT || y.type != HRIR_VALUE_INT)) break;
+        dst[k] = vector_scalar(op, a[k], y);
+        k++;
+    }
+    return k;
+}
+
+void hr_ir_vector_invert(HRIR_Opcode op, HRIR_Value* dst, const HRIR_Value* a, const HRIR_Value* b,
+                         size_t count) {
+    HRIR_Value unused = hr_ir_value_int(0);
+
+    if (op == HRIR_OPC_VSUB && dst == b) {
+        // dst = a - dst is its own inverse
+        hr_ir_vector_apply(HRIR_OPC_VSUB, dst, a, dst, unused, count, true);
+        return;
+    }
+
+    const HRIR_Value* other = dst == a ? b : a;
+    HRIR_Opcode inverse = op == HRIR_OPC_VADD ? HRIR_OPC_VSUB : op == HRIR_OPC_VSUB ? HRIR_OPC_VADD
+                                                                                   : HRIR_OPC_VXOR;
+    hr_ir_vector_apply(inverse, dst, dst, other, unused, count, true);
+}
+
+HRIR_Value hr_ir_vector_sum(const HRIR_Value* values, size_t count) {
+    const HRIR_VectorKernels* kernels = &vector_kernels[hr_ir_vector_isa()];
+    uint64_t sum = 0;
+    size_t k = 0;
+
+    while (k < count) {
+        k += kernels->sum_int(values + k, count - k, &sum);
+        if (k == count || values[k].type == HRIR_VALUE_FLOAT) break;
+        if (values[k].type == HRIR_VALUE_INT) sum += (uint64_t)values[k].as.i;
+        k++; // An empty slot reads as 0
+    }
+    if (k == count) return hr_ir_value_int((int64_t)sum);
+
+    // A float anywhere makes it a float sum of every slot
+    double lanes[4] = { 0.0, 0.0, 0.0, 0.0 };
+    size_t groups = count / 4;
+    size_t g = 0;
+    while (g < groups) {
+        g += kernels->sum_float(values + 4 * g, groups - g, lanes);
+        if (g == groups) break;
+        for (size_t j = 0; j < 4; j++) lanes[j] += vector_as_float(values[4 * g + j]);
+        g++;
+    }
+    for (k = 4 * groups; k < count; k++) lanes[k % 4] += vector_as_float(values[k]);
+    return hr_ir_value_float((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]));
+}
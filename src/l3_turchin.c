@@ -2,12 +2,18 @@
 // L3 Turchin Actor Runtime Implementation
 // D-term coordination: Message passing, supervision, error handling
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "l3_turchin.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdarg.h>
 #include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // =============================================================================
 // UTILITY FUNCTIONS
@@ -62,6 +68,197 @@ static char* l3_substring(const char* str, size_t start, size_t len) {
     return sub;
 }
 
+unsigned long long l3_now_ms(L3_ActorRuntime* runtime) {
+    if (runtime && runtime->simulated) return runtime->virtual_ms;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (unsigned long long)ts.tv_sec * 1000ULL + (unsigned long long)ts.tv_nsec / 1000000ULL;
+}
+
+// Runtime clock in seconds (passivation idle times)
+static unsigned long l3_now(L3_ActorRuntime* runtime) {
+    return (unsigned long)(l3_now_ms(runtime) / 1000ULL);
+}
+
+static void l3_trace(L3_ActorRuntime* runtime, const char* format, ...) {
+    if (runtime && !runtime->trace) return;
+
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+// xorshift64* - small, fast and identical on every platform
+static unsigned long long l3_random(L3_ActorRuntime* runtime) {
+    unsigned long long x = runtime->rng_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    runtime->rng_state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static int l3_find_actor_index(L3_ActorRuntime* runtime, int actor_id) {
+    // Actors are never removed and ids are handed out sequentially,
+    // so the id normally maps straight onto its slot
+    size_t guess = (size_t)(actor_id - 1);
+    if (actor_id > 0 && guess < runtime->actor_count &&
+        runtime->actors[guess]->id == actor_id) {
+        return (int)guess;
+    }
+
+    for (size_t i = 0; i < runtime->actor_count; i++) {
+        if (runtime->actors[i]->id == actor_id) {
+            return (int)i;
+        }
+    }
+
+    return -1;
+}
+
+static void l3_free_handlers(L3_Handler** handlers, size_t count) {
+    if (!handlers) return;
+
+    for (size_t h = 0; h < count; h++) {
+        if (handlers[h]) {
+            free(handlers[h]->event_name);
+            free(handlers[h]->body_code);
+            free(handlers[h]);
+        }
+    }
+    free(handlers);
+}
+
+// =============================================================================
+// MEMORY ACCOUNTING (charged to tenants)
+// =============================================================================
+
+static size_t l3_string_bytes(const char* str) {
+    return str ? strlen(str) + 1 : 0;
+}
+
+static size_t l3_state_bytes(L3_ActorState* state) {
+    if (!state) return 0;
+
+    size_t bytes = sizeof(L3_ActorState) + state->capacity * 2 * sizeof(char*);
+    for (size_t i = 0; i < state->count; i++) {
+        bytes += l3_string_bytes(state->keys[i]) + l3_string_bytes(state->values[i]);
+    }
+    return bytes;
+}
+
+static size_t l3_handlers_bytes(L3_Handler** handlers, size_t count) {
+    size_t bytes = count * (sizeof(L3_Handler*) + sizeof(L3_Handler));
+    for (size_t h = 0; h < count; h++) {
+        bytes += l3_string_bytes(handlers[h]->event_name) +
+                 l3_string_bytes(handlers[h]->body_code);
+    }
+    return bytes;
+}
+
+static size_t l3_message_bytes(const char* event, const char* data) {
+    return sizeof(L3_Message) + l3_string_bytes(event) + l3_string_bytes(data ? data : "{}");
+}
+
+// A resident actor: the spawn quota check charges a definition with the same
+// formula before anything is allocated
+static size_t l3_resident_bytes(const char* name, const char* role, L3_ActorState* state,
+                                L3_Handler** handlers, size_t handler_count) {
+    // Mailbox slots are charged at their initial capacity; queued
+    // messages are charged separately as they arrive
+    return sizeof(L3_Actor) + l3_string_bytes(name) + l3_string_bytes(role) + l3_state_bytes(state) +
+           l3_handlers_bytes(handlers, handler_count) +
+           sizeof(L3_MessageQueue) + 64 * sizeof(L3_Message*);
+}
+
+static size_t l3_actor_footprint(L3_Actor* actor) {
+    if (actor->passivated) {
+        return sizeof(L3_Actor) + l3_string_bytes(actor->name) +
+               l3_handlers_bytes(actor->natives, actor->native_count);
+    }
+    return l3_resident_bytes(actor->name, actor->role, actor->state,
+                             actor->handlers, actor->handler_count);
+}
+
+static L3_Tenant* l3_get_tenant(L3_ActorRuntime* runtime, int tenant_id) {
+    if (tenant_id <= 0 || (size_t)tenant_id > runtime->tenant_count) return NULL;
+    return runtime->tenants[tenant_id - 1];
+}
+
+// Re-measure an actor and move the difference onto its tenant's bill
+static void l3_recharge_actor(L3_ActorRuntime* runtime, L3_Actor* actor) {
+    size_t footprint = l3_actor_footprint(actor);
+    L3_Tenant* tenant = l3_get_tenant(runtime, actor->tenant_id);
+
+    if (tenant) {
+        tenant->usage.memory_used -= actor->footprint;
+        tenant->usage.memory_used += footprint;
+    }
+    actor->footprint = footprint;
+}
+
+// =============================================================================
+// IDLE LIST (passivation candidates)
+// =============================================================================
+
+// An actor joins at the tail when its mailbox drains (or on spawn and
+// activation) and leaves when a message is queued or it is passivated, so
+// the list stays ordered by last_active and idle passivation stops at the
+// first actor still within its timeout.
+static void l3_idle_remove(L3_ActorRuntime* runtime, L3_Actor* actor) {
+    if (!actor->idle) return;
+
+    if (actor->idle_prev) actor->idle_prev->idle_next = actor->idle_next;
+    else runtime->idle_head = actor->idle_next;
+    if (actor->idle_next) actor->idle_next->idle_prev = actor->idle_prev;
+    else runtime->idle_tail = actor->idle_prev;
+
+    actor->idle_prev = NULL;
+    actor->idle_next = NULL;
+    actor->idle = false;
+}
+
+static void l3_idle_push(L3_ActorRuntime* runtime, L3_Actor* actor) {
+    l3_idle_remove(runtime, actor);
+
+    actor->idle_prev = runtime->idle_tail;
+    if (runtime->idle_tail) runtime->idle_tail->idle_next = actor;
+    else runtime->idle_head = actor;
+    runtime->idle_tail = actor;
+    actor->idle = true;
+}
+
+// =============================================================================
+// READY LIST (untenanted actors with mail, for simulated rounds)
+// =============================================================================
+
+// An untenanted actor joins when a message is queued for it and leaves once a
+// simulated round finds its mailbox drained, so a round shuffles only actors
+// that have work. Spawns reserve a slot for every untenanted actor: joining
+// never allocates.
+static bool l3_ready_reserve(L3_ActorRuntime* runtime, size_t count) {
+    if (count <= runtime->ready_capacity) return true;
+
+    size_t new_cap = runtime->ready_capacity ? runtime->ready_capacity * 2 : 16;
+    while (new_cap < count) new_cap *= 2;
+    size_t* slots = realloc(runtime->ready_slots, new_cap * sizeof(size_t));
+    if (!slots) return false;
+
+    runtime->ready_slots = slots;
+    runtime->ready_capacity = new_cap;
+    return true;
+}
+
+static void l3_ready_push(L3_ActorRuntime* runtime, size_t slot) {
+    L3_Actor* actor = runtime->actors[slot];
+    if (actor->ready || actor->tenant_id != 0) return;
+
+    runtime->ready_slots[runtime->ready_count++] = slot;
+    actor->ready = true;
+}
+
 // =============================================================================
 // STATE MANAGEMENT
 // =============================================================================
@@ -131,6 +328,36 @@ const char* l3_state_get(L3_ActorState* state, const char* key) {
     return NULL;
 }
 
+long long l3_state_get_int(L3_ActorState* state, const char* key, long long fallback) {
+    const char* value = l3_state_get(state, key);
+    if (!value) return fallback;
+
+    char* end = NULL;
+    long long result = strtoll(value, &end, 10);
+    return end == value ? fallback : result;
+}
+
+bool l3_state_set_int(L3_ActorState* state, const char* key, long long value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lld", value);
+    return l3_state_set(state, key, buf);
+}
+
+double l3_state_get_number(L3_ActorState* state, const char* key, double fallback) {
+    const char* value = l3_state_get(state, key);
+    if (!value) return fallback;
+
+    char* end = NULL;
+    double result = strtod(value, &end);
+    return end == value ? fallback : result;
+}
+
+bool l3_state_set_number(L3_ActorState* state, const char* key, double value) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.17g", value);
+    return l3_state_set(state, key, buf);
+}
+
 void l3_state_free(L3_ActorState* state) {
     if (!state) return;
 
@@ -166,7 +393,8 @@ static L3_MessageQueue* l3_queue_create(void) {
     return queue;
 }
 
-static bool l3_queue_push(L3_MessageQueue* queue, const char* event, const char* data) {
+static bool l3_queue_push(L3_MessageQueue* queue, const char* event, const char* data,
+                          unsigned long long timestamp) {
     if (!queue) return false;
 
     if (queue->count >= queue->capacity) {
@@ -192,7 +420,7 @@ static bool l3_queue_push(L3_MessageQueue* queue, const char* event, const char*
 
     msg->event = l3_strdup(event);
     msg->data = l3_strdup(data ? data : "{}");
-    msg->timestamp = (unsigned long)time(NULL);
+    msg->timestamp = timestamp;
 
     queue->messages[queue->tail] = msg;
     queue->tail = (queue->tail + 1) % queue->capacity;
@@ -245,6 +473,33 @@ L3_ActorRuntime* l3_runtime_init(void) {
     runtime->next_actor_id = 1;
     runtime->running = false;
 
+    runtime->store_dir = NULL;
+    runtime->idle_timeout = 0;
+    runtime->passivated_count = 0;
+    runtime->idle_head = NULL;
+    runtime->idle_tail = NULL;
+
+    runtime->tenants = NULL;
+    runtime->tenant_count = 0;
+    runtime->tenant_capacity = 0;
+
+    runtime->timers = NULL;
+    runtime->timer_count = 0;
+    runtime->timer_capacity = 0;
+    runtime->timer_seq = 0;
+    runtime->pending_messages = 0;
+
+    runtime->simulated = false;
+    runtime->virtual_ms = 0;
+    runtime->rng_state = 0;
+    runtime->schedule_order = NULL;
+    runtime->schedule_capacity = 0;
+    runtime->ready_slots = NULL;
+    runtime->ready_count = 0;
+    runtime->ready_capacity = 0;
+
+    runtime->trace = true;
+
     if (!runtime->actors || !runtime->message_queues) {
         free(runtime->actors);
         free(runtime->message_queues);
@@ -276,8 +531,42 @@ void l3_stop_runtime(L3_ActorRuntime* runtime) {
 // =============================================================================
 
 int l3_spawn_actor(L3_ActorRuntime* runtime, L3_ActorDefinition* def) {
+    return l3_spawn_actor_in_tenant(runtime, def, 0);
+}
+
+int l3_spawn_actor_in_tenant(L3_ActorRuntime* runtime, L3_ActorDefinition* def, int tenant_id) {
     if (!runtime || !def) return -1;
 
+    L3_Tenant* tenant = NULL;
+    if (tenant_id != 0) {
+        tenant = l3_get_tenant(runtime, tenant_id);
+        if (!tenant) {
+            printf("❌ Tenant %d not found\n", tenant_id);
+            return -1;
+        }
+
+        // Refuse spawns that would push the tenant over its memory quota
+        size_t estimate = l3_resident_bytes(def->name, def->role, def->initial_state,
+                                            def->handlers, def->handler_count);
+        if (tenant->quota.memory_quota &&
+            tenant->usage.memory_used + estimate > tenant->quota.memory_quota) {
+            tenant->usage.spawns_rejected++;
+            printf("⛔ Tenant %s over memory quota, spawn refused\n", tenant->name);
+            return -1;
+        }
+
+        if (tenant->actor_count >= tenant->actor_capacity) {
+            size_t new_cap = tenant->actor_capacity ? tenant->actor_capacity * 2 : 16;
+            size_t* new_slots = realloc(tenant->actor_slots, new_cap * sizeof(size_t));
+            if (!new_slots) return -1;
+
+            tenant->actor_slots = new_slots;
+            tenant->actor_capacity = new_cap;
+        }
+    } else if (!l3_ready_reserve(runtime, runtime->actor_count + 1)) {
+        return -1;
+    }
+
     // Expand if needed
     if (runtime->actor_count >= runtime->actor_capacity) {
         size_t new_cap = runtime->actor_capacity * 2;
@@ -298,6 +587,16 @@ int l3_spawn_actor(L3_ActorRuntime* runtime, L3_ActorDefinition* def) {
     actor->id = runtime->next_actor_id++;
     actor->name = l3_strdup(def->name);
     actor->role = l3_strdup(def->role);
+    actor->passivated = false;
+    actor->last_active = l3_now(runtime);
+    actor->natives = NULL;
+    actor->native_count = 0;
+    actor->idle_prev = NULL;
+    actor->idle_next = NULL;
+    actor->idle = false;
+    actor->ready = false;
+    actor->tenant_id = tenant_id;
+    actor->footprint = 0;
 
     // Copy initial state
     actor->state = l3_state_create();
@@ -314,6 +613,7 @@ int l3_spawn_actor(L3_ActorRuntime* runtime, L3_ActorDefinition* def) {
         actor->handlers[i] = malloc(sizeof(L3_Handler));
         actor->handlers[i]->event_name = l3_strdup(def->handlers[i]->event_name);
         actor->handlers[i]->body_code = l3_strdup(def->handlers[i]->body_code);
+        actor->handlers[i]->native = def->handlers[i]->native;
     }
 
     // Create message queue
@@ -325,8 +625,14 @@ int l3_spawn_actor(L3_ActorRuntime* runtime, L3_ActorDefinition* def) {
     runtime->actor_count++;
     runtime->queue_count++;
 
-    printf("🎭 Spawned actor: %s (id: %d, role: \"%s\")\n",
-           actor->name, actor->id, actor->role);
+    if (tenant) {
+        tenant->actor_slots[tenant->actor_count++] = runtime->actor_count - 1;
+    }
+    l3_recharge_actor(runtime, actor);
+    l3_idle_push(runtime, actor);
+
+    l3_trace(runtime, "🎭 Spawned actor: %s (id: %d, role: \"%s\")\n",
+             actor->name, actor->id, actor->role);
 
     return actor->id;
 }
@@ -338,25 +644,47 @@ int l3_spawn_actor(L3_ActorRuntime* runtime, L3_ActorDefinition* def) {
 bool l3_send_message(L3_ActorRuntime* runtime, int actor_id, const char* event, const char* data) {
     if (!runtime || !event) return false;
 
-    // Find actor index
-    int actor_index = -1;
-    for (size_t i = 0; i < runtime->actor_count; i++) {
-        if (runtime->actors[i]->id == actor_id) {
-            actor_index = i;
-            break;
-        }
-    }
-
+    int actor_index = l3_find_actor_index(runtime, actor_id);
     if (actor_index == -1) {
         printf("❌ Actor %d not found\n", actor_id);
         return false;
     }
 
+    L3_Actor* actor = runtime->actors[actor_index];
+    L3_Tenant* tenant = l3_get_tenant(runtime, actor->tenant_id);
+
+    // First message for a passivated actor reloads it from the store
+    if (actor->passivated && !l3_activate_actor(runtime, actor_id)) {
+        if (tenant) tenant->usage.messages_rejected++;
+        return false;
+    }
+
+    size_t bytes = l3_message_bytes(event, data);
+
+    if (tenant) {
+        if ((tenant->quota.mailbox_quota &&
+             tenant->usage.mailbox_depth >= tenant->quota.mailbox_quota) ||
+            (tenant->quota.memory_quota &&
+             tenant->usage.memory_used + bytes > tenant->quota.memory_quota)) {
+            tenant->usage.messages_rejected++;
+            printf("⛔ Tenant %s over quota, dropped %s to actor %d\n",
+                   tenant->name, event, actor_id);
+            return false;
+        }
+    }
+
     L3_MessageQueue* queue = runtime->message_queues[actor_index];
-    bool success = l3_queue_push(queue, event, data);
+    bool success = l3_queue_push(queue, event, data, l3_now_ms(runtime));
 
     if (success) {
-        printf("📨 Sent %s to actor %d\n", event, actor_id);
+        l3_idle_remove(runtime, actor);
+        l3_ready_push(runtime, (size_t)actor_index);
+        runtime->pending_messages++;
+        if (tenant) {
+            tenant->usage.mailbox_depth++;
+            tenant->usage.memory_used += bytes;
+        }
+        l3_trace(runtime, "📨 Sent %s to actor %d\n", event, actor_id);
     }
 
     return success;
@@ -375,63 +703,744 @@ int l3_get_actor_by_name(L3_ActorRuntime* runtime, const char* name) {
 }
 
 // =============================================================================
-// TICK (Process one message per actor)
+// TIMERS
 // =============================================================================
 
+static bool l3_timer_before(const L3_Timer* a, const L3_Timer* b) {
+    return a->due_ms < b->due_ms || (a->due_ms == b->due_ms && a->seq < b->seq);
+}
+
+bool l3_send_after(L3_ActorRuntime* runtime, int actor_id, const char* event,
+                   const char* data, unsigned long long delay_ms) {
+    if (!runtime || !event) return false;
+    if (l3_find_actor_index(runtime, actor_id) == -1) return false;
+
+    if (runtime->timer_count >= runtime->timer_capacity) {
+        size_t new_cap = runtime->timer_capacity ? runtime->timer_capacity * 2 : 16;
+        L3_Timer* new_timers = realloc(runtime->timers, new_cap * sizeof(L3_Timer));
+        if (!new_timers) return false;
+
+        runtime->timers = new_timers;
+        runtime->timer_capacity = new_cap;
+    }
+
+    L3_Timer timer;
+    timer.due_ms = l3_now_ms(runtime) + delay_ms;
+    timer.seq = runtime->timer_seq++;
+    timer.actor_id = actor_id;
+    timer.event = l3_strdup(event);
+    timer.data = l3_strdup(data);
+
+    // Sift up
+    size_t i = runtime->timer_count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!l3_timer_before(&timer, &runtime->timers[parent])) break;
+        runtime->timers[i] = runtime->timers[parent];
+        i = parent;
+    }
+    runtime->timers[i] = timer;
+
+    l3_trace(runtime, "⏰ Scheduled %s for actor %d at %llums\n", event, actor_id, timer.due_ms);
+    return true;
+}
+
+static L3_Timer l3_timer_pop(L3_ActorRuntime* runtime) {
+    L3_Timer top = runtime->timers[0];
+    L3_Timer last = runtime->timers[--runtime->timer_count];
+
+    // Sift down
+    size_t i = 0;
+    size_t count = runtime->timer_count;
+    while (2 * i + 1 < count) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < count && l3_timer_before(&runtime->timers[child + 1], &runtime->timers[child])) {
+            child++;
+        }
+        if (!l3_timer_before(&runtime->timers[child], &last)) break;
+        runtime->timers[i] = runtime->timers[child];
+        i = child;
+    }
+    if (count > 0) runtime->timers[i] = last;
+
+    return top;
+}
+
+static void l3_fire_timers(L3_ActorRuntime* runtime) {
+    if (runtime->timer_count == 0) return;
+
+    unsigned long long now = l3_now_ms(runtime);
+    while (runtime->timer_count > 0 && runtime->timers[0].due_ms <= now) {
+        L3_Timer timer = l3_timer_pop(runtime);
+        l3_send_message(runtime, timer.actor_id, timer.event, timer.data);
+        free(timer.event);
+        free(timer.data);
+    }
+}
+
+// =============================================================================
+// TICK (Scheduling round)
+// =============================================================================
+
+// Pop and handle the next message queued for the actor in this slot
+static bool l3_process_next(L3_ActorRuntime* runtime, size_t index) {
+    L3_MessageQueue* queue = runtime->message_queues[index];
+    if (!queue || queue->count == 0) return false;
+
+    L3_Message* msg = l3_queue_pop(queue);
+    if (!msg) return false;
+
+    L3_Actor* actor = runtime->actors[index];
+    actor->last_active = l3_now(runtime);
+    runtime->pending_messages--;
+
+    L3_Tenant* tenant = l3_get_tenant(runtime, actor->tenant_id);
+    if (tenant) {
+        tenant->usage.mailbox_depth--;
+        tenant->usage.memory_used -= l3_message_bytes(msg->event, msg->data);
+        tenant->usage.messages_processed++;
+    }
+
+    // Find handler
+    L3_Handler* handler = NULL;
+    for (size_t h = 0; h < actor->handler_count; h++) {
+        if (strcmp(actor->handlers[h]->event_name, msg->event) == 0) {
+            handler = actor->handlers[h];
+            break;
+        }
+    }
+
+    if (handler) {
+        l3_trace(runtime, "🎬 Actor %s handling: %s\n", actor->name, msg->event);
+
+        // Create execution context (locals are allocated on first use)
+        L3_ExecutionContext ctx;
+        ctx.state = actor->state;
+        ctx.data = msg->data;
+        ctx.runtime = runtime;
+        ctx.actor_id = actor->id;
+        ctx.local_capacity = 0;
+        ctx.local_count = 0;
+        ctx.local_keys = NULL;
+        ctx.local_values = NULL;
+
+        // Execute handler
+        if (handler->native) {
+            handler->native(&ctx);
+        } else {
+            l3_execute_handler(handler->body_code, &ctx);
+        }
+
+        // Free local variables
+        for (size_t l = 0; l < ctx.local_count; l++) {
+            free(ctx.local_keys[l]);
+            free(ctx.local_values[l]);
+        }
+        free(ctx.local_keys);
+        free(ctx.local_values);
+
+        // Handlers may grow state; keep the tenant's bill current
+        if (tenant) {
+            l3_recharge_actor(runtime, actor);
+        }
+    } else {
+        printf("⚠️  No handler for %s on %s\n", msg->event, actor->name);
+    }
+
+    // Free message
+    free(msg->event);
+    free(msg->data);
+    free(msg);
+
+    // The handler may have queued more work for this actor
+    queue = runtime->message_queues[index];
+    if (!actor->passivated && queue && queue->count == 0) {
+        l3_idle_push(runtime, actor);
+    }
+
+    return true;
+}
+
+// Deficit round robin: each tenant with queued work earns its quantum per
+// round and spends one unit per message, so a flooded or hot tenant cannot
+// take more than its share. Idle tenants forfeit leftover credit.
+static size_t l3_schedule_tenant(L3_ActorRuntime* runtime, L3_Tenant* tenant) {
+    if (tenant->usage.mailbox_depth == 0 || tenant->actor_count == 0) {
+        tenant->deficit = 0;
+        return 0;
+    }
+
+    tenant->deficit += tenant->quota.cpu_quantum;
+    tenant->usage.rounds_scheduled++;
+
+    size_t processed = 0;
+    size_t idle_visits = 0;
+    while (tenant->deficit > 0 && tenant->usage.mailbox_depth > 0 &&
+           idle_visits < tenant->actor_count) {
+        size_t slot = tenant->actor_slots[tenant->cursor];
+        tenant->cursor = (tenant->cursor + 1) % tenant->actor_count;
+
+        if (l3_process_next(runtime, slot)) {
+            tenant->deficit--;
+            processed++;
+            idle_visits = 0;
+        } else {
+            idle_visits++;
+        }
+    }
+
+    if (tenant->usage.mailbox_depth == 0) {
+        tenant->deficit = 0;
+    }
+
+    return processed;
+}
+
+// Fill the scratch order with 0..count-1, shuffled from the seed when
+// simulating so that scheduling order is reproducible but not fixed
+static size_t* l3_schedule_order(L3_ActorRuntime* runtime, size_t count) {
+    if (count > runtime->schedule_capacity || !runtime->schedule_order) {
+        size_t new_cap = runtime->schedule_capacity ? runtime->schedule_capacity : 32;
+        while (new_cap < count) new_cap *= 2;
+
+        size_t* new_order = realloc(runtime->schedule_order, new_cap * sizeof(size_t));
+        if (!new_order) return NULL;
+
+        runtime->schedule_order = new_order;
+        runtime->schedule_capacity = new_cap;
+    }
+
+    size_t* order = runtime->schedule_order;
+    for (size_t i = 0; i < count; i++) order[i] = i;
+
+    for (size_t i = count; i > 1; i--) {
+        size_t j = (size_t)(l3_random(runtime) % i);
+        size_t tmp = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = tmp;
+    }
+
+    return order;
+}
+
+// One message each for the untenanted actors that had mail when the round
+// began, in an order shuffled from the seed like l3_schedule_order's. Only
+// the ready list is visited, so a round costs the actors with work rather
+// than every actor. Actors messaged during the round wait for the next one.
+static size_t l3_run_ready(L3_ActorRuntime* runtime) {
+    size_t count = runtime->ready_count;
+    size_t* ready = runtime->ready_slots;
+
+    for (size_t i = count; i > 1; i--) {
+        size_t j = (size_t)(l3_random(runtime) % i);
+        size_t tmp = ready[i - 1];
+        ready[i - 1] = ready[j];
+        ready[j] = tmp;
+    }
+
+    // Handlers may spawn actors, moving the list
+    size_t processed = 0;
+    for (size_t k = 0; k < count; k++) {
+        if (l3_process_next(runtime, runtime->ready_slots[k])) processed++;
+    }
+
+    // Drop drained actors, keeping the rest in order ahead of later arrivals
+    ready = runtime->ready_slots;
+    size_t kept = 0;
+    for (size_t k = 0; k < runtime->ready_count; k++) {
+        size_t slot = ready[k];
+        L3_MessageQueue* queue = runtime->message_queues[slot];
+        if (k < count && (!queue || queue->count == 0)) {
+            runtime->actors[slot]->ready = false;
+            continue;
+        }
+        ready[kept++] = slot;
+    }
+    runtime->ready_count = kept;
+
+    return processed;
+}
+
+static size_t l3_run_round(L3_ActorRuntime* runtime) {
+    size_t processed = 0;
+
+    l3_fire_timers(runtime);
+
+    if (runtime->simulated) {
+        processed += l3_run_ready(runtime);
+
+        size_t* order = l3_schedule_order(runtime, runtime->tenant_count);
+        if (!order) return processed;
+
+        for (size_t k = 0; k < runtime->tenant_count; k++) {
+            processed += l3_schedule_tenant(runtime, runtime->tenants[order[k]]);
+        }
+    } else {
+        for (size_t i = 0; i < runtime->actor_count; i++) {
+            if (runtime->actors[i]->tenant_id == 0 && l3_process_next(runtime, i)) {
+                processed++;
+            }
+        }
+
+        for (size_t t = 0; t < runtime->tenant_count; t++) {
+            processed += l3_schedule_tenant(runtime, runtime->tenants[t]);
+        }
+    }
+
+    if (runtime->store_dir) {
+        l3_passivate_idle(runtime);
+    }
+
+    return processed;
+}
+
 void l3_tick(L3_ActorRuntime* runtime) {
     if (!runtime) return;
+    l3_run_round(runtime);
+}
 
-    for (size_t i = 0; i < runtime->actor_count; i++) {
-        L3_MessageQueue* queue = runtime->message_queues[i];
-        if (queue->count > 0) {
-            L3_Message* msg = l3_queue_pop(queue);
-            if (msg) {
-                L3_Actor* actor = runtime->actors[i];
-
-                // Find handler
-                L3_Handler* handler = NULL;
-                for (size_t h = 0; h < actor->handler_count; h++) {
-                    if (strcmp(actor->handlers[h]->event_name, msg->event) == 0) {
-                        handler = actor->handlers[h];
-                        break;
-                    }
-                }
+// =============================================================================
+// MULTI-TENANT HOSTING
+// =============================================================================
 
-                if (handler) {
-                    printf("🎬 Actor %s handling: %s\n", actor->name, msg->event);
-
-                    // Create execution context
-                    L3_ExecutionContext ctx;
-                    ctx.state = actor->state;
-                    ctx.data = msg->data;
-                    ctx.runtime = runtime;
-                    ctx.actor_id = actor->id;
-                    ctx.local_capacity = 16;
-                    ctx.local_count = 0;
-                    ctx.local_keys = malloc(ctx.local_capacity * sizeof(char*));
-                    ctx.local_values = malloc(ctx.local_capacity * sizeof(char*));
-
-                    // Execute handler
-                    l3_execute_handler(handler->body_code, &ctx);
-
-                    // Free local variables
-                    for (size_t l = 0; l < ctx.local_count; l++) {
-                        free(ctx.local_keys[l]);
-                        free(ctx.local_values[l]);
-                    }
-                    free(ctx.local_keys);
-                    free(ctx.local_values);
-                } else {
-                    printf("⚠️  No handler for %s on %s\n", msg->event, actor->name);
-                }
+L3_TenantQuota l3_default_tenant_quota(void) {
+    L3_TenantQuota quota;
+    quota.cpu_quantum = 1;
+    quota.memory_quota = 0;
+    quota.mailbox_quota = 0;
+    return quota;
+}
+
+int l3_create_tenant(L3_ActorRuntime* runtime, const char* name, L3_TenantQuota quota) {
+    if (!runtime || !name || quota.cpu_quantum == 0) return -1;
+
+    if (runtime->tenant_count >= runtime->tenant_capacity) {
+        size_t new_cap = runtime->tenant_capacity ? runtime->tenant_capacity * 2 : 4;
+        L3_Tenant** new_tenants = realloc(runtime->tenants, new_cap * sizeof(L3_Tenant*));
+        if (!new_tenants) return -1;
+
+        runtime->tenants = new_tenants;
+        runtime->tenant_capacity = new_cap;
+    }
+
+    L3_Tenant* tenant = calloc(1, sizeof(L3_Tenant));
+    if (!tenant) return -1;
+
+    tenant->name = l3_strdup(name);
+    tenant->quota = quota;
+    tenant->id = (int)runtime->tenant_count + 1;
+    runtime->tenants[runtime->tenant_count++] = tenant;
+
+    printf("🏢 Created tenant %s (id: %d, quantum: %zu)\n",
+           tenant->name, tenant->id, quota.cpu_quantum);
+
+    return tenant->id;
+}
+
+bool l3_get_tenant_usage(L3_ActorRuntime* runtime, int tenant_id, L3_TenantUsage* usage) {
+    if (!runtime || !usage) return false;
+
+    L3_Tenant* tenant = l3_get_tenant(runtime, tenant_id);
+    if (!tenant) return false;
+
+    *usage = tenant->usage;
+    return true;
+}
 
-                // Free message
-                free(msg->event);
-                free(msg->data);
-                free(msg);
+// =============================================================================
+// DETERMINISTIC SIMULATION
+// =============================================================================
+
+void l3_enable_simulation(L3_ActorRuntime* runtime, unsigned long long seed) {
+    if (!runtime) return;
+
+    runtime->simulated = true;
+    runtime->virtual_ms = 0;
+    runtime->rng_state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+
+    l3_trace(runtime, "🧪 L3 Turchin: Simulation mode (seed: %llu)\n", seed);
+}
+
+size_t l3_run_simulation(L3_ActorRuntime* runtime, unsigned long long duration_ms) {
+    if (!runtime || !runtime->simulated) return 0;
+
+    unsigned long long end = runtime->virtual_ms + duration_ms;
+    size_t processed = 0;
+
+    while (runtime->virtual_ms < end) {
+        bool timer_due = runtime->timer_count > 0 &&
+                         runtime->timers[0].due_ms <= runtime->virtual_ms;
+
+        if (runtime->pending_messages > 0 || timer_due) {
+            size_t round = l3_run_round(runtime);
+            processed += round;
+
+            // A round with work takes a millisecond, so actors that keep
+            // messaging each other still reach the deadline
+            if (round > 0) {
+                runtime->virtual_ms++;
+                continue;
             }
+            if (timer_due) continue; // Fired timers are consumed even if refused
         }
+
+        // Idle, or only undeliverable mail left: jump to the next timer
+        if (runtime->timer_count == 0 || runtime->timers[0].due_ms >= end) break;
+        runtime->virtual_ms = runtime->timers[0].due_ms;
     }
+
+    if (runtime->virtual_ms < end) runtime->virtual_ms = end;
+    return processed;
+}
+
+void l3_set_trace(L3_ActorRuntime* runtime, bool enabled) {
+    if (runtime) runtime->trace = enabled;
+}
+
+// =============================================================================
+// PASSIVATION (on-disk actor store)
+// =============================================================================
+
+// Store format: one file per actor, strings length-prefixed so that
+// handler bodies may contain newlines ("-" encodes NULL). Native handlers
+// are code, not data: they stay with the resident stub and are rebound by
+// event name on reload, so nothing read from the store is ever called.
+//   L3A 3
+//   <role>
+//   <state count>  { <key> <value> }*
+//   <handler count> { <event> <body> }*
+
+// False if the path does not fit buf
+static bool l3_store_path(L3_ActorRuntime* runtime, int actor_id, char* buf, size_t size) {
+    int length = snprintf(buf, size, "%s/actor_%d.l3a", runtime->store_dir, actor_id);
+    return length >= 0 && (size_t)length < size;
+}
+
+static bool l3_store_write_string(FILE* f, const char* str) {
+    if (!str) return fputs("-\n", f) >= 0;
+
+    size_t len = strlen(str);
+    if (fprintf(f, "%zu\n", len) < 0) return false;
+    if (fwrite(str, 1, len, f) != len) return false;
+    return fputc('\n', f) != EOF;
+}
+
+static bool l3_store_read_string(FILE* f, char** out) {
+    char header[32];
+    *out = NULL;
+
+    if (!fgets(header, sizeof(header), f)) return false;
+    if (header[0] == '-') return true;
+
+    char* end = NULL;
+    unsigned long len = strtoul(header, &end, 10);
+    if (end == header) return false;
+
+    char* str = malloc(len + 1);
+    if (!str) return false;
+
+    if (fread(str, 1, len, f) != len || fgetc(f) != '\n') {
+        free(str);
+        return false;
+    }
+    str[len] = '\0';
+
+    *out = str;
+    return true;
+}
+
+static bool l3_store_write_actor(FILE* f, L3_Actor* actor) {
+    if (fprintf(f, "L3A 3\n") < 0) return false;
+    if (!l3_store_write_string(f, actor->role)) return false;
+
+    if (fprintf(f, "%zu\n", actor->state->count) < 0) return false;
+    for (size_t i = 0; i < actor->state->count; i++) {
+        if (!l3_store_write_string(f, actor->state->keys[i]) ||
+            !l3_store_write_string(f, actor->state->values[i])) {
+            return false;
+        }
+    }
+
+    if (fprintf(f, "%zu\n", actor->handler_count) < 0) return false;
+    for (size_t h = 0; h < actor->handler_count; h++) {
+        if (!l3_store_write_string(f, actor->handlers[h]->event_name) ||
+            !l3_store_write_string(f, actor->handlers[h]->body_code)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool l3_store_read_count(FILE* f, size_t* count) {
+    char line[32];
+    if (!fgets(line, sizeof(line), f)) return false;
+
+    char* end = NULL;
+    *count = (size_t)strtoul(line, &end, 10);
+    return end != line;
+}
+
+static bool l3_store_read_actor(FILE* f, L3_Actor* actor) {
+    char magic[16];
+    if (!fgets(magic, sizeof(magic), f) || strcmp(magic, "L3A 3\n") != 0) return false;
+    if (!l3_store_read_string(f, &actor->role)) return false;
+
+    size_t state_count = 0;
+    actor->state = l3_state_create();
+    if (!actor->state || !l3_store_read_count(f, &state_count)) return false;
+
+    for (size_t i = 0; i < state_count; i++) {
+        char* key = NULL;
+        char* value = NULL;
+        bool ok = l3_store_read_string(f, &key) && l3_store_read_string(f, &value) &&
+                  l3_state_set(actor->state, key, value);
+        free(key);
+        free(value);
+        if (!ok) return false;
+    }
+
+    size_t handler_count = 0;
+    if (!l3_store_read_count(f, &handler_count)) return false;
+
+    actor->handlers = calloc(handler_count ? handler_count : 1, sizeof(L3_Handler*));
+    if (!actor->handlers) return false;
+
+    for (size_t h = 0; h < handler_count; h++) {
+        L3_Handler* handler = calloc(1, sizeof(L3_Handler));
+        if (!handler) return false;
+        actor->handlers[h] = handler;
+        actor->handler_count = h + 1;
+
+        if (!l3_store_read_string(f, &handler->event_name) ||
+            !l3_store_read_string(f, &handler->body_code) || !handler->event_name) {
+            return false;
+        }
+
+        for (size_t n = 0; n < actor->native_count; n++) {
+            if (strcmp(actor->natives[n]->event_name, handler->event_name) == 0) {
+                handler->native = actor->natives[n]->native;
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool l3_enable_passivation(L3_ActorRuntime* runtime, const char* store_dir,
+                           unsigned long idle_seconds) {
+    if (!runtime || !store_dir) return false;
+
+    // Stored actors cannot follow the runtime to another directory
+    if (runtime->passivated_count > 0) {
+        printf("❌ Actors still passivated in %s\n", runtime->store_dir);
+        return false;
+    }
+
+    if (mkdir(store_dir, 0700) != 0 && errno != EEXIST) {
+        printf("❌ Cannot create actor store %s\n", store_dir);
+        return false;
+    }
+
+    // Actor ids restart in every runtime: each gets a directory of its own,
+    // so runtimes sharing store_dir never see each other's files. Leave room
+    // for the "/actor_<id>.l3a" names l3_store_path appends.
+    char path[1024];
+    int length = snprintf(path, sizeof(path), "%s/l3-XXXXXX", store_dir);
+    if (length < 0 || (size_t)length + sizeof("/actor_-2147483648.l3a") > sizeof(path)) {
+        printf("❌ Actor store path too long: %s\n", store_dir);
+        return false;
+    }
+    if (!mkdtemp(path)) {
+        printf("❌ Cannot create actor store in %s\n", store_dir);
+        return false;
+    }
+
+    char* own_dir = l3_strdup(path);
+    if (!own_dir) {
+        rmdir(path);
+        return false;
+    }
+    if (runtime->store_dir) rmdir(runtime->store_dir);
+    free(runtime->store_dir);
+    runtime->store_dir = own_dir;
+    runtime->idle_timeout = idle_seconds;
+
+    printf("💤 L3 Turchin: Passivation enabled (store: %s, idle: %lus)\n",
+           runtime->store_dir, idle_seconds);
+
+    return true;
+}
+
+bool l3_passivate_actor(L3_ActorRuntime* runtime, int actor_id) {
+    if (!runtime || !runtime->store_dir) return false;
+
+    int index = l3_find_actor_index(runtime, actor_id);
+    if (index == -1) return false;
+
+    L3_Actor* actor = runtime->actors[index];
+    L3_MessageQueue* queue = runtime->message_queues[index];
+
+    // Only quiescent actors can be evicted
+    if (actor->passivated) return true;
+    if (queue && queue->count > 0) return false;
+
+    char path[1024];
+    if (!l3_store_path(runtime, actor_id, path, sizeof(path))) return false;
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+
+    bool ok = l3_store_write_actor(f, actor);
+    if (fclose(f) != 0) ok = false;
+
+    size_t native_count = 0;
+    for (size_t h = 0; h < actor->handler_count; h++) {
+        if (actor->handlers[h]->native) native_count++;
+    }
+    L3_Handler** natives = NULL;
+    if (ok && native_count > 0) {
+        natives = malloc(native_count * sizeof(L3_Handler*));
+        ok = natives != NULL;
+    }
+
+    if (!ok) {
+        unlink(path);
+        return false;
+    }
+
+    // Leave a stub: id, name and native handlers stay resident
+    actor->native_count = 0;
+    for (size_t h = 0; h < actor->handler_count; h++) {
+        if (actor->handlers[h]->native) {
+            natives[actor->native_count++] = actor->handlers[h];
+            actor->handlers[h] = NULL;
+        }
+    }
+    actor->natives = natives;
+
+    free(actor->role);
+    l3_state_free(actor->state);
+    l3_free_handlers(actor->handlers, actor->handler_count);
+    actor->role = NULL;
+    actor->state = NULL;
+    actor->handlers = NULL;
+    actor->handler_count = 0;
+    actor->passivated = true;
+    l3_recharge_actor(runtime, actor);
+
+    l3_idle_remove(runtime, actor);
+    l3_queue_free(queue);
+    runtime->message_queues[index] = NULL;
+    runtime->passivated_count++;
+
+    return true;
+}
+
+bool l3_activate_actor(L3_ActorRuntime* runtime, int actor_id) {
+    if (!runtime || !runtime->store_dir) return false;
+
+    int index = l3_find_actor_index(runtime, actor_id);
+    if (index == -1) return false;
+
+    L3_Actor* actor = runtime->actors[index];
+    if (!actor->passivated) return true;
+
+    char path[1024];
+    FILE* f = l3_store_path(runtime, actor_id, path, sizeof(path)) ? fopen(path, "rb") : NULL;
+    if (!f) {
+        printf("❌ Actor %d missing from store %s\n", actor_id, runtime->store_dir);
+        return false;
+    }
+
+    L3_MessageQueue* queue = l3_queue_create();
+    bool ok = queue && l3_store_read_actor(f, actor);
+    fclose(f);
+
+    // Reloading is charged like a spawn: refuse it if the tenant is full
+    L3_Tenant* tenant = l3_get_tenant(runtime, actor->tenant_id);
+    bool over_quota = false;
+    if (ok && tenant && tenant->quota.memory_quota) {
+        actor->passivated = false;
+        size_t footprint = l3_actor_footprint(actor);
+        actor->passivated = true;
+        over_quota = tenant->usage.memory_used - actor->footprint + footprint >
+                     tenant->quota.memory_quota;
+        ok = !over_quota;
+    }
+
+    if (!ok) {
+        // Roll back to a clean stub; the stored copy is left untouched
+        free(actor->role);
+        l3_state_free(actor->state);
+        l3_free_handlers(actor->handlers, actor->handler_count);
+        actor->role = NULL;
+        actor->state = NULL;
+        actor->handlers = NULL;
+        actor->handler_count = 0;
+        l3_queue_free(queue);
+        if (over_quota) {
+            tenant->usage.activations_rejected++;
+            printf("⛔ Tenant %s over memory quota, actor %d left in store\n",
+                   tenant->name, actor_id);
+        } else {
+            printf("❌ Failed to reload actor %d from store\n", actor_id);
+        }
+        return false;
+    }
+
+    unlink(path);
+
+    // Loaded handlers have their native bindings back; the stub's copies go
+    l3_free_handlers(actor->natives, actor->native_count);
+    actor->natives = NULL;
+    actor->native_count = 0;
+
+    actor->passivated = false;
+    actor->last_active = l3_now(runtime);
+    l3_recharge_actor(runtime, actor);
+    runtime->message_queues[index] = queue;
+    runtime->passivated_count--;
+    l3_idle_push(runtime, actor);
+
+    return true;
+}
+
+bool l3_is_passivated(L3_ActorRuntime* runtime, int actor_id) {
+    if (!runtime) return false;
+
+    int index = l3_find_actor_index(runtime, actor_id);
+    return index != -1 && runtime->actors[index]->passivated;
+}
+
+size_t l3_passivate_idle(L3_ActorRuntime* runtime) {
+    if (!runtime || !runtime->store_dir) return 0;
+
+    unsigned long now = l3_now(runtime);
+    size_t evicted = 0;
+
+    // Oldest first: stop at the first actor still within its timeout
+    while (runtime->idle_head && now - runtime->idle_head->last_active >= runtime->idle_timeout) {
+        L3_Actor* actor = runtime->idle_head;
+        if (l3_passivate_actor(runtime, actor->id)) {
+            evicted++;
+            continue;
+        }
+
+        // Store unwritable: retry this actor after another idle period and
+        // leave the rest for the next round
+        actor->last_active = now;
+        l3_idle_push(runtime, actor);
+        break;
+    }
+
+    if (evicted > 0) {
+        l3_trace(runtime, "💤 Passivated %zu idle actor(s) (%zu on disk)\n",
+                 evicted, runtime->passivated_count);
+    }
+
+    return evicted;
 }
 
 // =============================================================================
@@ -459,24 +1468,54 @@ void l3_free_actor_definition(L3_ActorDefinition* def) {
     free(def);
 }
 
+bool l3_register_native_handler(L3_ActorDefinition* def, const char* event,
+                                L3_NativeHandler fn) {
+    if (!def || !event || !fn) return false;
+
+    for (size_t i = 0; i < def->handler_count; i++) {
+        if (strcmp(def->handlers[i]->event_name, event) == 0) {
+            def->handlers[i]->native = fn;
+            return true;
+        }
+    }
+
+    if (def->handler_count >= def->handler_capacity) {
+        size_t new_cap = def->handler_capacity ? def->handler_capacity * 2 : 8;
+        L3_Handler** new_handlers = realloc(def->handlers, new_cap * sizeof(L3_Handler*));
+        if (!new_handlers) return false;
+
+        def->handlers = new_handlers;
+        def->handler_capacity = new_cap;
+    }
+
+    L3_Handler* h = malloc(sizeof(L3_Handler));
+    if (!h) return false;
+
+    h->event_name = l3_strdup(event);
+    h->body_code = NULL;
+    h->native = fn;
+    def->handlers[def->handler_count++] = h;
+
+    return true;
+}
+
 void l3_free_runtime(L3_ActorRuntime* runtime) {
     if (!runtime) return;
 
     for (size_t i = 0; i < runtime->actor_count; i++) {
         L3_Actor* actor = runtime->actors[i];
         if (actor) {
+            if (actor->passivated) {
+                // Stored actors do not outlive their runtime
+                char path[1024];
+                if (l3_store_path(runtime, actor->id, path, sizeof(path))) unlink(path);
+            }
+
             free(actor->name);
             free(actor->role);
             l3_state_free(actor->state);
-
-            for (size_t h = 0; h < actor->handler_count; h++) {
-                if (actor->handlers[h]) {
-                    free(actor->handlers[h]->event_name);
-                    free(actor->handlers[h]->body_code);
-                    free(actor->handlers[h]);
-                }
-            }
-            free(actor->handlers);
+            l3_free_handlers(actor->handlers, actor->handler_count);
+            l3_free_handlers(actor->natives, actor->native_count);
             free(actor);
         }
     }
@@ -485,8 +1524,25 @@ void l3_free_runtime(L3_ActorRuntime* runtime) {
         l3_queue_free(runtime->message_queues[i]);
     }
 
+    for (size_t t = 0; t < runtime->tenant_count; t++) {
+        free(runtime->tenants[t]->name);
+        free(runtime->tenants[t]->actor_slots);
+        free(runtime->tenants[t]);
+    }
+
+    for (size_t t = 0; t < runtime->timer_count; t++) {
+        free(runtime->timers[t].event);
+        free(runtime->timers[t].data);
+    }
+
     free(runtime->actors);
     free(runtime->message_queues);
+    free(runtime->tenants);
+    free(runtime->timers);
+    free(runtime->schedule_order);
+    free(runtime->ready_slots);
+    if (runtime->store_dir) rmdir(runtime->store_dir);
+    free(runtime->store_dir);
     free(runtime);
 }
 
@@ -566,6 +1622,7 @@ L3_ActorDefinition* l3_parse_actor(const char* turchin_code) {
                 L3_Handler* h = malloc(sizeof(L3_Handler));
                 h->event_name = current_handler_name;
                 h->body_code = current_handler_body;
+                h->native = NULL;
                 def->handlers[def->handler_count++] = h;
 
                 current_handler_name = NULL;
@@ -616,6 +1673,7 @@ L3_ActorDefinition* l3_parse_actor(const char* turchin_code) {
                 L3_Handler* h = malloc(sizeof(L3_Handler));
                 h->event_name = current_handler_name;
                 h->body_code = current_handler_body;
+                h->native = NULL;
                 def->handlers[def->handler_count++] = h;
             }
 
@@ -656,6 +1714,7 @@ L3_ActorDefinition* l3_parse_actor(const char* turchin_code) {
         L3_Handler* h = malloc(sizeof(L3_Handler));
         h->event_name = current_handler_name;
         h->body_code = current_handler_body;
+        h->native = NULL;
         def->handlers[def->handler_count++] = h;
     }
 
@@ -709,7 +1768,7 @@ static void l3_set_local(L3_ExecutionContext* ctx, const char* key, const char*
 
     // Add new
     if (ctx->local_count >= ctx->local_capacity) {
-        ctx->local_capacity *= 2;
+        ctx->local_capacity = ctx->local_capacity ? ctx->local_capacity * 2 : 16;
         ctx->local_keys = realloc(ctx->local_keys, ctx->local_capacity * sizeof(char*));
         ctx->local_values = realloc(ctx->local_values, ctx->local_capacity * sizeof(char*));
     }
@@ -942,15 +2001,29 @@ static void l3_execute_line(const char* trimmed, L3_ExecutionContext* ctx) {
             if (msg[0] == '"' || msg[0] == '\'') {
                 size_t len = strlen(msg);
                 char* unquoted = l3_substring(msg, 1, len - 2);
-                printf("   📝 %s\n", unquoted);
+                l3_trace(ctx->runtime, "   📝 %s\n", unquoted);
                 free(unquoted);
             } else {
-                printf("   📝 %s\n", msg);
+                l3_trace(ctx->runtime, "   📝 %s\n", msg);
             }
             free(msg);
         }
         free(message_part);
     }
+    // after <ms> -> <message> (timer message to self)
+    else if (l3_starts_with(trimmed, "after ") && strstr(trimmed, "->")) {
+        char* arrow_pos = strstr(trimmed, "->");
+        char* delay_expr = l3_substring(trimmed, 6, arrow_pos - trimmed - 6);
+        char* delay = l3_evaluate_expression(delay_expr, ctx);
+        char* message_name = l3_trim(arrow_pos + 2);
+
+        l3_send_after(ctx->runtime, ctx->actor_id, message_name, ctx->data,
+                      strtoull(delay, NULL, 10));
+
+        free(delay_expr);
+        free(delay);
+        free(message_name);
+    }
     // <Actor> -> <message> [args] (arrow message to actor)
     else if (strstr(trimmed, "->") && isupper(trimmed[0])) {
         char* arrow_pos = strstr(trimmed, "->");
@@ -974,7 +2047,7 @@ static void l3_execute_line(const char* trimmed, L3_ExecutionContext* ctx) {
         // Message to another actor
         int target_id = l3_get_actor_by_name(ctx->runtime, target_trimmed);
         if (target_id != -1) {
-            printf("   → %s -> %s\n", target_trimmed, message_name);
+            l3_trace(ctx->runtime, "   → %s -> %s\n", target_trimmed, message_name);
             l3_send_message(ctx->runtime, target_id, message_name, ctx->data);
         } else {
             printf("❌ Target actor \"%s\" not found\n", target_trimmed);
@@ -999,7 +2072,7 @@ static void l3_execute_line(const char* trimmed, L3_ExecutionContext* ctx) {
             char* value = l3_evaluate_expression(value_expr, ctx);
 
             l3_set_local(ctx, var_trimmed, value);
-            printf("   📦 Let %s -> %s\n", var_trimmed, value);
+            l3_trace(ctx->runtime, "   📦 Let %s -> %s\n", var_trimmed, value);
 
             free(var_trimmed);
             free(value_expr);
@@ -1021,10 +2094,10 @@ static void l3_execute_line(const char* trimmed, L3_ExecutionContext* ctx) {
         if (l3_starts_with(target_trimmed, "state.")) {
             const char* key = target_trimmed + 6;
             l3_state_set(ctx->state, key, value);
-            printf("   ✏️  Set state.%s -> %s\n", key, value);
+            l3_trace(ctx->runtime, "   ✏️  Set state.%s -> %s\n", key, value);
         } else {
             l3_set_local(ctx, target_trimmed, value);
-            printf("   📦 Set %s -> %s\n", target_trimmed, value);
+            l3_trace(ctx->runtime, "   📦 Set %s -> %s\n", target_trimmed, value);
         }
 
         free(target_trimmed);
@@ -1040,10 +2113,10 @@ static void l3_execute_line(const char* trimmed, L3_ExecutionContext* ctx) {
         if (msg_trimmed[0] == '"' || msg_trimmed[0] == '\'') {
             size_t len = strlen(msg_trimmed);
             char* unquoted = l3_substring(msg_trimmed, 1, len - 2);
-            printf("   📝 %s\n", unquoted);
+            l3_trace(ctx->runtime, "   📝 %s\n", unquoted);
             free(unquoted);
         } else {
-            printf("   📝 %s\n", msg_trimmed);
+            l3_trace(ctx->runtime, "   📝 %s\n", msg_trimmed);
         }
 
         free(msg_trimmed);
@@ -1251,6 +2324,21 @@ static void l3_execute_block(char** lines, size_t* line_idx, size_t line_count,
     }
 }
 
+bool l3_send_from(L3_ExecutionContext* ctx, const char* target, const char* event,
+                  const char* data) {
+    if (!ctx || !target || !event) return false;
+
+    int target_id = strcmp(target, "self") == 0
+                        ? ctx->actor_id
+                        : l3_get_actor_by_name(ctx->runtime, target);
+    if (target_id == -1) {
+        printf("❌ Target actor \"%s\" not found\n", target);
+        return false;
+    }
+
+    return l3_send_message(ctx->runtime, target_id, event, data ? data : ctx->data);
+}
+
 void l3_execute_handler(const char* body, L3_ExecutionContext* ctx) {
     if (!body || !ctx) return;
 
@@ -19,9 +19,15 @@ typedef struct L3_ActorState {
     size_t capacity;
 } L3_ActorState;
 
+struct L3_ExecutionContext;
+
+// Native handler: runs as C against the actor's context (state, data, send API)
+typedef void (*L3_NativeHandler)(struct L3_ExecutionContext* ctx);
+
 typedef struct L3_Handler {
     char* event_name;
     char* body_code;       // Handler body (to be compiled)
+    L3_NativeHandler native; // C implementation; takes precedence over body_code
 } L3_Handler;
 
 typedef struct L3_ActorDefinition {
@@ -40,7 +46,7 @@ typedef struct L3_ActorDefinition {
 typedef struct L3_Message {
     char* event;
     char* data;            // JSON string of message data
-    unsigned long timestamp;
+    unsigned long long timestamp;  // Runtime clock (ms) when queued
 } L3_Message;
 
 typedef struct L3_MessageQueue {
@@ -51,6 +57,15 @@ typedef struct L3_MessageQueue {
     size_t tail;
 } L3_MessageQueue;
 
+// Delayed message, fired once the runtime clock reaches due_ms
+typedef struct L3_Timer {
+    unsigned long long due_ms;
+    unsigned long long seq;  // Insertion order breaks ties deterministically
+    int actor_id;
+    char* event;
+    char* data;
+} L3_Timer;
+
 // =============================================================================
 // ACTOR INSTANCE
 // =============================================================================
@@ -62,8 +77,59 @@ typedef struct L3_Actor {
     L3_ActorState* state;
     L3_Handler** handlers;
     size_t handler_count;
+
+    // Passivation: an idle actor keeps only id, name and native handlers resident;
+    // role, state and handlers live in the on-disk store until reactivated
+    bool passivated;
+    unsigned long last_active;  // Time of last handled message
+    L3_Handler** natives;       // Native handlers kept by the stub; function
+    size_t native_count;        // pointers never go to the store
+
+    // Idle list: resident actors with empty mailboxes, oldest first
+    struct L3_Actor* idle_prev;
+    struct L3_Actor* idle_next;
+    bool idle;                  // Linked into the idle list
+    bool ready;                 // In the ready list (untenanted, mail queued)
+
+    // Multi-tenant accounting (tenant_id 0 = untenanted)
+    int tenant_id;
+    size_t footprint;           // Resident bytes charged to the tenant
 } L3_Actor;
 
+// =============================================================================
+// TENANTS
+// =============================================================================
+
+typedef struct L3_TenantQuota {
+    size_t cpu_quantum;    // Messages processed per scheduling round
+    size_t memory_quota;   // Bytes of actor state + queued messages (0 = unlimited)
+    size_t mailbox_quota;  // Messages queued across the tenant (0 = unlimited)
+} L3_TenantQuota;
+
+typedef struct L3_TenantUsage {
+    size_t messages_processed;
+    size_t messages_rejected;  // Refused by mailbox or memory quota
+    size_t spawns_rejected;    // Refused by memory quota
+    size_t activations_rejected; // Reloads from the store refused by memory quota
+    size_t memory_used;        // Current charged bytes
+    size_t mailbox_depth;      // Current queued messages
+    size_t rounds_scheduled;   // Rounds in which the tenant had work
+} L3_TenantUsage;
+
+typedef struct L3_Tenant {
+    int id;
+    char* name;
+    L3_TenantQuota quota;
+    L3_TenantUsage usage;
+
+    // Deficit round robin
+    size_t deficit;            // Unspent credit (messages)
+    size_t* actor_slots;       // Indices into runtime->actors
+    size_t actor_count;
+    size_t actor_capacity;
+    size_t cursor;             // Next actor to serve within the tenant
+} L3_Tenant;
+
 // =============================================================================
 // ACTOR RUNTIME
 // =============================================================================
@@ -78,6 +144,37 @@ typedef struct L3_ActorRuntime {
 
     int next_actor_id;
     bool running;
+
+    // Passivation (disabled while store_dir is NULL)
+    char* store_dir;               // This runtime's directory of passivated actors
+    unsigned long idle_timeout;    // Seconds idle before passivation
+    size_t passivated_count;       // Actors currently evicted to disk
+    L3_Actor* idle_head;           // Passivation candidates, least recently active first
+    L3_Actor* idle_tail;
+
+    // Tenants (scheduled by deficit round robin once any exist)
+    L3_Tenant** tenants;
+    size_t tenant_count;
+    size_t tenant_capacity;
+
+    // Timers (min-heap on due time)
+    L3_Timer* timers;
+    size_t timer_count;
+    size_t timer_capacity;
+    unsigned long long timer_seq;
+    size_t pending_messages;       // Queued across all mailboxes
+
+    // Deterministic simulation: virtual clock and seeded scheduling order
+    bool simulated;
+    unsigned long long virtual_ms;
+    unsigned long long rng_state;
+    size_t* schedule_order;        // Scratch permutation of tenant slots
+    size_t schedule_capacity;
+    size_t* ready_slots;           // Untenanted actor slots with mail queued
+    size_t ready_count;            // (room for every untenanted actor)
+    size_t ready_capacity;
+
+    bool trace;                    // Print runtime events (default on)
 } L3_ActorRuntime;
 
 // =============================================================================
@@ -90,6 +187,11 @@ L3_ActorDefinition* l3_parse_actor(const char* turchin_code);
 // Free actor definition
 void l3_free_actor_definition(L3_ActorDefinition* def);
 
+// Bind a C function to an event, replacing the interpreted body for that
+// event (or adding a new handler); other handlers stay interpreted
+bool l3_register_native_handler(L3_ActorDefinition* def, const char* event,
+                                L3_NativeHandler fn);
+
 // =============================================================================
 // RUNTIME API
 // =============================================================================
@@ -100,22 +202,86 @@ L3_ActorRuntime* l3_runtime_init(void);
 // Spawn an actor from definition
 int l3_spawn_actor(L3_ActorRuntime* runtime, L3_ActorDefinition* def);
 
+// Spawn an actor owned by a tenant (tenant_id 0 = untenanted)
+int l3_spawn_actor_in_tenant(L3_ActorRuntime* runtime, L3_ActorDefinition* def, int tenant_id);
+
 // Send message to actor
 bool l3_send_message(L3_ActorRuntime* runtime, int actor_id, const char* event, const char* data);
 
-// Process one message per actor (single tick)
+// Process one scheduling round: one message per untenanted actor, then
+// up to each tenant's deficit round robin credit
 void l3_tick(L3_ActorRuntime* runtime);
 
 // Start/stop runtime
 void l3_start_runtime(L3_ActorRuntime* runtime);
 void l3_stop_runtime(L3_ActorRuntime* runtime);
 
+// Deliver a message after delay_ms on the runtime clock
+bool l3_send_after(L3_ActorRuntime* runtime, int actor_id, const char* event,
+                   const char* data, unsigned long long delay_ms);
+
 // Get actor by name
 int l3_get_actor_by_name(L3_ActorRuntime* runtime, const char* name);
 
 // Cleanup
 void l3_free_runtime(L3_ActorRuntime* runtime);
 
+// Toggle printing of runtime events (spawns, sends, handler output)
+void l3_set_trace(L3_ActorRuntime* runtime, bool enabled);
+
+// =============================================================================
+// CLOCK & DETERMINISTIC SIMULATION
+// =============================================================================
+
+// Current runtime clock in milliseconds (wall clock, or virtual when simulated)
+unsigned long long l3_now_ms(L3_ActorRuntime* runtime);
+
+// Switch to a virtual clock starting at 0 and a scheduling order seeded
+// from seed; identical seeds reproduce identical runs
+void l3_enable_simulation(L3_ActorRuntime* runtime, unsigned long long seed);
+
+// Run for duration_ms of virtual time: tick while any mailbox has work,
+// otherwise jump the clock to the next timer. Each round that processes
+// messages takes 1ms, so endless message exchanges stop at the deadline;
+// work due at the deadline itself is left for the next call. Returns
+// messages processed.
+size_t l3_run_simulation(L3_ActorRuntime* runtime, unsigned long long duration_ms);
+
+// =============================================================================
+// MULTI-TENANT HOSTING
+// =============================================================================
+
+// Quota with a one-message quantum and no memory/mailbox limits
+L3_TenantQuota l3_default_tenant_quota(void);
+
+// Create a tenant; returns its id (> 0) or -1
+int l3_create_tenant(L3_ActorRuntime* runtime, const char* name, L3_TenantQuota quota);
+
+// Copy a tenant's usage counters
+bool l3_get_tenant_usage(L3_ActorRuntime* runtime, int tenant_id, L3_TenantUsage* usage);
+
+// =============================================================================
+// PASSIVATION
+// =============================================================================
+
+// Evict actors idle for idle_seconds (with empty mailboxes) to a private
+// l3-XXXXXX directory created in store_dir and removed by l3_free_runtime,
+// so runtimes may share store_dir. The first message sent to a passivated
+// actor transparently reloads it. Fails if store_dir is too long for actor
+// paths or actors are still passivated under an earlier call.
+bool l3_enable_passivation(L3_ActorRuntime* runtime, const char* store_dir,
+                           unsigned long idle_seconds);
+
+// Passivate / reactivate a single actor explicitly
+bool l3_passivate_actor(L3_ActorRuntime* runtime, int actor_id);
+bool l3_activate_actor(L3_ActorRuntime* runtime, int actor_id);
+bool l3_is_passivated(L3_ActorRuntime* runtime, int actor_id);
+
+// Passivate every actor idle past the timeout (called from l3_tick when
+// enabled); visits only those candidates, not every actor. Reloading an
+// actor of a tenant is refused if it would exceed the tenant's memory quota.
+size_t l3_passivate_idle(L3_ActorRuntime* runtime);
+
 // =============================================================================
 // STATE MANAGEMENT
 // =============================================================================
@@ -129,6 +295,12 @@ bool l3_state_set(L3_ActorState* state, const char* key, const char* value);
 // Get value from state
 const char* l3_state_get(L3_ActorState* state, const char* key);
 
+// Typed access for native handlers (values are stored as strings)
+long long l3_state_get_int(L3_ActorState* state, const char* key, long long fallback);
+bool l3_state_set_int(L3_ActorState* state, const char* key, long long value);
+double l3_state_get_number(L3_ActorState* state, const char* key, double fallback);
+bool l3_state_set_number(L3_ActorState* state, const char* key, double value);
+
 // Free state
 void l3_state_free(L3_ActorState* state);
 
@@ -152,6 +324,10 @@ typedef struct L3_ExecutionContext {
 // Execute handler body with context
 void l3_execute_handler(const char* body, L3_ExecutionContext* ctx);
 
+// Send from inside a handler; target is an actor name or "self"
+bool l3_send_from(L3_ExecutionContext* ctx, const char* target, const char* event,
+                  const char* data);
+
 // =============================================================================
 // EXPRESSION EVALUATION
 // =============================================================================
@@ -19,6 +19,7 @@ typedef struct {
     bool auto_hoist;
     bool reversible_default;
     bool l5_enhanced;        // Enable L5 homoiconic features
+    bool optimize_hrir;      // Peephole-optimize L1 HRIR
 } CLIOptions;
 
 // Parse CLI arguments
@@ -30,7 +31,8 @@ CLIOptions parse_cli(int argc, char** argv) {
         .debug_mode = false,
         .auto_hoist = true,
         .reversible_default = true,
-        .l5_enhanced = l5_should_use_enhanced_mode()  // Check environment
+        .l5_enhanced = l5_should_use_enhanced_mode(),  // Check environment
+        .optimize_hrir = false
     };
 
     for (int i = 1; i < argc; i++) {
@@ -46,6 +48,8 @@ CLIOptions parse_cli(int argc, char** argv) {
             opts.l5_enhanced = true;
         } else if (strcmp(argv[i], "--no-reversible") == 0) {
             opts.reversible_default = false;
+        } else if (strcmp(argv[i], "--optimize") == 0) {
+            opts.optimize_hrir = true;
         } else if (!opts.input_file && strstr(argv[i], ".rio")) {
             opts.input_file = argv[i];
         }
@@ -101,7 +105,8 @@ int main(int argc, char** argv) {
         .strict_mode = cli.strict_mode,
         .auto_hoist = cli.auto_hoist,
         .debug_mode = cli.debug_mode,
-        .reversible_default = cli.reversible_default
+        .reversible_default = cli.reversible_default,
+        .optimize_hrir = cli.optimize_hrir
     };
 
     printf("🌀 August-Rio Unified Compiler Bootloader\n");
@@ -114,6 +119,7 @@ int main(int argc, char** argv) {
         printf("🔄 Reversible default: %s\n", cli.reversible_default ? "ENABLED" : "DISABLED");
         printf("📄 JSON output: %s\n", cli.json_output ? "ENABLED" : "DISABLED");
         printf("🌀 L5 Enhanced: %s\n", cli.l5_enhanced ? "ENABLED" : "DISABLED");
+        printf("⚡ HRIR optimizer: %s\n", cli.optimize_hrir ? "ENABLED" : "DISABLED");
         if (cli.input_file) printf("📁 Input file: %s\n", cli.input_file);
         printf("\n");
     }
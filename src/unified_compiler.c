@@ -14,7 +14,8 @@
 // =============================================================================
 
 // Forward declarations
-static char* generate_hrir_json(SurfaceAST* ast, CompilerOptions options);
+static char* generate_hrir_json(SurfaceAST* ast, CompilerOptions options,
+                                size_t* cells_removed);
 
 // Forward declarations for layer interfaces
 static char* canonicalize_paths(SurfaceAST* ast, CompilerOptions options);
@@ -46,6 +47,7 @@ CompilationResult* compile(const char* code, CompilerOptions options) {
     result->stats.r_term_ops_count = 0;
     result->stats.d_term_ops_count = 0;
     result->stats.membrane_crossings_count = 0;
+    result->stats.hrir_cells_removed = 0;
     result->stats.compilation_time_ms = 0.0;
     result->stats.validation_time_ms = 0.0;
 
@@ -54,7 +56,8 @@ CompilationResult* compile(const char* code, CompilerOptions options) {
         printf("  Strict mode: %s\n", options.strict_mode ? "ENABLED" : "DISABLED");
         printf("  Auto-hoist: %s\n", options.auto_hoist ? "ENABLED" : "DISABLED");
         printf("  Debug mode: %s\n", options.debug_mode ? "ENABLED" : "DISABLED");
-        printf("  Reversible default: %s\n\n", options.reversible_default ? "ENABLED" : "DISABLED");
+        printf("  Reversible default: %s\n", options.reversible_default ? "ENABLED" : "DISABLED");
+        printf("  HRIR optimizer: %s\n\n", options.optimize_hrir ? "ENABLED" : "DISABLED");
     }
 
     // Phase 1: Parse Surface (L5/L4)
@@ -111,7 +114,7 @@ CompilationResult* compile(const char* code, CompilerOptions options) {
 
     // Phase 5: Generate HRIR (L1 Homoiconic Reversible IR)
     // This is the true L1 layer - homoiconic and reversible
-    result->hrir_json = generate_hrir_json(ast, options);
+    result->hrir_json = generate_hrir_json(ast, options, &result->stats.hrir_cells_removed);
 
     if (options.debug_mode) {
         printf("🏗️ Generating L1 HRIR (Homoiconic Reversible IR)...\n");
@@ -159,6 +162,9 @@ CompilationResult* compile(const char* code, CompilerOptions options) {
         printf("  R-term ops: %zu\n", result->stats.r_term_ops_count);
         printf("  D-term ops: %zu\n", result->stats.d_term_ops_count);
         printf("  Membrane crossings: %zu\n", result->stats.membrane_crossings_count);
+        if (options.optimize_hrir) {
+            printf("  HRIR cells removed: %zu\n", result->stats.hrir_cells_removed);
+        }
         printf("  Compilation time: %.2f ms\n", result->stats.compilation_time_ms);
         printf("  Validation time: %.2f ms\n\n", result->stats.validation_time_ms);
     }
@@ -173,7 +179,8 @@ CompilationResult* compile(const char* code, CompilerOptions options) {
 // L1 HRIR GENERATION (True Homoiconic Reversible IR)
 // =============================================================================
 
-static char* generate_hrir_json(SurfaceAST* ast, CompilerOptions options) {
+static char* generate_hrir_json(SurfaceAST* ast, CompilerOptions options,
+                                size_t* cells_removed) {
     if (!ast) return NULL;
 
     // Create HRIR program from surface AST
@@ -218,6 +225,13 @@ static char* generate_hrir_json(SurfaceAST* ast, CompilerOptions options) {
         }
     }
 
+    if (options.optimize_hrir) {
+        HRIR_OptimizeStats stats;
+        if (hr_ir_optimize_program(program, &stats)) {
+            *cells_removed = stats.cells_removed;
+        }
+    }
+
     // Serialize to JSON
     char* json = hr_ir_serialize_program(program);
 
@@ -0,0 +1,1794 @@
+// test_hr_ir.c
+// Test L1 HRIR program encoding and execution
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "src/hr_ir.h"
+#include <fenv.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int failures = 0;
+
+static void check(bool condition, const char* description) {
+    if (condition) {
+        printf("✅ %s\n", description);
+    } else {
+        printf("❌ %s\n", description);
+        failures++;
+    }
+}
+
+static double elapsed_ms(clock_t start) {
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static void test_compact_encoding(void) {
+    printf("TEST 1: Cells are encoded into parallel arrays over a constant pool\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = hr_ir_create_program("encoding");
+
+    HRIR_Cell* add = hr_ir_create_cell(HRIR_OP_ADD, (const char*[]){"5", "3"}, 2);
+    hr_ir_set_cell_meta(add, "test.c", 1, "MathProto.MathActor.add");
+    check(hr_ir_add_cell(program, add), "Legacy cell added");
+
+    uint32_t id = hr_ir_emit(program, HRIR_OP_MULTIPLY, (const char*[]){"result", "2.5"}, 2, true);
+    check(id == 2, "Emitted cell gets the next id");
+    check(hr_ir_set_meta(program, 1, "test.c", 2, "MathProto.MathActor.multiply"),
+          "Metadata set by index");
+
+    hr_ir_emit(program, "send", (const char*[]){"Counter", "increment"}, 2, false);
+
+    check(program->opcodes[0] == HRIR_OPC_ADD && program->opcodes[1] == HRIR_OPC_MULTIPLY,
+          "Built-in opcodes map to enum values");
+    check(program->opcodes[2] == HRIR_OPC_CUSTOM &&
+          strcmp(hr_ir_get_opcode_name(program, 2), "send") == 0,
+          "Custom opcode name kept in cold metadata");
+
+    const HRIR_Const* five = hr_ir_get_const(program, program->args[program->arg_offsets[0]]);
+    check(five->kind == HRIR_CONST_NUMBER && five->value.type == HRIR_VALUE_INT &&
+          five->value.as.i == 5, "Integer literal pre-parsed");
+
+    const HRIR_Const* half = hr_ir_get_const(program, program->args[program->arg_offsets[1] + 1]);
+    check(half->kind == HRIR_CONST_NUMBER && half->value.type == HRIR_VALUE_FLOAT &&
+          half->value.as.f == 2.5, "Float literal pre-parsed");
+
+    const HRIR_Const* result = hr_ir_get_const(program, program->args[program->arg_offsets[1]]);
+    check(result->kind == HRIR_CONST_SYMBOL && result->reg == HRIR_RESULT_REGISTER,
+          "\"result\" is register 0");
+
+    uint32_t again = hr_ir_intern(program, "5", 1);
+    check(again == program->args[program->arg_offsets[0]], "Constants are interned once");
+
+    HRIR_Cell* view = hr_ir_get_cell(program, 1);
+    check(view && strcmp(view->opcode, "multiply") == 0 && view->arg_count == 2 &&
+          strcmp(view->args[1], "2.5") == 0 && view->line_number == 2 &&
+          strcmp(view->canonical_path, "MathProto.MathActor.multiply") == 0,
+          "Accessor view materialized from encoding");
+    check(hr_ir_get_cell(program, 1) == view, "Views are cached");
+    check(hr_ir_get_cell_by_id(program, 3) && !hr_ir_get_cell_by_id(program, 3)->is_reversible,
+          "Lookup by id still works");
+
+    HRIR_Stats stats = hr_ir_get_stats(program);
+    check(stats.total_cells == 3 && stats.r_term_cells == 2 && stats.d_term_cells == 1,
+          "Stats computed from flags");
+
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+static void test_large_program(void) {
+    printf("TEST 2: Large programs need no per-cell allocations\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = hr_ir_create_program("large");
+    clock_t start = clock();
+
+    bool ok = true;
+    for (int i = 0; i < 1000000 && ok; i++) {
+        char literal[16];
+        snprintf(literal, sizeof(literal), "%d", i % 100);
+        const char* args[] = {"result", literal};
+        ok = hr_ir_emit(program, HRIR_OP_ADD, args, 2, true) != 0;
+    }
+
+    printf("   Encoded 1M cells in %.1f ms\n", elapsed_ms(start));
+    check(ok && program->cell_count == 1000000, "1M cells encoded");
+    check(program->pool.count <= 102, "Pool holds only distinct constants");
+
+    size_t hot_bytes = program->cell_count * (sizeof(uint8_t) * 2 + sizeof(uint32_t) * 2 +
+                                              sizeof(uint16_t)) +
+                       program->arg_count * sizeof(uint32_t);
+    printf("   Hot encoding: %.1f bytes/cell\n", (double)hot_bytes / program->cell_count);
+    check(hot_bytes / program->cell_count < 32, "Hot encoding under 32 bytes per cell");
+
+    char* json = hr_ir_serialize_program(program);
+    check(json && strstr(json, "\"cell_count\": 1000000"), "Large program serializes");
+    free(json);
+
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+static void test_json_escaping(void) {
+    printf("TEST 3: Serialized strings are escaped\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = hr_ir_create_program("say \"hi\"");
+    hr_ir_emit(program, HRIR_OP_PRINT, (const char*[]){"line\n\"quoted\""}, 1, false);
+
+    char* json = hr_ir_serialize_program(program);
+    check(json && strstr(json, "\"say \\\"hi\\\"\""), "Source name escaped");
+    check(json && strstr(json, "\"line\\n\\\"quoted\\\"\""), "Argument escaped");
+    free(json);
+
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+static int64_t reg(HRIR_Runtime* runtime, const char* name) {
+    return hr_ir_get_register(runtime, name).as.i;
+}
+
+// sum = 0 + 1 + ... + 10, then round-trip it through memory
+static HRIR_Program* build_loop_program(void) {
+    HRIR_Program* program = hr_ir_create_program("loop");
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "0", "i"}, 3, true);       // 1
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "0", "sum"}, 3, true);     // 2
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"sum", "i", "sum"}, 3, true);   // 3
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"i", "1", "i"}, 3, true);       // 4
+    hr_ir_emit(program, HRIR_OP_LESS, (const char*[]){"i", "11", "c"}, 3, true);     // 5
+    hr_ir_emit(program, HRIR_OP_JUMP_IF, (const char*[]){"c", "3"}, 2, true);        // 6
+    hr_ir_emit(program, HRIR_OP_STORE, (const char*[]){"100", "sum"}, 2, true);      // 7
+    hr_ir_emit(program, HRIR_OP_LOAD, (const char*[]){"x", "100"}, 2, true);         // 8
+    hr_ir_emit(program, HRIR_OP_DIVIDE, (const char*[]){"x", "2.0"}, 2, true);       // 9
+    return program;
+}
+
+static void test_interpreter(void) {
+    printf("TEST 4: Built-in operations execute on registers and memory\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = build_loop_program();
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+
+    check(hr_ir_run(runtime), "Loop program runs to completion");
+    check(reg(runtime, "sum") == 55 && reg(runtime, "i") == 11 && reg(runtime, "c") == 0,
+          "Loop computed sum of 0..10");
+    check(hr_ir_get_memory(runtime, 100).as.i == 55 && reg(runtime, "x") == 55,
+          "Store and load round-trip through memory");
+    HRIR_Value result = hr_ir_get_register(runtime, "result");
+    check(result.type == HRIR_VALUE_FLOAT && result.as.f == 27.5,
+          "Mixed division promotes to float into result");
+
+    HRIR_Program* bad = hr_ir_create_program("bad");
+    hr_ir_emit(bad, HRIR_OP_DIVIDE, (const char*[]){"1", "0"}, 2, true);
+    HRIR_Runtime* bad_runtime = hr_ir_create_runtime(bad);
+    check(!hr_ir_step(bad_runtime) && hr_ir_get_last_error(bad_runtime) == HRIR_ERROR_EXECUTION_FAILED &&
+          hr_ir_get_pc(bad_runtime) == 0, "Division by zero fails without advancing");
+    hr_ir_free_runtime(bad_runtime);
+    hr_ir_free_program(bad);
+
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+typedef struct {
+    size_t pc;
+    int64_t i, sum, c, x, mem;
+    HRIR_Value result;
+} LoopState;
+
+static LoopState capture(HRIR_Runtime* runtime) {
+    LoopState state = {
+        .pc = hr_ir_get_pc(runtime),
+        .i = reg(runtime, "i"), .sum = reg(runtime, "sum"),
+        .c = reg(runtime, "c"), .x = reg(runtime, "x"),
+        .mem = hr_ir_get_memory(runtime, 100).as.i,
+        .result = hr_ir_get_register(runtime, "result")
+    };
+    return state;
+}
+
+static bool same_state(LoopState a, LoopState b) {
+    return a.pc == b.pc && a.i == b.i && a.sum == b.sum && a.c == b.c && a.x == b.x &&
+           a.mem == b.mem && a.result.type == b.result.type &&
+           memcmp(&a.result.as, &b.result.as, sizeof(a.result.as)) == 0;
+}
+
+static void test_undo(void) {
+    printf("TEST 5: Undo restores every prior state\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = build_loop_program();
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+
+    LoopState states[128];
+    size_t count = 0;
+    states[count++] = capture(runtime);
+    while (count < 128 && hr_ir_step(runtime)) {
+        states[count++] = capture(runtime);
+    }
+    check(hr_ir_is_complete(runtime), "Forward run recorded");
+    check(hr_ir_get_runtime_stats(runtime).executed_cells == 9 && hr_ir_cell_result(runtime, 2).as.i == 55,
+          "Runtime tracks executed cells and their results");
+
+    bool all_match = true;
+    for (size_t k = count - 1; k > 0; k--) {
+        if (!hr_ir_undo(runtime) || !same_state(capture(runtime), states[k - 1])) {
+            all_match = false;
+            break;
+        }
+    }
+    check(all_match, "Each undo reproduces the state before that step");
+    check(!hr_ir_undo(runtime) && hr_ir_get_pc(runtime) == 0, "Undo stops at the start");
+    check(hr_ir_get_runtime_stats(runtime).executed_cells == 0 &&
+          hr_ir_cell_result(runtime, 2).type == HRIR_VALUE_NONE, "Undo clears per-cell execution state");
+
+    hr_ir_run(runtime);
+    hr_ir_checkpoint(runtime);
+    hr_ir_set_register(runtime, "sum", hr_ir_value_int(0));
+    check(hr_ir_rollback(runtime) && reg(runtime, "sum") == 0, "Rollback to current point is a no-op");
+
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+// acc += i (and facc += 0.5) for i in 0..n-1
+static HRIR_Program* build_counting_program(const char* n) {
+    HRIR_Program* program = hr_ir_create_program("counting");
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "0", "i"}, 3, true);       // 1
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "0", "acc"}, 3, true);     // 2
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"acc", "i", "acc"}, 3, true);   // 3
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"facc", "0.5", "facc"}, 3, true); // 4
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"i", "1", "i"}, 3, true);       // 5
+    hr_ir_emit(program, HRIR_OP_LESS, (const char*[]){"i", n, "c"}, 3, true);        // 6
+    hr_ir_emit(program, HRIR_OP_JUMP_IF, (const char*[]){"c", "3"}, 2, true);        // 7
+    return program;
+}
+
+static void test_delta_tape(void) {
+    printf("TEST 6: Undo tape is delta-encoded and chunked\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = build_loop_program();
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+    hr_ir_run(runtime);
+
+    const HRIR_Tape* tape = &runtime->tape;
+    check(tape->records < tape->steps, "Exactly invertible steps write no record");
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(program);
+
+    program = build_counting_program("1000000");
+    runtime = hr_ir_create_runtime(program);
+
+    clock_t start = clock();
+    hr_ir_run(runtime);
+    double forward_ms = elapsed_ms(start);
+
+    tape = &runtime->tape;
+    printf("   Forward: %llu steps in %.1f ms, %llu records, %.2f bytes/step, %zu chunks\n",
+           (unsigned long long)tape->steps, forward_ms, (unsigned long long)tape->records,
+           (double)tape->bytes / (double)tape->steps, tape->chunk_count);
+    check(reg(runtime, "acc") == 499999500000LL &&
+          hr_ir_get_register(runtime, "facc").as.f == 500000.0, "Counting loop computed");
+    check(tape->bytes < tape->steps * 4, "Tape under 4 bytes per step");
+    check(tape->chunk_count > 1, "Tape spans multiple chunks");
+
+    start = clock();
+    size_t undone = 0;
+    while (hr_ir_undo(runtime)) undone++;
+    double undo_ms = elapsed_ms(start);
+
+    printf("   Undo: %zu steps in %.1f ms\n", undone, undo_ms);
+    HRIR_Value facc = hr_ir_get_register(runtime, "facc");
+    check(reg(runtime, "acc") == 0 && reg(runtime, "i") == 0 && facc.type == HRIR_VALUE_INT &&
+          facc.as.i == 0 && hr_ir_get_pc(runtime) == 0, "Full undo restores initial state");
+    check(tape->steps == 0 && tape->bytes == 0 && tape->chunk_count == 0,
+          "Tape chunks released as undo drains them");
+    check(undo_ms <= forward_ms * 4 + 5, "Undo throughput within a small factor of forward");
+
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+static void run_steps(HRIR_Runtime* runtime, size_t steps) {
+    for (size_t i = 0; i < steps && hr_ir_step(runtime); i++) {
+    }
+}
+
+static void test_checkpoint_tree(void) {
+    printf("TEST 7: Named checkpoints form a tree\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = build_counting_program("100000");
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+
+    run_steps(runtime, 100);
+    int a = hr_ir_create_checkpoint(runtime, "a");
+    int64_t acc_a = reg(runtime, "acc");
+    size_t pc_a = hr_ir_get_pc(runtime);
+
+    run_steps(runtime, 100);
+    int b = hr_ir_create_checkpoint(runtime, "b");
+    int64_t acc_b = reg(runtime, "acc");
+
+    check(runtime->checkpoints[b].parent == a && runtime->checkpoints[a].parent == -1,
+          "Checkpoints chain along the execution path");
+    check(hr_ir_find_checkpoint(runtime, "b") == b && hr_ir_find_checkpoint(runtime, "zz") == -1,
+          "Checkpoints found by name");
+
+    size_t rollbacks = runtime->rollbacks;
+    check(hr_ir_rollback_to(runtime, a) && reg(runtime, "acc") == acc_a &&
+          hr_ir_get_pc(runtime) == pc_a, "Rollback to ancestor restores its state");
+    check(runtime->rollbacks - rollbacks == 100, "Ancestor rollback undoes only the distance");
+
+    run_steps(runtime, 30);
+    int c = hr_ir_create_checkpoint(runtime, "c");
+    check(runtime->checkpoints[c].parent == a, "Checkpoint after rollback starts a branch");
+
+    rollbacks = runtime->rollbacks;
+    size_t steps = runtime->steps_executed;
+    check(hr_ir_rollback_to(runtime, b) && reg(runtime, "acc") == acc_b,
+          "Jump to sibling branch replays to its state");
+    check(runtime->rollbacks - rollbacks == 30 && runtime->steps_executed - steps + 30 == 100,
+          "Branch switch costs the tree distance");
+    check(runtime->active_checkpoint == b, "Target becomes the active checkpoint");
+
+    check(hr_ir_rollback_to(runtime, -1) && hr_ir_get_pc(runtime) == 0 && reg(runtime, "acc") == 0,
+          "Rollback to execution start");
+    check(!hr_ir_rollback_to(runtime, 999) &&
+          hr_ir_get_last_error(runtime) == HRIR_ERROR_CHECKPOINT_NOT_FOUND,
+          "Unknown checkpoint rejected");
+
+    // Many bookmarks in a long run
+    hr_ir_rollback_to(runtime, -1);
+    clock_t start = clock();
+    char name[32];
+    for (int i = 0; i < 100000; i++) {
+        run_steps(runtime, 3);
+        snprintf(name, sizeof(name), "step_%d", i);
+        hr_ir_create_checkpoint(runtime, name);
+    }
+    printf("   100k steps + bookmarks in %.1f ms\n", elapsed_ms(start));
+    int mid = hr_ir_find_checkpoint(runtime, "step_99990");
+    rollbacks = runtime->rollbacks;
+    check(mid >= 0 && hr_ir_rollback_to(runtime, mid) && runtime->rollbacks - rollbacks == 27,
+          "Late bookmark restored without walking the whole run");
+
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(program);
+
+    // Branches that read different input
+    const char* input_path = "test_hr_ir_input.txt";
+    FILE* input = fopen(input_path, "w");
+    fputs("5\n9\n7\n", input);
+    fclose(input);
+    freopen(input_path, "r", stdin);
+
+    program = hr_ir_create_program("reader");
+    hr_ir_emit(program, HRIR_OP_READ, (const char*[]){"x"}, 1, true);
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"x", "0", "y"}, 3, true);
+    runtime = hr_ir_create_runtime(program);
+
+    hr_ir_run(runtime);
+    b = hr_ir_create_checkpoint(runtime, "read_5");
+    hr_ir_rollback_to(runtime, -1);
+    hr_ir_run(runtime);
+    c = hr_ir_create_checkpoint(runtime, "read_9");
+    check(reg(runtime, "y") == 9 && hr_ir_rollback_to(runtime, b) && reg(runtime, "y") == 5,
+          "Sibling replay reads its own branch's input");
+    check(hr_ir_rollback_to(runtime, c) && reg(runtime, "y") == 9 && hr_ir_rollback_to(runtime, b) &&
+          reg(runtime, "y") == 5, "Switching back and forth keeps each branch's input");
+
+    check(!runtime->checkpoints[b].fingerprinted && !runtime->checkpoints[c].fingerprinted,
+          "Checkpoints skip the state fingerprint unless verification is on");
+    hr_ir_set_checkpoint_verification(runtime, true);
+    hr_ir_rollback_to(runtime, -1);
+    hr_ir_step(runtime);
+    hr_ir_set_register(runtime, "x", hr_ir_value_int(100));
+    hr_ir_step(runtime);
+    int edited = hr_ir_create_checkpoint(runtime, "edited");
+    check(reg(runtime, "y") == 100 && hr_ir_rollback_to(runtime, c) && !hr_ir_rollback_to(runtime, edited) &&
+          hr_ir_get_last_error(runtime) == HRIR_ERROR_EXECUTION_FAILED,
+          "Replay that cannot reproduce an edited branch reports divergence");
+
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(program);
+    freopen("/dev/null", "r", stdin);
+    remove(input_path);
+    printf("\n");
+}
+
+static void test_memory_budget(void) {
+    printf("TEST 8: Bounded-memory reverse execution recomputes from snapshots\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = build_counting_program("200000");
+    HRIR_Runtime* full = hr_ir_create_runtime(program);
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+
+    size_t budget = 256 * 1024;
+    check(hr_ir_set_memory_budget(runtime, budget), "Memory budget set");
+
+    hr_ir_run(full);
+    hr_ir_run(runtime);
+    HRIR_ReverseStats stats = hr_ir_get_reverse_stats(runtime);
+    printf("   %llu steps: %zu bytes used of %zu, %zu snapshots every %llu steps (full tape: %zu bytes)\n",
+           (unsigned long long)hr_ir_get_position(runtime), stats.memory_used, budget,
+           stats.snapshot_count, (unsigned long long)stats.snapshot_interval,
+           hr_ir_get_reverse_stats(full).memory_used);
+    check(stats.memory_used <= budget, "Memory stays within the budget");
+    check(stats.snapshot_interval > 64, "Snapshot interval adapted upwards");
+
+    bool all_match = true;
+    for (int k = 0; k < 20000 && all_match; k++) {
+        all_match = hr_ir_undo(runtime) && hr_ir_undo(full) &&
+                    hr_ir_get_pc(runtime) == hr_ir_get_pc(full) &&
+                    reg(runtime, "acc") == reg(full, "acc") && reg(runtime, "i") == reg(full, "i") &&
+                    hr_ir_get_register(runtime, "facc").as.f == hr_ir_get_register(full, "facc").as.f;
+    }
+    check(all_match, "Reverse steps match a full-tape runtime");
+
+    clock_t start = clock();
+    while (hr_ir_undo(runtime)) {
+    }
+    stats = hr_ir_get_reverse_stats(runtime);
+    printf("   Full reverse in %.1f ms: %llu undone, %llu recomputed\n", elapsed_ms(start),
+           (unsigned long long)stats.steps_undone, (unsigned long long)stats.steps_recomputed);
+    check(hr_ir_get_position(runtime) == 0 && reg(runtime, "acc") == 0 && hr_ir_get_pc(runtime) == 0,
+          "Reverse execution reaches the start");
+    check(stats.steps_recomputed > 0 && stats.steps_recomputed <= stats.steps_undone * 2,
+          "Recompute cost bounded by steps undone");
+    hr_ir_free_runtime(runtime);
+
+    // Smallest budget: one snapshot plus one tape chunk
+    HRIR_Program* wide = hr_ir_create_program("wide");
+    hr_ir_emit(wide, HRIR_OP_STORE, (const char*[]){"2000", "0"}, 2, true);      // 1
+    hr_ir_emit(wide, HRIR_OP_ADD, (const char*[]){"0", "0", "i"}, 3, true);     // 2
+    hr_ir_emit(wide, HRIR_OP_ADD, (const char*[]){"i", "1", "i"}, 3, true);     // 3
+    hr_ir_emit(wide, HRIR_OP_STORE, (const char*[]){"1000", "i"}, 2, true);     // 4
+    hr_ir_emit(wide, HRIR_OP_LESS, (const char*[]){"i", "5000", "c"}, 3, true); // 5
+    hr_ir_emit(wide, HRIR_OP_JUMP_IF, (const char*[]){"c", "3"}, 2, true);      // 6
+    HRIR_Runtime* reference = hr_ir_create_runtime(wide);
+    runtime = hr_ir_create_runtime(wide);
+    hr_ir_step(reference);
+    hr_ir_step(runtime);
+
+    size_t chunk = sizeof(HRIR_TapeChunk) + HRIR_TAPE_CHUNK_SIZE;
+    check(!hr_ir_set_memory_budget(runtime, chunk) && !runtime->recompute,
+          "Budget below one snapshot plus one chunk is rejected");
+    budget = chunk + 2001 * sizeof(HRIR_Value) + 1024;
+    hr_ir_run(reference);
+    check(hr_ir_set_memory_budget(runtime, budget) && hr_ir_run(runtime), "Tight budget runs");
+    stats = hr_ir_get_reverse_stats(runtime);
+    check(stats.memory_used <= budget && stats.snapshot_count == 1, "Tight budget keeps only the newest snapshot");
+    bool recent = true;
+    for (int k = 0; k < 20 && recent; k++) {
+        recent = hr_ir_undo(runtime) && hr_ir_undo(reference) && reg(runtime, "i") == reg(reference, "i") &&
+                 hr_ir_get_pc(runtime) == hr_ir_get_pc(reference);
+    }
+    check(recent, "Tight budget still undoes recent steps");
+    hr_ir_free_runtime(reference);
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(wide);
+
+    // State that outgrows the budget stops execution with an error
+    HRIR_Program* grown = hr_ir_create_program("grown");
+    hr_ir_emit(grown, HRIR_OP_STORE, (const char*[]){"20000", "0"}, 2, true);    // 1
+    hr_ir_emit(grown, HRIR_OP_ADD, (const char*[]){"0", "0", "i"}, 3, true);     // 2
+    hr_ir_emit(grown, HRIR_OP_ADD, (const char*[]){"i", "1", "i"}, 3, true);     // 3
+    hr_ir_emit(grown, HRIR_OP_LESS, (const char*[]){"i", "1000", "c"}, 3, true); // 4
+    hr_ir_emit(grown, HRIR_OP_JUMP_IF, (const char*[]){"c", "3"}, 2, true);      // 5
+    runtime = hr_ir_create_runtime(grown);
+    hr_ir_set_memory_budget(runtime, budget);
+    check(!hr_ir_run(runtime) && hr_ir_get_last_error(runtime) == HRIR_ERROR_MEMORY_ALLOCATION &&
+          runtime->last_error && strstr(runtime->last_error, "budget") && hr_ir_get_position(runtime) > 1 &&
+          reg(runtime, "i") < 1000,
+          "Snapshot that no longer fits stops execution with an error");
+    uint64_t failed_at = hr_ir_get_position(runtime);
+    check(hr_ir_undo(runtime) && hr_ir_get_position(runtime) == failed_at - 1, "Failed step stands and can be undone");
+
+    hr_ir_free_runtime(full);
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(grown);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+typedef struct {
+    const HRIR_Program* program;
+    int64_t acc;
+    bool reversed;
+} SharedRun;
+
+static void* run_shared(void* arg) {
+    SharedRun* run = arg;
+    HRIR_Runtime* runtime = hr_ir_create_runtime(run->program);
+
+    hr_ir_run(runtime);
+    run->acc = reg(runtime, "acc");
+    while (hr_ir_undo(runtime)) {
+    }
+    run->reversed = hr_ir_get_pc(runtime) == 0 && reg(runtime, "acc") == 0 &&
+                    !hr_ir_cell_executed(runtime, 0);
+
+    hr_ir_free_runtime(runtime);
+    return NULL;
+}
+
+static void test_shared_program(void) {
+    printf("TEST 9: One immutable program serves concurrent runtimes\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = build_counting_program("100000");
+    HRIR_Runtime* a = hr_ir_create_runtime(program);
+    HRIR_Runtime* b = hr_ir_create_runtime(program);
+
+    run_steps(a, 1001);
+    run_steps(b, 10);
+    check(hr_ir_get_pc(a) != hr_ir_get_pc(b) && reg(a, "i") != reg(b, "i"),
+          "Runtimes on one program keep separate pc and registers");
+    hr_ir_undo(a);
+    check(hr_ir_get_position(a) == 1000 && hr_ir_get_position(b) == 10, "Each runtime owns its tape");
+    hr_ir_free_runtime(a);
+    hr_ir_free_runtime(b);
+
+    enum { THREADS = 8 };
+    pthread_t threads[THREADS];
+    SharedRun runs[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        runs[t] = (SharedRun){ .program = program };
+        pthread_create(&threads[t], NULL, run_shared, &runs[t]);
+    }
+
+    bool all_match = true;
+    for (int t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        all_match = all_match && runs[t].acc == 4999950000LL && runs[t].reversed;
+    }
+    check(all_match, "Threads run and reverse the shared program independently");
+
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+// Inverse pair, foldable registers, a constant branch and a jump to the next cell
+static HRIR_Program* build_peephole_program(void) {
+    HRIR_Program* program = hr_ir_create_program("peephole");
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "5", "x"}, 3, true);       // 1
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"x", "3", "x"}, 3, true);       // 2
+    hr_ir_emit(program, HRIR_OP_SUBTRACT, (const char*[]){"x", "3", "x"}, 3, true);  // 3
+    hr_ir_emit(program, HRIR_OP_MULTIPLY, (const char*[]){"x", "2", "y"}, 3, true);  // 4
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"x", "1", "x"}, 3, true);       // 5
+    hr_ir_emit(program, HRIR_OP_LESS, (const char*[]){"y", "20", "c"}, 3, true);     // 6
+    hr_ir_emit(program, HRIR_OP_JUMP_IF, (const char*[]){"c", "9"}, 2, true);        // 7
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "1", "skipped"}, 3, true); // 8
+    hr_ir_emit(program, HRIR_OP_JUMP, (const char*[]){"10"}, 1, true);               // 9
+    hr_ir_emit(program, HRIR_OP_DIVIDE, (const char*[]){"y", "4.0"}, 2, true);       // 10
+    hr_ir_set_meta(program, 9, "peephole.rio", 10, "Math.Calc.divide");
+    return program;
+}
+
+static void test_optimizer(void) {
+    printf("TEST 10: Peephole optimizer removes cells without changing results\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* reference = build_peephole_program();
+    HRIR_Program* program = build_peephole_program();
+    HRIR_OptimizeStats stats;
+
+    check(hr_ir_optimize_program(program, &stats), "Optimizer ran");
+    printf("   %zu -> %zu cells: %zu inverse pairs, %zu folded, %zu jumps removed, %zu simplified\n",
+           stats.cells_before, program->cell_count, stats.inverse_pairs, stats.constants_folded,
+           stats.jumps_removed, stats.jumps_simplified);
+    check(stats.cells_removed == 3 && stats.inverse_pairs == 1 && stats.constants_folded == 2 &&
+          stats.jumps_removed == 1 && stats.jumps_simplified == 1, "Each pass fired");
+    check(!hr_ir_get_cell_by_id(program, 2) && !hr_ir_get_cell_by_id(program, 9) &&
+          hr_ir_get_cell_by_id(program, 10)->line_number == 10, "Surviving cells keep ids and source mapping");
+    check(strcmp(hr_ir_get_opcode_name(program, 4), "jump") == 0 &&
+          strcmp(hr_ir_const_text(program, program->args[program->arg_offsets[4]]), "10") == 0,
+          "Branch into a removed cell is redirected");
+    check(strcmp(hr_ir_const_text(program, program->args[program->arg_offsets[2]]), "x") == 0,
+          "In-place update is not folded");
+
+    HRIR_Runtime* expected = hr_ir_create_runtime(reference);
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+    hr_ir_run(expected);
+    hr_ir_run(runtime);
+    HRIR_Value result = hr_ir_get_register(runtime, "result");
+    check(reg(runtime, "x") == reg(expected, "x") && reg(runtime, "y") == reg(expected, "y") &&
+          reg(runtime, "c") == reg(expected, "c") && reg(runtime, "skipped") == 0 &&
+          result.type == HRIR_VALUE_FLOAT && result.as.f == hr_ir_get_register(expected, "result").as.f,
+          "Optimized program computes the same registers");
+    check(hr_ir_get_position(runtime) < hr_ir_get_position(expected), "Optimized program takes fewer steps");
+    while (hr_ir_undo(runtime)) {
+    }
+    check(hr_ir_get_pc(runtime) == 0 && reg(runtime, "x") == 0 && reg(runtime, "y") == 0,
+          "Optimized program still reverses to the start");
+    hr_ir_free_runtime(expected);
+    hr_ir_free_runtime(runtime);
+
+    HRIR_Program* loop = build_loop_program();
+    check(hr_ir_optimize_program(loop, &stats) && stats.cells_removed == 0, "Loop left intact");
+    runtime = hr_ir_create_runtime(loop);
+    check(hr_ir_run(runtime) && reg(runtime, "sum") == 55, "Optimized loop still computes its sum");
+    hr_ir_free_runtime(runtime);
+
+    // A pair starting at a jump target stays, and the program still completes
+    HRIR_Program* tail = hr_ir_create_program("tail");
+    hr_ir_emit(tail, HRIR_OP_ADD, (const char*[]){"0", "1", "c"}, 3, true);      // 1
+    hr_ir_emit(tail, HRIR_OP_JUMP_IF, (const char*[]){"c", "4"}, 2, true);       // 2
+    hr_ir_emit(tail, HRIR_OP_ADD, (const char*[]){"0", "7", "x"}, 3, true);      // 3
+    hr_ir_emit(tail, HRIR_OP_MULTIPLY, (const char*[]){"x", "1", "x"}, 3, true); // 4
+    hr_ir_emit(tail, HRIR_OP_DIVIDE, (const char*[]){"x", "1", "x"}, 3, true);   // 5
+    check(hr_ir_optimize_program(tail, &stats) && stats.inverse_pairs == 0, "Pair at a jump target is kept");
+    runtime = hr_ir_create_runtime(tail);
+    check(hr_ir_run(runtime) && hr_ir_is_complete(runtime), "Optimized jump into the tail still completes");
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(tail);
+
+    // multiply/divide by 1 of an empty register writes int 0 and stays
+    HRIR_Program* empty = hr_ir_create_program("empty");
+    hr_ir_emit(empty, HRIR_OP_MULTIPLY, (const char*[]){"x", "1", "x"}, 3, true);
+    hr_ir_emit(empty, HRIR_OP_DIVIDE, (const char*[]){"x", "1", "x"}, 3, true);
+    check(hr_ir_optimize_program(empty, &stats) && stats.inverse_pairs == 0, "Pair over an untyped register is kept");
+    runtime = hr_ir_create_runtime(empty);
+    hr_ir_run(runtime);
+    check(hr_ir_get_register(runtime, "x").type == HRIR_VALUE_INT, "Untyped register still ends up an int");
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(empty);
+
+    hr_ir_free_program(loop);
+    hr_ir_free_program(reference);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+// Independent lanes (add, square, store), an accumulating chain and a load.
+// With divide_lane >= 0 that lane divides by a zero register instead.
+static HRIR_Program* build_wide_program(int lanes, int divide_lane) {
+    HRIR_Program* program = hr_ir_create_program("wide");
+    char r[32], s[32], address[32];
+
+    for (int i = 0; i < lanes; i++) {
+        snprintf(r, sizeof(r), "r%d", i);
+        snprintf(address, sizeof(address), "%d", i);
+        hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){address, "1", r}, 3, true);
+    }
+    for (int i = 0; i < lanes; i++) {
+        snprintf(r, sizeof(r), "r%d", i);
+        snprintf(s, sizeof(s), "s%d", i);
+        if (i == divide_lane) {
+            hr_ir_emit(program, HRIR_OP_DIVIDE, (const char*[]){r, "zero", s}, 3, true);
+        } else {
+            hr_ir_emit(program, HRIR_OP_MULTIPLY, (const char*[]){r, r, s}, 3, true);
+        }
+    }
+    for (int i = 0; i < lanes; i++) {
+        snprintf(s, sizeof(s), "s%d", i);
+        snprintf(address, sizeof(address), "%d", i);
+        hr_ir_emit(program, HRIR_OP_STORE, (const char*[]){address, s}, 2, true);
+    }
+    for (int i = 0; i < 64; i++) {
+        snprintf(s, sizeof(s), "s%d", i);
+        hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"acc", s, "acc"}, 3, true);
+    }
+    hr_ir_emit(program, HRIR_OP_LOAD, (const char*[]){"last", "5"}, 2, true);
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"last", "acc", "result"}, 3, true);
+    return program;
+}
+
+static bool same_registers(HRIR_Runtime* a, HRIR_Runtime* b) {
+    if (a->register_count != b->register_count) return false;
+    for (size_t i = 0; i < a->register_count; i++) {
+        HRIR_Value x = a->registers[i], y = b->registers[i];
+        if (x.type != y.type || x.as.i != y.as.i) return false;
+    }
+    return true;
+}
+
+static void test_parallel_waves(void) {
+    printf("TEST 11: Independent cells run in parallel waves with exact history\n");
+    printf("-------------------------------------------------------------\n");
+
+    enum { LANES = 4096 };
+    HRIR_Program* program = build_wide_program(LANES, -1);
+    HRIR_Schedule* schedule = hr_ir_build_schedule(program);
+    HRIR_ScheduleStats stats = hr_ir_get_schedule_stats(schedule);
+
+    printf("   %zu cells in %zu blocks: %zu edges, %zu waves, widest %zu\n",
+           stats.cells, stats.blocks, stats.edges, stats.waves, stats.widest_wave);
+    check(schedule && stats.blocks == 1 && stats.widest_wave > LANES, "Lanes share a wave");
+
+    size_t count;
+    const uint32_t* preds = hr_ir_schedule_predecessors(schedule, LANES, &count);
+    check(count == 1 && preds[0] == 0, "Square waits only for its own add");
+    preds = hr_ir_schedule_predecessors(schedule, 3 * LANES + 1, &count);
+    check(count == 2 && preds[0] == 3 * LANES && preds[1] == LANES + 1, "Chain cell waits for accumulator and operand");
+
+    HRIR_Runtime* expected = hr_ir_create_runtime(program);
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+    clock_t start = clock();
+    hr_ir_run(expected);
+    double sequential_ms = elapsed_ms(start);
+    start = clock();
+    check(hr_ir_run_parallel(runtime, schedule, 4), "Parallel run completes");
+    double parallel_ms = elapsed_ms(start);
+    printf("   sequential %.2f ms, parallel %.2f ms (CPU time)\n", sequential_ms, parallel_ms);
+
+    bool memory_matches = true;
+    for (size_t i = 0; i < LANES; i++) {
+        memory_matches = memory_matches &&
+                         hr_ir_get_memory(runtime, i).as.i == hr_ir_get_memory(expected, i).as.i;
+    }
+    check(same_registers(runtime, expected) && memory_matches && reg(runtime, "last") == 36,
+          "Registers and memory match the sequential run");
+    check(hr_ir_get_position(runtime) == hr_ir_get_position(expected) &&
+          runtime->steps_executed == expected->steps_executed && hr_ir_cell_executed(runtime, LANES),
+          "History and per-cell state match the sequential run");
+
+    while (hr_ir_undo(runtime)) {
+    }
+    bool cleared = hr_ir_get_memory(runtime, 5).as.i == 0;
+    for (size_t i = 0; i < runtime->register_count; i++) {
+        cleared = cleared && runtime->registers[i].as.i == 0;
+    }
+    check(hr_ir_get_position(runtime) == 0 && hr_ir_get_pc(runtime) == 0 && cleared,
+          "Undo rewinds the parallel run to the start");
+    hr_ir_free_runtime(expected);
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_schedule(schedule);
+    hr_ir_free_program(program);
+
+    program = build_wide_program(LANES, 1500);
+    schedule = hr_ir_build_schedule(program);
+    expected = hr_ir_create_runtime(program);
+    runtime = hr_ir_create_runtime(program);
+    hr_ir_run(expected);
+    check(!hr_ir_run_parallel(runtime, schedule, 4), "Division by zero stops the parallel run");
+    check(runtime->error == expected->error && hr_ir_get_pc(runtime) == hr_ir_get_pc(expected) &&
+          hr_ir_get_position(runtime) == hr_ir_get_position(expected) && same_registers(runtime, expected),
+          "Error is reported at the same cell with the same state");
+    hr_ir_free_runtime(expected);
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_schedule(schedule);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+static void test_cell_arena(void) {
+    printf("TEST 12: Cell views live in the program arena\n");
+    printf("-------------------------------------------------------------\n");
+
+    enum { CELLS = 20000 };
+    HRIR_Program* program = hr_ir_create_program("arena");
+    for (int i = 0; i < CELLS; i++) {
+        hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"x", "1", "x"}, 3, true);
+    }
+
+    bool in_arena = true;
+    for (size_t i = 0; i < CELLS; i++) {
+        HRIR_Cell* view = hr_ir_get_cell(program, i);
+        in_arena = in_arena && view && view->arena == &program->arena &&
+                   hr_ir_get_inverse(view) && view->inverse->arena == &program->arena &&
+                   strcmp(view->args[2], "x") == 0 && view->args[3] == NULL;
+    }
+    printf("   %zu views in %zu chunks (%zu bytes)\n", (size_t)CELLS, program->arena.chunk_count,
+           program->arena.bytes_used);
+    check(in_arena && program->heap_cells == 0, "Views and inverses are bump allocated");
+    check(program->arena.chunk_count < CELLS / 50, "Arena uses few large chunks");
+
+    hr_ir_set_meta(program, 7, "arena.rio", 7, "Arena.Proto.add");
+    check(strcmp(hr_ir_get_cell(program, 7)->source_location, "arena.rio") == 0,
+          "Metadata of a view is updated in the arena");
+    check(!hr_ir_add_cell(program, hr_ir_get_cell(program, 0)), "Arena cell cannot be added twice");
+
+    HRIR_Cell* cell = hr_ir_create_cell(HRIR_OP_SUBTRACT, (const char*[]){"x", "1"}, 2);
+    hr_ir_set_cell_meta(cell, "arena.rio", 1, "Arena.Proto.first");
+    hr_ir_set_cell_meta(cell, "arena.rio", 2, "Arena.Proto.second");
+    check(cell->arena == NULL && hr_ir_add_cell(program, cell) && program->heap_cells == 1 &&
+          hr_ir_get_cell(program, CELLS) == cell, "Heap cell is adopted as a view");
+
+    clock_t start = clock();
+    hr_ir_free_program(program);
+    printf("   Freed in %.2f ms\n", elapsed_ms(start));
+    printf("\n");
+}
+
+static void test_lazy_inverse(void) {
+    printf("TEST 13: Inverse cells are derived on demand\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = hr_ir_create_program("inverse");
+    HRIR_Cell* added = hr_ir_create_cell(HRIR_OP_MULTIPLY, (const char*[]){"x", "2", "y"}, 3);
+    hr_ir_add_cell(program, added);
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"x", "1", "x"}, 3, true);
+    hr_ir_emit(program, HRIR_OP_PRINT, (const char*[]){"x"}, 1, true);
+    hr_ir_emit(program, HRIR_OP_SUBTRACT, (const char*[]){"x", "1", "x"}, 3, false);
+
+    check(added->inverse == NULL && hr_ir_get_cell(program, 1)->inverse == NULL,
+          "Adding and viewing cells builds no inverse");
+    check(hr_ir_inverse_opcode(HRIR_OPC_ADD) == HRIR_OPC_SUBTRACT &&
+          hr_ir_inverse_opcode(HRIR_OPC_DIVIDE) == HRIR_OPC_MULTIPLY &&
+          hr_ir_inverse_opcode(HRIR_OPC_PRINT) == HRIR_OPC_COUNT, "Inverse opcodes come from a table");
+    check(hr_ir_has_inverse(program, 0) && hr_ir_has_inverse(program, 1) &&
+          !hr_ir_has_inverse(program, 2) && !hr_ir_has_inverse(program, 3),
+          "Invertibility is known without materializing");
+
+    HRIR_Cell* view = hr_ir_get_cell(program, 1);
+    HRIR_Cell* inverse = hr_ir_get_inverse(view);
+    check(inverse && strcmp(inverse->opcode, HRIR_OP_SUBTRACT) == 0 && inverse->args == view->args &&
+          hr_ir_get_inverse(view) == inverse, "Inverse shares operands and is cached");
+    check(strcmp(hr_ir_get_inverse(added)->opcode, HRIR_OP_DIVIDE) == 0 && added->inverse->args == added->args,
+          "Adopted heap cell gets its inverse on request");
+    check(!hr_ir_get_inverse(hr_ir_get_cell(program, 2)) && !hr_ir_get_inverse(hr_ir_get_cell(program, 3)),
+          "Print and irreversible cells have none");
+
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+static void test_json_loader(void) {
+    printf("TEST 14: Serialized programs load back for execution\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* original = build_peephole_program();
+    hr_ir_optimize_program(original, NULL);
+    hr_ir_emit(original, HRIR_OP_PRINT, (const char*[]){"tab\t \xc3\xbc \x01 \"q\""}, 1, false);
+    hr_ir_emit(original, "send", (const char*[]){"Counter", "increment"}, 2, false);
+
+    char* json = hr_ir_serialize_program(original);
+    HRIR_Program* loaded = hr_ir_deserialize_program(json);
+    char* again = loaded ? hr_ir_serialize_program(loaded) : NULL;
+    check(loaded && again && strcmp(json, again) == 0, "Round trip reproduces the JSON");
+    check(loaded && loaded->ids[4] == original->ids[4] && loaded->next_id == original->next_id &&
+          strcmp(loaded->source_name, "peephole") == 0, "Cell ids with gaps are kept");
+    check(loaded && loaded->opcodes[loaded->cell_count - 1] == HRIR_OPC_CUSTOM &&
+          strcmp(hr_ir_get_opcode_name(loaded, loaded->cell_count - 1), "send") == 0,
+          "Custom opcodes load by name");
+
+    HRIR_Runtime* expected = hr_ir_create_runtime(original);
+    HRIR_Runtime* runtime = loaded ? hr_ir_create_runtime(loaded) : NULL;
+    hr_ir_set_register(expected, "result", hr_ir_value_int(0));
+    check(runtime && hr_ir_run(expected) == hr_ir_run(runtime) && reg(runtime, "y") == reg(expected, "y") &&
+          hr_ir_get_position(runtime) == hr_ir_get_position(expected), "Loaded program runs the same");
+    hr_ir_free_runtime(expected);
+    hr_ir_free_runtime(runtime);
+    free(again);
+    free(json);
+    hr_ir_free_program(loaded);
+    hr_ir_free_program(original);
+
+    const char* with_meta =
+        "{\"cells\": [{\"id\": 3, \"opcode\": \"add\", \"args\": [\"x\", 2],"
+        " \"source_location\": \"meta.rio\", \"line_number\": 7, \"extra\": {\"a\": [1, null]},"
+        " \"canonical_path\": \"P.A.add\"}], \"cell_count\": 1}";
+    loaded = hr_ir_deserialize_program(with_meta);
+    HRIR_Cell* cell = loaded ? hr_ir_get_cell(loaded, 0) : NULL;
+    check(cell && cell->id == 3 && cell->line_number == 7 && strcmp(cell->args[1], "2") == 0 &&
+          strcmp(cell->canonical_path, "P.A.add") == 0 && cell->is_reversible,
+          "Metadata, numeric args and unknown keys are accepted");
+    hr_ir_free_program(loaded);
+
+    const char* bad[] = {
+        "{\"cells\": [{\"id\": 2, \"opcode\": \"add\"}, {\"id\": 2, \"opcode\": \"add\"}]}",
+        "{\"cells\": [{\"id\": 1, \"args\": []}]}",
+        "{\"cell_count\": 2, \"cells\": [{\"opcode\": \"add\"}]}",
+        "{\"cells\": [{\"opcode\": \"add\", \"args\": [\"x\"\n \"y\"]}]}",
+        "{\"cells\": []} trailing",
+        "{\"cells\": [{\"opcode\": \"pr\\u0000int\"}]}",
+        "{\"cells\": [{\"opcode\": \"print\", \"args\": [\"unterminated]}]}",
+    };
+    bool all_rejected = true;
+    char* message = NULL;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        free(message);
+        HRIR_Program* rejected = hr_ir_parse_program(bad[i], strlen(bad[i]), &message);
+        all_rejected = all_rejected && !rejected && message;
+        hr_ir_free_program(rejected);
+    }
+    check(all_rejected, "Malformed documents are rejected");
+    free(message);
+    hr_ir_parse_program(bad[3], strlen(bad[3]), &message);
+    printf("   %s\n", message ? message : "(no message)");
+    check(message && strstr(message, "line 2, column 2"), "Errors report line and column");
+    free(message);
+
+    HRIR_Program* wide = build_wide_program(50000, -1);
+    json = hr_ir_serialize_program(wide);
+    size_t bytes = json ? strlen(json) : 0;
+    clock_t start = clock();
+    loaded = hr_ir_parse_program(json, bytes, NULL);
+    double ms = elapsed_ms(start);
+    printf("   %zu cells, %.1f MB in %.1f ms (%.0f MB/s)\n", wide->cell_count, bytes / 1e6, ms,
+           ms > 0 ? bytes / 1e3 / ms : 0.0);
+    check(loaded && loaded->cell_count == wide->cell_count && loaded->arg_count == wide->arg_count,
+          "Large program loads completely");
+    hr_ir_free_program(loaded);
+    hr_ir_free_program(wide);
+    free(json);
+    printf("\n");
+}
+
+static void test_binary_format(void) {
+    printf("TEST 15: Binary images map back without per-cell allocation\n");
+    printf("-------------------------------------------------------------\n");
+
+    const char* path = "test_hr_ir.hrirb";
+    HRIR_Program* original = build_loop_program();
+    hr_ir_set_meta(original, 2, "loop.rio", 3, "Main.loop.add");
+    check(hr_ir_save_binary(original, path), "Program saved as .hrirb");
+
+    char* error = NULL;
+    HRIR_Program* loaded = hr_ir_load_binary(path, &error);
+    check(loaded && loaded->image && loaded->cell_count == original->cell_count &&
+          strcmp(loaded->source_name, "loop") == 0, "Image mapped as a program");
+    HRIR_Cell* cell = loaded ? hr_ir_get_cell(loaded, 2) : NULL;
+    check(cell && cell->line_number == 3 && strcmp(cell->canonical_path, "Main.loop.add") == 0 &&
+          strcmp(cell->source_location, "loop.rio") == 0, "Metadata survives");
+
+    HRIR_Runtime* runtime = loaded ? hr_ir_create_runtime(loaded) : NULL;
+    check(runtime && hr_ir_run(runtime) && reg(runtime, "sum") == 55, "Mapped program runs");
+    check(runtime && hr_ir_undo(runtime) && hr_ir_undo(runtime), "Mapped program undoes");
+    hr_ir_free_runtime(runtime);
+
+    uint32_t id = loaded ? hr_ir_emit(loaded, HRIR_OP_ADD, (const char*[]){"sum", "1", "fresh"}, 3, true) : 0;
+    check(loaded && id == original->next_id && !loaded->image &&
+          hr_ir_find_const(loaded, "fresh", 5) != HRIR_NO_CONST, "Growing copies the program off the image");
+    hr_ir_free_program(loaded);
+
+    size_t size = 0;
+    unsigned char* image = hr_ir_serialize_binary(original, &size);
+    image[size - 8] ^= 0x40;
+    loaded = hr_ir_read_binary(image, size, &error);
+    check(!loaded && error && strstr(error, "checksum"), "Corrupted image is rejected");
+    free(error);
+    image[size - 8] ^= 0x40;
+    loaded = hr_ir_read_binary(image, size - 8, &error);
+    check(!loaded && error, "Truncated image is rejected");
+    free(error);
+    loaded = hr_ir_read_binary(image, size, NULL);
+    check(loaded != NULL, "In-memory image loads");
+    hr_ir_free_program(loaded);
+    free(image);
+    hr_ir_free_program(original);
+
+    HRIR_Program* wide = build_wide_program(50000, -1);
+    char* json = hr_ir_serialize_program(wide);
+    hr_ir_save_binary(wide, path);
+    clock_t start = clock();
+    HRIR_Program* from_json = hr_ir_deserialize_program(json);
+    double json_ms = elapsed_ms(start);
+    start = clock();
+    loaded = hr_ir_load_binary(path, NULL);
+    double binary_ms = elapsed_ms(start);
+    printf("   %zu cells: JSON %.1f ms, binary %.1f ms\n", wide->cell_count, json_ms, binary_ms);
+    check(loaded && from_json && loaded->arg_count == from_json->arg_count &&
+          memcmp(loaded->args, from_json->args, loaded->arg_count * sizeof(uint32_t)) == 0,
+          "Binary and JSON loads agree");
+    hr_ir_free_program(loaded);
+    hr_ir_free_program(from_json);
+    hr_ir_free_program(wide);
+    free(json);
+    remove(path);
+    printf("\n");
+}
+
+// Two of each cell; the first multiply folds, the second reads loaded memory
+static HRIR_Program* build_repeated_program(bool hash_consing) {
+    HRIR_Program* program = hr_ir_create_program("repeated");
+    if (hash_consing) hr_ir_set_hash_consing(program, true);
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "5", "x"}, 3, true);
+    hr_ir_emit(program, HRIR_OP_MULTIPLY, (const char*[]){"x", "2", "y"}, 3, true);
+    hr_ir_emit(program, HRIR_OP_LOAD, (const char*[]){"x", "100"}, 2, true);
+    hr_ir_emit(program, HRIR_OP_MULTIPLY, (const char*[]){"x", "2", "y"}, 3, true);
+    for (int i = 0; i < 2000; i++) {
+        hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"x", "1", "x"}, 3, true);
+        hr_ir_emit(program, HRIR_OP_STORE, (const char*[]){"200", "x"}, 2, true);
+    }
+    return program;
+}
+
+static void test_hash_consing(void) {
+    printf("TEST 16: Hash-consed cells share argument runs\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* plain = build_repeated_program(false);
+    HRIR_Program* shared = build_repeated_program(true);
+    printf("   argument slots: %zu plain, %zu shared (%zu cells reuse a run)\n",
+           plain->arg_count, shared->arg_count, shared->bodies.shared_cells);
+    check(shared->arg_count == 13 && shared->bodies.shared_cells == 3999 &&
+          plain->arg_count == shared->arg_count + shared->bodies.saved_slots,
+          "Repeated cells store their arguments once");
+    check(shared->arg_offsets[1] == shared->arg_offsets[3] && shared->ids[3] == 4,
+          "Positions keep their own ids over a shared body");
+
+    size_t plain_size = 0, shared_size = 0;
+    void* plain_image = hr_ir_serialize_binary(plain, &plain_size);
+    void* shared_image = hr_ir_serialize_binary(shared, &shared_size);
+    printf("   binary image: %zu bytes plain, %zu bytes shared\n", plain_size, shared_size);
+    check(shared_size < plain_size, "Serialized image shrinks");
+    free(plain_image);
+    free(shared_image);
+
+    char* plain_json = hr_ir_serialize_program(plain);
+    char* shared_json = hr_ir_serialize_program(shared);
+    check(strcmp(plain_json, shared_json) == 0, "Shared program reads back the same cells");
+    free(plain_json);
+    free(shared_json);
+
+    hr_ir_optimize_program(plain, NULL);
+    hr_ir_optimize_program(shared, NULL);
+    plain_json = hr_ir_serialize_program(plain);
+    shared_json = hr_ir_serialize_program(shared);
+    const char* folded = hr_ir_get_cell(shared, 1)->args[0];
+    const char* kept = hr_ir_get_cell(shared, 3)->args[0];
+    check(strcmp(plain_json, shared_json) == 0 && strcmp(folded, "10") == 0 && strcmp(kept, "x") == 0,
+          "Rewriting one cell leaves the cells sharing its body alone");
+    free(plain_json);
+    free(shared_json);
+
+    size_t before = plain->arg_count;
+    check(hr_ir_set_hash_consing(plain, true) && plain->arg_count < 20 && before > 8000,
+          "Enabling folds the cells already in the program");
+    HRIR_Runtime* runtime = hr_ir_create_runtime(plain);
+    check(hr_ir_run(runtime) && reg(runtime, "x") == 2000 && reg(runtime, "y") == 0,
+          "Folded program still runs");
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(plain);
+    hr_ir_free_program(shared);
+    printf("\n");
+}
+
+static void test_superinstructions(void) {
+    printf("TEST 17: Fused superinstructions run with one dispatch\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* plain = build_counting_program("1000000");
+    HRIR_Program* fused = build_counting_program("1000000");
+    HRIR_FuseStats stats;
+    check(hr_ir_fuse_program(fused, NULL, &stats), "Fusion pass ran");
+    printf("   %zu op/op, %zu compare/branch groups over %zu cells\n",
+           stats.fused[HRIR_SUPER_OP_OP], stats.fused[HRIR_SUPER_COMPARE_BRANCH], stats.cells_covered);
+    check(stats.fused[HRIR_SUPER_OP_OP] == 2 && stats.fused[HRIR_SUPER_COMPARE_BRANCH] == 1 &&
+          hr_ir_get_superinstruction(fused, 2) == HRIR_SUPER_OP_OP &&
+          hr_ir_get_superinstruction(fused, 5) == HRIR_SUPER_COMPARE_BRANCH &&
+          hr_ir_get_superinstruction(fused, 4) == HRIR_SUPER_NONE, "Table patterns found");
+
+    HRIR_Runtime* expected = hr_ir_create_runtime(plain);
+    HRIR_Runtime* runtime = hr_ir_create_runtime(fused);
+    clock_t start = clock();
+    hr_ir_run(expected);
+    double plain_ms = elapsed_ms(start);
+    start = clock();
+    hr_ir_run(runtime);
+    double fused_ms = elapsed_ms(start);
+    printf("   %zu steps: %.1f ms plain, %.1f ms fused\n", runtime->steps_executed, plain_ms, fused_ms);
+    check(reg(runtime, "acc") == reg(expected, "acc") && hr_ir_get_position(runtime) == hr_ir_get_position(expected) &&
+          hr_ir_get_register(runtime, "facc").as.f == hr_ir_get_register(expected, "facc").as.f,
+          "Fused run matches the plain run");
+    bool same_counts = true;
+    for (size_t i = 0; i < fused->cell_count; i++) {
+        same_counts = same_counts && runtime->exec_counts[i] == expected->exec_counts[i];
+    }
+    check(same_counts && runtime->tape.records == expected->tape.records &&
+          runtime->tape.bytes == expected->tape.bytes, "Fused groups write the plain run's tape records");
+    hr_ir_free_runtime(expected);
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(plain);
+    hr_ir_free_program(fused);
+
+    HRIR_Program* program = build_loop_program();
+    hr_ir_emit(program, HRIR_OP_LOAD, (const char*[]){"t", "100"}, 2, true);
+    hr_ir_emit(program, HRIR_OP_MULTIPLY, (const char*[]){"t", "3", "t"}, 3, true);
+    hr_ir_emit(program, HRIR_OP_STORE, (const char*[]){"100", "t"}, 2, true);
+    hr_ir_fuse_program(program, NULL, &stats);
+    runtime = hr_ir_create_runtime(program);
+    check(hr_ir_run(runtime) && hr_ir_get_memory(runtime, 100).as.i == 165 &&
+          hr_ir_get_superinstruction(program, 9) == HRIR_SUPER_LOAD_OP_STORE, "Load/op/store fused");
+    while (hr_ir_undo(runtime)) {
+    }
+    check(hr_ir_get_position(runtime) == 0 && reg(runtime, "sum") == 0 && reg(runtime, "t") == 0 &&
+          hr_ir_get_memory(runtime, 100).as.i == 0, "Fused groups undo through their cells' inverses");
+
+    // A group stops at the cell that fails, exactly where stepping would
+    HRIR_Program* failing[2];
+    HRIR_Runtime* failed[2];
+    for (int k = 0; k < 2; k++) {
+        failing[k] = hr_ir_create_program("failing");
+        hr_ir_emit(failing[k], HRIR_OP_STORE, (const char*[]){"100", "6"}, 2, true);
+        hr_ir_emit(failing[k], HRIR_OP_LESS, (const char*[]){"0", "1", "c"}, 3, true);
+        hr_ir_emit(failing[k], HRIR_OP_JUMP_IF, (const char*[]){"1", "5"}, 2, true);
+        hr_ir_emit(failing[k], HRIR_OP_ADD, (const char*[]){"0", "99", "z"}, 3, true);
+        hr_ir_emit(failing[k], HRIR_OP_LOAD, (const char*[]){"t", "100"}, 2, true);
+        hr_ir_emit(failing[k], HRIR_OP_DIVIDE, (const char*[]){"t", "z", "t"}, 3, true);
+        hr_ir_emit(failing[k], HRIR_OP_STORE, (const char*[]){"100", "t"}, 2, true);
+        if (k == 1) hr_ir_fuse_program(failing[k], NULL, NULL);
+        failed[k] = hr_ir_create_runtime(failing[k]);
+        hr_ir_run(failed[k]);
+    }
+    check(hr_ir_get_superinstruction(failing[1], 1) == HRIR_SUPER_COMPARE_BRANCH &&
+          hr_ir_get_superinstruction(failing[1], 4) == HRIR_SUPER_LOAD_OP_STORE &&
+          failed[1]->error == failed[0]->error && failed[1]->error == HRIR_ERROR_EXECUTION_FAILED &&
+          failed[1]->pc == 5 && failed[0]->pc == 5 && reg(failed[1], "t") == 6 && reg(failed[1], "z") == 0 &&
+          hr_ir_get_position(failed[1]) == hr_ir_get_position(failed[0]), "Group failing partway stops at its cell");
+    for (int k = 0; k < 2; k++) {
+        hr_ir_free_runtime(failed[k]);
+        hr_ir_free_program(failing[k]);
+    }
+
+    HRIR_Runtime* profile = hr_ir_create_runtime(program);
+    hr_ir_fuse_program(program, NULL, NULL);
+    hr_ir_run(profile);
+    check(hr_ir_fuse_program(program, profile, &stats) &&
+          hr_ir_get_superinstruction(program, 0) == HRIR_SUPER_NONE &&
+          hr_ir_get_superinstruction(program, 2) == HRIR_SUPER_OP_OP &&
+          stats.fused[HRIR_SUPER_LOAD_OP_STORE] == 0, "Profile restricts fusion to hot cells");
+    hr_ir_free_runtime(profile);
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+// Same registers, per-cell state and tape as far as undo can tell
+static bool same_history(HRIR_Runtime* a, HRIR_Runtime* b) {
+    if (!same_registers(a, b) || a->pc != b->pc || a->steps_executed != b->steps_executed ||
+        a->tape.steps != b->tape.steps || a->tape.records != b->tape.records ||
+        a->tape.bytes != b->tape.bytes || a->error != b->error) {
+        return false;
+    }
+    for (size_t i = 0; i < a->cell_state_count && i < b->cell_state_count; i++) {
+        if (a->exec_counts[i] != b->exec_counts[i]) return false;
+    }
+    return true;
+}
+
+static void test_native_backend(void) {
+    printf("TEST 18: Native backend matches the interpreter, undo included\n");
+    printf("-------------------------------------------------------------\n");
+
+    const char* path = "./test_hr_ir_native.so";
+    HRIR_Program* program = build_loop_program();
+    hr_ir_emit(program, HRIR_OP_MULTIPLY, (const char*[]){"x", "1.5", "f"}, 3, true);
+    hr_ir_emit(program, HRIR_OP_GREATER, (const char*[]){"f", "40"}, 2, true);
+    hr_ir_emit(program, HRIR_OP_JUMP_IF, (const char*[]){"result", "14"}, 2, true);
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "1", "skipped"}, 3, true);
+    hr_ir_emit(program, HRIR_OP_DIVIDE, (const char*[]){"sum", "0"}, 2, true);
+
+    char* source = hr_ir_emit_c(program);
+    check(source && strstr(source, "goto L2;") && strstr(source, "hrir_native_run"),
+          "C translation unit emitted with gotos");
+    free(source);
+
+    char* error = NULL;
+    bool compiled = hr_ir_compile_native(program, path, &error);
+    check(compiled, "Compiled with the system C compiler");
+    if (!compiled) {
+        printf("   %s\n", error ? error : "(no message)");
+        free(error);
+        hr_ir_free_program(program);
+        printf("\n");
+        return;
+    }
+    HRIR_Native* native = hr_ir_load_native(path, program, &error);
+    check(native != NULL, "Shared object loaded");
+
+    HRIR_Runtime* expected = hr_ir_create_runtime(program);
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+    bool interpreted = hr_ir_run(expected);
+    bool ran = native && hr_ir_run_native(runtime, native);
+    check(!interpreted && !ran && runtime->error == HRIR_ERROR_EXECUTION_FAILED && runtime->pc == 13 &&
+          same_history(runtime, expected), "Same state and same error at the same cell");
+    check(reg(runtime, "sum") == 55 && hr_ir_get_register(runtime, "f").as.f == 82.5 &&
+          reg(runtime, "skipped") == 0, "Registers hold the interpreter's values");
+
+    bool undone = true;
+    while (hr_ir_undo(expected)) {
+        undone = undone && hr_ir_undo(runtime) && same_history(runtime, expected);
+    }
+    check(undone && hr_ir_get_position(runtime) == 0 && reg(runtime, "sum") == 0 &&
+          hr_ir_get_memory(runtime, 100).as.i == 0, "Native history undoes step by step");
+    hr_ir_free_runtime(expected);
+    hr_ir_free_runtime(runtime);
+
+    HRIR_Program* other = build_loop_program();
+    check(!hr_ir_load_native(path, other, NULL), "Object from a different program is rejected");
+    hr_ir_free_program(other);
+    hr_ir_free_native(native);
+    hr_ir_free_program(program);
+    remove(path);
+
+    program = build_counting_program("1000000");
+    native = hr_ir_compile_native(program, path, NULL) ? hr_ir_load_native(path, program, NULL) : NULL;
+    expected = hr_ir_create_runtime(program);
+    runtime = hr_ir_create_runtime(program);
+    clock_t start = clock();
+    hr_ir_run(expected);
+    double interpreted_ms = elapsed_ms(start);
+    start = clock();
+    ran = native && hr_ir_run_native(runtime, native);
+    double native_ms = elapsed_ms(start);
+    printf("   %zu steps: %.1f ms interpreted, %.1f ms native\n", runtime->steps_executed,
+           interpreted_ms, native_ms);
+    check(ran && same_history(runtime, expected), "Hot loop matches the interpreter");
+    hr_ir_free_runtime(expected);
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_native(native);
+    hr_ir_free_program(program);
+    remove(path);
+    printf("\n");
+}
+
+// Recomputations across a loop: the header is a merge point, the cells after
+// the loop inherit its numbering
+static HRIR_Program* build_redundant_program(void) {
+    HRIR_Program* program = hr_ir_create_program("redundant");
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "3", "a"}, 3, true);       // 1
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "4", "b"}, 3, true);       // 2
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"a", "b", "t"}, 3, true);       // 3
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"a", "b", "t"}, 3, true);       // 4 loop header
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"a", "b", "t"}, 3, true);       // 5 redundant
+    hr_ir_emit(program, HRIR_OP_MULTIPLY, (const char*[]){"t", "1", "c"}, 3, true);  // 6 copy
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"a", "b", "c"}, 3, true);       // 7 redundant
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"i", "1", "i"}, 3, true);       // 8
+    hr_ir_emit(program, HRIR_OP_LESS, (const char*[]){"i", "3", "k"}, 3, true);      // 9
+    hr_ir_emit(program, HRIR_OP_JUMP_IF, (const char*[]){"k", "4"}, 2, true);        // 10
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"a", "b", "t"}, 3, true);       // 11 redundant
+    hr_ir_emit(program, HRIR_OP_LESS, (const char*[]){"i", "3", "k"}, 3, true);      // 12 redundant
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"5", "3", "z"}, 3, true);       // 13
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"5", "3", "z"}, 3, true);       // 14 redundant
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"i", "1", "i"}, 3, true);       // 15
+    hr_ir_emit(program, HRIR_OP_DIVIDE, (const char*[]){"t", "2.0"}, 2, true);       // 16
+    return program;
+}
+
+static void test_value_numbering(void) {
+    printf("TEST 19: Value numbering removes recomputed values\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* reference = build_redundant_program();
+    HRIR_Program* program = build_redundant_program();
+    HRIR_ValueNumberStats stats;
+
+    check(hr_ir_value_number_program(program, &stats), "Value numbering ran");
+    printf("   %zu -> %zu cells: %zu extended blocks, %zu values\n", stats.cells_before,
+           program->cell_count, stats.extended_blocks, stats.values);
+    check(stats.cells_removed == 5 && stats.extended_blocks == 2, "Redundant cells reported");
+    check(hr_ir_get_cell_by_id(program, 4) && !hr_ir_get_cell_by_id(program, 5) &&
+          !hr_ir_get_cell_by_id(program, 7) && !hr_ir_get_cell_by_id(program, 11) &&
+          !hr_ir_get_cell_by_id(program, 12) && !hr_ir_get_cell_by_id(program, 14),
+          "Loop header kept, repeats and copies matched");
+    check(hr_ir_get_cell_by_id(program, 8) && hr_ir_get_cell_by_id(program, 15),
+          "In-place updates are never equal to their input");
+
+    HRIR_Runtime* expected = hr_ir_create_runtime(reference);
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+    hr_ir_run(expected);
+    check(hr_ir_run(runtime) && same_registers(runtime, expected) && reg(runtime, "i") == 4,
+          "Same registers as the unnumbered program");
+    check(hr_ir_get_position(runtime) < hr_ir_get_position(expected), "Fewer steps executed");
+    while (hr_ir_undo(runtime)) {
+    }
+    check(hr_ir_get_pc(runtime) == 0 && reg(runtime, "t") == 0 && reg(runtime, "c") == 0 &&
+          reg(runtime, "i") == 0, "Numbered program still reverses to the start");
+    hr_ir_free_runtime(expected);
+    hr_ir_free_runtime(runtime);
+
+    HRIR_Program* loop = build_loop_program();
+    check(hr_ir_value_number_program(loop, &stats) && stats.cells_removed == 0, "Loop left intact");
+    runtime = hr_ir_create_runtime(loop);
+    check(hr_ir_run(runtime) && reg(runtime, "sum") == 55, "Numbered loop still computes its sum");
+    hr_ir_free_runtime(runtime);
+
+    // A redundant last cell that a jump lands on stays so the jump resolves
+    HRIR_Program* tail = hr_ir_create_program("tail");
+    hr_ir_emit(tail, HRIR_OP_ADD, (const char*[]){"0", "7", "x"}, 3, true);      // 1
+    hr_ir_emit(tail, HRIR_OP_JUMP, (const char*[]){"4"}, 1, true);               // 2
+    hr_ir_emit(tail, HRIR_OP_JUMP, (const char*[]){"1"}, 1, true);               // 3
+    hr_ir_emit(tail, HRIR_OP_MULTIPLY, (const char*[]){"x", "1", "x"}, 3, true); // 4
+    check(hr_ir_value_number_program(tail, &stats) && tail->cell_count == 4, "Trailing jump target is kept");
+    runtime = hr_ir_create_runtime(tail);
+    check(hr_ir_run(runtime) && hr_ir_is_complete(runtime) && reg(runtime, "x") == 7,
+          "Jump to the trailing target still completes");
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(tail);
+
+    hr_ir_free_program(loop);
+    hr_ir_free_program(reference);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+static void test_profiling(void) {
+    printf("TEST 20: Per-opcode profile and tape accounting\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = build_loop_program();
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+    run_steps(runtime, 3);
+    HRIR_Stats stats = hr_ir_get_runtime_stats(runtime);
+    check(!stats.profiled && stats.opcodes[HRIR_OPC_ADD].executions == 0 && stats.tape_bytes > 0,
+          "Tape is accounted without profiling");
+
+    check(hr_ir_set_profiling(runtime, true), "Profiling enabled");
+    size_t tape_at_start = runtime->tape.bytes;
+    hr_ir_run(runtime);
+    hr_ir_create_checkpoint(runtime, "end");
+    stats = hr_ir_get_runtime_stats(runtime);
+
+    uint64_t executions = 0, tape_bytes = 0;
+    for (size_t op = 0; op < HRIR_OPC_COUNT; op++) {
+        executions += stats.opcodes[op].executions;
+        tape_bytes += stats.opcodes[op].tape_bytes;
+    }
+    printf("   %llu steps, %zu tape bytes (peak %zu), add %llu ns\n", (unsigned long long)executions,
+           stats.tape_bytes, stats.peak_tape_bytes,
+           (unsigned long long)stats.opcodes[HRIR_OPC_ADD].nanoseconds);
+    check(stats.profiled && executions == runtime->steps_executed - 3 &&
+          stats.opcodes[HRIR_OPC_ADD].executions == 21 && stats.opcodes[HRIR_OPC_LESS].executions == 11 &&
+          stats.opcodes[HRIR_OPC_JUMP_IF].executions == 11 && stats.opcodes[HRIR_OPC_DIVIDE].executions == 1,
+          "Executions counted per opcode");
+    check(tape_bytes == stats.tape_bytes - tape_at_start && stats.opcodes[HRIR_OPC_JUMP_IF].tape_bytes > 0 &&
+          stats.opcodes[HRIR_OPC_PRINT].tape_bytes == 0, "Tape bytes attributed to the opcodes that wrote them");
+    check(stats.checkpoint_count == 1, "Checkpoints counted");
+
+    for (int k = 0; k < 4; k++) hr_ir_undo(runtime);
+    stats = hr_ir_get_runtime_stats(runtime);
+    check(stats.opcodes[HRIR_OPC_DIVIDE].undos == 1 && stats.opcodes[HRIR_OPC_LOAD].undos == 1 &&
+          stats.opcodes[HRIR_OPC_STORE].undos == 1 && stats.opcodes[HRIR_OPC_JUMP_IF].undos == 1,
+          "Undos counted per opcode");
+    check(stats.peak_tape_bytes > stats.tape_bytes, "Peak tape survives undo");
+
+    char* json = hr_ir_stats_to_json(&stats);
+    check(json && strstr(json, "\"checkpoint_count\": 1") && strstr(json, "\"less\": {\"executions\": 11") &&
+          !strstr(json, "\"print\""), "JSON dump lists the opcodes that ran");
+    free(json);
+
+    hr_ir_set_profiling(runtime, false);
+    stats = hr_ir_get_runtime_stats(runtime);
+    check(!stats.profiled && stats.opcodes[HRIR_OPC_ADD].executions == 0, "Disabling discards the profile");
+
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+static void test_fork(void) {
+    printf("TEST 21: Forked runtimes share state copy-on-write\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = build_counting_program("100000");
+    HRIR_Runtime* parent = hr_ir_create_runtime(program);
+    run_steps(parent, 300000);
+    int fork_point = hr_ir_create_checkpoint(parent, "fork");
+    uint64_t fork_position = hr_ir_get_position(parent);
+
+    HRIR_Runtime* child = hr_ir_fork(parent);
+    check(child && child->registers == parent->registers && child->tape.head == parent->tape.head &&
+          child->tape.chunk_count > 1 && hr_ir_find_checkpoint(child, "fork") == fork_point,
+          "Fork shares registers, tape and checkpoints");
+
+    // What if i had been 90000 at the fork point?
+    HRIR_Value i_at_fork = hr_ir_get_register(child, "i");
+    hr_ir_set_register(child, "i", hr_ir_value_int(90000));
+    check(child->registers != parent->registers && reg(parent, "i") == i_at_fork.as.i,
+          "First write copies the child's state");
+    check(hr_ir_run(child) && reg(child, "i") == 100000, "Child runs its own continuation");
+
+    while (hr_ir_get_position(child) > fork_position) hr_ir_undo(child);
+    hr_ir_set_register(child, "i", i_at_fork);
+    for (int k = 0; k < 100000; k++) hr_ir_undo(child);
+    HRIR_Runtime* expected = hr_ir_create_runtime(program);
+    run_steps(expected, 200000);
+    check(same_registers(child, expected) && child->pc == expected->pc &&
+          child->tape.bytes == expected->tape.bytes, "Child undoes into the shared tape prefix");
+
+    run_steps(expected, 100000);
+    hr_ir_run(expected);
+    hr_ir_run(parent);
+    check(same_registers(parent, expected) && parent->tape.bytes == expected->tape.bytes,
+          "Parent is unaffected by its child");
+
+    enum { FORKS = 1000 };
+    HRIR_Runtime* forks[FORKS];
+    clock_t start = clock();
+    for (int k = 0; k < FORKS; k++) forks[k] = hr_ir_fork(parent);
+    for (int k = 0; k < FORKS; k++) hr_ir_free_runtime(forks[k]);
+    printf("   %d forks created and freed in %.2f ms (CPU time)\n", FORKS, elapsed_ms(start));
+    HRIR_Value* registers = parent->registers;
+    check(hr_ir_undo(parent) && parent->registers == registers, "Last holder keeps the state without a copy");
+
+    HRIR_Runtime* orphan = hr_ir_fork(parent);
+    hr_ir_free_runtime(parent);
+    while (hr_ir_undo(orphan)) {
+    }
+    check(hr_ir_get_position(orphan) == 0 && reg(orphan, "acc") == 0,
+          "Fork outlives its parent and undoes to the start");
+    hr_ir_free_runtime(orphan);
+
+    // A fork under a memory budget recomputes from its own snapshots
+    parent = hr_ir_create_runtime(program);
+    hr_ir_set_memory_budget(parent, 256 * 1024);
+    run_steps(parent, 100000);
+    int early = hr_ir_create_checkpoint(parent, "early");
+    int64_t early_acc = reg(parent, "acc");
+    run_steps(parent, 100000);
+    HRIR_Runtime* budgeted = hr_ir_fork(parent);
+    check(budgeted && hr_ir_undo(budgeted) && hr_ir_undo(parent) &&
+          same_registers(budgeted, parent), "Budgeted fork undoes like its parent");
+    hr_ir_free_runtime(parent);
+    check(hr_ir_rollback_to(budgeted, early) && reg(budgeted, "acc") == early_acc &&
+          hr_ir_get_position(budgeted) == 100000, "Budgeted fork restores an inherited checkpoint");
+
+    hr_ir_free_runtime(budgeted);
+    hr_ir_free_runtime(child);
+    hr_ir_free_runtime(expected);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+static void test_bulk_append(void) {
+    printf("TEST 22: Bulk append and constant-time lookup by id\n");
+    printf("-------------------------------------------------------------\n");
+
+    enum { CELLS = 200000 };
+    HRIR_Cell** cells = malloc(CELLS * sizeof(HRIR_Cell*));
+    for (int i = 0; i < CELLS; i++) {
+        cells[i] = hr_ir_create_cell(i % 2 ? HRIR_OP_ADD : HRIR_OP_MULTIPLY, (const char*[]){"x", "2", "x"}, 3);
+    }
+
+    HRIR_Program* program = hr_ir_create_program("bulk");
+    hr_ir_emit(program, HRIR_OP_PRINT, (const char*[]){"x"}, 1, false);
+    HRIR_Cell* foreign = hr_ir_get_cell(program, 0);
+    HRIR_Cell* rejected[] = { cells[0], foreign };
+    check(!hr_ir_add_cells(program, rejected, 2) && program->cell_count == 1 && cells[0]->id == 0,
+          "Batch with an arena cell is rejected whole");
+
+    clock_t start = clock();
+    bool added = hr_ir_add_cells(program, cells, CELLS);
+    printf("   %d cells added in %.1f ms\n", CELLS, elapsed_ms(start));
+    check(added && program->cell_count == CELLS + 1 && program->capacity == CELLS + 1 &&
+          program->arg_capacity >= program->arg_count, "One reservation covers the batch");
+
+    start = clock();
+    bool found = true;
+    for (int i = 0; i < CELLS; i++) {
+        found = found && hr_ir_get_cell_by_id(program, cells[i]->id) == cells[i];
+    }
+    printf("   %d lookups by id in %.1f ms\n", CELLS, elapsed_ms(start));
+    check(found && !hr_ir_get_cell_by_id(program, CELLS + 2) && !hr_ir_get_cell_by_id(program, 0),
+          "Every id maps to its cell");
+
+    check(hr_ir_reserve(program, 1000, 3000) && program->capacity == CELLS + 1001, "Reserve grows exactly");
+    uint32_t id = hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"x", "1", "x"}, 3, true);
+    check(hr_ir_get_cell_by_id(program, id) == hr_ir_get_cell(program, CELLS + 1), "Appended cells are mapped");
+
+    HRIR_Program* peephole = build_peephole_program();
+    hr_ir_optimize_program(peephole, NULL);
+    check(!hr_ir_get_cell_by_id(peephole, 2) && hr_ir_get_cell_by_id(peephole, 10) ==
+          hr_ir_get_cell(peephole, peephole->cell_count - 1), "Map follows compaction");
+    hr_ir_free_program(peephole);
+
+    free(cells);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+static void test_fossil_collection(void) {
+    printf("TEST 23: Committed horizon releases old tape\n");
+    printf("-------------------------------------------------------------\n");
+
+    HRIR_Program* program = build_counting_program("1000000");
+    HRIR_Runtime* expected = hr_ir_create_runtime(program);
+    hr_ir_run(expected);
+    size_t full_chunks = expected->tape.chunk_count;
+
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+    int start_checkpoint = hr_ir_create_checkpoint(runtime, "start");
+    size_t peak_chunks = 0;
+    while (!hr_ir_is_complete(runtime)) {
+        run_steps(runtime, 100000);
+        if (runtime->tape.chunk_count > peak_chunks) peak_chunks = runtime->tape.chunk_count;
+        hr_ir_commit(runtime);
+    }
+    printf("   Peak tape chunks: %zu committed every 100000 steps, %zu uncommitted\n",
+           peak_chunks, full_chunks);
+    check(same_registers(runtime, expected) && peak_chunks * 4 < full_chunks &&
+          runtime->tape.chunk_count == 0 && runtime->horizon == hr_ir_get_position(runtime),
+          "Periodic commits keep tape memory flat with the same result");
+    check(!hr_ir_undo(runtime) && !hr_ir_rollback_to(runtime, start_checkpoint) &&
+          runtime->error == HRIR_ERROR_CHECKPOINT_NOT_FOUND, "Nothing behind the horizon can be undone");
+    hr_ir_free_runtime(runtime);
+
+    const char* path = "test_hr_ir_tape.bin";
+    remove(path);
+    runtime = hr_ir_create_runtime(program);
+    check(hr_ir_set_tape_archive(runtime, path), "Archive opened");
+    check(!hr_ir_set_memory_budget(runtime, 256 * 1024) && !runtime->recompute,
+          "Memory budget refused while archiving");
+    run_steps(runtime, 5000);
+    HRIR_Tape first = runtime->tape;
+    hr_ir_commit(runtime);
+    run_steps(runtime, 300);
+    HRIR_Tape second = runtime->tape;
+    hr_ir_commit(runtime);
+    hr_ir_set_tape_archive(runtime, NULL);
+    check(hr_ir_set_memory_budget(runtime, 256 * 1024) && !hr_ir_set_tape_archive(runtime, path) &&
+          !runtime->archive && hr_ir_set_memory_budget(runtime, 0), "Archive refused under a memory budget");
+    int horizon_checkpoint = hr_ir_create_checkpoint(runtime, "horizon");
+
+    HRIR_TapeSegment segments[2];
+    FILE* file = fopen(path, "rb");
+    bool read = file && fread(&segments[0], sizeof(HRIR_TapeSegment), 1, file) == 1 &&
+                fseek(file, (long)segments[0].bytes, SEEK_CUR) == 0 &&
+                fread(&segments[1], sizeof(HRIR_TapeSegment), 1, file) == 1 &&
+                fseek(file, (long)segments[1].bytes, SEEK_CUR) == 0 && fgetc(file) == EOF;
+    if (file) fclose(file);
+    remove(path);
+    check(read && segments[0].magic == HRIR_TAPE_SEGMENT_MAGIC && segments[0].position == 0 &&
+          segments[0].steps == 5000 && segments[0].bytes == first.bytes &&
+          segments[1].position == 5000 && segments[1].steps == 300 &&
+          segments[1].records == second.records && segments[1].bytes == second.bytes,
+          "Each commit appends one archive segment");
+
+    run_steps(runtime, 100);
+    HRIR_Runtime* reference = hr_ir_create_runtime(program);
+    run_steps(reference, 5300);
+    check(hr_ir_rollback_to(runtime, horizon_checkpoint) && same_registers(runtime, reference),
+          "Checkpoints at the horizon remain reachable");
+    hr_ir_free_runtime(reference);
+    hr_ir_free_runtime(runtime);
+
+    runtime = hr_ir_create_runtime(program);
+    hr_ir_set_memory_budget(runtime, 256 * 1024);
+    run_steps(runtime, 50000);
+    hr_ir_commit(runtime);
+    run_steps(runtime, 1000);
+    reference = hr_ir_create_runtime(program);
+    run_steps(reference, 50000);
+    for (int k = 0; k < 1000; k++) hr_ir_undo(runtime);
+    check(hr_ir_get_reverse_stats(runtime).snapshot_count == 1 && !hr_ir_undo(runtime) &&
+          same_registers(runtime, reference), "Memory budget re-anchors at the horizon");
+    hr_ir_free_runtime(reference);
+    hr_ir_free_runtime(runtime);
+
+    hr_ir_free_runtime(expected);
+    hr_ir_free_program(program);
+    printf("\n");
+}
+
+// mem[i] = i and mem[4096 + i] = 3i for i in 0..4095, then vector cells over
+// A = [0, 4096), B = [4096, 8192) and C = [8192, 12288)
+static HRIR_Program* build_vector_program(void) {
+    HRIR_Program* program = hr_ir_create_program("vector");
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "0", "i"}, 3, true);                 // 1
+    hr_ir_emit(program, HRIR_OP_STORE, (const char*[]){"i", "i"}, 2, true);                    // 2
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"i", "4096", "j"}, 3, true);              // 3
+    hr_ir_emit(program, HRIR_OP_MULTIPLY, (const char*[]){"i", "3", "t"}, 3, true);            // 4
+    hr_ir_emit(program, HRIR_OP_STORE, (const char*[]){"j", "t"}, 2, true);                    // 5
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"i", "1", "i"}, 3, true);                 // 6
+    hr_ir_emit(program, HRIR_OP_LESS, (const char*[]){"i", "4096", "c"}, 3, true);             // 7
+    hr_ir_emit(program, HRIR_OP_JUMP_IF, (const char*[]){"c", "2"}, 2, true);                  // 8
+    hr_ir_emit(program, HRIR_OP_VADD, (const char*[]){"0", "0", "4096", "4096"}, 4, true);     // 9: A += B
+    hr_ir_emit(program, HRIR_OP_VSUB, (const char*[]){"8192", "0", "4096", "4096"}, 4, true);  // 10: C = A - B
+    hr_ir_emit(program, HRIR_OP_VXOR, (const char*[]){"0", "4096", "0", "4096"}, 4, true);     // 11: A = B ^ A
+    hr_ir_emit(program, HRIR_OP_STORE, (const char*[]){"5", "2.5"}, 2, true);                  // 12
+    hr_ir_emit(program, HRIR_OP_VADD, (const char*[]){"0", "0", "4096", "4096"}, 4, true);     // 13: A += B, mixed
+    hr_ir_emit(program, HRIR_OP_VSCALE, (const char*[]){"8192", "0", "0.5", "4096"}, 4, true); // 14: C = A * 0.5
+    hr_ir_emit(program, HRIR_OP_VSUM, (const char*[]){"s", "0", "4096"}, 3, true);             // 15
+    hr_ir_emit(program, HRIR_OP_VSUM, (const char*[]){"si", "4096", "4096"}, 3, true);         // 16
+    return program;
+}
+
+static bool same_memory(HRIR_Runtime* runtime, const HRIR_Value* expected, size_t count) {
+    for (size_t k = 0; k < count; k++) {
+        HRIR_Value value = hr_ir_get_memory(runtime, k);
+        if (value.type != expected[k].type || value.as.i != expected[k].as.i) return false;
+    }
+    return true;
+}
+
+static void test_vector_ops(void) {
+    printf("TEST 24: Vector opcodes with SIMD kernels and reversible undo\n");
+    printf("-------------------------------------------------------------\n");
+
+    enum { N = 4096 };
+    HRIR_VectorIsa native = hr_ir_vector_isa();
+    printf("   Kernels: %s\n", hr_ir_vector_isa_name(native));
+
+    HRIR_Program* program = build_vector_program();
+    HRIR_Runtime* runtime = hr_ir_create_runtime(program);
+    while (hr_ir_get_pc(runtime) != 8 && hr_ir_step(runtime)) {
+    }
+    HRIR_Value* before = malloc(3 * N * sizeof(HRIR_Value));
+    for (size_t k = 0; k < 3 * N; k++) before[k] = hr_ir_get_memory(runtime, k);
+    uint64_t records = runtime->tape.records;
+
+    hr_ir_step(runtime);
+    bool added = true;
+    for (int64_t k = 0; k < N; k++) added = added && hr_ir_get_memory(runtime, k).as.i == 4 * k;
+    check(added && runtime->tape.records == records, "In-place integer vadd writes no tape record");
+    hr_ir_undo(runtime);
+    check(same_memory(runtime, before, 3 * N), "Undo recomputes the range from the result");
+
+    hr_ir_step(runtime);
+    hr_ir_step(runtime);
+    bool subtracted = true;
+    for (int64_t k = 0; k < N; k++) subtracted = subtracted && hr_ir_get_memory(runtime, 2 * N + k).as.i == k;
+    check(subtracted && runtime->tape.records == records + N, "Out-of-place vsub tapes the old range");
+
+    hr_ir_step(runtime);
+    bool xored = true;
+    for (int64_t k = 0; k < N; k++) xored = xored && hr_ir_get_memory(runtime, k).as.i == ((3 * k) ^ (4 * k));
+    check(xored && runtime->tape.records == records + N, "vxor into its second operand is exact too");
+
+    hr_ir_step(runtime);
+    hr_ir_step(runtime);
+    HRIR_Value mixed = hr_ir_get_memory(runtime, 5);
+    HRIR_Value next = hr_ir_get_memory(runtime, 6);
+    check(mixed.type == HRIR_VALUE_FLOAT && mixed.as.f == 17.5 && next.type == HRIR_VALUE_INT &&
+          next.as.i == ((18 ^ 24) + 18) && runtime->tape.records == records + 2 * N + 1,
+          "A float slot sends an in-place update to the tape");
+
+    hr_ir_run(runtime);
+    HRIR_Value scaled = hr_ir_get_memory(runtime, 2 * N + 5);
+    HRIR_Value s = hr_ir_get_register(runtime, "s");
+    check(hr_ir_is_complete(runtime) && scaled.type == HRIR_VALUE_FLOAT && scaled.as.f == 8.75 &&
+          s.type == HRIR_VALUE_FLOAT && reg(runtime, "si") == 3LL * N * (N - 1) / 2,
+          "vscale and vsum follow the scalar type rules");
+
+    // A fork shares the tape; undoing a range step there copies every chunk it spans first
+    HRIR_Runtime* fork = hr_ir_fork(runtime);
+    while (fork && hr_ir_get_pc(fork) != 8 && hr_ir_undo(fork)) {
+    }
+    check(fork && runtime->tape.chunk_count > 1 && same_memory(fork, before, 3 * N) &&
+          hr_ir_get_memory(runtime, 2 * N + 5).as.f == 8.75, "A fork undoes shared range steps on its own");
+    hr_ir_free_runtime(fork);
+
+    while (hr_ir_get_pc(runtime) != 8 && hr_ir_undo(runtime)) {
+    }
+    check(same_memory(runtime, before, 3 * N) && hr_ir_get_register(runtime, "s").type == HRIR_VALUE_INT,
+          "Undo restores every range");
+    hr_ir_free_runtime(runtime);
+
+    // Every instruction set leaves the same bits
+    HRIR_Runtime* expected = hr_ir_create_runtime(program);
+    hr_ir_set_vector_isa(HRIR_VECTOR_SCALAR);
+    hr_ir_run(expected);
+    bool identical = true;
+    for (int isa = HRIR_VECTOR_SSE2; isa <= HRIR_VECTOR_AVX2; isa++) {
+        if (!hr_ir_set_vector_isa((HRIR_VectorIsa)isa)) continue;
+        runtime = hr_ir_create_runtime(program);
+        hr_ir_run(runtime);
+        for (size_t k = 0; k < 3 * N; k++) before[k] = hr_ir_get_memory(expected, k);
+        identical = identical && same_memory(runtime, before, 3 * N) && same_registers(runtime, expected);
+        printf("   %s matches scalar: %s\n", hr_ir_vector_isa_name((HRIR_VectorIsa)isa), identical ? "yes" : "no");
+        hr_ir_free_runtime(runtime);
+    }
+    check(identical, "Results are bit-identical across instruction sets");
+    hr_ir_free_runtime(expected);
+    hr_ir_free_program(program);
+    free(before);
+
+    program = hr_ir_create_program("overlap");
+    hr_ir_emit(program, HRIR_OP_VADD, (const char*[]){"1", "0", "0", "8"}, 4, true);
+    runtime = hr_ir_create_runtime(program);
+    check(!hr_ir_run(runtime) && runtime->error == HRIR_ERROR_INVALID_OPERATION &&
+          hr_ir_get_position(runtime) == 0, "Partially overlapping ranges are rejected");
+    hr_ir_free_runtime(runtime);
+    hr_ir_free_program(program);
+
+    // 100 in-place integer updates of 65536 slots
+    program = hr_ir_create_program("throughput");
+    hr_ir_emit(program, HRIR_OP_VSUB, (const char*[]){"0", "0", "0", "131072"}, 4, true);
+    hr_ir_emit(program, HRIR_OP_VADD, (const char*[]){"0", "0", "65536", "65536"}, 4, true);
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"k", "1", "k"}, 3, true);
+    hr_ir_emit(program, HRIR_OP_LESS, (const char*[]){"k", "100", "c"}, 3, true);
+    hr_ir_emit(program, HRIR_OP_JUMP_IF, (const char*[]){"c", "2"}, 2, true);
+    for (int isa = HRIR_VECTOR_SCALAR; isa <= HRIR_VECTOR_AVX2; isa++) {
+        if (!hr_ir_set_vector_isa((HRIR_VectorIsa)isa)) continue;
+        runtime = hr_ir_create_runtime(program);
+        clock_t start = clock();
+        hr_ir_run(runtime);
+        printf("   %s: %.1f ms, %llu tape records\n", hr_ir_vector_isa_name((HRIR_VectorIsa)isa),
+               elapsed_ms(start), (unsigned long long)runtime->tape.records);
+        hr_ir_free_runtime(runtime);
+    }
+    hr_ir_free_program(program);
+
+    // 20 passes of C = A + B and C *= 0.3 over 16384 float slots, against scalar
+    program = hr_ir_create_program("float throughput");
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"0", "0", "i"}, 3, true);                      // 1
+    hr_ir_emit(program, HRIR_OP_MULTIPLY, (const char*[]){"i", "0.5", "t"}, 3, true);               // 2
+    hr_ir_emit(program, HRIR_OP_STORE, (const char*[]){"i", "t"}, 2, true);                         // 3
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"i", "16384", "j"}, 3, true);                  // 4
+    hr_ir_emit(program, HRIR_OP_STORE, (const char*[]){"j", "t"}, 2, true);                         // 5
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"i", "1", "i"}, 3, true);                      // 6
+    hr_ir_emit(program, HRIR_OP_LESS, (const char*[]){"i", "16384", "c"}, 3, true);                 // 7
+    hr_ir_emit(program, HRIR_OP_JUMP_IF, (const char*[]){"c", "2"}, 2, true);                       // 8
+    hr_ir_emit(program, HRIR_OP_VADD, (const char*[]){"32768", "0", "16384", "16384"}, 4, true);    // 9
+    hr_ir_emit(program, HRIR_OP_VSCALE, (const char*[]){"32768", "32768", "0.3", "16384"}, 4, true); // 10
+    hr_ir_emit(program, HRIR_OP_ADD, (const char*[]){"k", "1", "k"}, 3, true);                      // 11
+    hr_ir_emit(program, HRIR_OP_LESS, (const char*[]){"k", "20", "c"}, 3, true);                    // 12
+    hr_ir_emit(program, HRIR_OP_JUMP_IF, (const char*[]){"c", "9"}, 2, true);                       // 13
+    expected = NULL;
+    double scalar_ms = 0.0;
+    bool same_floats = true, quiet = true;
+    for (int isa = HRIR_VECTOR_SCALAR; isa <= HRIR_VECTOR_AVX2; isa++) {
+        if (!hr_ir_set_vector_isa((HRIR_VectorIsa)isa)) continue;
+        runtime = hr_ir_create_runtime(program);
+        while (hr_ir_get_pc(runtime) != 8 && hr_ir_step(runtime)) {
+        }
+        feclearexcept(FE_ALL_EXCEPT);
+        clock_t start = clock();
+        hr_ir_run(runtime);
+        quiet = quiet && !fetestexcept(FE_UNDERFLOW);
+        double ms = elapsed_ms(start);
+        if (!expected) {
+            expected = runtime;
+            scalar_ms = ms;
+            printf("   float scalar: %.1f ms\n", ms);
+            continue;
+        }
+        for (size_t k = 32768; k < 49152; k++) {
+            same_floats = same_floats && hr_ir_get_memory(runtime, k).as.i == hr_ir_get_memory(expected, k).as.i;
+        }
+        printf("   float %s: %.1f ms (%.2fx scalar)\n", hr_ir_vector_isa_name((HRIR_VectorIsa)isa), ms,
+               ms > 0.0 ? scalar_ms / ms : 0.0);
+        hr_ir_free_runtime(runtime);
+    }
+    check(same_floats && hr_ir_get_memory(expected, 32769).as.f == 0.3,
+          "Float kernels match the scalar path bit for bit");
+    check(quiet, "Float kernels do no arithmetic on the tag halves");
+    hr_ir_free_runtime(expected);
+    hr_ir_free_program(program);
+
+    hr_ir_set_vector_isa(native);
+    printf("\n");
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("L1 HRIR TEST\n");
+    printf("=============================================================\n\n");
+
+    test_compact_encoding();
+    test_large_program();
+    test_json_escaping();
+    test_interpreter();
+    test_undo();
+    test_delta_tape();
+    test_checkpoint_tree();
+    test_memory_budget();
+    test_shared_program();
+    test_optimizer();
+    test_parallel_waves();
+    test_cell_arena();
+    test_lazy_inverse();
+    test_json_loader();
+    test_binary_format();
+    test_hash_consing();
+    test_superinstructions();
+    test_native_backend();
+    test_value_numbering();
+    test_profiling();
+    test_fork();
+    test_bulk_append();
+    test_fossil_collection();
+    test_vector_ops();
+
+    printf("=============================================================\n");
+    printf("%s\n", failures == 0 ? "ALL HRIR TESTS PASSED" : "HRIR TESTS FAILED");
+    printf("=============================================================\n");
+
+    return failures == 0 ? 0 : 1;
+}
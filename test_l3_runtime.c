@@ -0,0 +1,492 @@
+// test_l3_runtime.c
+// Test L3 Turchin runtime scaling features: passivation, tenants, simulation,
+// native handlers
+
+#include "src/l3_turchin.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+static int failures = 0;
+
+static void check(bool condition, const char* description) {
+    if (condition) {
+        printf("✅ %s\n", description);
+    } else {
+        printf("❌ %s\n", description);
+        failures++;
+    }
+}
+
+static const char* session_code =
+    "actor Session\n"
+    "    role is \"Track one user session\"\n"
+    "\n"
+    "    state has\n"
+    "        hits is 0\n"
+    "        user is \"anonymous\"\n"
+    "\n"
+    "    handlers\n"
+    "\n"
+    "    on hit\n"
+    "        state.hits -> 7\n"
+    "        log \"Session hit\"\n";
+
+static void test_passivation(void) {
+    printf("TEST 1: Idle actors are passivated and reloaded on demand\n");
+    printf("-------------------------------------------------------------\n");
+
+    L3_ActorDefinition* def = l3_parse_actor(session_code);
+    L3_ActorRuntime* runtime = l3_runtime_init();
+
+    check(l3_enable_passivation(runtime, "/tmp/l3_test_store", 0),
+          "Passivation enabled");
+
+    int first = l3_spawn_actor(runtime, def);
+    int second = l3_spawn_actor(runtime, def);
+
+    l3_send_message(runtime, first, "hit", NULL);
+    l3_tick(runtime);
+
+    check(l3_is_passivated(runtime, first) && l3_is_passivated(runtime, second),
+          "Idle actors evicted after tick");
+    check(runtime->passivated_count == 2, "Passivated count tracks evictions");
+    check(runtime->actors[0]->state == NULL && runtime->message_queues[0] == NULL,
+          "Stub keeps no state or mailbox resident");
+    check(l3_get_actor_by_name(runtime, "Session") == first,
+          "Stub still resolves by name");
+
+    // Sending to a stub reloads it before the message is queued
+    check(l3_send_message(runtime, first, "hit", NULL), "Send to passivated actor");
+    check(!l3_is_passivated(runtime, first), "Actor reactivated by send");
+
+    const char* hits = l3_state_get(runtime->actors[0]->state, "hits");
+    const char* user = l3_state_get(runtime->actors[0]->state, "user");
+    check(hits && strcmp(hits, "7") == 0, "State survived the round trip");
+    check(user && strcmp(user, "anonymous") == 0, "String state survived the round trip");
+    check(runtime->actors[0]->handler_count == 1, "Handlers survived the round trip");
+
+    l3_tick(runtime);
+    check(l3_is_passivated(runtime, first), "Actor passivated again once idle");
+
+    l3_free_runtime(runtime);
+    l3_free_actor_definition(def);
+    printf("\n");
+}
+
+static void test_idle_timeout(void) {
+    printf("TEST 2: Recently active actors stay resident\n");
+    printf("-------------------------------------------------------------\n");
+
+    L3_ActorDefinition* def = l3_parse_actor(session_code);
+    L3_ActorRuntime* runtime = l3_runtime_init();
+    l3_enable_passivation(runtime, "/tmp/l3_test_store", 3600);
+
+    int id = l3_spawn_actor(runtime, def);
+    l3_send_message(runtime, id, "hit", NULL);
+    l3_tick(runtime);
+
+    check(!l3_is_passivated(runtime, id), "Actor within idle timeout not evicted");
+    check(l3_passivate_actor(runtime, id), "Explicit passivation");
+    check(l3_activate_actor(runtime, id), "Explicit activation");
+    check(runtime->passivated_count == 0, "No actors left on disk");
+
+    // Both runtimes number their first actor 1 and share the store
+    L3_ActorRuntime* other = l3_runtime_init();
+    l3_enable_passivation(other, "/tmp/l3_test_store", 3600);
+    int other_id = l3_spawn_actor(other, def);
+    check(other_id == id && strcmp(other->store_dir, runtime->store_dir) != 0,
+          "Runtimes sharing a store get directories of their own");
+    l3_passivate_actor(runtime, id);
+    l3_passivate_actor(other, other_id);
+    l3_activate_actor(runtime, id);
+    l3_activate_actor(other, other_id);
+    const char* hits = l3_state_get(runtime->actors[0]->state, "hits");
+    const char* other_hits = l3_state_get(other->actors[0]->state, "hits");
+    check(hits && strcmp(hits, "7") == 0 && other_hits && strcmp(other_hits, "0") == 0,
+          "Same actor id in two runtimes does not share a stored file");
+
+    char store[1024];
+    struct stat info;
+    snprintf(store, sizeof(store), "%s", runtime->store_dir);
+    l3_free_runtime(runtime);
+    check(stat(store, &info) != 0 && l3_passivate_actor(other, other_id) &&
+          l3_activate_actor(other, other_id), "Freeing a runtime removes only its own directory");
+
+    // An existing directory, spelled too long to hold actor file names
+    char long_dir[1010] = "/tmp";
+    while (strlen(long_dir) + 2 < sizeof(long_dir)) strcat(long_dir, "/.");
+    check(!l3_enable_passivation(other, long_dir, 3600), "Store path too long for actor files refused");
+
+    l3_free_runtime(other);
+    l3_free_actor_definition(def);
+    printf("\n");
+}
+
+static void test_tenants(void) {
+    printf("TEST 3: Tenants are scheduled by deficit round robin\n");
+    printf("-------------------------------------------------------------\n");
+
+    L3_ActorDefinition* def = l3_parse_actor(session_code);
+    L3_ActorRuntime* runtime = l3_runtime_init();
+
+    L3_TenantQuota noisy_quota = l3_default_tenant_quota();
+    noisy_quota.mailbox_quota = 50;
+    L3_TenantQuota fair_quota = l3_default_tenant_quota();
+    fair_quota.cpu_quantum = 2;
+
+    int noisy = l3_create_tenant(runtime, "noisy", noisy_quota);
+    int fair = l3_create_tenant(runtime, "fair", fair_quota);
+
+    int flood_target = l3_spawn_actor_in_tenant(runtime, def, noisy);
+    int quiet_target = l3_spawn_actor_in_tenant(runtime, def, fair);
+
+    size_t accepted = 0;
+    for (int i = 0; i < 60; i++) {
+        if (l3_send_message(runtime, flood_target, "hit", NULL)) accepted++;
+    }
+    for (int i = 0; i < 4; i++) {
+        l3_send_message(runtime, quiet_target, "hit", NULL);
+    }
+
+    L3_TenantUsage usage;
+    l3_get_tenant_usage(runtime, noisy, &usage);
+    check(accepted == 50 && usage.messages_rejected == 10, "Mailbox quota caps the flood");
+
+    l3_tick(runtime);
+    l3_tick(runtime);
+
+    L3_TenantUsage noisy_usage, fair_usage;
+    l3_get_tenant_usage(runtime, noisy, &noisy_usage);
+    l3_get_tenant_usage(runtime, fair, &fair_usage);
+    check(noisy_usage.messages_processed == 2, "Flooding tenant limited to its quantum");
+    check(fair_usage.messages_processed == 4 && fair_usage.mailbox_depth == 0,
+          "Other tenant drained despite the flood");
+    check(noisy_usage.mailbox_depth == 48, "Usage reports remaining backlog");
+    check(noisy_usage.memory_used > 0, "Memory usage charged to tenant");
+
+    L3_TenantQuota tiny_quota = l3_default_tenant_quota();
+    tiny_quota.memory_quota = 64;
+    int tiny = l3_create_tenant(runtime, "tiny", tiny_quota);
+    check(l3_spawn_actor_in_tenant(runtime, def, tiny) == -1, "Memory quota refuses spawn");
+    l3_get_tenant_usage(runtime, tiny, &usage);
+    check(usage.spawns_rejected == 1, "Rejected spawn counted");
+
+    // The pre-check charges what the spawn will: mailbox included
+    size_t footprint = runtime->actors[0]->footprint;
+    tiny_quota.memory_quota = footprint - 1;
+    int tight = l3_create_tenant(runtime, "tight", tiny_quota);
+    tiny_quota.memory_quota = footprint;
+    int exact = l3_create_tenant(runtime, "exact", tiny_quota);
+    check(l3_spawn_actor_in_tenant(runtime, def, tight) == -1 &&
+          l3_spawn_actor_in_tenant(runtime, def, exact) != -1 &&
+          l3_get_tenant_usage(runtime, exact, &usage) && usage.memory_used == footprint,
+          "Spawn estimate matches the footprint it is charged");
+
+    l3_free_runtime(runtime);
+    l3_free_actor_definition(def);
+    printf("\n");
+}
+
+static const char* heartbeat_code =
+    "actor Heartbeat\n"
+    "    role is \"Beat once per simulated second\"\n"
+    "\n"
+    "    handlers\n"
+    "\n"
+    "    on beat\n"
+    "        after 1000 -> beat\n";
+
+static const char* racer_code_a =
+    "actor RacerA\n"
+    "    role is \"Report to the recorder on every tick\"\n"
+    "\n"
+    "    handlers\n"
+    "\n"
+    "    on go\n"
+    "        Recorder -> from_a\n"
+    "        after 50 -> go\n";
+
+static const char* racer_code_b =
+    "actor RacerB\n"
+    "    role is \"Report to the recorder on every tick\"\n"
+    "\n"
+    "    handlers\n"
+    "\n"
+    "    on go\n"
+    "        Recorder -> from_b\n"
+    "        after 50 -> go\n";
+
+static const char* recorder_code =
+    "actor Recorder\n"
+    "    role is \"Remember who reported last\"\n"
+    "\n"
+    "    state has\n"
+    "        last is none\n"
+    "\n"
+    "    handlers\n"
+    "\n"
+    "    on from_a\n"
+    "        state.last -> a\n"
+    "\n"
+    "    on from_b\n"
+    "        state.last -> b\n";
+
+// Run the racers for a while and return who the recorder saw last
+static char simulate_race(unsigned long long seed) {
+    L3_ActorDefinition* a = l3_parse_actor(racer_code_a);
+    L3_ActorDefinition* b = l3_parse_actor(racer_code_b);
+    L3_ActorDefinition* rec = l3_parse_actor(recorder_code);
+
+    L3_ActorRuntime* runtime = l3_runtime_init();
+    l3_set_trace(runtime, false);
+    l3_enable_simulation(runtime, seed);
+
+    int rec_id = l3_spawn_actor(runtime, rec);
+    l3_send_message(runtime, l3_spawn_actor(runtime, a), "go", NULL);
+    l3_send_message(runtime, l3_spawn_actor(runtime, b), "go", NULL);
+    l3_run_simulation(runtime, 1000);
+
+    L3_ActorState* state = runtime->actors[rec_id - 1]->state;
+    char last = l3_state_get(state, "last")[0];
+
+    l3_free_runtime(runtime);
+    l3_free_actor_definition(a);
+    l3_free_actor_definition(b);
+    l3_free_actor_definition(rec);
+    return last;
+}
+
+static const char* ping_code =
+    "actor Ping\n"
+    "    role is \"Answer every pong\"\n"
+    "\n"
+    "    handlers\n"
+    "\n"
+    "    on pong\n"
+    "        Pong -> ping\n";
+
+static const char* pong_code =
+    "actor Pong\n"
+    "    role is \"Answer every ping\"\n"
+    "\n"
+    "    handlers\n"
+    "\n"
+    "    on ping\n"
+    "        Ping -> pong\n";
+
+static void test_simulation(void) {
+    printf("TEST 4: Deterministic simulation with a virtual clock\n");
+    printf("-------------------------------------------------------------\n");
+
+    L3_ActorDefinition* def = l3_parse_actor(heartbeat_code);
+    L3_ActorRuntime* runtime = l3_runtime_init();
+    l3_set_trace(runtime, false);
+    l3_enable_simulation(runtime, 42);
+
+    int id = l3_spawn_actor(runtime, def);
+    l3_send_message(runtime, id, "beat", NULL);
+
+    clock_t start = clock();
+    size_t processed = l3_run_simulation(runtime, 100000ULL * 1000ULL);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("   %zu beats over 100000 simulated seconds in %.3fs\n", processed, seconds);
+    check(processed == 100000, "One beat per simulated second, the one at the deadline left pending");
+    check(l3_now_ms(runtime) == 100000ULL * 1000ULL, "Virtual clock advanced to the end");
+    check(runtime->timer_count == 1, "Next beat still pending");
+
+    l3_free_runtime(runtime);
+    l3_free_actor_definition(def);
+
+    char first = simulate_race(7);
+    check(first == simulate_race(7), "Same seed reproduces the same run");
+
+    bool order_varies = false;
+    for (unsigned long long seed = 1; seed <= 8; seed++) {
+        if (simulate_race(seed) != first) order_varies = true;
+    }
+    check(order_varies, "Seed drives scheduling order");
+
+    // Two actors messaging each other forever still stop at the deadline
+    L3_ActorDefinition* ping = l3_parse_actor(ping_code);
+    L3_ActorDefinition* pong = l3_parse_actor(pong_code);
+    runtime = l3_runtime_init();
+    l3_set_trace(runtime, false);
+    l3_enable_simulation(runtime, 3);
+    l3_spawn_actor(runtime, ping);
+    l3_send_message(runtime, l3_spawn_actor(runtime, pong), "ping", NULL);
+    processed = l3_run_simulation(runtime, 500);
+    check(processed >= 500 && processed <= 1000 && l3_now_ms(runtime) == 500 &&
+          runtime->pending_messages == 1,
+          "Endless exchange bounded by the deadline");
+
+    l3_free_runtime(runtime);
+    l3_free_actor_definition(ping);
+    l3_free_actor_definition(pong);
+
+    printf("\n");
+}
+
+static void native_count(L3_ExecutionContext* ctx) {
+    long long hits = l3_state_get_int(ctx->state, "hits", 0);
+    l3_state_set_int(ctx->state, "hits", hits + 1);
+
+    if (hits + 1 == 3) {
+        l3_send_from(ctx, "self", "reset", NULL);
+    }
+}
+
+static void test_native_handlers(void) {
+    printf("TEST 5: Native and interpreted handlers in one actor\n");
+    printf("-------------------------------------------------------------\n");
+
+    const char* mixed_code =
+        "actor Mixed\n"
+        "    role is \"Hot path in C, cold path interpreted\"\n"
+        "\n"
+        "    state has\n"
+        "        hits is 0\n"
+        "        resets is 0\n"
+        "\n"
+        "    handlers\n"
+        "\n"
+        "    on hit\n"
+        "        log \"interpreted hit\"\n"
+        "\n"
+        "    on reset\n"
+        "        state.hits -> 0\n"
+        "        state.resets -> 1\n";
+
+    L3_ActorDefinition* def = l3_parse_actor(mixed_code);
+    check(l3_register_native_handler(def, "hit", native_count), "Native handler registered");
+    check(def->handler_count == 2, "Native handler replaced the interpreted one");
+
+    L3_ActorRuntime* runtime = l3_runtime_init();
+    l3_set_trace(runtime, false);
+    l3_enable_passivation(runtime, "/tmp/l3_test_store", 0);
+
+    int id = l3_spawn_actor(runtime, def);
+    for (int i = 0; i < 3; i++) {
+        l3_send_message(runtime, id, "hit", NULL);
+        l3_tick(runtime);
+    }
+
+    L3_ActorState* state = runtime->actors[0]->state;
+    check(state && l3_state_get_int(state, "hits", -1) == 3, "Native handler updated typed state");
+
+    l3_tick(runtime);
+    state = runtime->actors[0]->state;
+    check(state == NULL, "Mixed actor passivated between messages");
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/actor_%d.l3a", runtime->store_dir, id);
+    FILE* stored = fopen(path, "rb");
+    char header[16] = "";
+    bool stored_read = stored && fgets(header, sizeof(header), stored);
+    if (stored) fclose(stored);
+    check(stored_read && strcmp(header, "L3A 3\n") == 0 && runtime->actors[0]->native_count == 1 &&
+          runtime->actors[0]->natives[0]->native == native_count,
+          "Native binding kept by the stub, not written to the store");
+
+    l3_send_message(runtime, id, "hit", NULL);
+    l3_tick(runtime);
+    l3_activate_actor(runtime, id);
+    state = runtime->actors[0]->state;
+    check(l3_state_get_int(state, "resets", 0) == 1, "Native send reached interpreted handler");
+    check(l3_state_get_int(state, "hits", -1) == 1, "Native handler survived passivation");
+
+    l3_free_runtime(runtime);
+    l3_free_actor_definition(def);
+    printf("\n");
+}
+
+static void test_idle_candidates(void) {
+    printf("TEST 6: Idle passivation visits only candidates, reloads respect quotas\n");
+    printf("-------------------------------------------------------------\n");
+
+    enum { ACTORS = 20000 };
+    L3_ActorDefinition* def = l3_parse_actor(session_code);
+    L3_ActorRuntime* runtime = l3_runtime_init();
+    l3_set_trace(runtime, false);
+    l3_enable_simulation(runtime, 1);
+    l3_enable_passivation(runtime, "/tmp/l3_test_store", 10);
+
+    for (int i = 0; i < ACTORS; i++) l3_spawn_actor(runtime, def);
+    int busy = 1;
+
+    clock_t start = clock();
+    for (int i = 0; i < 1000; i++) l3_passivate_idle(runtime);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("   1000 idle scans over %d resident actors in %.4fs\n", ACTORS, seconds);
+    check(runtime->passivated_count == 0 && seconds < 0.05, "Scans stop at the first actor within its timeout");
+
+    start = clock();
+    for (int i = 0; i < 1000; i++) l3_tick(runtime);
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("   1000 simulated rounds over %d idle actors in %.4fs\n", ACTORS, seconds);
+    check(runtime->ready_count == 0 && seconds < 0.05, "Simulated rounds shuffle only actors with mail");
+
+    runtime->virtual_ms = 5000;
+    l3_send_message(runtime, busy, "hit", NULL);
+    check(runtime->ready_count == 1, "A message puts its actor on the ready list");
+    l3_tick(runtime);
+    runtime->virtual_ms = 11000;
+    l3_tick(runtime);
+    check(runtime->passivated_count == ACTORS - 1 && !l3_is_passivated(runtime, busy),
+          "Recently active actor kept, the rest evicted");
+    runtime->virtual_ms = 16000;
+    l3_tick(runtime);
+    check(l3_is_passivated(runtime, busy), "It follows once its own timeout runs out");
+
+    l3_free_runtime(runtime);
+
+    // Reloading is charged against the tenant like a spawn
+    runtime = l3_runtime_init();
+    l3_set_trace(runtime, false);
+    l3_enable_passivation(runtime, "/tmp/l3_test_store", 3600);
+    int tenant = l3_create_tenant(runtime, "bounded", l3_default_tenant_quota());
+    int first = l3_spawn_actor_in_tenant(runtime, def, tenant);
+    l3_passivate_actor(runtime, first);
+    int second = l3_spawn_actor_in_tenant(runtime, def, tenant);
+
+    L3_TenantUsage usage;
+    l3_get_tenant_usage(runtime, tenant, &usage);
+    runtime->tenants[tenant - 1]->quota.memory_quota = usage.memory_used + 256;
+
+    check(!l3_send_message(runtime, first, "hit", NULL) && l3_is_passivated(runtime, first),
+          "Reload over the memory quota refused");
+    l3_get_tenant_usage(runtime, tenant, &usage);
+    check(usage.activations_rejected == 1 && usage.messages_rejected == 1 &&
+          usage.memory_used <= runtime->tenants[tenant - 1]->quota.memory_quota,
+          "Refused reload counted and quota held");
+
+    l3_passivate_actor(runtime, second);
+    check(l3_send_message(runtime, first, "hit", NULL) && !l3_is_passivated(runtime, first),
+          "Reload succeeds once the tenant has room");
+
+    l3_free_runtime(runtime);
+    l3_free_actor_definition(def);
+    printf("\n");
+}
+
+int main() {
+    printf("=============================================================\n");
+    printf("L3 RUNTIME SCALING TEST\n");
+    printf("=============================================================\n\n");
+
+    test_passivation();
+    test_idle_timeout();
+    test_tenants();
+    test_simulation();
+    test_native_handlers();
+    test_idle_candidates();
+
+    printf("=============================================================\n");
+    printf("%s\n", failures == 0 ? "ALL L3 RUNTIME TESTS PASSED" : "L3 RUNTIME TESTS FAILED");
+    printf("=============================================================\n");
+
+    return failures == 0 ? 0 : 1;
+}